@@ -158,6 +158,24 @@ int av_sample_fmt_is_planar(enum AVSampleFormat sample_fmt)
 #  endif
 #endif
 
+#ifndef CODEC_CAP_AUTO_THREADS
+#  ifdef AV_CODEC_CAP_AUTO_THREADS
+#    define CODEC_CAP_AUTO_THREADS AV_CODEC_CAP_AUTO_THREADS
+#  endif
+#endif
+
+#ifndef CODEC_CAP_FRAME_THREADS
+#  ifdef AV_CODEC_CAP_FRAME_THREADS
+#    define CODEC_CAP_FRAME_THREADS AV_CODEC_CAP_FRAME_THREADS
+#  endif
+#endif
+
+#ifndef CODEC_CAP_SLICE_THREADS
+#  ifdef AV_CODEC_CAP_SLICE_THREADS
+#    define CODEC_CAP_SLICE_THREADS AV_CODEC_CAP_SLICE_THREADS
+#  endif
+#endif
+
 /* FFmpeg upstream 1.0 is the first who added AV_ prefix. */
 #if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(54, 59, 100)
 #  define AV_CODEC_ID_NONE CODEC_ID_NONE
@@ -183,7 +183,8 @@ public:
 		return size;
 	}
 
-	void enforce_limits() {
+	/* reserve: memory which has to stay free on top of the elements in the cache */
+	void enforce_limits(size_t reserve = 0) {
 		size_t max = MEM_CacheLimiter_get_maximum();
 		bool is_disabled = MEM_CacheLimiter_is_disabled();
 		size_t mem_in_use, cur_size;
@@ -196,6 +197,8 @@ public:
 			return;
 		}
 
+		max = (reserve < max) ? max - reserve : 0;
+
 		mem_in_use = get_memory_in_use();
 
 		if (mem_in_use <= max) {
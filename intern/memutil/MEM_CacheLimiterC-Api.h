@@ -95,6 +95,15 @@ MEM_CacheLimiterHandleC *MEM_CacheLimiter_insert(MEM_CacheLimiterC *This, void *
 
 void MEM_CacheLimiter_enforce_limits(MEM_CacheLimiterC *This);
 
+/**
+ * Free objects until an object of the given size fits in the limit
+ *
+ * \param This "This" pointer
+ * \param reserve size of the object to make room for
+ */
+
+void MEM_CacheLimiter_enforce_limits_reserve(MEM_CacheLimiterC *This, size_t reserve);
+
 /**
  * Unmanage object previously inserted object.
  * Does _not_ delete managed object!
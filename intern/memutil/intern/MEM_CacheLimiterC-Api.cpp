@@ -179,6 +179,11 @@ void MEM_CacheLimiter_enforce_limits(MEM_CacheLimiterC *This)
 	cast(This)->get_cache()->enforce_limits();
 }
 
+void MEM_CacheLimiter_enforce_limits_reserve(MEM_CacheLimiterC *This, size_t reserve)
+{
+	cast(This)->get_cache()->enforce_limits(reserve);
+}
+
 void MEM_CacheLimiter_unmanage(MEM_CacheLimiterHandleC *handle)
 {
 	cast(handle)->unmanage();
@@ -119,6 +119,18 @@ void openSubdiv_evaluateLimit(OpenSubdiv_EvaluatorDescr *evaluator_descr,
                               float dPdu[3],
                               float dPdv[3]);
 
+/* Evaluate num_coords points of the same PTex face at once, face_uv holds
+ * (u, v) pairs and the outputs are arrays of float[3]. dPdu and dPdv are
+ * either both given or both NULL.
+ */
+void openSubdiv_evaluateLimitBatch(OpenSubdiv_EvaluatorDescr *evaluator_descr,
+                                   int osd_face_index,
+                                   const float *face_uv,
+                                   int num_coords,
+                                   float *P,
+                                   float *dPdu,
+                                   float *dPdv);
+
 void openSubdiv_evaluateVarying(OpenSubdiv_EvaluatorDescr *evaluator_descr,
                                int osd_face_index,
                                float face_u, float face_v,
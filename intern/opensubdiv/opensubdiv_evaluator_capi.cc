@@ -41,6 +41,10 @@
 #include <opensubdiv/osd/mesh.h>
 #include <opensubdiv/osd/types.h>
 
+#ifdef OPENSUBDIV_HAS_OPENMP
+#  include <opensubdiv/osd/ompEvaluator.h>
+#endif
+
 #include "opensubdiv_intern.h"
 #include "opensubdiv_topology_refiner.h"
 
@@ -114,6 +118,41 @@ protected:
 	PatchCoord patch_coord_;
 };
 
+/* Helper class to wrap an array of patch coords allocated by the
+ * caller into a buffer, so multiple coordinates are evaluated at once.
+ */
+class PatchCoordArrayBuffer {
+public:
+	PatchCoordArrayBuffer(PatchCoord *patch_coords, int num_patch_coords)
+	        : patch_coords_(patch_coords),
+	          num_patch_coords_(num_patch_coords) {
+	}
+	PatchCoord *BindCpuBuffer() {
+		return patch_coords_;
+	}
+	int GetNumVertices() {
+		return num_patch_coords_;
+	}
+protected:
+	PatchCoord *patch_coords_;
+	int num_patch_coords_;
+};
+
+/* Helper class to wrap memory owned by the caller into a buffer,
+ * evaluation results are written directly into it.
+ */
+class RawDataWrapperBuffer {
+public:
+	RawDataWrapperBuffer(float *data)
+	        : data_(data) {
+	}
+	float *BindCpuBuffer() {
+		return data_;
+	}
+protected:
+	float *data_;
+};
+
 /* Helper class which is aimed to be used in cases when buffer
  * is small enough and better to be allocated in stack rather
  * than in heap.
@@ -142,14 +181,17 @@ protected:
 
 /* Volatile evaluator which can be used from threads.
  *
- * TODO(sergey): Make it possible to evaluate coordinates in chuncks.
+ * Stencils are evaluated with STENCIL_EVALUATOR, which could differ from the
+ * patch evaluator: refinement processes all the vertices at once, while the
+ * patches are evaluated in small batches from the caller's own threads.
  */
 template<typename SRC_VERTEX_BUFFER,
          typename EVAL_VERTEX_BUFFER,
          typename STENCIL_TABLE,
          typename PATCH_TABLE,
          typename EVALUATOR,
-         typename DEVICE_CONTEXT = void>
+         typename DEVICE_CONTEXT = void,
+         typename STENCIL_EVALUATOR = EVALUATOR>
 class VolatileEvalOutput {
 public:
 	typedef OpenSubdiv::Osd::EvaluatorCacheT<EVALUATOR> EvaluatorCache;
@@ -205,31 +247,21 @@ public:
 		BufferDescriptor dst_desc = src_desc_;
 		dst_desc.offset += num_coarse_verts_ * src_desc_.stride;
 
-		const EVALUATOR *eval_instance =
-		        OpenSubdiv::Osd::GetEvaluator<EVALUATOR>(evaluator_cache_,
-		                                                 src_desc_,
-		                                                 dst_desc,
-		                                                 device_context_);
-
-		EVALUATOR::EvalStencils(src_data_, src_desc_,
-		                        src_data_, dst_desc,
-		                        vertex_stencils_,
-		                        eval_instance,
-		                        device_context_);
+		/* Only CPU side evaluators are used here, they don't need an instance. */
+		STENCIL_EVALUATOR::EvalStencils(src_data_, src_desc_,
+		                                src_data_, dst_desc,
+		                                vertex_stencils_,
+		                                (const STENCIL_EVALUATOR *)NULL,
+		                                device_context_);
 
 		dst_desc = src_varying_desc_;
 		dst_desc.offset += num_coarse_verts_ * src_varying_desc_.stride;
-		eval_instance =
-		        OpenSubdiv::Osd::GetEvaluator<EVALUATOR>(evaluator_cache_,
-		                                                 src_varying_desc_,
-		                                                 dst_desc,
-		                                                 device_context_);
 
-		EVALUATOR::EvalStencils(src_varying_data_, src_varying_desc_,
-		                        src_varying_data_, dst_desc,
-		                        varying_stencils_,
-		                        eval_instance,
-		                        device_context_);
+		STENCIL_EVALUATOR::EvalStencils(src_varying_data_, src_varying_desc_,
+		                                src_varying_data_, dst_desc,
+		                                varying_stencils_,
+		                                (const STENCIL_EVALUATOR *)NULL,
+		                                device_context_);
 	}
 
 	void EvalPatchCoord(PatchCoord& patch_coord, float P[3])
@@ -288,6 +320,51 @@ public:
 		}
 	}
 
+	/* Evaluate limit positions of multiple coordinates at once, derivatives
+	 * are either both requested or none of them.
+	 */
+	void EvalPatchCoords(PatchCoord *patch_coords,
+	                     int num_patch_coords,
+	                     float *P,
+	                     float *dPdu,
+	                     float *dPdv)
+	{
+		RawDataWrapperBuffer P_data(P);
+		BufferDescriptor P_desc(0, 3, 3);
+		PatchCoordArrayBuffer patch_coord_buffer(patch_coords, num_patch_coords);
+		if (dPdu != NULL && dPdv != NULL) {
+			RawDataWrapperBuffer dPdu_data(dPdu), dPdv_data(dPdv);
+			BufferDescriptor du_desc(0, 3, 3),
+			                 dv_desc(0, 3, 3);
+			const EVALUATOR *eval_instance =
+			        OpenSubdiv::Osd::GetEvaluator<EVALUATOR>(evaluator_cache_,
+			                                                 src_desc_,
+			                                                 P_desc,
+			                                                 du_desc,
+			                                                 dv_desc,
+			                                                 device_context_);
+			EVALUATOR::EvalPatches(src_data_, src_desc_,
+			                       &P_data, P_desc,
+			                       &dPdu_data, du_desc,
+			                       &dPdv_data, dv_desc,
+			                       patch_coord_buffer.GetNumVertices(),
+			                       &patch_coord_buffer,
+			                       patch_table_, eval_instance, device_context_);
+		}
+		else {
+			const EVALUATOR *eval_instance =
+			        OpenSubdiv::Osd::GetEvaluator<EVALUATOR>(evaluator_cache_,
+			                                                 src_desc_,
+			                                                 P_desc,
+			                                                 device_context_);
+			EVALUATOR::EvalPatches(src_data_, src_desc_,
+			                       &P_data, P_desc,
+			                       patch_coord_buffer.GetNumVertices(),
+			                       &patch_coord_buffer,
+			                       patch_table_, eval_instance, device_context_);
+		}
+	}
+
 	void EvalPatchVarying(PatchCoord& patch_coord,
 	                      float varying[3]) {
 		StackAllocatedBuffer<3, 1> varying_data;
@@ -325,11 +402,22 @@ private:
 
 }  /* namespace */
 
+/* Refinement goes over all the vertices, use OpenMP for it when OpenSubdiv
+ * has it. Patches are evaluated per face from Blender's task pool threads.
+ */
+#ifdef OPENSUBDIV_HAS_OPENMP
+typedef OpenSubdiv::Osd::OmpEvaluator CpuStencilEvaluator;
+#else
+typedef OpenSubdiv::Osd::CpuEvaluator CpuStencilEvaluator;
+#endif
+
 typedef VolatileEvalOutput<OpenSubdiv::Osd::CpuVertexBuffer,
                            OpenSubdiv::Osd::CpuVertexBuffer,
                            OpenSubdiv::Far::StencilTable,
                            OpenSubdiv::Osd::CpuPatchTable,
-                           OpenSubdiv::Osd::CpuEvaluator> CpuEvalOutput;
+                           OpenSubdiv::Osd::CpuEvaluator,
+                           void,
+                           CpuStencilEvaluator> CpuEvalOutput;
 
 typedef struct OpenSubdiv_EvaluatorDescr {
 	CpuEvalOutput *eval_output;
@@ -483,6 +571,31 @@ void openSubdiv_evaluateLimit(OpenSubdiv_EvaluatorDescr *evaluator_descr,
 	}
 }
 
+void openSubdiv_evaluateLimitBatch(OpenSubdiv_EvaluatorDescr *evaluator_descr,
+                                   int osd_face_index,
+                                   const float *face_uv,
+                                   int num_coords,
+                                   float *P,
+                                   float *dPdu,
+                                   float *dPdv)
+{
+	std::vector<PatchCoord> patch_coords;
+	patch_coords.reserve(num_coords);
+	for (int i = 0; i < num_coords; i++) {
+		const float face_u = face_uv[i * 2 + 0],
+		            face_v = face_uv[i * 2 + 1];
+		assert((face_u >= 0.0f) && (face_u <= 1.0f) && (face_v >= 0.0f) && (face_v <= 1.0f));
+		const PatchTable::PatchHandle *handle =
+		        evaluator_descr->patch_map->FindPatch(osd_face_index, face_u, face_v);
+		patch_coords.push_back(PatchCoord(*handle, face_u, face_v));
+	}
+	evaluator_descr->eval_output->EvalPatchCoords(&patch_coords[0],
+	                                              num_coords,
+	                                              P,
+	                                              dPdu,
+	                                              dPdv);
+}
+
 void openSubdiv_evaluateVarying(OpenSubdiv_EvaluatorDescr *evaluator_descr,
                                int osd_face_index,
                                float face_u, float face_v,
@@ -163,6 +163,7 @@ class DATA_PT_modifiers(ModifierButtonsPanel, Panel):
         col.label(text="Object:")
         col.prop(md, "object", text="")
 
+        layout.row().prop(md, "solver", expand=True)
         layout.prop(md, "double_threshold")
 
         if bpy.app.debug:
@@ -315,6 +316,9 @@ class DATA_PT_modifiers(ModifierButtonsPanel, Panel):
             row = col.split(percentage=0.75)
             row.prop(md, "use_symmetry")
             row.prop(md, "symmetry_axis", text="")
+            sub = col.row()
+            sub.active = not md.use_symmetry
+            sub.prop(md, "use_fast")
 
         elif decimate_type == 'UNSUBDIV':
             layout.prop(md, "iterations")
@@ -982,6 +986,8 @@ class DATA_PT_modifiers(ModifierButtonsPanel, Panel):
         col.prop(md, "show_only_control_edges")
         if hasattr(md, "use_opensubdiv"):
             col.prop(md, "use_opensubdiv")
+        if hasattr(md, "use_opensubdiv_cpu"):
+            col.prop(md, "use_opensubdiv_cpu")
 
         if show_adaptive_options and ob.cycles.use_adaptive_subdivision:
             col = layout.column(align=True)
@@ -384,6 +384,7 @@ class PARTICLE_PT_hair_dynamics(ParticleButtonsPanel, Panel):
         col = split.column()
         col.label(text="Quality:")
         col.prop(cloth, "quality", text="Steps", slider=True)
+        col.prop(cloth, "use_parallel_solver", text="Parallel Solver")
 
         row = col.row()
         row.prop(psys.settings, "show_hair_grid", text="HairGrid")
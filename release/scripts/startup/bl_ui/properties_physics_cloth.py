@@ -73,7 +73,9 @@ class PHYSICS_PT_cloth(PhysicButtonsPanel, Panel):
         split = layout.split(percentage=0.25)
 
         split.label(text="Quality:")
-        split.prop(cloth, "quality", text="Steps")
+        row = split.row()
+        row.prop(cloth, "quality", text="Steps")
+        row.prop(cloth, "use_parallel_solver", text="Parallel")
 
         split = layout.split(percentage=0.25)
 
@@ -1170,6 +1170,10 @@ class SEQUENCER_PT_view(SequencerButtonsPanel_Output, Panel):
         col.separator()
         col.prop(st, "proxy_render_size")
 
+        ed = context.scene.sequence_editor
+        if ed:
+            col.prop(ed, "use_cache_disk")
+
 
 class SEQUENCER_PT_view_safe_areas(SequencerButtonsPanel_Output, Panel):
     bl_label = "Safe Areas"
@@ -365,6 +365,10 @@ class USERPREF_PT_edit(Panel):
         col.prop(edit, "use_global_undo")
         col.prop(edit, "undo_steps", text="Steps")
         col.prop(edit, "undo_memory_limit", text="Memory Limit")
+        col.prop(edit, "use_sculpt_undo_pack")
+        sub = col.column()
+        sub.active = edit.use_sculpt_undo_pack
+        sub.prop(edit, "sculpt_undo_memory_limit", text="Sculpt Memory Limit")
 
         row.separator()
         row.separator()
@@ -558,9 +562,18 @@ class USERPREF_PT_system(Panel):
         col.separator()
 
         col.label(text="Sequencer/Clip Editor:")
-        # currently disabled in the code
-        # col.prop(system, "prefetch_frames")
+        col.prop(system, "prefetch_frames")
         col.prop(system, "memory_cache_limit")
+        col.prop(system, "sequencer_disk_cache_size_limit")
+        col.prop(system, "sequencer_disk_cache_compression")
+
+        col.separator()
+
+        col.label(text="Modifiers:")
+        col.prop(system, "use_modifier_cache")
+        sub = col.column()
+        sub.active = system.use_modifier_cache
+        sub.prop(system, "modifier_cache_limit")
 
         # 3. Column
         column = split.column()
@@ -1011,6 +1024,7 @@ class USERPREF_PT_file(Panel):
         sub.label(text="Sounds:")
         sub.label(text="Temp:")
         sub.label(text="Render Cache:")
+        sub.label(text="Sequencer Cache:")
         sub.label(text="I18n Branches:")
         sub.label(text="Image Editor:")
         sub.label(text="Animation Player:")
@@ -1023,6 +1037,7 @@ class USERPREF_PT_file(Panel):
         sub.prop(paths, "sound_directory", text="")
         sub.prop(paths, "temporary_directory", text="")
         sub.prop(paths, "render_cache_directory", text="")
+        sub.prop(paths, "sequencer_disk_cache_directory", text="")
         sub.prop(paths, "i18n_branches_directory", text="")
         sub.prop(paths, "image_editor", text="")
         subsplit = sub.split(percentage=0.3)
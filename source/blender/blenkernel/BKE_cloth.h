@@ -169,6 +169,7 @@ typedef enum {
 	CLOTH_SIMSETTINGS_FLAG_NO_SPRING_COMPRESS = (1 << 13), /* don't allow spring compression */
 	CLOTH_SIMSETTINGS_FLAG_SEW = (1 << 14), /* pull ends of loose edges together */
 	CLOTH_SIMSETTINGS_FLAG_DYNAMIC_BASEMESH = (1 << 15), /* make simulation respect deformations in the base object */
+	CLOTH_SIMSETTINGS_FLAG_PARALLEL_SOLVER = (1 << 16), /* solve with the multi-threaded block-CSR solver */
 } CLOTH_SIMSETTINGS_FLAGS;
 
 /* COLLISION FLAGS */
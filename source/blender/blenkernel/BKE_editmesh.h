@@ -83,6 +83,7 @@ typedef struct BMEditMesh {
 
 /* editmesh.c */
 void        BKE_editmesh_tessface_calc(BMEditMesh *em);
+void        BKE_editmesh_tessface_calc_with_partial(BMEditMesh *em, const struct BMPartialUpdate *bmpinfo);
 BMEditMesh *BKE_editmesh_create(BMesh *bm, const bool do_tessellate);
 BMEditMesh *BKE_editmesh_copy(BMEditMesh *em);
 BMEditMesh *BKE_editmesh_from_object(struct Object *ob);
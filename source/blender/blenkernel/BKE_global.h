@@ -144,10 +144,12 @@ enum {
 	G_DEBUG_GPU =       (1 << 16), /* gpu debug */
 	G_DEBUG_IO = (1 << 17),   /* IO Debugging (for Collada, ...)*/
 	G_DEBUG_GPU_SHADERS = (1 << 18),   /* GLSL shaders */
+	G_DEBUG_MODIFIER_CACHE = (1 << 19),   /* modifier stack cache hits in the viewport */
 };
 
 #define G_DEBUG_ALL  (G_DEBUG | G_DEBUG_FFMPEG | G_DEBUG_PYTHON | G_DEBUG_EVENTS | G_DEBUG_WM | G_DEBUG_JOBS | \
-                      G_DEBUG_FREESTYLE | G_DEBUG_DEPSGRAPH | G_DEBUG_GPU_MEM | G_DEBUG_IO | G_DEBUG_GPU_SHADERS)
+                      G_DEBUG_FREESTYLE | G_DEBUG_DEPSGRAPH | G_DEBUG_GPU_MEM | G_DEBUG_IO | G_DEBUG_GPU_SHADERS | \
+                      G_DEBUG_MODIFIER_CACHE)
 
 
 /* G.fileflags */
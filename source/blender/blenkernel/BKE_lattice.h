@@ -43,6 +43,8 @@ struct Scene;
 struct DerivedMesh;
 struct BPoint;
 struct MDeformVert;
+struct ArmatureDeformWeights;
+struct ID;
 
 void BKE_lattice_resize(struct Lattice *lt, int u, int v, int w, struct Object *ltOb);
 void BKE_lattice_init(struct Lattice *lt);
@@ -73,7 +75,9 @@ void lattice_deform_verts(struct Object *laOb, struct Object *target,
 void armature_deform_verts(struct Object *armOb, struct Object *target,
                            struct DerivedMesh *dm, float (*vertexCos)[3],
                            float (*defMats)[3][3], int numVerts, int deformflag,
-                           float (*prevCos)[3], const char *defgrp_name);
+                           float (*prevCos)[3], const char *defgrp_name,
+                           struct ArmatureDeformWeights **weights_cache);
+void armature_deform_weights_free(struct ArmatureDeformWeights *weights);
 
 float (*BKE_lattice_vertexcos_get(struct Object *ob, int *r_numVerts))[3];
 void    BKE_lattice_vertexcos_apply(struct Object *ob, float (*vertexCos)[3]);
@@ -180,6 +180,10 @@ void BKE_mesh_calc_normals_poly(
         const struct MLoop *mloop, const struct MPoly *mpolys,
         int numLoops, int numPolys, float (*r_polyNors)[3],
         const bool only_face_normals);
+void BKE_mesh_calc_normals_poly_cos(
+        const float (*vert_cos)[3], float (*r_vertnors)[3], int numVerts,
+        const struct MLoop *mloop, const struct MPoly *mpolys,
+        int numLoops, int numPolys);
 void BKE_mesh_calc_normals(struct Mesh *me);
 void BKE_mesh_calc_normals_tessface(
         struct MVert *mverts, int numVerts,
@@ -0,0 +1,79 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __BKE_MODIFIER_CACHE_H__
+#define __BKE_MODIFIER_CACHE_H__
+
+/** \file BKE_modifier_cache.h
+ *  \ingroup bke
+ *
+ * Cache of intermediate modifier stack results, so evaluation of a mesh
+ * object can resume after the last modifier whose input and settings did
+ * not change since the previous evaluation.
+ */
+
+#include "DNA_listBase.h"
+
+#include "BKE_customdata.h"
+
+struct DerivedMesh;
+struct Mesh;
+struct ModifierCacheEval;
+struct ModifierData;
+struct Object;
+
+typedef struct ModifierStackCache {
+	struct ModifierStackCache *next, *prev;
+
+	ListBase entries;  /* ModifierCacheEntry */
+
+	/* Bumped every time the object data is evaluated, so objects using
+	 * this one (boolean operands, shrinkwrap targets, ...) notice changes. */
+	unsigned int eval_count;
+
+	/* Statistics of the last evaluation, for the debug overlay. */
+	int steps_total;
+	int steps_reused;
+	size_t mem_in_use;
+} ModifierStackCache;
+
+void BKE_modifier_cache_free(struct Object *ob);
+void BKE_modifier_cache_clear(struct Object *ob);
+void BKE_modifier_cache_tag_evaluated(struct Object *ob);
+size_t BKE_modifier_cache_mem_in_use(void);
+
+/* Evaluation, see mesh_calc_modifiers(). */
+struct ModifierCacheEval *BKE_modifier_cache_eval_begin(
+        struct Object *ob, struct Mesh *me, const float (*vertexCos)[3], int numVerts,
+        CustomDataMask dataMask, int app_flags, bool need_mapping, bool build_shapekey_layers);
+void BKE_modifier_cache_eval_step(
+        struct ModifierCacheEval *ce, struct ModifierData *md,
+        CustomDataMask mask, CustomDataMask nextmask, bool is_constructive);
+struct ModifierData *BKE_modifier_cache_eval_restore(
+        struct ModifierCacheEval *ce,
+        struct DerivedMesh **r_dm, struct DerivedMesh **r_orcodm, struct DerivedMesh **r_clothorcodm,
+        CustomDataMask *r_append_mask);
+void BKE_modifier_cache_eval_store(
+        struct ModifierCacheEval *ce, struct ModifierData *md,
+        struct DerivedMesh *dm, struct DerivedMesh *orcodm, struct DerivedMesh *clothorcodm,
+        CustomDataMask append_mask);
+void BKE_modifier_cache_eval_end(struct ModifierCacheEval *ce);
+
+#endif  /* __BKE_MODIFIER_CACHE_H__ */
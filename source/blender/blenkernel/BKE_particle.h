@@ -104,6 +104,13 @@ typedef struct SPHData {
 	/* Integrator callbacks. This allows different SPH implementations. */
 	void (*force_cb) (void *sphdata_v, ParticleKey *state, float *force, float *impulse);
 	void (*density_cb) (void *rangedata_v, int index, const float co[3], float squared_dist);
+
+	/* Neighbor search grids, one per system in psys. */
+	struct SPHGrid *grid[10];
+
+	/* Viscoelastic springs created during a step, owned by the thread using this copy. */
+	struct ParticleSpring *new_springs;
+	int tot_new_springs, alloc_new_springs;
 } SPHData;
 
 typedef struct ParticleTexture {
@@ -363,6 +370,13 @@ void psys_sph_init(struct ParticleSimulationData *sim, struct SPHData *sphdata);
 void psys_sph_finalise(struct SPHData *sphdata);
 void psys_sph_density(struct BVHTree *tree, struct SPHData *data, float co[3], float vars[2]);
 
+/* SPH neighbor search grid */
+struct SPHGrid *psys_sph_grid_build(struct ParticleSystem *psys, float cell_size, float cfra);
+void psys_sph_grid_free(struct SPHGrid *grid);
+void psys_sph_grid_range_query(
+        const struct SPHGrid *grid, const float co[3], float radius,
+        void (*callback)(void *userdata, int index, const float co[3], float dist_sq), void *userdata);
+
 /* for anim.c */
 void psys_get_dupli_texture(struct ParticleSystem *psys, struct ParticleSettings *part,
                             struct ParticleSystemModifierData *psmd, struct ParticleData *pa, struct ChildParticle *cpa,
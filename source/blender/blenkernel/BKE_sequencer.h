@@ -102,6 +102,7 @@ typedef struct SeqRenderData {
 	float motion_blur_shutter;
 	bool skip_cache;
 	bool is_proxy_render;
+	bool is_prefetch_render;
 	int view_id;
 
 	/* special case for OpenGL render */
@@ -187,10 +188,22 @@ struct SeqEffectHandle {
  * ********************************************************************** */
 
 struct ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int chanshown);
-struct ImBuf *BKE_sequencer_give_ibuf_threaded(const SeqRenderData *context, float cfra, int chanshown);
 struct ImBuf *BKE_sequencer_give_ibuf_direct(const SeqRenderData *context, float cfra, struct Sequence *seq);
 struct ImBuf *BKE_sequencer_give_ibuf_seqbase(const SeqRenderData *context, float cfra, int chan_shown, struct ListBase *seqbasep);
-void BKE_sequencer_give_ibuf_prefetch_request(const SeqRenderData *context, float cfra, int chan_shown);
+
+/* **********************************************************************
+ * seqprefetch.c
+ *
+ * background rendering of frames ahead of the playhead
+ * ********************************************************************** */
+
+void BKE_sequencer_prefetch_start(const SeqRenderData *context, float cfra, int chanshown);
+void BKE_sequencer_prefetch_stop(void);
+bool BKE_sequencer_prefetch_is_running(void);
+void BKE_sequencer_prefetch_lock(void);
+void BKE_sequencer_prefetch_unlock(void);
+struct Sequence *BKE_sequencer_prefetch_get_original_sequence(const SeqRenderData *context, struct Sequence *seq);
+struct Scene *BKE_sequencer_prefetch_get_original_scene(const SeqRenderData *context);
 
 /* **********************************************************************
  * sequencer.c
@@ -207,6 +220,7 @@ void BKE_sequencer_pixel_from_sequencer_space_v4(struct Scene *scene, float pixe
  * ********************************************************************** */
 struct Editing  *BKE_sequencer_editing_get(struct Scene *scene, bool alloc);
 struct Editing  *BKE_sequencer_editing_ensure(struct Scene *scene);
+void             BKE_sequencer_editing_free_ex(struct Scene *scene, const bool do_cache, const bool do_id_user);
 void             BKE_sequencer_editing_free(struct Scene *scene, const bool do_id_user);
 
 void             BKE_sequencer_sort(struct Scene *scene);
@@ -251,6 +265,7 @@ bool BKE_sequencer_input_have_to_preprocess(const SeqRenderData *context, struct
 
 void BKE_sequencer_proxy_rebuild_context(struct Main *bmain, struct Scene *scene, struct Sequence *seq, struct GSet *file_list, ListBase *queue);
 void BKE_sequencer_proxy_rebuild(struct SeqIndexBuildContext *context, short *stop, short *do_update, float *progress);
+void BKE_sequencer_proxy_rebuild_queue(ListBase *queue, short *stop, short *do_update, float *progress);
 void BKE_sequencer_proxy_rebuild_finish(struct SeqIndexBuildContext *context, bool stop);
 
 void BKE_sequencer_proxy_set(struct Sequence *seq, bool value);
@@ -396,11 +411,13 @@ typedef struct SeqLoadInfo {
 #define SEQ_DUPE_CONTEXT        (1 << 1)
 #define SEQ_DUPE_ANIM           (1 << 2)
 #define SEQ_DUPE_ALL            (1 << 3) /* otherwise only selected are copied */
+#define SEQ_DUPE_NO_SOUND       (1 << 4) /* don't add sounds to the destination scene's sound scene */
 
 /* use as an api function */
 typedef struct Sequence *(*SeqLoadFunc)(struct bContext *, ListBase *, struct SeqLoadInfo *);
 
 struct Sequence *BKE_sequence_alloc(ListBase *lb, int cfra, int machine);
+void BKE_sequence_cache_id_init(struct Sequence *seq);
 
 void BKE_sequence_alpha_mode_from_extension(struct Sequence *seq);
 void BKE_sequence_init_colorspace(struct Sequence *seq);
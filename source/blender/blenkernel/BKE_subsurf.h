@@ -72,6 +72,8 @@ struct DerivedMesh *subsurf_make_derived_from_derived(
 
 void subsurf_calculate_limit_positions(struct Mesh *me, float (*r_positions)[3]);
 
+void subsurf_free_render_cache(struct SubsurfModifierData *smd);
+
 /* get gridsize from 'level', level must be greater than zero */
 int BKE_ccg_gridsize(int level);
 
@@ -106,6 +108,8 @@ typedef struct CCGDerivedMesh {
 
 	struct CCGSubSurf *ss;
 	int freeSS;
+	/* ss was taken from the renderCache of this modifier, it's given back on release */
+	struct SubsurfModifierData *render_cache_smd;
 	int drawInteriorEdges, useSubsurfUv, useGpuBackend;
 
 	struct {int startVert; struct CCGVert *vert; } *vertMap;
@@ -140,6 +144,10 @@ typedef struct CCGDerivedMesh {
 
 		struct Object *ob;
 		MultiresModifiedFlags modified_flags;
+
+		/* Bitmap of base faces whose grids were changed through the PBVH,
+		 * used to only recalculate their displacements, NULL when unknown. */
+		unsigned int *modified_polys;
 	} multires;
 
 	struct EdgeHash *ehash;
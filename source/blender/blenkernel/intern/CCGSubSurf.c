@@ -312,6 +312,7 @@ CCGSubSurf *ccgSubSurf_new(CCGMeshIFC *ifc, int subdivLevels, CCGAllocatorIFC *a
 		ss->osd_coarse_coords_invalid = false;
 		ss->osd_vao = 0;
 		ss->skip_grids = false;
+		ss->osd_use_evaluator = false;
 		ss->osd_compute = 0;
 		ss->osd_next_face_ptex_index = 0;
 		ss->osd_coarse_coords = NULL;
@@ -850,7 +851,7 @@ CCGError ccgSubSurf_syncFace(CCGSubSurf *ss, CCGFaceHDL fHDL, int numVerts, CCGV
 static void ccgSubSurf__sync(CCGSubSurf *ss)
 {
 #ifdef WITH_OPENSUBDIV
-	if (ss->skip_grids) {
+	if (ss->skip_grids || ss->osd_use_evaluator) {
 		ccgSubSurf__sync_opensubdiv(ss);
 	}
 	else
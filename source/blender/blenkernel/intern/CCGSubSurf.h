@@ -230,6 +230,13 @@ int ccgSubSurf_getNumGLMeshBaseFaceVerts(CCGSubSurf *ss, int face);
 void ccgSubSurf_setSkipGrids(CCGSubSurf *ss, bool skip_grids);
 bool ccgSubSurf_needGrids(CCGSubSurf *ss);
 
+/* Fill in CCG grids with the limit surface evaluated by OpenSubdiv on CPU
+ * instead of the regular subdivision. Evaluator is kept until topology
+ * changes, see ccgSubSurf_checkTopologyChanged().
+ */
+void ccgSubSurf_setUseOpenSubdivEvaluator(CCGSubSurf *ss, bool use_evaluator);
+bool ccgSubSurf_getUseOpenSubdivEvaluator(const CCGSubSurf *ss);
+
 /* Set evaluator's face varying data from UV coordinates.
  * Used for CPU evaluation.
  */
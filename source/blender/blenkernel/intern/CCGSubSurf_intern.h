@@ -248,6 +248,10 @@ struct CCGSubSurf {
 
 	/* ** CPU backend. ** */
 
+	/* Evaluate CCG grids from the limit surface rather than with legacy
+	 * subdivision.
+	 */
+	bool osd_use_evaluator;
 	/* Limit evaluator, used to evaluate CCG. */
 	struct OpenSubdiv_EvaluatorDescr *osd_evaluator;
 	/* Next PTex face index, used while CCG synchronization
@@ -30,6 +30,7 @@
 #include "BLI_utildefines.h" /* for BLI_assert */
 #include "BLI_listbase.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "CCGSubSurf.h"
@@ -111,8 +112,11 @@ static bool compare_ccg_derivedmesh_topology(CCGSubSurf *ss, DerivedMesh *dm)
 		}
 	}
 
-	/* TODO(sergey): Crease topology changes detection. */
+	/* Check for crease changes, using same crease conversion as the sync
+	 * from derived mesh does.
+	 */
 	{
+		const float crease_factor = (float)ss->subdivLevels;
 		CCGEdgeIterator ccg_edge_iter;
 		for (ccgSubSurf_initEdgeIterator(ss, &ccg_edge_iter);
 		     !ccgEdgeIterator_isStopped(&ccg_edge_iter);
@@ -120,7 +124,10 @@ static bool compare_ccg_derivedmesh_topology(CCGSubSurf *ss, DerivedMesh *dm)
 		{
 			/* const */ CCGEdge *ccg_edge = ccgEdgeIterator_getCurrent(&ccg_edge_iter);
 			const int edge_index = POINTER_AS_INT(ccgSubSurf_getEdgeEdgeHandle(ccg_edge));
-			if (ccg_edge->crease != medge[edge_index].crease) {
+			const float crease = ss->meshIFC.simpleSubdiv ?
+			        crease_factor :
+			        medge[edge_index].crease * crease_factor / 255.0f;
+			if (ccg_edge->crease != crease) {
 				return false;
 			}
 		}
@@ -355,6 +362,16 @@ bool ccgSubSurf_needGrids(CCGSubSurf *ss)
 	return ss->skip_grids == false;
 }
 
+void ccgSubSurf_setUseOpenSubdivEvaluator(CCGSubSurf *ss, bool use_evaluator)
+{
+	ss->osd_use_evaluator = use_evaluator;
+}
+
+bool ccgSubSurf_getUseOpenSubdivEvaluator(const CCGSubSurf *ss)
+{
+	return ss->osd_use_evaluator;
+}
+
 BLI_INLINE void ccgSubSurf__mapGridToFace(int S, float grid_u, float grid_v,
                                           float *face_u, float *face_v)
 {
@@ -447,6 +464,28 @@ void ccgSubSurf_evaluatorFVarUV(CCGSubSurf *ss,
 	zero_v2(uv);
 }
 
+static bool opensubdiv_hasLooseGeometry(CCGSubSurf *ss)
+{
+	int i;
+	for (i = 0; i < ss->vMap->curSize; i++) {
+		CCGVert *v = (CCGVert *) ss->vMap->buckets[i];
+		for (; v; v = v->next) {
+			if (v->numFaces == 0) {
+				return true;
+			}
+		}
+	}
+	for (i = 0; i < ss->eMap->curSize; i++) {
+		CCGEdge *e = (CCGEdge *) ss->eMap->buckets[i];
+		for (; e; e = e->next) {
+			if (e->numFaces == 0) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
 static bool opensubdiv_createEvaluator(CCGSubSurf *ss)
 {
 	OpenSubdiv_Converter converter;
@@ -455,6 +494,12 @@ static bool opensubdiv_createEvaluator(CCGSubSurf *ss)
 		/* OpenSubdiv doesn't support meshes without faces. */
 		return false;
 	}
+	if (ss->skip_grids == false && opensubdiv_hasLooseGeometry(ss)) {
+		/* Only face grids are evaluated from the limit surface, loose
+		 * edges and vertices are left to the legacy subdivision.
+		 */
+		return false;
+	}
 	ccgSubSurf_converter_setup_from_ccg(ss, &converter);
 	topology_refiner = openSubdiv_createTopologyRefinerDescr(&converter);
 	ccgSubSurf_converter_free(&converter);
@@ -524,9 +569,91 @@ static void opensubdiv_updateEvaluatorCoarsePositions(CCGSubSurf *ss)
 	MEM_freeN(positions);
 }
 
+/* Evaluate limit surface into a single grid of the face, all the grid points
+ * belong to the same PTex face so they're passed to the evaluator at once.
+ *
+ * Vertices shared with other faces are only written by their first face, so
+ * faces can be evaluated from multiple threads.
+ */
+static void opensubdiv_evaluateFaceGrid(CCGSubSurf *ss,
+                                        CCGFace *face,
+                                        const int S,
+                                        const int osd_face_index,
+                                        float (*face_uv)[2],
+                                        float (*P)[3],
+                                        float (*dPdu)[3],
+                                        float (*dPdv)[3])
+{
+	int normalDataOffset = ss->normalDataOffset;
+	int subdivLevels = ss->subdivLevels;
+	int gridSize = ccg_gridsize(subdivLevels);
+	int vertDataSize = ss->meshIFC.vertDataSize;
+	bool do_normals = ss->meshIFC.numLayers == 3;
+	CCGVert *corner_vert = FACE_getVerts(face)[S];
+	int x, y, index;
+
+	openSubdiv_evaluateLimitBatch(ss->osd_evaluator, osd_face_index,
+	                              &face_uv[0][0], gridSize * gridSize,
+	                              &P[0][0],
+	                              do_normals ? &dPdu[0][0] : NULL,
+	                              do_normals ? &dPdv[0][0] : NULL);
+
+	for (x = 0, index = 0; x < gridSize; x++) {
+		for (y = 0; y < gridSize; y++, index++) {
+			float *co = FACE_getIFCo(face, subdivLevels, S, x, y);
+			float *no = FACE_getIFNo(face, subdivLevels, S, x, y);
+
+			OSD_LOG("face=%d, corner=%d, u=%f, v=%f, P=(%f, %f, %f)\n",
+			        osd_face_index, S, face_uv[index][0], face_uv[index][1],
+			        P[index][0], P[index][1], P[index][2]);
+
+			VertDataCopy(co, P[index], ss);
+			if (do_normals) {
+				cross_v3_v3v3(no, dPdu[index], dPdv[index]);
+				normalize_v3(no);
+			}
+
+			if (x == gridSize - 1 && y == gridSize - 1 && corner_vert->faces[0] == face) {
+				float *vert_co = VERT_getCo(corner_vert, subdivLevels);
+				VertDataCopy(vert_co, co, ss);
+				if (do_normals) {
+					float *vert_no = VERT_getNo(corner_vert, subdivLevels);
+					VertDataCopy(vert_no, no, ss);
+				}
+			}
+			if (S == 0 && x == 0 && y == 0) {
+				float *center_co = (float *)FACE_getCenterData(face);
+				VertDataCopy(center_co, co, ss);
+				if (do_normals) {
+					float *center_no = (float *)((byte *)FACE_getCenterData(face) + normalDataOffset);
+					VertDataCopy(center_no, no, ss);
+				}
+			}
+		}
+	}
+
+	for (x = 0; x < gridSize; x++) {
+		VertDataCopy(FACE_getIECo(face, subdivLevels, S, x),
+		             FACE_getIFCo(face, subdivLevels, S, x, 0), ss);
+		if (do_normals) {
+			VertDataCopy(FACE_getIENo(face, subdivLevels, S, x),
+			             FACE_getIFNo(face, subdivLevels, S, x, 0), ss);
+		}
+	}
+}
+
+/* Per-thread storage for evaluation of a grid. */
+typedef struct OpenSubdivGridBuffers {
+	float (*face_uv)[2];
+	float (*P)[3];
+	float (*dPdu)[3];
+	float (*dPdv)[3];
+} OpenSubdivGridBuffers;
+
 static void opensubdiv_evaluateQuadFaceGrids(CCGSubSurf *ss,
                                              CCGFace *face,
-                                             const int osd_face_index)
+                                             const int osd_face_index,
+                                             OpenSubdivGridBuffers *buffers)
 {
 	int normalDataOffset = ss->normalDataOffset;
 	int subdivLevels = ss->subdivLevels;
@@ -536,66 +663,25 @@ static void opensubdiv_evaluateQuadFaceGrids(CCGSubSurf *ss,
 	int S;
 	bool do_normals = ss->meshIFC.numLayers == 3;
 
-#pragma omp parallel for
 	for (S = 0; S < face->numVerts; S++) {
-		int x, y, k;
+		int x, y, k, index;
 		CCGEdge *edge = NULL;
-		bool inverse_edge;
+		bool inverse_edge = false;
 
-		for (x = 0; x < gridSize; x++) {
-			for (y = 0; y < gridSize; y++) {
-				float *co = FACE_getIFCo(face, subdivLevels, S, x, y);
-				float *no = FACE_getIFNo(face, subdivLevels, S, x, y);
+		for (x = 0, index = 0; x < gridSize; x++) {
+			for (y = 0; y < gridSize; y++, index++) {
 				float grid_u = (float) x / (gridSize - 1),
 				      grid_v = (float) y / (gridSize - 1);
-				float face_u, face_v;
-				float P[3], dPdu[3], dPdv[3];
-
-				ccgSubSurf__mapGridToFace(S, grid_u, grid_v, &face_u, &face_v);
 
-				/* TODO(sergey): Need proper port. */
-				openSubdiv_evaluateLimit(ss->osd_evaluator, osd_face_index,
-				                         face_u, face_v,
-				                         P,
-				                         do_normals ? dPdu : NULL,
-				                         do_normals ? dPdv : NULL);
-
-				OSD_LOG("face=%d, corner=%d, grid_u=%f, grid_v=%f, face_u=%f, face_v=%f, P=(%f, %f, %f)\n",
-				        osd_face_index, S, grid_u, grid_v, face_u, face_v, P[0], P[1], P[2]);
-
-				VertDataCopy(co, P, ss);
-				if (do_normals) {
-					cross_v3_v3v3(no, dPdu, dPdv);
-					normalize_v3(no);
-				}
-
-				if (x == gridSize - 1 && y == gridSize - 1) {
-					float *vert_co = VERT_getCo(FACE_getVerts(face)[S], subdivLevels);
-					VertDataCopy(vert_co, co, ss);
-					if (do_normals) {
-						float *vert_no = VERT_getNo(FACE_getVerts(face)[S], subdivLevels);
-						VertDataCopy(vert_no, no, ss);
-					}
-				}
-				if (S == 0 && x == 0 && y == 0) {
-					float *center_co = (float *)FACE_getCenterData(face);
-					VertDataCopy(center_co, co, ss);
-					if (do_normals) {
-						float *center_no = (float *)((byte *)FACE_getCenterData(face) + normalDataOffset);
-						VertDataCopy(center_no, no, ss);
-					}
-				}
+				ccgSubSurf__mapGridToFace(S, grid_u, grid_v,
+				                          &buffers->face_uv[index][0],
+				                          &buffers->face_uv[index][1]);
 			}
 		}
 
-		for (x = 0; x < gridSize; x++) {
-			VertDataCopy(FACE_getIECo(face, subdivLevels, S, x),
-			             FACE_getIFCo(face, subdivLevels, S, x, 0), ss);
-			if (do_normals) {
-				VertDataCopy(FACE_getIENo(face, subdivLevels, S, x),
-				             FACE_getIFNo(face, subdivLevels, S, x, 0), ss);
-			}
-		}
+		opensubdiv_evaluateFaceGrid(ss, face, S, osd_face_index,
+		                            buffers->face_uv, buffers->P,
+		                            buffers->dPdu, buffers->dPdv);
 
 		for (k = 0; k < face->numVerts; k++) {
 			CCGEdge *current_edge = FACE_getEdges(face)[k];
@@ -618,6 +704,11 @@ static void opensubdiv_evaluateQuadFaceGrids(CCGSubSurf *ss,
 
 		BLI_assert(edge != NULL);
 
+		/* Shared edges are evaluated by their first face only. */
+		if (edge->faces[0] != face) {
+			continue;
+		}
+
 		for (x = 0; x < edgeSize; x++) {
 			float u = 0, v = 0;
 			float *co = EDGE_getCo(edge, subdivLevels, x);
@@ -644,7 +735,8 @@ static void opensubdiv_evaluateQuadFaceGrids(CCGSubSurf *ss,
 
 static void opensubdiv_evaluateNGonFaceGrids(CCGSubSurf *ss,
                                              CCGFace *face,
-                                             const int osd_face_index)
+                                             const int osd_face_index,
+                                             OpenSubdivGridBuffers *buffers)
 {
 	CCGVert **all_verts = FACE_getVerts(face);
 	int normalDataOffset = ss->normalDataOffset;
@@ -684,64 +776,31 @@ static void opensubdiv_evaluateNGonFaceGrids(CCGSubSurf *ss,
 	 */
 
 	/* Evaluate face grids. */
-#pragma omp parallel for
 	for (S = 0; S < face->numVerts; S++) {
-		int x, y;
-		for (x = 0; x < gridSize; x++) {
-			for (y = 0; y < gridSize; y++) {
-				float *co = FACE_getIFCo(face, subdivLevels, S, x, y);
-				float *no = FACE_getIFNo(face, subdivLevels, S, x, y);
-				float u = 1.0f - (float) y / (gridSize - 1),
-				      v = 1.0f - (float) x / (gridSize - 1);
-				float P[3], dPdu[3], dPdv[3];
-
-				/* TODO(sergey): Need proper port. */
-				openSubdiv_evaluateLimit(ss->osd_evaluator, osd_face_index + S, u, v, P, dPdu, dPdv);
-
-				OSD_LOG("face=%d, corner=%d, u=%f, v=%f, P=(%f, %f, %f)\n",
-				        osd_face_index + S, S, u, v, P[0], P[1], P[2]);
-
-				VertDataCopy(co, P, ss);
-				if (do_normals) {
-					cross_v3_v3v3(no, dPdu, dPdv);
-					normalize_v3(no);
-				}
-
-				/* TODO(sergey): De-dpuplicate with the quad case. */
-				if (x == gridSize - 1 && y == gridSize - 1) {
-					float *vert_co = VERT_getCo(FACE_getVerts(face)[S], subdivLevels);
-					VertDataCopy(vert_co, co, ss);
-					if (do_normals) {
-						float *vert_no = VERT_getNo(FACE_getVerts(face)[S], subdivLevels);
-						VertDataCopy(vert_no, no, ss);
-					}
-				}
-				if (S == 0 && x == 0 && y == 0) {
-					float *center_co = (float *)FACE_getCenterData(face);
-					VertDataCopy(center_co, co, ss);
-					if (do_normals) {
-						float *center_no = (float *)((byte *)FACE_getCenterData(face) + normalDataOffset);
-						VertDataCopy(center_no, no, ss);
-					}
-				}
-			}
-		}
-		for (x = 0; x < gridSize; x++) {
-			VertDataCopy(FACE_getIECo(face, subdivLevels, S, x),
-			             FACE_getIFCo(face, subdivLevels, S, x, 0), ss);
-			if (do_normals) {
-				VertDataCopy(FACE_getIENo(face, subdivLevels, S, x),
-				             FACE_getIFNo(face, subdivLevels, S, x, 0), ss);
+		int x, y, index;
+		for (x = 0, index = 0; x < gridSize; x++) {
+			for (y = 0; y < gridSize; y++, index++) {
+				buffers->face_uv[index][0] = 1.0f - (float) y / (gridSize - 1);
+				buffers->face_uv[index][1] = 1.0f - (float) x / (gridSize - 1);
 			}
 		}
+
+		opensubdiv_evaluateFaceGrid(ss, face, S, osd_face_index + S,
+		                            buffers->face_uv, buffers->P,
+		                            buffers->dPdu, buffers->dPdv);
 	}
 
 	/* Evaluate edges. */
 	for (S = 0; S < face->numVerts; S++) {
 		CCGEdge *edge = FACE_getEdges(face)[S];
-		int x, S0, S1;
+		int x, S0 = 0, S1 = 0;
 		bool flip;
 
+		/* Shared edges are evaluated by their first face only. */
+		if (edge->faces[0] != face) {
+			continue;
+		}
+
 		for (x = 0; x < face->numVerts; ++x) {
 			if (all_verts[x] == edge->v0) {
 				S0 = x;
@@ -796,25 +855,82 @@ static void opensubdiv_evaluateNGonFaceGrids(CCGSubSurf *ss,
 	}
 }
 
+typedef struct OpenSubdivEvaluateGridsData {
+	CCGSubSurf *ss;
+	CCGFace **faces;
+} OpenSubdivEvaluateGridsData;
+
+static void opensubdiv_evaluateGrids_cb(
+        void *__restrict userdata,
+        const int face_index,
+        const ParallelRangeTLS *__restrict tls)
+{
+	OpenSubdivEvaluateGridsData *data = userdata;
+	OpenSubdivGridBuffers *buffers = tls->userdata_chunk;
+	CCGSubSurf *ss = data->ss;
+	CCGFace *face = data->faces[face_index];
+
+	if (buffers->face_uv == NULL) {
+		const int gridSize = ccg_gridsize(ss->subdivLevels);
+		const int grid_area = gridSize * gridSize;
+		buffers->face_uv = MEM_mallocN(sizeof(*buffers->face_uv) * grid_area, "OpenSubdiv grid uv");
+		buffers->P = MEM_mallocN(sizeof(*buffers->P) * grid_area, "OpenSubdiv grid P");
+		buffers->dPdu = MEM_mallocN(sizeof(*buffers->dPdu) * grid_area, "OpenSubdiv grid dPdu");
+		buffers->dPdv = MEM_mallocN(sizeof(*buffers->dPdv) * grid_area, "OpenSubdiv grid dPdv");
+	}
+
+	if (face->numVerts == 4) {
+		/* For quads we do special magic with converting face coords
+		 * into corner coords and interpolating grids from it.
+		 */
+		opensubdiv_evaluateQuadFaceGrids(ss, face, face->osd_index, buffers);
+	}
+	else {
+		/* NGons and tris are split into separate osd faces which
+		 * evaluates onto grids directly.
+		 */
+		opensubdiv_evaluateNGonFaceGrids(ss, face, face->osd_index, buffers);
+	}
+}
+
+static void opensubdiv_evaluateGrids_finalize(
+        void *__restrict UNUSED(userdata),
+        void *__restrict userdata_chunk)
+{
+	OpenSubdivGridBuffers *buffers = userdata_chunk;
+	if (buffers->face_uv != NULL) {
+		MEM_freeN(buffers->face_uv);
+		MEM_freeN(buffers->P);
+		MEM_freeN(buffers->dPdu);
+		MEM_freeN(buffers->dPdv);
+	}
+}
+
 static void opensubdiv_evaluateGrids(CCGSubSurf *ss)
 {
-	int i;
-	for (i = 0; i < ss->fMap->curSize; i++) {
-		CCGFace *face = (CCGFace *) ss->fMap->buckets[i];
-		for (; face; face = face->next) {
-			if (face->numVerts == 4) {
-				/* For quads we do special magic with converting face coords
-				 * into corner coords and interpolating grids from it.
-				 */
-				opensubdiv_evaluateQuadFaceGrids(ss, face, face->osd_index);
-			}
-			else {
-				/* NGons and tris are split into separate osd faces which
-				 * evaluates onto grids directly.
-				 */
-				opensubdiv_evaluateNGonFaceGrids(ss, face, face->osd_index);
-			}
-		}
+	CCGFace **faces = NULL;
+	int num_faces, free_faces;
+	OpenSubdivGridBuffers buffers = {NULL};
+	OpenSubdivEvaluateGridsData data;
+	ParallelRangeSettings settings;
+
+	ccgSubSurf__allFaces(ss, &faces, &num_faces, &free_faces);
+
+	data.ss = ss;
+	data.faces = faces;
+
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.min_iter_per_thread = CCG_TASK_LIMIT;
+	settings.userdata_chunk = &buffers;
+	settings.userdata_chunk_size = sizeof(buffers);
+	settings.func_finalize = opensubdiv_evaluateGrids_finalize;
+	BLI_task_parallel_range(0, num_faces,
+	                        &data,
+	                        opensubdiv_evaluateGrids_cb,
+	                        &settings);
+
+	if (free_faces) {
+		MEM_freeN(faces);
 	}
 }
 
@@ -890,6 +1006,12 @@ void ccgSubSurf__sync_opensubdiv(CCGSubSurf *ss)
 			/* Evaluate opensubdiv mesh into the CCG grids. */
 			opensubdiv_evaluateGrids(ss);
 		}
+		else {
+			/* Topology OpenSubdiv can't evaluate, subdivide it the
+			 * regular way.
+			 */
+			ccgSubSurf__sync_legacy(ss);
+		}
 	}
 	else {
 		BLI_assert(ss->meshIFC.numLayers == 3);
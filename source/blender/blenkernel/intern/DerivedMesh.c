@@ -58,6 +58,7 @@
 #include "BKE_library.h"
 #include "BKE_material.h"
 #include "BKE_modifier.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_mesh.h"
 #include "BKE_mesh_mapping.h"
 #include "BKE_object.h"
@@ -1744,6 +1745,50 @@ static void dm_ensure_display_normals(DerivedMesh *dm)
 	}
 }
 
+/**
+ * Add the steps mesh_calc_modifiers() is going to evaluate to the modifier cache,
+ * following the same checks, and get the last cached result to continue from.
+ */
+static ModifierData *mesh_calc_modifiers_cache_restore(
+        struct ModifierCacheEval *modcache, Scene *scene, ModifierData *md, CDMaskLink *curr,
+        const int required_mode, const bool need_mapping, CustomDataMask dataMask,
+        DerivedMesh **r_dm, DerivedMesh **r_orcodm, DerivedMesh **r_clothorcodm,
+        CustomDataMask *r_append_mask)
+{
+	bool has_dm = false;
+
+	for (; md; md = md->next, curr = curr->next) {
+		const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+		const bool is_constructive = (mti->type != eModifierTypeType_OnlyDeform);
+		CustomDataMask nextmask = 0;
+
+		md->scene = scene;
+
+		if (!modifier_isEnabled(scene, md, required_mode)) {
+			continue;
+		}
+
+		if ((mti->flags & eModifierTypeFlag_RequiresOriginalData) && has_dm) {
+			/* Also set when the modifier is skipped by resuming. */
+			modifier_setError(md, "Modifier requires original data, bad stack position");
+			continue;
+		}
+
+		if (need_mapping && !modifier_supportsMapping(md)) {
+			continue;
+		}
+
+		if (is_constructive) {
+			nextmask = curr->next ? curr->next->mask : dataMask;
+			has_dm = true;
+		}
+
+		BKE_modifier_cache_eval_step(modcache, md, curr->mask, nextmask, is_constructive);
+	}
+
+	return BKE_modifier_cache_eval_restore(modcache, r_dm, r_orcodm, r_clothorcodm, r_append_mask);
+}
+
 /**
  * new value for useDeform -1  (hack for the gameengine):
  *
@@ -1791,6 +1836,11 @@ static void mesh_calc_modifiers(
 	const bool do_loop_normals = (me->flag & ME_AUTOSMOOTH) != 0;
 	const float loop_normals_split_angle = me->smoothresh;
 
+	/* Only the viewport result of the whole stack is cached, see modifier_cache.c. */
+	const bool use_modifier_cache = (useCache && !useRenderParams && useDeform > 0 && index == -1 &&
+	                                 inputVertexCos == NULL && !sculpt_mode && !do_init_wmcol);
+	struct ModifierCacheEval *modcache = NULL;
+
 	VirtualModifierData virtualModifierData;
 
 	ModifierApplyFlag app_flags = useRenderParams ? MOD_APPLY_RENDER : 0;
@@ -1905,6 +1955,30 @@ static void mesh_calc_modifiers(
 	orcodm = NULL;
 	clothorcodm = NULL;
 
+	if (use_modifier_cache) {
+		modcache = BKE_modifier_cache_eval_begin(
+		        ob, me, (const float (*)[3])deformedVerts, numVerts,
+		        dataMask, app_flags, need_mapping, build_shapekey_layers);
+	}
+
+	if (modcache) {
+		ModifierData *md_cached = mesh_calc_modifiers_cache_restore(
+		        modcache, scene, md, curr, required_mode, need_mapping, dataMask,
+		        &dm, &orcodm, &clothorcodm, &append_mask);
+
+		if (md_cached) {
+			/* Continue after the cached result, as if it was just evaluated. */
+			MEM_SAFE_FREE(deformedVerts);
+
+			while (md != md_cached) {
+				md = md->next;
+				curr = curr->next;
+			}
+			md = md->next;
+			curr = curr->next;
+		}
+	}
+
 	for (; md; md = md->next, curr = curr->next) {
 		const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
 
@@ -2018,9 +2092,12 @@ static void mesh_calc_modifiers(
 			/* apply vertex coordinates or build a DerivedMesh as necessary */
 			if (dm) {
 				if (deformedVerts) {
-					DerivedMesh *tdm = CDDM_copy(dm);
-					dm->release(dm);
-					dm = tdm;
+					/* we own dm, a CDDM can take the positions without being copied first */
+					if (dm->type != DM_TYPE_CDDM) {
+						DerivedMesh *tdm = CDDM_copy(dm);
+						dm->release(dm);
+						dm = tdm;
+					}
 
 					CDDM_apply_vert_coords(dm, deformedVerts);
 				}
@@ -2147,6 +2224,10 @@ static void mesh_calc_modifiers(
 			}
 
 			dm->deformedOnly = false;
+
+			if (modcache) {
+				BKE_modifier_cache_eval_store(modcache, md, dm, orcodm, clothorcodm, append_mask);
+			}
 		}
 
 		isPrevDeform = (mti->type == eModifierTypeType_OnlyDeform);
@@ -2160,6 +2241,10 @@ static void mesh_calc_modifiers(
 		}
 	}
 
+	if (modcache) {
+		BKE_modifier_cache_eval_end(modcache);
+	}
+
 	for (md = firstmd; md; md = md->next)
 		modifier_freeTemporaryData(md);
 
@@ -2168,9 +2253,13 @@ static void mesh_calc_modifiers(
 	 * DerivedMesh then we need to build one.
 	 */
 	if (dm && deformedVerts) {
-		finaldm = CDDM_copy(dm);
-
-		dm->release(dm);
+		if (dm->type == DM_TYPE_CDDM) {
+			finaldm = dm;
+		}
+		else {
+			finaldm = CDDM_copy(dm);
+			dm->release(dm);
+		}
 
 		CDDM_apply_vert_coords(finaldm, deformedVerts);
 
@@ -2405,11 +2494,14 @@ static void editbmesh_calc_modifiers(
 			/* apply vertex coordinates or build a DerivedMesh as necessary */
 			if (dm) {
 				if (deformedVerts) {
-					DerivedMesh *tdm = CDDM_copy(dm);
-					if (!(r_cage && dm == *r_cage)) {
-						dm->release(dm);
+					/* the cage is kept as-is, otherwise a CDDM can take the positions directly */
+					if (dm->type != DM_TYPE_CDDM || (r_cage && dm == *r_cage)) {
+						DerivedMesh *tdm = CDDM_copy(dm);
+						if (!(r_cage && dm == *r_cage)) {
+							dm->release(dm);
+						}
+						dm = tdm;
 					}
-					dm = tdm;
 
 					CDDM_apply_vert_coords(dm, deformedVerts);
 				}
@@ -2519,10 +2611,15 @@ static void editbmesh_calc_modifiers(
 	 * then we need to build one.
 	 */
 	if (dm && deformedVerts) {
-		*r_final = CDDM_copy(dm);
+		if (dm->type == DM_TYPE_CDDM && !(r_cage && dm == *r_cage)) {
+			*r_final = dm;
+		}
+		else {
+			*r_final = CDDM_copy(dm);
 
-		if (!(r_cage && dm == *r_cage)) {
-			dm->release(dm);
+			if (!(r_cage && dm == *r_cage)) {
+				dm->release(dm);
+			}
 		}
 
 		CDDM_apply_vert_coords(*r_final, deformedVerts);
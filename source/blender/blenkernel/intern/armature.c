@@ -42,6 +42,7 @@
 #include "BLI_string.h"
 #include "BLI_ghash.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_anim_types.h"
@@ -972,22 +973,337 @@ static void armature_bbone_defmats_cb(void *userdata, Link *iter, int index)
 	}
 }
 
+/* Per-vertex bone weights stored as compressed rows (CSR), indexed by pose channel.
+ * Only weights of vertex groups that map to a deforming bone are stored, so the
+ * deform loop never has to resolve vertex group indices or names.
+ *
+ * Every Armature modifier keeps its own table between evaluations. It is only built for
+ * the weights stored in the target's own data (not those of a DerivedMesh created by
+ * previous modifiers). It is rebuilt when the weight array was re-allocated, when the
+ * target object or its data was tagged for update since (see #ID.recalc_generation), or
+ * when the vertex groups or the bones they map to changed. */
+typedef struct ArmatureDeformWeights {
+	const MDeformVert *dverts;  /* only compared, to detect re-allocated weights */
+	int dverts_tot;
+	int totvert;
+	int defbase_tot;
+	int ob_generation;
+	int data_generation;
+
+	int totweight;
+	int *defnr_to_pchan;  /* defbase_tot items, -1 for groups without a deforming bone */
+	int *vert_offset;     /* totvert + 1 items, row start of every vertex */
+	int *pchan_index;     /* totweight items */
+	float *weight;        /* totweight items */
+} ArmatureDeformWeights;
+
+/* Guards the tables stored by modifiers, which might be evaluated by several threads at once. */
+static ThreadMutex armature_deform_weights_lock = BLI_MUTEX_INITIALIZER;
+
+void armature_deform_weights_free(ArmatureDeformWeights *weights)
+{
+	if (weights == NULL) {
+		return;
+	}
+
+	MEM_SAFE_FREE(weights->defnr_to_pchan);
+	MEM_SAFE_FREE(weights->vert_offset);
+	MEM_SAFE_FREE(weights->pchan_index);
+	MEM_SAFE_FREE(weights->weight);
+	MEM_freeN(weights);
+}
+
+typedef struct ArmatureDeformWeightsData {
+	ArmatureDeformWeights *weights;
+	const MDeformVert *dverts;
+	int dverts_tot;
+	const int *defnr_to_pchan;
+	int defbase_tot;
+} ArmatureDeformWeightsData;
+
+BLI_INLINE int armature_dw_pchan_index(const ArmatureDeformWeightsData *data, const MDeformWeight *dw)
+{
+	const int index = dw->def_nr;
+	return (index >= 0 && index < data->defbase_tot) ? data->defnr_to_pchan[index] : -1;
+}
+
+static void armature_weights_count_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	ArmatureDeformWeightsData *data = userdata;
+	int count = 0;
+
+	if (i < data->dverts_tot) {
+		const MDeformVert *dvert = &data->dverts[i];
+		const MDeformWeight *dw = dvert->dw;
+
+		for (int j = dvert->totweight; j != 0; j--, dw++) {
+			if (armature_dw_pchan_index(data, dw) != -1) {
+				count++;
+			}
+		}
+	}
+
+	/* Row sizes are turned into offsets afterwards. */
+	data->weights->vert_offset[i + 1] = count;
+}
+
+static void armature_weights_fill_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	ArmatureDeformWeightsData *data = userdata;
+	ArmatureDeformWeights *weights = data->weights;
+	int k = weights->vert_offset[i];
+
+	if (i < data->dverts_tot) {
+		const MDeformVert *dvert = &data->dverts[i];
+		const MDeformWeight *dw = dvert->dw;
+
+		for (int j = dvert->totweight; j != 0; j--, dw++) {
+			const int pchan_index = armature_dw_pchan_index(data, dw);
+			if (pchan_index != -1) {
+				weights->pchan_index[k] = pchan_index;
+				weights->weight[k] = dw->weight;
+				k++;
+			}
+		}
+	}
+
+	BLI_assert(k == weights->vert_offset[i + 1]);
+}
+
+/* Make sure *weights_p holds the CSR table for the given vertex groups of target,
+ * reusing the existing one when the target wasn't tagged for update since. */
+static void armature_deform_weights_ensure(
+        ArmatureDeformWeights **weights_p, const Object *target,
+        const MDeformVert *dverts, int dverts_tot, int totvert,
+        const int *defnr_to_pchan, int defbase_tot)
+{
+	ArmatureDeformWeights *weights = *weights_p;
+	const int ob_generation = target->id.recalc_generation;
+	const int data_generation = ((const ID *)target->data)->recalc_generation;
+	ArmatureDeformWeightsData data = {
+	    .dverts = dverts, .dverts_tot = dverts_tot,
+	    .defnr_to_pchan = defnr_to_pchan, .defbase_tot = defbase_tot,
+	};
+	ParallelRangeSettings settings;
+
+	if (weights &&
+	    weights->ob_generation == ob_generation &&
+	    weights->data_generation == data_generation &&
+	    weights->dverts == dverts &&
+	    weights->dverts_tot == dverts_tot &&
+	    weights->totvert == totvert &&
+	    weights->defbase_tot == defbase_tot &&
+	    memcmp(weights->defnr_to_pchan, defnr_to_pchan, sizeof(int) * defbase_tot) == 0)
+	{
+		return;
+	}
+
+	armature_deform_weights_free(weights);
+	weights = data.weights = MEM_callocN(sizeof(*weights), __func__);
+	weights->dverts = dverts;
+	weights->dverts_tot = dverts_tot;
+	weights->totvert = totvert;
+	weights->defbase_tot = defbase_tot;
+	weights->ob_generation = ob_generation;
+	weights->data_generation = data_generation;
+	weights->defnr_to_pchan = MEM_mallocN(sizeof(int) * max_ii(defbase_tot, 1), "defnr_to_pchan");
+	memcpy(weights->defnr_to_pchan, defnr_to_pchan, sizeof(int) * defbase_tot);
+	weights->vert_offset = MEM_mallocN(sizeof(int) * (totvert + 1), "armature weights offset");
+	weights->vert_offset[0] = 0;
+
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (totvert > 1000);
+
+	BLI_task_parallel_range(0, totvert, &data, armature_weights_count_cb, &settings);
+
+	for (int i = 0; i < totvert; i++) {
+		weights->vert_offset[i + 1] += weights->vert_offset[i];
+	}
+	weights->totweight = weights->vert_offset[totvert];
+
+	weights->pchan_index = MEM_mallocN(sizeof(int) * max_ii(weights->totweight, 1), "armature weights pchan");
+	weights->weight = MEM_mallocN(sizeof(float) * max_ii(weights->totweight, 1), "armature weights");
+
+	BLI_task_parallel_range(0, totvert, &data, armature_weights_fill_cb, &settings);
+
+	*weights_p = weights;
+}
+
+typedef struct ArmatureDeformVertsData {
+	bPoseChannel **pchan_array;
+	bPoseChanDeform *pdef_info_array;
+	int totchan;
+
+	const ArmatureDeformWeights *weights;  /* NULL when vertex groups are not used */
+	const MDeformVert *dverts;
+	int dverts_tot;
+	int armature_def_nr;
+
+	float (*vertexCos)[3];
+	float (*defMats)[3][3];
+	float (*prevCos)[3];
+
+	bool use_envelope;
+	bool use_quaternion;
+	bool invert_vgroup;
+
+	float premat[4][4];
+	float postmat[4][4];
+} ArmatureDeformVertsData;
+
+static void armature_deform_verts_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	ArmatureDeformVertsData *data = userdata;
+	const bool use_quaternion = data->use_quaternion;
+	float (*defMats)[3][3] = data->defMats;
+	float (*prevCos)[3] = data->prevCos;
+	float (*vertexCos)[3] = data->vertexCos;
+	const MDeformVert *dvert = (i < data->dverts_tot) ? &data->dverts[i] : NULL;
+	DualQuat sumdq, *dq = NULL;
+	float *co, dco[3];
+	float sumvec[3], summat[3][3];
+	float *vec = NULL, (*smat)[3] = NULL;
+	float contrib = 0.0f;
+	float armature_weight = 1.0f; /* default to 1 if no overall def group */
+	float prevco_weight = 1.0f;   /* weight for optional cached vertexcos */
+
+	if (use_quaternion) {
+		memset(&sumdq, 0, sizeof(DualQuat));
+		dq = &sumdq;
+	}
+	else {
+		sumvec[0] = sumvec[1] = sumvec[2] = 0.0f;
+		vec = sumvec;
+
+		if (defMats) {
+			zero_m3(summat);
+			smat = summat;
+		}
+	}
+
+	if (data->armature_def_nr != -1 && dvert) {
+		armature_weight = defvert_find_weight(dvert, data->armature_def_nr);
+
+		if (data->invert_vgroup)
+			armature_weight = 1.0f - armature_weight;
+
+		/* hackish: the blending factor can be used for blending with prevCos too */
+		if (prevCos) {
+			prevco_weight = armature_weight;
+			armature_weight = 1.0f;
+		}
+	}
+
+	/* check if there's any  point in calculating for this vert */
+	if (armature_weight == 0.0f)
+		return;
+
+	/* get the coord we work on */
+	co = prevCos ? prevCos[i] : vertexCos[i];
+
+	/* Apply the object's matrix */
+	mul_m4_v3(data->premat, co);
+
+	/* use weight groups ? if there are vertexgroups but not groups with bones
+	 * (like for softbody groups), fall back to envelopes */
+	if (data->weights && data->weights->vert_offset[i] != data->weights->vert_offset[i + 1]) {
+		const ArmatureDeformWeights *weights = data->weights;
+		const int k_end = weights->vert_offset[i + 1];
+
+		for (int k = weights->vert_offset[i]; k < k_end; k++) {
+			const int pchan_index = weights->pchan_index[k];
+			bPoseChannel *pchan = data->pchan_array[pchan_index];
+			Bone *bone = pchan->bone;
+			float weight = weights->weight[k];
+
+			if (bone && bone->flag & BONE_MULT_VG_ENV) {
+				weight *= distfactor_to_bone(co, bone->arm_head, bone->arm_tail,
+				                             bone->rad_head, bone->rad_tail, bone->dist);
+			}
+			pchan_bone_deform(pchan, &data->pdef_info_array[pchan_index], weight, vec, dq, smat, co, &contrib);
+		}
+	}
+	else if (data->use_envelope) {
+		for (int j = 0; j < data->totchan; j++) {
+			bPoseChannel *pchan = data->pchan_array[j];
+			if (!(pchan->bone->flag & BONE_NO_DEFORM))
+				contrib += dist_bone_deform(pchan, &data->pdef_info_array[j], vec, dq, smat, co);
+		}
+	}
+
+	/* actually should be EPSILON? weight values and contrib can be like 10e-39 small */
+	if (contrib > 0.0001f) {
+		if (use_quaternion) {
+			normalize_dq(dq, contrib);
+
+			if (armature_weight != 1.0f) {
+				copy_v3_v3(dco, co);
+				mul_v3m3_dq(dco, (defMats) ? summat : NULL, dq);
+				sub_v3_v3(dco, co);
+				mul_v3_fl(dco, armature_weight);
+				add_v3_v3(co, dco);
+			}
+			else
+				mul_v3m3_dq(co, (defMats) ? summat : NULL, dq);
+
+			smat = summat;
+		}
+		else {
+			mul_v3_fl(vec, armature_weight / contrib);
+			add_v3_v3v3(co, vec, co);
+		}
+
+		if (defMats) {
+			float pre[3][3], post[3][3], tmpmat[3][3];
+
+			copy_m3_m4(pre, data->premat);
+			copy_m3_m4(post, data->postmat);
+			copy_m3_m3(tmpmat, defMats[i]);
+
+			if (!use_quaternion) /* quaternion already is scale corrected */
+				mul_m3_fl(smat, armature_weight / contrib);
+
+			mul_m3_series(defMats[i], post, smat, pre, tmpmat);
+		}
+	}
+
+	/* always, check above code */
+	mul_m4_v3(data->postmat, co);
+
+	/* interpolate with previous modifier position using weight group */
+	if (prevCos) {
+		float mw = 1.0f - prevco_weight;
+		vertexCos[i][0] = prevco_weight * vertexCos[i][0] + mw * co[0];
+		vertexCos[i][1] = prevco_weight * vertexCos[i][1] + mw * co[1];
+		vertexCos[i][2] = prevco_weight * vertexCos[i][2] + mw * co[2];
+	}
+}
+
 void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float (*vertexCos)[3],
                            float (*defMats)[3][3], int numVerts, int deformflag,
-                           float (*prevCos)[3], const char *defgrp_name)
+                           float (*prevCos)[3], const char *defgrp_name,
+                           ArmatureDeformWeights **weights_cache)
 {
 	bPoseChanDeform *pdef_info_array;
 	bPoseChanDeform *pdef_info = NULL;
 	bArmature *arm = armOb->data;
-	bPoseChannel *pchan, **defnrToPC = NULL;
+	bPoseChannel *pchan, **pchan_array;
 	int *defnrToPCIndex = NULL;
-	MDeformVert *dverts = NULL;
+	MDeformVert *dverts = NULL, *orig_dverts;
 	bDeformGroup *dg;
 	DualQuat *dualquats = NULL;
-	float obinv[4][4], premat[4][4], postmat[4][4];
-	const bool use_envelope   = (deformflag & ARM_DEF_ENVELOPE) != 0;
+	ArmatureDeformWeights *weights = NULL;
+	float obinv[4][4];
 	const bool use_quaternion = (deformflag & ARM_DEF_QUATERNION) != 0;
-	const bool invert_vgroup  = (deformflag & ARM_DEF_INVERT_VGROUP) != 0;
 	int defbase_tot = 0;       /* safety for vertexgroup index overflow */
 	int i, target_totvert = 0; /* safety for vertexgroup overflow */
 	bool use_dverts = false;
@@ -1004,10 +1320,16 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 		BLI_assert(0);
 	}
 
+	ArmatureDeformVertsData data = {
+	    .vertexCos = vertexCos, .defMats = defMats, .prevCos = prevCos,
+	    .use_envelope = (deformflag & ARM_DEF_ENVELOPE) != 0,
+	    .use_quaternion = use_quaternion,
+	    .invert_vgroup = (deformflag & ARM_DEF_INVERT_VGROUP) != 0,
+	};
+
 	invert_m4_m4(obinv, target->obmat);
-	copy_m4_m4(premat, target->obmat);
-	mul_m4_m4m4(postmat, obinv, armOb->obmat);
-	invert_m4_m4(premat, postmat);
+	mul_m4_m4m4(data.postmat, obinv, armOb->obmat);
+	invert_m4_m4(data.premat, data.postmat);
 
 	/* bone defmats are already in the channels, chan_mat */
 
@@ -1019,11 +1341,16 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 	}
 
 	pdef_info_array = MEM_callocN(sizeof(bPoseChanDeform) * totchan, "bPoseChanDeform");
+	pchan_array = MEM_mallocN(sizeof(*pchan_array) * max_ii(totchan, 1), "pchan_array");
 
-	ArmatureBBoneDefmatsData data = {
+	ArmatureBBoneDefmatsData bbone_data = {
 	    .pdef_info_array = pdef_info_array, .dualquats = dualquats, .use_quaternion = use_quaternion
 	};
-	BLI_task_parallel_listbase(&armOb->pose->chanbase, &data, armature_bbone_defmats_cb, totchan > 512);
+	BLI_task_parallel_listbase(&armOb->pose->chanbase, &bbone_data, armature_bbone_defmats_cb, totchan > 512);
+
+	for (i = 0, pchan = armOb->pose->chanbase.first; pchan; i++, pchan = pchan->next) {
+		pchan_array[i] = pchan;
+	}
 
 	/* get the def_nr for the overall armature vertex group if present */
 	armature_def_nr = defgroup_name_index(target, defgrp_name);
@@ -1045,24 +1372,25 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 		}
 	}
 
+	orig_dverts = dverts;
+
+	/* the DerivedMesh vertex groups take precedence over the original ones */
+	if (dm) {
+		dverts = dm->getVertDataArray(dm, CD_MDEFORMVERT);
+		target_totvert = dverts ? min_ii(numVerts, dm->getNumVerts(dm)) : 0;
+	}
+
 	/* get a vertex-deform-index to posechannel array */
 	if (deformflag & ARM_DEF_VGROUP) {
 		if (ELEM(target->type, OB_MESH, OB_LATTICE)) {
 			/* if we have a DerivedMesh, only use dverts if it has them */
-			if (dm) {
-				use_dverts = (dm->getVertDataArray(dm, CD_MDEFORMVERT) != NULL);
-			}
-			else if (dverts) {
-				use_dverts = true;
-			}
+			use_dverts = (dverts != NULL);
 
 			if (use_dverts) {
-				defnrToPC = MEM_callocN(sizeof(*defnrToPC) * defbase_tot, "defnrToBone");
-				defnrToPCIndex = MEM_callocN(sizeof(*defnrToPCIndex) * defbase_tot, "defnrToIndex");
+				defnrToPCIndex = MEM_mallocN(sizeof(*defnrToPCIndex) * max_ii(defbase_tot, 1), "defnrToIndex");
 				/* TODO(sergey): Some considerations here:
 				 *
 				 * - Make it more generic function, maybe even keep together with chanhash.
-				 * - Check whether keeping this consistent across frames gives speedup.
 				 * - Don't use hash for small armatures.
 				 */
 				GHash *idx_hash = BLI_ghash_ptr_new("pose channel index by name");
@@ -1071,171 +1399,58 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 					BLI_ghash_insert(idx_hash, pchan, POINTER_FROM_INT(pchan_index));
 				}
 				for (i = 0, dg = target->defbase.first; dg; i++, dg = dg->next) {
-					defnrToPC[i] = BKE_pose_channel_find_name(armOb->pose, dg->name);
+					pchan = BKE_pose_channel_find_name(armOb->pose, dg->name);
 					/* exclude non-deforming bones */
-					if (defnrToPC[i]) {
-						if (defnrToPC[i]->bone->flag & BONE_NO_DEFORM) {
-							defnrToPC[i] = NULL;
-						}
-						else {
-							defnrToPCIndex[i] = POINTER_AS_INT(BLI_ghash_lookup(idx_hash, defnrToPC[i]));
-						}
+					if (pchan && !(pchan->bone->flag & BONE_NO_DEFORM)) {
+						defnrToPCIndex[i] = POINTER_AS_INT(BLI_ghash_lookup(idx_hash, pchan));
+					}
+					else {
+						defnrToPCIndex[i] = -1;
 					}
 				}
 				BLI_ghash_free(idx_hash, NULL, NULL);
-			}
-		}
-	}
 
-	for (i = 0; i < numVerts; i++) {
-		MDeformVert *dvert;
-		DualQuat sumdq, *dq = NULL;
-		float *co, dco[3];
-		float sumvec[3], summat[3][3];
-		float *vec = NULL, (*smat)[3] = NULL;
-		float contrib = 0.0f;
-		float armature_weight = 1.0f; /* default to 1 if no overall def group */
-		float prevco_weight = 1.0f;   /* weight for optional cached vertexcos */
-
-		if (use_quaternion) {
-			memset(&sumdq, 0, sizeof(DualQuat));
-			dq = &sumdq;
-		}
-		else {
-			sumvec[0] = sumvec[1] = sumvec[2] = 0.0f;
-			vec = sumvec;
-
-			if (defMats) {
-				zero_m3(summat);
-				smat = summat;
-			}
-		}
-
-		if (use_dverts || armature_def_nr != -1) {
-			if (dm)
-				dvert = dm->getVertData(dm, i, CD_MDEFORMVERT);
-			else if (dverts && i < target_totvert)
-				dvert = dverts + i;
-			else
-				dvert = NULL;
-		}
-		else
-			dvert = NULL;
-
-		if (armature_def_nr != -1 && dvert) {
-			armature_weight = defvert_find_weight(dvert, armature_def_nr);
-
-			if (invert_vgroup)
-				armature_weight = 1.0f - armature_weight;
-
-			/* hackish: the blending factor can be used for blending with prevCos too */
-			if (prevCos) {
-				prevco_weight = armature_weight;
-				armature_weight = 1.0f;
-			}
-		}
-
-		/* check if there's any  point in calculating for this vert */
-		if (armature_weight == 0.0f)
-			continue;
-
-		/* get the coord we work on */
-		co = prevCos ? prevCos[i] : vertexCos[i];
-
-		/* Apply the object's matrix */
-		mul_m4_v3(premat, co);
-
-		if (use_dverts && dvert && dvert->totweight) { /* use weight groups ? */
-			MDeformWeight *dw = dvert->dw;
-			int deformed = 0;
-			unsigned int j;
-
-			for (j = dvert->totweight; j != 0; j--, dw++) {
-				const int index = dw->def_nr;
-				if (index >= 0 && index < defbase_tot && (pchan = defnrToPC[index])) {
-					float weight = dw->weight;
-					Bone *bone = pchan->bone;
-					pdef_info = pdef_info_array + defnrToPCIndex[index];
-
-					deformed = 1;
-
-					if (bone && bone->flag & BONE_MULT_VG_ENV) {
-						weight *= distfactor_to_bone(co, bone->arm_head, bone->arm_tail,
-						                             bone->rad_head, bone->rad_tail, bone->dist);
-					}
-					pchan_bone_deform(pchan, pdef_info, weight, vec, dq, smat, co, &contrib);
-				}
-			}
-			/* if there are vertexgroups but not groups with bones
-			 * (like for softbody groups) */
-			if (deformed == 0 && use_envelope) {
-				pdef_info = pdef_info_array;
-				for (pchan = armOb->pose->chanbase.first; pchan; pchan = pchan->next, pdef_info++) {
-					if (!(pchan->bone->flag & BONE_NO_DEFORM))
-						contrib += dist_bone_deform(pchan, pdef_info, vec, dq, smat, co);
+				/* only the target's own weights are tagged for update, so only those can be kept,
+				 * the table is taken out of the modifier while in use */
+				if (weights_cache && dverts == orig_dverts) {
+					BLI_mutex_lock(&armature_deform_weights_lock);
+					weights = *weights_cache;
+					*weights_cache = NULL;
+					BLI_mutex_unlock(&armature_deform_weights_lock);
 				}
+				armature_deform_weights_ensure(&weights, target, dverts, target_totvert, numVerts,
+				                               defnrToPCIndex, defbase_tot);
 			}
 		}
-		else if (use_envelope) {
-			pdef_info = pdef_info_array;
-			for (pchan = armOb->pose->chanbase.first; pchan; pchan = pchan->next, pdef_info++) {
-				if (!(pchan->bone->flag & BONE_NO_DEFORM))
-					contrib += dist_bone_deform(pchan, pdef_info, vec, dq, smat, co);
-			}
-		}
-
-		/* actually should be EPSILON? weight values and contrib can be like 10e-39 small */
-		if (contrib > 0.0001f) {
-			if (use_quaternion) {
-				normalize_dq(dq, contrib);
-
-				if (armature_weight != 1.0f) {
-					copy_v3_v3(dco, co);
-					mul_v3m3_dq(dco, (defMats) ? summat : NULL, dq);
-					sub_v3_v3(dco, co);
-					mul_v3_fl(dco, armature_weight);
-					add_v3_v3(co, dco);
-				}
-				else
-					mul_v3m3_dq(co, (defMats) ? summat : NULL, dq);
-
-				smat = summat;
-			}
-			else {
-				mul_v3_fl(vec, armature_weight / contrib);
-				add_v3_v3v3(co, vec, co);
-			}
-
-			if (defMats) {
-				float pre[3][3], post[3][3], tmpmat[3][3];
-
-				copy_m3_m4(pre, premat);
-				copy_m3_m4(post, postmat);
-				copy_m3_m3(tmpmat, defMats[i]);
-
-				if (!use_quaternion) /* quaternion already is scale corrected */
-					mul_m3_fl(smat, armature_weight / contrib);
+	}
 
-				mul_m3_series(defMats[i], post, smat, pre, tmpmat);
-			}
-		}
+	data.pchan_array = pchan_array;
+	data.pdef_info_array = pdef_info_array;
+	data.totchan = totchan;
+	data.weights = weights;
+	data.armature_def_nr = armature_def_nr;
+	if (use_dverts || armature_def_nr != -1) {
+		data.dverts = dverts;
+		data.dverts_tot = target_totvert;
+	}
 
-		/* always, check above code */
-		mul_m4_v3(postmat, co);
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (numVerts > 1000);
+	BLI_task_parallel_range(0, numVerts, &data, armature_deform_verts_cb, &settings);
 
-		/* interpolate with previous modifier position using weight group */
-		if (prevCos) {
-			float mw = 1.0f - prevco_weight;
-			vertexCos[i][0] = prevco_weight * vertexCos[i][0] + mw * co[0];
-			vertexCos[i][1] = prevco_weight * vertexCos[i][1] + mw * co[1];
-			vertexCos[i][2] = prevco_weight * vertexCos[i][2] + mw * co[2];
+	if (weights) {
+		if (weights_cache && dverts == orig_dverts) {
+			/* another evaluation might have put its table back meanwhile */
+			BLI_mutex_lock(&armature_deform_weights_lock);
+			SWAP(ArmatureDeformWeights *, weights, *weights_cache);
+			BLI_mutex_unlock(&armature_deform_weights_lock);
 		}
+		armature_deform_weights_free(weights);
 	}
 
 	if (dualquats)
 		MEM_freeN(dualquats);
-	if (defnrToPC)
-		MEM_freeN(defnrToPC);
 	if (defnrToPCIndex)
 		MEM_freeN(defnrToPCIndex);
 
@@ -1249,6 +1464,7 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 	}
 
 	MEM_freeN(pdef_info_array);
+	MEM_freeN(pchan_array);
 }
 
 /* ************ END Armature Deform ******************* */
@@ -46,7 +46,15 @@
 
 #include "MEM_guardedalloc.h"
 
-static ThreadRWMutex cache_rwlock = BLI_RWLOCK_INITIALIZER;
+/* Protects all caches, only held while looking up or adding items,
+ * trees are built outside of it so different trees can be built at once. */
+static ThreadMutex cache_lock = BLI_MUTEX_INITIALIZER;
+/* Notified when a tree being built by another thread is ready. */
+static ThreadCondition cache_cond = PTHREAD_COND_INITIALIZER;
+
+typedef BVHTree *(*BVHCacheCreateFn)(void *userdata);
+
+static BVHTree *bvhcache_ensure(BVHCache **cache_p, int type, BVHCacheCreateFn create_fn, void *userdata);
 
 /* -------------------------------------------------------------------- */
 /** \name Local Callbacks
@@ -891,6 +899,22 @@ static void bvhtree_from_mesh_looptri_setup_data(
 	data->looptri_allocated = looptri_allocated;
 }
 
+struct EditMeshLooptriCreateData {
+	BMEditMesh *em;
+	const BLI_bitmap *looptri_mask;
+	int looptri_num_active;
+	float epsilon;
+	int tree_type, axis;
+};
+
+static BVHTree *bvhtree_from_editmesh_looptri_create_cb(void *userdata)
+{
+	const struct EditMeshLooptriCreateData *data = userdata;
+	return bvhtree_from_editmesh_looptri_create_tree(
+	        data->epsilon, data->tree_type, data->axis,
+	        data->em, data->em->tottri, data->looptri_mask, data->looptri_num_active);
+}
+
 /**
  * Builds a bvh tree where nodes are the looptri faces of the given bm
  */
@@ -904,24 +928,15 @@ BVHTree *bvhtree_from_editmesh_looptri_ex(
 
 	BVHTree *tree;
 	if (bvhCache) {
-		BLI_rw_mutex_lock(&cache_rwlock, THREAD_LOCK_READ);
-		tree = bvhcache_find(*bvhCache, BVHTREE_FROM_EM_LOOPTRI);
-		BLI_rw_mutex_unlock(&cache_rwlock);
-		if (tree == NULL) {
-			BLI_rw_mutex_lock(&cache_rwlock, THREAD_LOCK_WRITE);
-			tree = bvhcache_find(*bvhCache, BVHTREE_FROM_EM_LOOPTRI);
-			if (tree == NULL) {
-				tree = bvhtree_from_editmesh_looptri_create_tree(
-				        epsilon, tree_type, axis,
-				        em, em->tottri, looptri_mask, looptri_num_active);
-				if (tree) {
-					/* Save on cache for later use */
-					/* printf("BVHTree built and saved on cache\n"); */
-					bvhcache_insert(bvhCache, tree, BVHTREE_FROM_EM_LOOPTRI);
-				}
-			}
-			BLI_rw_mutex_unlock(&cache_rwlock);
-		}
+		struct EditMeshLooptriCreateData create_data = {
+			.em = em,
+			.looptri_mask = looptri_mask,
+			.looptri_num_active = looptri_num_active,
+			.epsilon = epsilon,
+			.tree_type = tree_type,
+			.axis = axis,
+		};
+		tree = bvhcache_ensure(bvhCache, BVHTREE_FROM_EM_LOOPTRI, bvhtree_from_editmesh_looptri_create_cb, &create_data);
 	}
 	else {
 		tree = bvhtree_from_editmesh_looptri_create_tree(
@@ -976,8 +991,61 @@ BVHTree *bvhtree_from_mesh_looptri_ex(
 	return tree;
 }
 
+struct DerivedMeshCreateData {
+	DerivedMesh *dm;
+	int type, tree_type;
+	const MVert *mvert;
+	const MEdge *medge;
+	const MFace *mface;
+	const MLoop *mloop;
+	const MLoopTri *looptri;
+};
+
+static BVHTree *bvhtree_from_mesh_create_cb(void *userdata)
+{
+	const struct DerivedMeshCreateData *data = userdata;
+	DerivedMesh *dm = data->dm;
+
+	switch (data->type) {
+		case BVHTREE_FROM_VERTS:
+			return bvhtree_from_mesh_verts_create_tree(
+			        0.0, data->tree_type, 6, data->mvert, dm->getNumVerts(dm), NULL, -1);
+
+		case BVHTREE_FROM_EDGES:
+			return bvhtree_from_mesh_edges_create_tree(
+			        data->mvert, data->medge, dm->getNumEdges(dm),
+			        NULL, -1, 0.0, data->tree_type, 6);
+
+		case BVHTREE_FROM_FACES:
+		{
+			int numFaces = dm->getNumTessFaces(dm);
+			BLI_assert(!(numFaces == 0 && dm->getNumPolys(dm) != 0));
+
+			return bvhtree_from_mesh_faces_create_tree(
+			        0.0, data->tree_type, 6, data->mvert, data->mface, numFaces, NULL, -1);
+		}
+
+		case BVHTREE_FROM_LOOPTRI:
+		{
+			int looptri_num = dm->getNumLoopTri(dm);
+
+			/* this assert checks we have looptris,
+			 * if not caller should use DM_ensure_looptri() */
+			BLI_assert(!(looptri_num == 0 && dm->getNumPolys(dm) != 0));
+
+			return bvhtree_from_mesh_looptri_create_tree(
+			        0.0, data->tree_type, 6,
+			        data->mvert, data->mloop, data->looptri, looptri_num, NULL, -1);
+		}
+	}
+
+	return NULL;
+}
+
 /**
  * Builds or queries a bvhcache for the cache bvhtree of the request type.
+ *
+ * Safe to call from multiple threads, the tree is only built once.
  */
 BVHTree *bvhtree_from_mesh_get(
         struct BVHTreeFromMesh *data, struct DerivedMesh *dm,
@@ -999,32 +1067,11 @@ BVHTree *bvhtree_from_mesh_get(
 	bool loop_allocated = false;
 	bool looptri_allocated = false;
 
-	BLI_rw_mutex_lock(&cache_rwlock, THREAD_LOCK_READ);
-	tree = bvhcache_find(dm->bvhCache, type);
-	BLI_rw_mutex_unlock(&cache_rwlock);
-
 	switch (type) {
 		case BVHTREE_FROM_VERTS:
 			raycast_callback = mesh_verts_spherecast;
 
 			mvert = DM_get_vert_array(dm, &vert_allocated);
-
-			if (tree == NULL) {
-				/* Not in cache */
-				BLI_rw_mutex_lock(&cache_rwlock, THREAD_LOCK_WRITE);
-				tree = bvhcache_find(dm->bvhCache, BVHTREE_FROM_VERTS);
-				if (tree == NULL) {
-					tree = bvhtree_from_mesh_verts_create_tree(
-					        0.0, tree_type, 6, mvert, dm->getNumVerts(dm), NULL, -1);
-
-					if (tree) {
-						/* Save on cache for later use */
-						/* printf("BVHTree built and saved on cache\n"); */
-						bvhcache_insert(&dm->bvhCache, tree, BVHTREE_FROM_VERTS);
-					}
-				}
-				BLI_rw_mutex_unlock(&cache_rwlock);
-			}
 			break;
 
 		case BVHTREE_FROM_EDGES:
@@ -1033,24 +1080,6 @@ BVHTree *bvhtree_from_mesh_get(
 
 			mvert = DM_get_vert_array(dm, &vert_allocated);
 			medge = DM_get_edge_array(dm, &edge_allocated);
-
-			if (tree == NULL) {
-				/* Not in cache */
-				BLI_rw_mutex_lock(&cache_rwlock, THREAD_LOCK_WRITE);
-				tree = bvhcache_find(dm->bvhCache, BVHTREE_FROM_EDGES);
-				if (tree == NULL) {
-					tree = bvhtree_from_mesh_edges_create_tree(
-					        mvert, medge, dm->getNumEdges(dm),
-					        NULL, -1, 0.0, tree_type, 6);
-
-					if (tree) {
-						/* Save on cache for later use */
-						/* printf("BVHTree built and saved on cache\n"); */
-						bvhcache_insert(&dm->bvhCache, tree, BVHTREE_FROM_EDGES);
-					}
-				}
-				BLI_rw_mutex_unlock(&cache_rwlock);
-			}
 			break;
 
 		case BVHTREE_FROM_FACES:
@@ -1059,26 +1088,6 @@ BVHTree *bvhtree_from_mesh_get(
 
 			mvert = DM_get_vert_array(dm, &vert_allocated);
 			mface = DM_get_tessface_array(dm, &face_allocated);
-
-			if (tree == NULL) {
-				/* Not in cache */
-				BLI_rw_mutex_lock(&cache_rwlock, THREAD_LOCK_WRITE);
-				tree = bvhcache_find(dm->bvhCache, BVHTREE_FROM_FACES);
-				if (tree == NULL) {
-					int numFaces = dm->getNumTessFaces(dm);
-					BLI_assert(!(numFaces == 0 && dm->getNumPolys(dm) != 0));
-
-					tree = bvhtree_from_mesh_faces_create_tree(
-					        0.0, tree_type, 6, mvert, mface, numFaces, NULL, -1);
-
-					if (tree) {
-						/* Save on cache for later use */
-						/* printf("BVHTree built and saved on cache\n"); */
-						bvhcache_insert(&dm->bvhCache, tree, BVHTREE_FROM_FACES);
-					}
-				}
-				BLI_rw_mutex_unlock(&cache_rwlock);
-			}
 			break;
 
 		case BVHTREE_FROM_LOOPTRI:
@@ -1088,32 +1097,23 @@ BVHTree *bvhtree_from_mesh_get(
 			mvert = DM_get_vert_array(dm, &vert_allocated);
 			mloop = DM_get_loop_array(dm, &loop_allocated);
 			looptri = dm->getLoopTriArray(dm);
-
-			if (tree == NULL) {
-				/* Not in cache */
-				BLI_rw_mutex_lock(&cache_rwlock, THREAD_LOCK_WRITE);
-				tree = bvhcache_find(dm->bvhCache, BVHTREE_FROM_LOOPTRI);
-				if (tree == NULL) {
-					int looptri_num = dm->getNumLoopTri(dm);
-
-					/* this assert checks we have looptris,
-					 * if not caller should use DM_ensure_looptri() */
-					BLI_assert(!(looptri_num == 0 && dm->getNumPolys(dm) != 0));
-
-					tree = bvhtree_from_mesh_looptri_create_tree(
-					        0.0, tree_type, 6,
-					        mvert, mloop, looptri, looptri_num, NULL, -1);
-					if (tree) {
-						/* Save on cache for later use */
-						/* printf("BVHTree built and saved on cache\n"); */
-						bvhcache_insert(&dm->bvhCache, tree, BVHTREE_FROM_LOOPTRI);
-					}
-				}
-				BLI_rw_mutex_unlock(&cache_rwlock);
-			}
 			break;
 	}
 
+	{
+		struct DerivedMeshCreateData create_data = {
+			.dm = dm,
+			.type = type,
+			.tree_type = tree_type,
+			.mvert = mvert,
+			.medge = medge,
+			.mface = mface,
+			.mloop = mloop,
+			.looptri = looptri,
+		};
+		tree = bvhcache_ensure(&dm->bvhCache, type, bvhtree_from_mesh_create_cb, &create_data);
+	}
+
 	if (tree != NULL) {
 #ifdef DEBUG
 		if (BLI_bvhtree_get_tree_type(tree) != tree_type) {
@@ -1211,23 +1211,31 @@ typedef struct BVHCacheItem {
 	int type;
 	BVHTree *tree;
 
+	/* Set while another thread builds the tree, see #bvhcache_ensure. */
+	bool is_building;
 } BVHCacheItem;
 
-/**
- * Queries a bvhcache for the cache bvhtree of the request type
- */
-BVHTree *bvhcache_find(BVHCache *cache, int type)
+static BVHCacheItem *bvhcache_find_item(BVHCache *cache, int type)
 {
 	while (cache) {
-		const BVHCacheItem *item = cache->link;
+		BVHCacheItem *item = cache->link;
 		if (item->type == type) {
-			return item->tree;
+			return item;
 		}
 		cache = cache->next;
 	}
 	return NULL;
 }
 
+/**
+ * Queries a bvhcache for the cache bvhtree of the request type
+ */
+BVHTree *bvhcache_find(BVHCache *cache, int type)
+{
+	const BVHCacheItem *item = bvhcache_find_item(cache, type);
+	return (item && !item->is_building) ? item->tree : NULL;
+}
+
 bool bvhcache_has_tree(const BVHCache *cache, const BVHTree *tree)
 {
 	while (cache) {
@@ -1259,10 +1267,77 @@ void bvhcache_insert(BVHCache **cache_p, BVHTree *tree, int type)
 
 	item->type = type;
 	item->tree = tree;
+	item->is_building = false;
 
 	BLI_linklist_prepend(cache_p, item);
 }
 
+/* Unlinks and frees an item without tree. */
+static void bvhcache_remove_item(BVHCache **cache_p, BVHCacheItem *item)
+{
+	LinkNode **node_p;
+
+	for (node_p = cache_p; *node_p; node_p = &(*node_p)->next) {
+		if ((*node_p)->link == item) {
+			LinkNode *node = *node_p;
+			*node_p = node->next;
+			MEM_freeN(node);
+			break;
+		}
+	}
+
+	MEM_freeN(item);
+}
+
+/**
+ * Returns the tree of the given type, calling \a create_fn to build it on first use.
+ *
+ * The lock is released while building, so trees of other meshes (or of other types)
+ * can be built in parallel. Threads requesting a tree which is being built
+ * wait for it instead of building their own.
+ * A NULL result (empty mesh) isn't cached, the next request tries again.
+ */
+static BVHTree *bvhcache_ensure(BVHCache **cache_p, int type, BVHCacheCreateFn create_fn, void *userdata)
+{
+	BVHCacheItem *item;
+	BVHTree *tree;
+
+	BLI_mutex_lock(&cache_lock);
+
+	/* look the item up again after waiting, a build without result removes it */
+	while ((item = bvhcache_find_item(*cache_p, type)) && item->is_building) {
+		BLI_condition_wait(&cache_cond, &cache_lock);
+	}
+
+	if (item == NULL) {
+		item = MEM_mallocN(sizeof(BVHCacheItem), "BVHCacheItem");
+		item->type = type;
+		item->tree = NULL;
+		item->is_building = true;
+		BLI_linklist_prepend(cache_p, item);
+
+		BLI_mutex_unlock(&cache_lock);
+		tree = create_fn(userdata);
+		BLI_mutex_lock(&cache_lock);
+
+		if (tree) {
+			item->tree = tree;
+			item->is_building = false;
+		}
+		else {
+			bvhcache_remove_item(cache_p, item);
+		}
+		BLI_condition_notify_all(&cache_cond);
+	}
+	else {
+		tree = item->tree;
+	}
+
+	BLI_mutex_unlock(&cache_lock);
+
+	return tree;
+}
+
 /**
  * inits and frees a bvhcache
  */
@@ -42,6 +42,7 @@
 #include "BLI_utildefines_stack.h"
 
 #include "BKE_pbvh.h"
+#include "BKE_bvhutils.h"
 #include "BKE_cdderivedmesh.h"
 #include "BKE_global.h"
 #include "BKE_mesh.h"
@@ -2551,6 +2552,9 @@ void CDDM_apply_vert_coords(DerivedMesh *dm, float (*vertCoords)[3])
 		copy_v3_v3(vert->co, vertCoords[i]);
 
 	cddm->dm.dirty |= DM_DIRTY_NORMALS;
+
+	/* trees built for the previous coordinates */
+	bvhcache_free(&dm->bvhCache);
 }
 
 void CDDM_apply_vert_normals(DerivedMesh *dm, short (*vertNormals)[3])
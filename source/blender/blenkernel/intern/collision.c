@@ -44,6 +44,7 @@
 #include "BLI_blenlib.h"
 #include "BLI_math.h"
 #include "BLI_edgehash.h"
+#include "BLI_task.h"
 
 #include "BKE_cloth.h"
 #include "BKE_effect.h"
@@ -60,6 +61,9 @@
 #include "eltopo-capi.h"
 #endif
 
+/* Below this number of collision pairs the narrow phase and response run single threaded. */
+#define COLLISION_THREADED_LIMIT 64
+
 
 /***********************************
 Collision modifier code start
@@ -226,165 +230,212 @@ DO_INLINE void collision_interpolateOnTriangle ( float to[3], float v1[3], float
 	VECADDMUL(to, v3, w3);
 }
 
-static int cloth_collision_response_static ( ClothModifierData *clmd, CollisionModifierData *collmd, CollPair *collpair, CollPair *collision_end )
+/* Impulses of a single collision pair, merged into the cloth vertices once all pairs are computed. */
+typedef struct CollPairImpulse {
+	float i1[3], i2[3], i3[3];
+	bool hit;
+} CollPairImpulse;
+
+typedef struct ColResponseData {
+	ClothModifierData *clmd;
+	CollisionModifierData *collmd;
+	CollPair *collisions;
+	CollPairImpulse *impulses;
+	float epsilon2;
+} ColResponseData;
+
+/* Compute the impulses of one collision pair, only reads the cloth state so pairs can run in parallel. */
+static void cloth_collision_response_pair_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
 {
-	int result = 0;
-	Cloth *cloth1;
+	ColResponseData *data = userdata;
+	ClothModifierData *clmd = data->clmd;
+	CollisionModifierData *collmd = data->collmd;
+	CollPair *collpair = &data->collisions[index];
+	CollPairImpulse *pair_impulse = &data->impulses[index];
+	const float epsilon2 = data->epsilon2;
+	Cloth *cloth1 = clmd->clothObject;
 	float w1, w2, w3, u1, u2, u3;
 	float v1[3], v2[3], relativeVelocity[3];
 	float magrelVel;
-	float epsilon2 = BLI_bvhtree_get_epsilon ( collmd->bvhtree );
+	float *i1 = pair_impulse->i1, *i2 = pair_impulse->i2, *i3 = pair_impulse->i3;
 
-	cloth1 = clmd->clothObject;
+	zero_v3(i1);
+	zero_v3(i2);
+	zero_v3(i3);
+	pair_impulse->hit = false;
 
-	for ( ; collpair != collision_end; collpair++ ) {
-		float i1[3], i2[3], i3[3];
+	/* only handle static collisions here */
+	if ( collpair->flag & COLLISION_IN_FUTURE )
+		return;
 
-		zero_v3(i1);
-		zero_v3(i2);
-		zero_v3(i3);
+	/* compute barycentric coordinates for both collision points */
+	collision_compute_barycentric ( collpair->pa,
+		cloth1->verts[collpair->ap1].txold,
+		cloth1->verts[collpair->ap2].txold,
+		cloth1->verts[collpair->ap3].txold,
+		&w1, &w2, &w3 );
 
-		/* only handle static collisions here */
-		if ( collpair->flag & COLLISION_IN_FUTURE )
-			continue;
+	/* was: txold */
+	collision_compute_barycentric ( collpair->pb,
+		collmd->current_x[collpair->bp1].co,
+		collmd->current_x[collpair->bp2].co,
+		collmd->current_x[collpair->bp3].co,
+		&u1, &u2, &u3 );
 
-		/* compute barycentric coordinates for both collision points */
-		collision_compute_barycentric ( collpair->pa,
-			cloth1->verts[collpair->ap1].txold,
-			cloth1->verts[collpair->ap2].txold,
-			cloth1->verts[collpair->ap3].txold,
-			&w1, &w2, &w3 );
+	/* Calculate relative "velocity". */
+	collision_interpolateOnTriangle ( v1, cloth1->verts[collpair->ap1].tv, cloth1->verts[collpair->ap2].tv, cloth1->verts[collpair->ap3].tv, w1, w2, w3 );
 
-		/* was: txold */
-		collision_compute_barycentric ( collpair->pb,
-			collmd->current_x[collpair->bp1].co,
-			collmd->current_x[collpair->bp2].co,
-			collmd->current_x[collpair->bp3].co,
-			&u1, &u2, &u3 );
+	collision_interpolateOnTriangle ( v2, collmd->current_v[collpair->bp1].co, collmd->current_v[collpair->bp2].co, collmd->current_v[collpair->bp3].co, u1, u2, u3 );
 
-		/* Calculate relative "velocity". */
-		collision_interpolateOnTriangle ( v1, cloth1->verts[collpair->ap1].tv, cloth1->verts[collpair->ap2].tv, cloth1->verts[collpair->ap3].tv, w1, w2, w3 );
+	sub_v3_v3v3(relativeVelocity, v2, v1);
 
-		collision_interpolateOnTriangle ( v2, collmd->current_v[collpair->bp1].co, collmd->current_v[collpair->bp2].co, collmd->current_v[collpair->bp3].co, u1, u2, u3 );
+	/* Calculate the normal component of the relative velocity (actually only the magnitude - the direction is stored in 'normal'). */
+	magrelVel = dot_v3v3(relativeVelocity, collpair->normal);
 
-		sub_v3_v3v3(relativeVelocity, v2, v1);
+	/* printf("magrelVel: %f\n", magrelVel); */
 
-		/* Calculate the normal component of the relative velocity (actually only the magnitude - the direction is stored in 'normal'). */
-		magrelVel = dot_v3v3(relativeVelocity, collpair->normal);
+	/* Calculate masses of points.
+	 * TODO */
 
-		/* printf("magrelVel: %f\n", magrelVel); */
+	/* If v_n_mag < 0 the edges are approaching each other. */
+	if ( magrelVel > ALMOST_ZERO ) {
+		/* Calculate Impulse magnitude to stop all motion in normal direction. */
+		float magtangent = 0, repulse = 0, d = 0;
+		double impulse = 0.0;
+		float vrel_t_pre[3];
+		float temp[3], spf;
 
-		/* Calculate masses of points.
-		 * TODO */
+		/* calculate tangential velocity */
+		copy_v3_v3 ( temp, collpair->normal );
+		mul_v3_fl(temp, magrelVel);
+		sub_v3_v3v3(vrel_t_pre, relativeVelocity, temp);
 
-		/* If v_n_mag < 0 the edges are approaching each other. */
-		if ( magrelVel > ALMOST_ZERO ) {
-			/* Calculate Impulse magnitude to stop all motion in normal direction. */
-			float magtangent = 0, repulse = 0, d = 0;
-			double impulse = 0.0;
-			float vrel_t_pre[3];
-			float temp[3], spf;
+		/* Decrease in magnitude of relative tangential velocity due to coulomb friction
+		 * in original formula "magrelVel" should be the "change of relative velocity in normal direction" */
+		magtangent = min_ff(clmd->coll_parms->friction * 0.01f * magrelVel, len_v3(vrel_t_pre));
 
-			/* calculate tangential velocity */
-			copy_v3_v3 ( temp, collpair->normal );
-			mul_v3_fl(temp, magrelVel);
-			sub_v3_v3v3(vrel_t_pre, relativeVelocity, temp);
+		/* Apply friction impulse. */
+		if ( magtangent > ALMOST_ZERO ) {
+			normalize_v3(vrel_t_pre);
 
-			/* Decrease in magnitude of relative tangential velocity due to coulomb friction
-			 * in original formula "magrelVel" should be the "change of relative velocity in normal direction" */
-			magtangent = min_ff(clmd->coll_parms->friction * 0.01f * magrelVel, len_v3(vrel_t_pre));
+			impulse = magtangent / ( 1.0f + w1*w1 + w2*w2 + w3*w3 ); /* 2.0 * */
+			VECADDMUL ( i1, vrel_t_pre, w1 * impulse );
+			VECADDMUL ( i2, vrel_t_pre, w2 * impulse );
+			VECADDMUL ( i3, vrel_t_pre, w3 * impulse );
+		}
 
-			/* Apply friction impulse. */
-			if ( magtangent > ALMOST_ZERO ) {
-				normalize_v3(vrel_t_pre);
+		/* Apply velocity stopping impulse
+		 * I_c = m * v_N / 2.0
+		 * no 2.0 * magrelVel normally, but looks nicer DG */
+		impulse =  magrelVel / ( 1.0 + w1*w1 + w2*w2 + w3*w3 );
+
+		VECADDMUL ( i1, collpair->normal, w1 * impulse );
+		VECADDMUL ( i2, collpair->normal, w2 * impulse );
+		VECADDMUL ( i3, collpair->normal, w3 * impulse );
+
+		/* Apply repulse impulse if distance too short
+		 * I_r = -min(dt*kd, m(0, 1d/dt - v_n))
+		 * DG: this formula ineeds to be changed for this code since we apply impulses/repulses like this:
+		 * v += impulse; x_new = x + v;
+		 * We don't use dt!!
+		 * DG TODO: Fix usage of dt here! */
+		spf = (float)clmd->sim_parms->stepsPerFrame / clmd->sim_parms->timescale;
+
+		d = clmd->coll_parms->epsilon*8.0f/9.0f + epsilon2*8.0f/9.0f - collpair->distance;
+		if ( ( magrelVel < 0.1f*d*spf ) && ( d > ALMOST_ZERO ) ) {
+			repulse = MIN2 ( d*1.0f/spf, 0.1f*d*spf - magrelVel );
+
+			/* stay on the safe side and clamp repulse */
+			if ( impulse > ALMOST_ZERO )
+				repulse = min_ff( repulse, 5.0*impulse );
+			repulse = max_ff(impulse, repulse);
+
+			impulse = repulse / ( 1.0f + w1*w1 + w2*w2 + w3*w3 ); /* original 2.0 / 0.25 */
+			VECADDMUL ( i1, collpair->normal,  impulse );
+			VECADDMUL ( i2, collpair->normal,  impulse );
+			VECADDMUL ( i3, collpair->normal,  impulse );
+		}
 
-				impulse = magtangent / ( 1.0f + w1*w1 + w2*w2 + w3*w3 ); /* 2.0 * */
-				VECADDMUL ( i1, vrel_t_pre, w1 * impulse );
-				VECADDMUL ( i2, vrel_t_pre, w2 * impulse );
-				VECADDMUL ( i3, vrel_t_pre, w3 * impulse );
-			}
+		pair_impulse->hit = true;
+	}
+	else {
+		/* Apply repulse impulse if distance too short
+		 * I_r = -min(dt*kd, max(0, 1d/dt - v_n))
+		 * DG: this formula ineeds to be changed for this code since we apply impulses/repulses like this:
+		 * v += impulse; x_new = x + v;
+		 * We don't use dt!! */
+		float spf = (float)clmd->sim_parms->stepsPerFrame / clmd->sim_parms->timescale;
 
-			/* Apply velocity stopping impulse
-			 * I_c = m * v_N / 2.0
-			 * no 2.0 * magrelVel normally, but looks nicer DG */
-			impulse =  magrelVel / ( 1.0 + w1*w1 + w2*w2 + w3*w3 );
+		float d = clmd->coll_parms->epsilon*8.0f/9.0f + epsilon2*8.0f/9.0f - (float)collpair->distance;
+		if ( d > ALMOST_ZERO) {
+			/* stay on the safe side and clamp repulse */
+			float repulse = d*1.0f/spf;
 
-			VECADDMUL ( i1, collpair->normal, w1 * impulse );
-			cloth1->verts[collpair->ap1].impulse_count++;
+			float impulse = repulse / ( 3.0f * ( 1.0f + w1*w1 + w2*w2 + w3*w3 )); /* original 2.0 / 0.25 */
 
-			VECADDMUL ( i2, collpair->normal, w2 * impulse );
-			cloth1->verts[collpair->ap2].impulse_count++;
-
-			VECADDMUL ( i3, collpair->normal, w3 * impulse );
-			cloth1->verts[collpair->ap3].impulse_count++;
-
-			/* Apply repulse impulse if distance too short
-			 * I_r = -min(dt*kd, m(0, 1d/dt - v_n))
-			 * DG: this formula ineeds to be changed for this code since we apply impulses/repulses like this:
-			 * v += impulse; x_new = x + v;
-			 * We don't use dt!!
-			 * DG TODO: Fix usage of dt here! */
-			spf = (float)clmd->sim_parms->stepsPerFrame / clmd->sim_parms->timescale;
-
-			d = clmd->coll_parms->epsilon*8.0f/9.0f + epsilon2*8.0f/9.0f - collpair->distance;
-			if ( ( magrelVel < 0.1f*d*spf ) && ( d > ALMOST_ZERO ) ) {
-				repulse = MIN2 ( d*1.0f/spf, 0.1f*d*spf - magrelVel );
-
-				/* stay on the safe side and clamp repulse */
-				if ( impulse > ALMOST_ZERO )
-					repulse = min_ff( repulse, 5.0*impulse );
-				repulse = max_ff(impulse, repulse);
-
-				impulse = repulse / ( 1.0f + w1*w1 + w2*w2 + w3*w3 ); /* original 2.0 / 0.25 */
-				VECADDMUL ( i1, collpair->normal,  impulse );
-				VECADDMUL ( i2, collpair->normal,  impulse );
-				VECADDMUL ( i3, collpair->normal,  impulse );
-			}
+			VECADDMUL ( i1, collpair->normal,  impulse );
+			VECADDMUL ( i2, collpair->normal,  impulse );
+			VECADDMUL ( i3, collpair->normal,  impulse );
 
-			result = 1;
+			pair_impulse->hit = true;
 		}
-		else {
-			/* Apply repulse impulse if distance too short
-			 * I_r = -min(dt*kd, max(0, 1d/dt - v_n))
-			 * DG: this formula ineeds to be changed for this code since we apply impulses/repulses like this:
-			 * v += impulse; x_new = x + v;
-			 * We don't use dt!! */
-			float spf = (float)clmd->sim_parms->stepsPerFrame / clmd->sim_parms->timescale;
+	}
+}
 
-			float d = clmd->coll_parms->epsilon*8.0f/9.0f + epsilon2*8.0f/9.0f - (float)collpair->distance;
-			if ( d > ALMOST_ZERO) {
-				/* stay on the safe side and clamp repulse */
-				float repulse = d*1.0f/spf;
+/**
+ * Impulses of all pairs are computed in parallel, then merged into the vertices in pair order,
+ * so a vertex shared by several pairs keeps the strongest impulse per axis as before.
+ */
+static int cloth_collision_response_static ( ClothModifierData *clmd, CollisionModifierData *collmd, CollPair *collpair, CollPair *collision_end, CollPairImpulse *impulses )
+{
+	Cloth *cloth1 = clmd->clothObject;
+	const int collisions_num = (int)(collision_end - collpair);
+	int result = 0;
+	int a, i;
 
-				float impulse = repulse / ( 3.0f * ( 1.0f + w1*w1 + w2*w2 + w3*w3 )); /* original 2.0 / 0.25 */
+	ColResponseData data = {
+		.clmd = clmd, .collmd = collmd, .collisions = collpair, .impulses = impulses,
+		.epsilon2 = BLI_bvhtree_get_epsilon ( collmd->bvhtree ),
+	};
 
-				VECADDMUL ( i1, collpair->normal,  impulse );
-				VECADDMUL ( i2, collpair->normal,  impulse );
-				VECADDMUL ( i3, collpair->normal,  impulse );
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (collisions_num > COLLISION_THREADED_LIMIT);
+	BLI_task_parallel_range(0, collisions_num, &data, cloth_collision_response_pair_cb, &settings);
 
-				cloth1->verts[collpair->ap1].impulse_count++;
-				cloth1->verts[collpair->ap2].impulse_count++;
-				cloth1->verts[collpair->ap3].impulse_count++;
+	for (a = 0; a < collisions_num; a++) {
+		const CollPair *pair = &collpair[a];
+		const CollPairImpulse *pair_impulse = &impulses[a];
+		ClothVertex *v1, *v2, *v3;
 
-				result = 1;
-			}
-		}
+		if (!pair_impulse->hit)
+			continue;
 
-		if (result) {
-			int i = 0;
+		v1 = &cloth1->verts[pair->ap1];
+		v2 = &cloth1->verts[pair->ap2];
+		v3 = &cloth1->verts[pair->ap3];
 
-			for (i = 0; i < 3; i++) {
-				if (cloth1->verts[collpair->ap1].impulse_count > 0 && ABS(cloth1->verts[collpair->ap1].impulse[i]) < ABS(i1[i]))
-					cloth1->verts[collpair->ap1].impulse[i] = i1[i];
+		v1->impulse_count++;
+		v2->impulse_count++;
+		v3->impulse_count++;
 
-				if (cloth1->verts[collpair->ap2].impulse_count > 0 && ABS(cloth1->verts[collpair->ap2].impulse[i]) < ABS(i2[i]))
-					cloth1->verts[collpair->ap2].impulse[i] = i2[i];
+		for (i = 0; i < 3; i++) {
+			if (ABS(v1->impulse[i]) < ABS(pair_impulse->i1[i]))
+				v1->impulse[i] = pair_impulse->i1[i];
 
-				if (cloth1->verts[collpair->ap3].impulse_count > 0 && ABS(cloth1->verts[collpair->ap3].impulse[i]) < ABS(i3[i]))
-					cloth1->verts[collpair->ap3].impulse[i] = i3[i];
-			}
+			if (ABS(v2->impulse[i]) < ABS(pair_impulse->i2[i]))
+				v2->impulse[i] = pair_impulse->i2[i];
+
+			if (ABS(v3->impulse[i]) < ABS(pair_impulse->i3[i]))
+				v3->impulse[i] = pair_impulse->i3[i];
 		}
+
+		result = 1;
 	}
+
 	return result;
 }
 
@@ -619,52 +670,131 @@ void free_collider_cache(ListBase **colliders)
 }
 
 
+typedef struct ColDetectData {
+	ClothModifierData *clmd;
+	CollisionModifierData *collmd;
+	BVHTreeOverlap *overlap;
+	CollPair *collisions;
+	bool *collided;
+	float dt;
+} ColDetectData;
+
+static void cloth_collision_detect_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	ColDetectData *data = userdata;
+	CollPair *collpair = &data->collisions[index];
+
+	data->collided[index] = (cloth_collision((ModifierData *)data->clmd, (ModifierData *)data->collmd,
+	                                         &data->overlap[index], collpair, data->dt) != collpair);
+}
+
 static void cloth_bvh_objcollisions_nearcheck ( ClothModifierData * clmd, CollisionModifierData *collmd,
 	CollPair **collisions, CollPair **collisions_index, int numresult, BVHTreeOverlap *overlap, double dt)
 {
-	int i;
+	bool *collided;
+	int i, collisions_num = 0;
 
-	*collisions = (CollPair *) MEM_mallocN(sizeof(CollPair) * numresult * 4, "collision array" ); // * 4 since cloth_collision_static can return more than 1 collision
-	*collisions_index = *collisions;
+	/* each overlap gives at most one collision, computed in parallel into its own slot */
+	*collisions = (CollPair *) MEM_mallocN(sizeof(CollPair) * numresult, "collision array" );
+	collided = MEM_mallocN(sizeof(*collided) * numresult, __func__);
 
+	ColDetectData data = {
+		.clmd = clmd, .collmd = collmd, .overlap = overlap,
+		.collisions = *collisions, .collided = collided, .dt = (float)dt,
+	};
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (numresult > COLLISION_THREADED_LIMIT);
+	BLI_task_parallel_range(0, numresult, &data, cloth_collision_detect_cb, &settings);
+
+	/* compact, keeping the overlap order */
 	for ( i = 0; i < numresult; i++ ) {
-		*collisions_index = cloth_collision((ModifierData *)clmd, (ModifierData *)collmd,
-		                                    overlap+i, *collisions_index, dt);
+		if (collided[i]) {
+			if (i != collisions_num) {
+				(*collisions)[collisions_num] = (*collisions)[i];
+			}
+			collisions_num++;
+		}
+	}
+	*collisions_index = *collisions + collisions_num;
+
+	MEM_freeN(collided);
+}
+
+typedef struct ColApplyImpulseData {
+	ClothVertex *verts;
+	/* number of vertices which received an impulse */
+	int ret;
+} ColApplyImpulseData;
+
+static void cloth_collision_apply_impulse_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict tls)
+{
+	ColApplyImpulseData *data = userdata;
+	ClothVertex *verts = data->verts;
+	int *ret = tls->userdata_chunk;
+
+	// calculate "velocities" (just xnew = xold + v; no dt in v)
+	if (verts[i].impulse_count) {
+		// VECADDMUL ( verts[i].tv, verts[i].impulse, 1.0f / verts[i].impulse_count );
+		VECADD ( verts[i].tv, verts[i].tv, verts[i].impulse);
+		zero_v3(verts[i].impulse);
+		verts[i].impulse_count = 0;
+
+		(*ret)++;
 	}
 }
 
+static void cloth_collision_apply_impulse_finalize(
+        void *__restrict userdata,
+        void *__restrict userdata_chunk)
+{
+	ColApplyImpulseData *data = userdata;
+	data->ret += *(int *)userdata_chunk;
+}
+
 static int cloth_bvh_objcollisions_resolve ( ClothModifierData * clmd, CollisionModifierData *collmd, CollPair *collisions, CollPair *collisions_index)
 {
 	Cloth *cloth = clmd->clothObject;
-	int i=0, j = 0, /*numfaces = 0, */ mvert_num = 0;
+	int j = 0, /*numfaces = 0, */ mvert_num = 0;
 	ClothVertex *verts = NULL;
+	CollPairImpulse *impulses;
 	int ret = 0;
 	int result = 0;
 
 	mvert_num = clmd->clothObject->mvert_num;
 	verts = cloth->verts;
 
+	impulses = MEM_mallocN(sizeof(*impulses) * (size_t)max_ii((int)(collisions_index - collisions), 1), __func__);
+
 	// process all collisions (calculate impulses, TODO: also repulses if distance too short)
 	result = 1;
 	for ( j = 0; j < 2; j++ ) { /* 5 is just a value that ensures convergence */
 		result = 0;
 
 		if ( collmd->bvhtree ) {
-			result += cloth_collision_response_static ( clmd, collmd, collisions, collisions_index );
+			result += cloth_collision_response_static ( clmd, collmd, collisions, collisions_index, impulses );
 
 			// apply impulses in parallel
 			if (result) {
-				for (i = 0; i < mvert_num; i++) {
-					// calculate "velocities" (just xnew = xold + v; no dt in v)
-					if (verts[i].impulse_count) {
-						// VECADDMUL ( verts[i].tv, verts[i].impulse, 1.0f / verts[i].impulse_count );
-						VECADD ( verts[i].tv, verts[i].tv, verts[i].impulse);
-						zero_v3(verts[i].impulse);
-						verts[i].impulse_count = 0;
-
-						ret++;
-					}
-				}
+				ColApplyImpulseData data = { .verts = verts, .ret = 0 };
+				int ret_chunk = 0;
+
+				ParallelRangeSettings settings;
+				BLI_parallel_range_settings_defaults(&settings);
+				settings.use_threading = (mvert_num > 1024);
+				settings.userdata_chunk = &ret_chunk;
+				settings.userdata_chunk_size = sizeof(ret_chunk);
+				settings.func_finalize = cloth_collision_apply_impulse_finalize;
+				BLI_task_parallel_range(0, mvert_num, &data, cloth_collision_apply_impulse_cb, &settings);
+
+				ret += data.ret;
 			}
 		}
 
@@ -672,9 +802,43 @@ static int cloth_bvh_objcollisions_resolve ( ClothModifierData * clmd, Collision
 			break;
 		}
 	}
+
+	MEM_freeN(impulses);
+
 	return ret;
 }
 
+/**
+ * Reject vertex pairs which can never self-collide while the overlap is searched,
+ * this runs threaded inside #BLI_bvhtree_overlap so only static vertex data is checked here.
+ */
+static bool cloth_bvh_selfcollision_overlap_cb(void *userdata, int index_a, int index_b, int UNUSED(thread))
+{
+	ClothModifierData *clmd = userdata;
+	const Cloth *cloth = clmd->clothObject;
+	const ClothVertex *verts = cloth->verts;
+
+	if ( clmd->sim_parms->flags & CLOTH_SIMSETTINGS_FLAG_GOAL ) {
+		if ( ( verts[index_a].flags & CLOTH_VERT_FLAG_PINNED ) &&
+		     ( verts[index_b].flags & CLOTH_VERT_FLAG_PINNED ) )
+		{
+			return false;
+		}
+	}
+
+	if ((verts[index_a].flags & CLOTH_VERT_FLAG_NOSELFCOLL) ||
+	    (verts[index_b].flags & CLOTH_VERT_FLAG_NOSELFCOLL))
+	{
+		return false;
+	}
+
+	if (BLI_edgeset_haskey(cloth->edgeset, index_a, index_b)) {
+		return false;
+	}
+
+	return true;
+}
+
 // cloth - object collisions
 int cloth_bvh_objcollision(Object *ob, ClothModifierData *clmd, float step, float dt )
 {
@@ -800,9 +964,14 @@ int cloth_bvh_objcollision(Object *ob, ClothModifierData *clmd, float step, floa
 
 				if ( cloth->bvhselftree ) {
 					// search for overlapping collision pairs
-					overlap = BLI_bvhtree_overlap(cloth->bvhselftree, cloth->bvhselftree, &result, NULL, NULL);
-
-					/* Could be parallelized (using BLI_task)... */
+					/* pinned, excluded and connected vertices are already filtered out by the
+					 * (threaded) overlap search, see #cloth_bvh_selfcollision_overlap_cb */
+					overlap = BLI_bvhtree_overlap(
+					        cloth->bvhselftree, cloth->bvhselftree, &result,
+					        cloth_bvh_selfcollision_overlap_cb, clmd);
+
+					/* The corrections are applied in order, each pair reads positions
+					 * moved by the pairs before it, so this loop stays serial. */
 					for ( k = 0; k < result; k++ ) {
 						float temp[3];
 						float length = 0;
@@ -813,28 +982,10 @@ int cloth_bvh_objcollision(Object *ob, ClothModifierData *clmd, float step, floa
 
 						mindistance = clmd->coll_parms->selfepsilon* ( cloth->verts[i].avg_spring_len + cloth->verts[j].avg_spring_len );
 
-						if ( clmd->sim_parms->flags & CLOTH_SIMSETTINGS_FLAG_GOAL ) {
-							if ( ( cloth->verts [i].flags & CLOTH_VERT_FLAG_PINNED ) &&
-							     ( cloth->verts [j].flags & CLOTH_VERT_FLAG_PINNED ) )
-							{
-								continue;
-							}
-						}
-
-						if ((cloth->verts[i].flags & CLOTH_VERT_FLAG_NOSELFCOLL) ||
-						    (cloth->verts[j].flags & CLOTH_VERT_FLAG_NOSELFCOLL))
-						{
-							continue;
-						}
-
 						sub_v3_v3v3(temp, verts[i].tx, verts[j].tx);
 
 						if ( ( ABS ( temp[0] ) > mindistance ) || ( ABS ( temp[1] ) > mindistance ) || ( ABS ( temp[2] ) > mindistance ) ) continue;
 
-						if (BLI_edgeset_haskey(cloth->edgeset, i, j)) {
-							continue;
-						}
-
 						length = normalize_v3(temp );
 
 						if ( length < mindistance ) {
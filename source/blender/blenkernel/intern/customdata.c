@@ -610,15 +610,35 @@ static int layerRead_mdisps(CDataFile *cdf, void *data, int count)
 static int layerWrite_mdisps(CDataFile *cdf, const void *data, int count)
 {
 	const MDisps *d = data;
+	float (*zero_disps)[3] = NULL;
+	int zero_totdisp = 0;
 	int i;
 
 	for (i = 0; i < count; ++i) {
-		if (!cdf_write_data(cdf, d[i].totdisp * 3 * sizeof(float), d[i].disps)) {
+		float (*disps)[3] = d[i].disps;
+
+		/* sparse grids (never displaced) are written out as zero displacement */
+		if (disps == NULL) {
+			if (zero_totdisp < d[i].totdisp) {
+				if (zero_disps)
+					MEM_freeN(zero_disps);
+				zero_totdisp = d[i].totdisp;
+				zero_disps = MEM_calloc_arrayN(zero_totdisp, 3 * sizeof(float), "mdisps write zero");
+			}
+			disps = zero_disps;
+		}
+
+		if (!cdf_write_data(cdf, d[i].totdisp * 3 * sizeof(float), disps)) {
 			printf("failed to write multires displacement %d/%d %d\n", i, count, d[i].totdisp);
+			if (zero_disps)
+				MEM_freeN(zero_disps);
 			return 0;
 		}
 	}
 
+	if (zero_disps)
+		MEM_freeN(zero_disps);
+
 	return 1;
 }
 
@@ -3012,6 +3012,10 @@ void DAG_id_tag_update_ex(Main *bmain, ID *id, short flag)
 		printf("%s: id=%s flag=%d\n", __func__, id->name, flag);
 	}
 
+	if (flag == 0 || (flag & OB_RECALC_DATA)) {
+		id->recalc_generation++;
+	}
+
 	/* tag ID for update */
 	if (flag) {
 		if (flag & OB_RECALC_OB)
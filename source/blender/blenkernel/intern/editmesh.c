@@ -165,6 +165,25 @@ void BKE_editmesh_tessface_calc(BMEditMesh *em)
 #endif
 }
 
+/**
+ * Re-tessellate only the faces in \a bmpinfo, see #BM_mesh_calc_tessellation_with_partial.
+ *
+ * \note Falls back to a full tessellation when the existing one doesn't match the topology.
+ */
+void BKE_editmesh_tessface_calc_with_partial(BMEditMesh *em, const struct BMPartialUpdate *bmpinfo)
+{
+	BMesh *bm = em->bm;
+
+	if (UNLIKELY((em->looptris == NULL) ||
+	             (em->tottri != poly_to_tri_count(bm->totface, bm->totloop))))
+	{
+		editmesh_tessface_calc_intern(em);
+		return;
+	}
+
+	BM_mesh_calc_tessellation_with_partial(bm, em->looptris, bmpinfo);
+}
+
 void BKE_editmesh_update_linked_customdata(BMEditMesh *em)
 {
 	BMesh *bm = em->bm;
@@ -3129,6 +3129,36 @@ static void image_create_multilayer(Image *ima, ImBuf *ibuf, int framenr)
 	/* set proper views */
 	image_init_multilayer_multiview(ima, ima->rr);
 }
+
+/* Multilayer files on disk only get their layers and passes listed here,
+ * a pass is decoded the first time an ImBuf of it is acquired.
+ * Only done for images already known to be multilayer (from an earlier load or
+ * a saved file), other images would have their file opened twice. */
+static bool image_load_multilayer_lazy(Image *ima, const char *filepath, int framenr)
+{
+	RenderResult *rr;
+
+	if (ima->type != IMA_TYPE_MULTILAYER)
+		return false;
+
+	rr = RE_MultilayerRead(filepath, ima->colorspace_settings.name, (ima->alpha_mode == IMA_ALPHA_PREMUL));
+	if (rr == NULL)
+		return false;
+
+	/* only load rr once for multiview */
+	if (ima->rr)
+		RE_FreeRenderResult(rr);
+	else
+		ima->rr = rr;
+
+	ima->rr->framenr = framenr;
+	ima->type = IMA_TYPE_MULTILAYER;
+
+	/* set proper views */
+	image_init_multilayer_multiview(ima, ima->rr);
+
+	return true;
+}
 #endif  /* WITH_OPENEXR */
 
 /* common stuff to do with images after loading */
@@ -3207,6 +3237,11 @@ static ImBuf *load_sequence_single(Image *ima, ImageUser *iuser, int frame, cons
 	flag = IB_rect | IB_multilayer;
 	flag |= imbuf_alpha_flags_for_image(ima);
 
+#ifdef WITH_OPENEXR
+	if (image_load_multilayer_lazy(ima, name, frame))
+		return NULL;
+#endif
+
 	/* read ibuf */
 	ibuf = IMB_loadiffname(name, flag, ima->colorspace_settings.name);
 
@@ -3321,7 +3356,7 @@ static ImBuf *image_load_sequence_multilayer(Image *ima, ImageUser *iuser, int f
 	if (ima->rr) {
 		RenderPass *rpass = BKE_image_multilayer_index(ima->rr, iuser);
 
-		if (rpass) {
+		if (rpass && RE_MultilayerPassEnsure(ima->rr, rpass)) {
 			// printf("load from pass %s\n", rpass->name);
 			/* since we free  render results, we copy the rect */
 			ibuf = IMB_allocImBuf(ima->rr->rectx, ima->rr->recty, 32, 0);
@@ -3506,6 +3541,11 @@ static ImBuf *load_image_single(
 
 		BKE_image_user_file_path(&iuser_t, ima, filepath);
 
+#ifdef WITH_OPENEXR
+		if (image_load_multilayer_lazy(ima, filepath, cfra))
+			return NULL;
+#endif
+
 		/* read ibuf */
 		ibuf = IMB_loadiffname(filepath, flag, ima->colorspace_settings.name);
 	}
@@ -3635,7 +3675,7 @@ static ImBuf *image_get_ibuf_multilayer(Image *ima, ImageUser *iuser)
 	if (ima->rr) {
 		RenderPass *rpass = BKE_image_multilayer_index(ima->rr, iuser);
 
-		if (rpass) {
+		if (rpass && RE_MultilayerPassEnsure(ima->rr, rpass)) {
 			ibuf = IMB_allocImBuf(ima->rr->rectx, ima->rr->recty, 32, 0);
 
 			image_initialize_after_load(ima, ibuf);
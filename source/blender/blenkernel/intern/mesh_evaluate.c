@@ -172,6 +172,8 @@ typedef struct MeshCalcNormalsData {
 	const MPoly *mpolys;
 	const MLoop *mloop;
 	MVert *mverts;
+	/* When set, positions are read from here and #MVert.no isn't written. */
+	const float (*vert_cos)[3];
 	float (*pnors)[3];
 	float (*lnors_weighted)[3];
 	float (*vnors)[3];
@@ -197,6 +199,7 @@ static void mesh_calc_normals_poly_prepare_cb(
 	const MPoly *mp = &data->mpolys[pidx];
 	const MLoop *ml = &data->mloop[mp->loopstart];
 	const MVert *mverts = data->mverts;
+	const float (*vert_cos)[3] = data->vert_cos;
 
 	float pnor_temp[3];
 	float *pnor = data->pnors ? data->pnors[pidx] : pnor_temp;
@@ -210,13 +213,13 @@ static void mesh_calc_normals_poly_prepare_cb(
 	/* inline version of #BKE_mesh_calc_poly_normal, also does edge-vectors */
 	{
 		int i_prev = nverts - 1;
-		const float *v_prev = mverts[ml[i_prev].v].co;
+		const float *v_prev = vert_cos ? vert_cos[ml[i_prev].v] : mverts[ml[i_prev].v].co;
 		const float *v_curr;
 
 		zero_v3(pnor);
 		/* Newell's Method */
 		for (i = 0; i < nverts; i++) {
-			v_curr = mverts[ml[i].v].co;
+			v_curr = vert_cos ? vert_cos[ml[i].v] : mverts[ml[i].v].co;
 			add_newell_cross_v3_v3v3(pnor, v_prev, v_curr);
 
 			/* Unrelated to normalize, calculate edge-vector */
@@ -260,9 +263,17 @@ static void mesh_calc_normals_poly_finalize_cb(
 {
 	MeshCalcNormalsData *data = userdata;
 
-	MVert *mv = &data->mverts[vidx];
 	float *no = data->vnors[vidx];
 
+	if (data->vert_cos) {
+		if (UNLIKELY(normalize_v3(no) == 0.0f)) {
+			normalize_v3_v3(no, data->vert_cos[vidx]);
+		}
+		return;
+	}
+
+	MVert *mv = &data->mverts[vidx];
+
 	if (UNLIKELY(normalize_v3(no) == 0.0f)) {
 		/* following Mesh convention; we use vertex coordinate itself for normal in this case */
 		normalize_v3_v3(no, mv->co);
@@ -332,6 +343,39 @@ void BKE_mesh_calc_normals_poly(
 	MEM_freeN(lnors_weighted);
 }
 
+/**
+ * Vertex normals of positions stored apart from the vertices (as deform modifiers use them),
+ * same as #BKE_mesh_calc_normals_poly but nothing is written into #MVert.
+ */
+void BKE_mesh_calc_normals_poly_cos(
+        const float (*vert_cos)[3], float (*r_vertnors)[3], int numVerts,
+        const MLoop *mloop, const MPoly *mpolys,
+        int numLoops, int numPolys)
+{
+	float (*lnors_weighted)[3] = MEM_malloc_arrayN((size_t)numLoops, sizeof(*lnors_weighted), __func__);
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.min_iter_per_thread = 1024;
+
+	memset(r_vertnors, 0, sizeof(*r_vertnors) * (size_t)numVerts);
+
+	MeshCalcNormalsData data = {
+	    .mpolys = mpolys, .mloop = mloop, .vert_cos = vert_cos,
+	    .lnors_weighted = lnors_weighted, .vnors = r_vertnors
+	};
+
+	BLI_task_parallel_range(0, numPolys, &data, mesh_calc_normals_poly_prepare_cb, &settings);
+
+	for (int lidx = 0; lidx < numLoops; lidx++) {
+		add_v3_v3(r_vertnors[mloop[lidx].v], lnors_weighted[lidx]);
+	}
+
+	BLI_task_parallel_range(0, numVerts, &data, mesh_calc_normals_poly_finalize_cb, &settings);
+
+	MEM_freeN(lnors_weighted);
+}
+
 void BKE_mesh_calc_normals(Mesh *mesh)
 {
 #ifdef DEBUG_TIME
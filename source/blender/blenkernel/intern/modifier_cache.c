@@ -0,0 +1,923 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenkernel/intern/modifier_cache.c
+ *  \ingroup bke
+ *
+ * Cache of intermediate modifier stack results.
+ *
+ * Every step of the modifier stack gets a key, chained from the key of the
+ * previous step: the first one hashes the contents of the original mesh
+ * (after leading deform modifiers), following ones add the modifier type,
+ * all of its RNA settings and the state of the objects it references.
+ * Results of constructive modifiers are stored with their key, evaluation
+ * then resumes after the last step whose stored key still matches.
+ * A result is only copied once the same key was seen in the previous
+ * evaluation, so steps with animated inputs get a new key every frame
+ * and never pay for storing.
+ *
+ * Modifiers with inputs which can't be hashed this way (time, point caches,
+ * textures, curve mappings, bind data...) end the chain, no result after
+ * them is ever reused.
+ *
+ * All caches share one memory limit, when it's reached the least recently
+ * used results of any object are freed, except those an evaluation which
+ * is running on another thread resumes from or just stored.
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_action_types.h"
+#include "DNA_armature_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "DNA_userdef_types.h"
+
+#include "BLI_hash_mm2a.h"
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_cdderivedmesh.h"
+#include "BKE_DerivedMesh.h"
+#include "BKE_global.h"
+#include "BKE_modifier.h"
+#include "BKE_modifier_cache.h"
+
+#include "RNA_access.h"
+
+#include "atomic_ops.h"
+
+/* Size of the pieces the mesh data is split into for hashing in parallel. */
+#define MODIFIER_CACHE_HASH_CHUNK (1 << 18)
+
+typedef struct ModifierCacheEntry {
+	struct ModifierCacheEntry *next, *prev;
+
+	ModifierData *md;  /* only compared, never dereferenced */
+	uint32_t key;
+	/* NULL dm: the key was seen but the result not stored yet. */
+	/* Used by the running evaluation of its object, can't be evicted. */
+	bool used;
+	unsigned int last_used;
+
+	DerivedMesh *dm, *orcodm, *clothorcodm;
+	CustomDataMask append_mask;
+	size_t mem;
+
+	/* Errors of the modifiers up to this one, by step. */
+	char **errors;
+	int errors_len;
+} ModifierCacheEntry;
+
+typedef struct ModifierCacheStep {
+	ModifierData *md;
+	uint32_t key;
+	bool is_constructive;
+} ModifierCacheStep;
+
+typedef struct ModifierCacheEval {
+	Object *ob;
+	ModifierStackCache *cache;
+
+	/* Key of the last step, false once an uncacheable modifier was met. */
+	uint32_t key;
+	bool valid;
+
+	ModifierCacheStep *steps;
+	int steps_len, steps_alloc;
+
+	/* Entry to resume from, found while adding the steps. */
+	ModifierCacheEntry *resume;
+	int resume_step;
+} ModifierCacheEval;
+
+/* Memory used by all caches together, checked against the user preference. */
+static size_t modifier_cache_mem = 0;
+
+/* All caches, for eviction. The lock protects the entries of every cache,
+ * objects are evaluated in parallel and evict each other's results. */
+static ListBase modifier_caches = {NULL, NULL};
+static ThreadMutex modifier_cache_lock = BLI_MUTEX_INITIALIZER;
+static unsigned int modifier_cache_clock = 0;
+
+/* -------------------------------------------------------------------- */
+/** \name Entries
+ * \{ */
+
+static void modifier_cache_dm_free(DerivedMesh *dm)
+{
+	if (dm) {
+		dm->needsFree = 1;
+		dm->release(dm);
+	}
+}
+
+static size_t modifier_cache_customdata_size(const CustomData *data, int totelem)
+{
+	size_t size = 0;
+	int i;
+
+	for (i = 0; i < data->totlayer; i++) {
+		size += (size_t)CustomData_sizeof(data->layers[i].type) * (size_t)totelem;
+	}
+
+	return size;
+}
+
+static size_t modifier_cache_dm_size(DerivedMesh *dm)
+{
+	if (dm == NULL) {
+		return 0;
+	}
+
+	return (modifier_cache_customdata_size(&dm->vertData, dm->numVertData) +
+	        modifier_cache_customdata_size(&dm->edgeData, dm->numEdgeData) +
+	        modifier_cache_customdata_size(&dm->loopData, dm->numLoopData) +
+	        modifier_cache_customdata_size(&dm->polyData, dm->numPolyData));
+}
+
+static void modifier_cache_entry_free(ModifierStackCache *cache, ModifierCacheEntry *entry)
+{
+	int i;
+
+	for (i = 0; i < entry->errors_len; i++) {
+		MEM_SAFE_FREE(entry->errors[i]);
+	}
+	MEM_SAFE_FREE(entry->errors);
+
+	modifier_cache_dm_free(entry->dm);
+	modifier_cache_dm_free(entry->orcodm);
+	modifier_cache_dm_free(entry->clothorcodm);
+
+	atomic_sub_and_fetch_z(&modifier_cache_mem, entry->mem);
+	cache->mem_in_use -= entry->mem;
+
+	BLI_freelinkN(&cache->entries, entry);
+}
+
+static ModifierCacheEntry *modifier_cache_entry_find(ModifierStackCache *cache, ModifierData *md)
+{
+	ModifierCacheEntry *entry;
+
+	for (entry = cache->entries.first; entry; entry = entry->next) {
+		if (entry->md == md) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+static size_t modifier_cache_limit(void)
+{
+	return (size_t)max_ii(U.modifier_cache_limit, 0) * 1024 * 1024;
+}
+
+/* Free least recently used results until \a mem more bytes fit in the limit. */
+static bool modifier_cache_evict(size_t mem)
+{
+	const size_t limit = modifier_cache_limit();
+
+	if (mem > limit) {
+		return false;
+	}
+
+	while (modifier_cache_mem + mem > limit) {
+		ModifierStackCache *cache, *lru_cache = NULL;
+		ModifierCacheEntry *entry, *lru = NULL;
+
+		for (cache = modifier_caches.first; cache; cache = cache->next) {
+			for (entry = cache->entries.first; entry; entry = entry->next) {
+				if (!entry->used && entry->dm && (lru == NULL || entry->last_used < lru->last_used)) {
+					lru_cache = cache;
+					lru = entry;
+				}
+			}
+		}
+
+		if (lru == NULL) {
+			return false;
+		}
+
+		if (G.debug & G_DEBUG_MODIFIER_CACHE) {
+			printf("modifier cache: evicting a result of %u KB\n", (unsigned int)(lru->mem / 1024));
+		}
+
+		modifier_cache_entry_free(lru_cache, lru);
+	}
+
+	return true;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Object Cache
+ * \{ */
+
+static void modifier_cache_clear_locked(ModifierStackCache *cache)
+{
+	while (cache->entries.first) {
+		modifier_cache_entry_free(cache, cache->entries.first);
+	}
+
+	cache->steps_total = 0;
+	cache->steps_reused = 0;
+}
+
+void BKE_modifier_cache_free(Object *ob)
+{
+	if (ob->modifier_cache) {
+		BLI_mutex_lock(&modifier_cache_lock);
+		modifier_cache_clear_locked(ob->modifier_cache);
+		BLI_remlink(&modifier_caches, ob->modifier_cache);
+		BLI_mutex_unlock(&modifier_cache_lock);
+
+		MEM_freeN(ob->modifier_cache);
+		ob->modifier_cache = NULL;
+	}
+}
+
+/* Free the stored results only, the evaluation counter has to keep going. */
+void BKE_modifier_cache_clear(Object *ob)
+{
+	ModifierStackCache *cache = ob->modifier_cache;
+
+	if (cache) {
+		BLI_mutex_lock(&modifier_cache_lock);
+		modifier_cache_clear_locked(cache);
+		BLI_mutex_unlock(&modifier_cache_lock);
+	}
+}
+
+/* Called from the object data update, also for objects which are no meshes. */
+void BKE_modifier_cache_tag_evaluated(Object *ob)
+{
+	if (ob->modifier_cache == NULL) {
+		if (U.flag & USER_MODIFIER_CACHE_DISABLE) {
+			return;
+		}
+		ob->modifier_cache = MEM_callocN(sizeof(ModifierStackCache), "ModifierStackCache");
+
+		BLI_mutex_lock(&modifier_cache_lock);
+		BLI_addtail(&modifier_caches, ob->modifier_cache);
+		BLI_mutex_unlock(&modifier_cache_lock);
+	}
+	else if (U.flag & USER_MODIFIER_CACHE_DISABLE) {
+		BKE_modifier_cache_clear(ob);
+	}
+
+	ob->modifier_cache->eval_count++;
+	ob->modifier_cache->steps_total = 0;
+	ob->modifier_cache->steps_reused = 0;
+}
+
+size_t BKE_modifier_cache_mem_in_use(void)
+{
+	return modifier_cache_mem;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Mesh Hashing
+ * \{ */
+
+typedef struct ModifierCacheHashChunk {
+	const void *data;
+	size_t size;
+	/* Weights are stored outside of the layer, hash them per vertex. */
+	const MDeformVert *dvert;
+	int dvert_len;
+} ModifierCacheHashChunk;
+
+typedef struct ModifierCacheHashData {
+	ModifierCacheHashChunk *chunks;
+	int chunks_len, chunks_alloc;
+	size_t size;
+	uint32_t *hashes;
+} ModifierCacheHashData;
+
+static ModifierCacheHashChunk *modifier_cache_hash_chunk_add(ModifierCacheHashData *hd)
+{
+	if (hd->chunks_len == hd->chunks_alloc) {
+		hd->chunks_alloc = max_ii(hd->chunks_alloc * 2, 64);
+		hd->chunks = MEM_reallocN(hd->chunks, sizeof(*hd->chunks) * (size_t)hd->chunks_alloc);
+	}
+
+	return memset(&hd->chunks[hd->chunks_len++], 0, sizeof(*hd->chunks));
+}
+
+static void modifier_cache_hash_data_add(ModifierCacheHashData *hd, const void *data, size_t size)
+{
+	const char *cdata = data;
+
+	while (size > 0) {
+		ModifierCacheHashChunk *chunk = modifier_cache_hash_chunk_add(hd);
+		chunk->data = cdata;
+		chunk->size = min_zz(size, MODIFIER_CACHE_HASH_CHUNK);
+
+		hd->size += chunk->size;
+		cdata += chunk->size;
+		size -= chunk->size;
+	}
+}
+
+static void modifier_cache_hash_dvert_add(ModifierCacheHashData *hd, const MDeformVert *dvert, int totvert)
+{
+	const int chunk_len = MODIFIER_CACHE_HASH_CHUNK / sizeof(MDeformWeight);
+	int i;
+
+	for (i = 0; i < totvert; i += chunk_len) {
+		ModifierCacheHashChunk *chunk = modifier_cache_hash_chunk_add(hd);
+		chunk->dvert = dvert + i;
+		chunk->dvert_len = min_ii(chunk_len, totvert - i);
+
+		hd->size += (size_t)chunk->dvert_len * sizeof(MDeformWeight);
+	}
+}
+
+static void modifier_cache_hash_customdata_add(
+        ModifierCacheHashData *hd, BLI_HashMurmur2A *mm2, const CustomData *data, int totelem)
+{
+	int i;
+
+	BLI_hash_mm2a_add_int(mm2, totelem);
+
+	for (i = 0; i < data->totlayer; i++) {
+		const CustomDataLayer *layer = &data->layers[i];
+
+		BLI_hash_mm2a_add_int(mm2, layer->type);
+		BLI_hash_mm2a_add_int(mm2, layer->flag);
+		BLI_hash_mm2a_add(mm2, (const unsigned char *)layer->name, strlen(layer->name));
+
+		if (layer->data == NULL) {
+			continue;
+		}
+
+		switch (layer->type) {
+			case CD_MDEFORMVERT:
+				modifier_cache_hash_dvert_add(hd, layer->data, totelem);
+				break;
+			case CD_MDISPS:
+			case CD_GRID_PAINT_MASK:
+				/* Only used by multires, which is never cached. */
+				break;
+			default:
+				modifier_cache_hash_data_add(hd, layer->data, (size_t)CustomData_sizeof(layer->type) * (size_t)totelem);
+				break;
+		}
+	}
+}
+
+static void modifier_cache_hash_chunk_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	ModifierCacheHashData *hd = userdata;
+	const ModifierCacheHashChunk *chunk = &hd->chunks[i];
+
+	if (chunk->dvert) {
+		BLI_HashMurmur2A mm2;
+		int j;
+
+		BLI_hash_mm2a_init(&mm2, 0);
+		for (j = 0; j < chunk->dvert_len; j++) {
+			const MDeformVert *dv = &chunk->dvert[j];
+			BLI_hash_mm2a_add_int(&mm2, dv->totweight);
+			if (dv->dw) {
+				BLI_hash_mm2a_add(&mm2, (const unsigned char *)dv->dw, sizeof(*dv->dw) * (size_t)dv->totweight);
+			}
+		}
+		hd->hashes[i] = BLI_hash_mm2a_end(&mm2);
+	}
+	else {
+		hd->hashes[i] = BLI_hash_mm2(chunk->data, chunk->size, 0);
+	}
+}
+
+static uint32_t modifier_cache_mesh_key(
+        Object *ob, Mesh *me, const float (*vertexCos)[3], int numVerts,
+        CustomDataMask dataMask, int app_flags, bool need_mapping, bool build_shapekey_layers)
+{
+	ModifierCacheHashData hd = {NULL};
+	BLI_HashMurmur2A mm2;
+	bDeformGroup *defgroup;
+
+	BLI_hash_mm2a_init(&mm2, 0);
+
+	modifier_cache_hash_customdata_add(&hd, &mm2, &me->vdata, me->totvert);
+	modifier_cache_hash_customdata_add(&hd, &mm2, &me->edata, me->totedge);
+	modifier_cache_hash_customdata_add(&hd, &mm2, &me->ldata, me->totloop);
+	modifier_cache_hash_customdata_add(&hd, &mm2, &me->pdata, me->totpoly);
+
+	if (vertexCos) {
+		BLI_hash_mm2a_add_int(&mm2, numVerts);
+		modifier_cache_hash_data_add(&hd, vertexCos, sizeof(*vertexCos) * (size_t)numVerts);
+	}
+
+	if (hd.chunks_len) {
+		ParallelRangeSettings settings;
+		int i;
+
+		hd.hashes = MEM_malloc_arrayN((size_t)hd.chunks_len, sizeof(*hd.hashes), __func__);
+
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.use_threading = (hd.size > 4 * MODIFIER_CACHE_HASH_CHUNK);
+		BLI_task_parallel_range(0, hd.chunks_len, &hd, modifier_cache_hash_chunk_cb, &settings);
+
+		for (i = 0; i < hd.chunks_len; i++) {
+			BLI_hash_mm2a_add_int(&mm2, (int)hd.hashes[i]);
+		}
+
+		MEM_freeN(hd.hashes);
+		MEM_freeN(hd.chunks);
+	}
+
+	/* Mesh settings some modifiers read (auto-smooth, texture space for orco). */
+	BLI_hash_mm2a_add_int(&mm2, me->flag);
+	BLI_hash_mm2a_add(&mm2, (const unsigned char *)&me->smoothresh, sizeof(me->smoothresh));
+	BLI_hash_mm2a_add_int(&mm2, me->texflag);
+	BLI_hash_mm2a_add(&mm2, (const unsigned char *)me->loc, sizeof(me->loc));
+	BLI_hash_mm2a_add(&mm2, (const unsigned char *)me->size, sizeof(me->size));
+
+	/* Vertex groups are looked up by name. */
+	for (defgroup = ob->defbase.first; defgroup; defgroup = defgroup->next) {
+		BLI_hash_mm2a_add(&mm2, (const unsigned char *)defgroup->name, strlen(defgroup->name));
+	}
+	BLI_hash_mm2a_add_int(&mm2, ob->totcol);
+
+	BLI_hash_mm2a_add(&mm2, (const unsigned char *)&dataMask, sizeof(dataMask));
+	BLI_hash_mm2a_add_int(&mm2, app_flags);
+	BLI_hash_mm2a_add_int(&mm2, need_mapping);
+	BLI_hash_mm2a_add_int(&mm2, build_shapekey_layers);
+
+	return BLI_hash_mm2a_end(&mm2);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Modifier Hashing
+ * \{ */
+
+static bool modifier_cache_type_supported(ModifierData *md)
+{
+	const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+
+	if (mti->dependsOnTime && mti->dependsOnTime(md)) {
+		return false;
+	}
+
+	/* Not checking eModifierTypeFlag_UsesPointCache, Boolean sets it too,
+	 * modifiers which actually use point caches are listed here. */
+	switch ((ModifierType)md->type) {
+		/* Simulations, particles and modifiers using data which isn't part of their settings. */
+		case eModifierType_Multires:
+		case eModifierType_ParticleSystem:
+		case eModifierType_ParticleInstance:
+		case eModifierType_Collision:
+		case eModifierType_Surface:
+		case eModifierType_Cloth:
+		case eModifierType_Softbody:
+		case eModifierType_Fluidsim:
+		case eModifierType_Smoke:
+		case eModifierType_DynamicPaint:
+		case eModifierType_Explode:
+		case eModifierType_Ocean:
+		/* Bind data. */
+		case eModifierType_LaplacianDeform:
+		case eModifierType_CorrectiveSmooth:
+		case eModifierType_MeshDeform:
+		case eModifierType_SurfaceDeform:
+			return false;
+		default:
+			return true;
+	}
+}
+
+/* The new depsgraph evaluates poses without the object data update,
+ * so eval_count doesn't change. Hash what armature deform reads instead. */
+static void modifier_cache_pose_hash(BLI_HashMurmur2A *mm2, bPose *pose)
+{
+	bPoseChannel *pchan;
+
+	for (pchan = pose->chanbase.first; pchan; pchan = pchan->next) {
+		const Bone *bone = pchan->bone;
+
+		BLI_hash_mm2a_add(mm2, (const unsigned char *)pchan->pose_mat, sizeof(pchan->pose_mat));
+		BLI_hash_mm2a_add(mm2, (const unsigned char *)pchan->chan_mat, sizeof(pchan->chan_mat));
+
+		if (bone) {
+			/* Deform flags and envelope settings. */
+			const float envelope[] = {
+			    bone->dist, bone->weight, bone->xwidth, bone->zwidth, bone->length,
+			    bone->rad_head, bone->rad_tail,
+			    bone->arm_head[0], bone->arm_head[1], bone->arm_head[2],
+			    bone->arm_tail[0], bone->arm_tail[1], bone->arm_tail[2]};
+
+			BLI_hash_mm2a_add_int(mm2, bone->flag);
+			BLI_hash_mm2a_add(mm2, (const unsigned char *)envelope, sizeof(envelope));
+		}
+
+		if (bone && bone->segments > 1) {
+			const float bbone[] = {
+			    pchan->roll1, pchan->roll2, pchan->curveInX, pchan->curveInY,
+			    pchan->curveOutX, pchan->curveOutY, pchan->ease1, pchan->ease2,
+			    pchan->scaleIn, pchan->scaleOut,
+			    bone->roll1, bone->roll2, bone->curveInX, bone->curveInY,
+			    bone->curveOutX, bone->curveOutY, bone->ease1, bone->ease2,
+			    bone->scaleIn, bone->scaleOut};
+
+			BLI_hash_mm2a_add_int(mm2, bone->segments);
+			BLI_hash_mm2a_add(mm2, (const unsigned char *)bbone, sizeof(bbone));
+		}
+	}
+}
+
+static void modifier_cache_object_hash(BLI_HashMurmur2A *mm2, Object *ob)
+{
+	BLI_hash_mm2a_add(mm2, (const unsigned char *)&ob, sizeof(ob));
+	BLI_hash_mm2a_add(mm2, (const unsigned char *)ob->obmat, sizeof(ob->obmat));
+	BLI_hash_mm2a_add_int(mm2, ob->modifier_cache ? (int)ob->modifier_cache->eval_count : 0);
+
+	if (ob->type == OB_ARMATURE && ob->pose) {
+		modifier_cache_pose_hash(mm2, ob->pose);
+	}
+}
+
+/* Adds all settings of the modifier, returns false when they can't be hashed. */
+static bool modifier_cache_settings_hash(BLI_HashMurmur2A *mm2, Object *ob, ModifierData *md, bool *r_uses_objects)
+{
+	PointerRNA ptr;
+	bool ok = true;
+
+	RNA_pointer_create(&ob->id, &RNA_Modifier, md, &ptr);
+
+	RNA_STRUCT_BEGIN (&ptr, prop)
+	{
+		const PropertyType type = RNA_property_type(prop);
+		const int len = RNA_property_array_check(prop) ? RNA_property_array_length(&ptr, prop) : 0;
+		int i;
+
+		if (STREQ(RNA_property_identifier(prop), "rna_type")) {
+			continue;
+		}
+
+		switch (type) {
+			case PROP_BOOLEAN:
+				if (len) {
+					for (i = 0; i < len; i++) {
+						BLI_hash_mm2a_add_int(mm2, RNA_property_boolean_get_index(&ptr, prop, i));
+					}
+				}
+				else {
+					BLI_hash_mm2a_add_int(mm2, RNA_property_boolean_get(&ptr, prop));
+				}
+				break;
+			case PROP_INT:
+				if (len) {
+					for (i = 0; i < len; i++) {
+						BLI_hash_mm2a_add_int(mm2, RNA_property_int_get_index(&ptr, prop, i));
+					}
+				}
+				else {
+					BLI_hash_mm2a_add_int(mm2, RNA_property_int_get(&ptr, prop));
+				}
+				break;
+			case PROP_FLOAT:
+				if (len) {
+					for (i = 0; i < len; i++) {
+						const float value = RNA_property_float_get_index(&ptr, prop, i);
+						BLI_hash_mm2a_add(mm2, (const unsigned char *)&value, sizeof(value));
+					}
+				}
+				else {
+					const float value = RNA_property_float_get(&ptr, prop);
+					BLI_hash_mm2a_add(mm2, (const unsigned char *)&value, sizeof(value));
+				}
+				break;
+			case PROP_ENUM:
+				BLI_hash_mm2a_add_int(mm2, RNA_property_enum_get(&ptr, prop));
+				break;
+			case PROP_STRING:
+			{
+				char fixedbuf[256];
+				int str_len;
+				char *str = RNA_property_string_get_alloc(&ptr, prop, fixedbuf, sizeof(fixedbuf), &str_len);
+				BLI_hash_mm2a_add(mm2, (const unsigned char *)str, (size_t)str_len);
+				if (str != fixedbuf) {
+					MEM_freeN(str);
+				}
+				break;
+			}
+			case PROP_POINTER:
+			{
+				PointerRNA pptr = RNA_property_pointer_get(&ptr, prop);
+
+				if (pptr.data == NULL) {
+					BLI_hash_mm2a_add_int(mm2, 0);
+				}
+				else if (RNA_struct_is_ID(pptr.type) && GS(((ID *)pptr.data)->name) == ID_OB) {
+					modifier_cache_object_hash(mm2, pptr.data);
+					*r_uses_objects = true;
+				}
+				else {
+					/* Textures, images, curve mappings, ... */
+					ok = false;
+				}
+				break;
+			}
+			case PROP_COLLECTION:
+				ok = false;
+				break;
+		}
+
+		if (!ok) {
+			break;
+		}
+	}
+	RNA_STRUCT_END;
+
+	return ok;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Evaluation
+ * \{ */
+
+/**
+ * Start evaluation of the modifier stack of \a ob, \a vertexCos being the result of
+ * the leading deform modifiers. Returns NULL when caching is disabled.
+ */
+ModifierCacheEval *BKE_modifier_cache_eval_begin(
+        Object *ob, Mesh *me, const float (*vertexCos)[3], int numVerts,
+        CustomDataMask dataMask, int app_flags, bool need_mapping, bool build_shapekey_layers)
+{
+	ModifierCacheEval *ce;
+
+	if ((U.flag & USER_MODIFIER_CACHE_DISABLE) || ob->modifier_cache == NULL) {
+		return NULL;
+	}
+
+	ce = MEM_callocN(sizeof(*ce), __func__);
+	ce->ob = ob;
+	ce->cache = ob->modifier_cache;
+	ce->key = modifier_cache_mesh_key(ob, me, vertexCos, numVerts, dataMask, app_flags,
+	                                  need_mapping, build_shapekey_layers);
+	ce->valid = true;
+	ce->resume_step = -1;
+
+	return ce;
+}
+
+/**
+ * Add the next modifier which will be evaluated, in stack order.
+ * All steps have to be added before restoring.
+ */
+void BKE_modifier_cache_eval_step(
+        ModifierCacheEval *ce, ModifierData *md,
+        CustomDataMask mask, CustomDataMask nextmask, bool is_constructive)
+{
+	ModifierCacheStep *step;
+
+	if (ce->steps_len == ce->steps_alloc) {
+		ce->steps_alloc = max_ii(ce->steps_alloc * 2, 16);
+		ce->steps = MEM_reallocN(ce->steps, sizeof(*ce->steps) * (size_t)ce->steps_alloc);
+	}
+
+	step = &ce->steps[ce->steps_len];
+	step->md = md;
+	step->is_constructive = is_constructive;
+
+	if (ce->valid && modifier_cache_type_supported(md)) {
+		BLI_HashMurmur2A mm2;
+		bool uses_objects = false;
+
+		BLI_hash_mm2a_init(&mm2, ce->key);
+		BLI_hash_mm2a_add_int(&mm2, md->type);
+		BLI_hash_mm2a_add(&mm2, (const unsigned char *)&mask, sizeof(mask));
+		BLI_hash_mm2a_add(&mm2, (const unsigned char *)&nextmask, sizeof(nextmask));
+
+		ce->valid = modifier_cache_settings_hash(&mm2, ce->ob, md, &uses_objects);
+
+		/* Results relative to other objects depend on our own transform too. */
+		if (uses_objects) {
+			BLI_hash_mm2a_add(&mm2, (const unsigned char *)ce->ob->obmat, sizeof(ce->ob->obmat));
+		}
+
+		ce->key = BLI_hash_mm2a_end(&mm2);
+	}
+	else {
+		ce->valid = false;
+	}
+
+	step->key = ce->key;
+
+	if (ce->valid && is_constructive) {
+		ModifierCacheEntry *entry;
+
+		BLI_mutex_lock(&modifier_cache_lock);
+		entry = modifier_cache_entry_find(ce->cache, md);
+		if (entry && entry->key == step->key) {
+			entry->used = true;
+			entry->last_used = ++modifier_cache_clock;
+			if (entry->dm) {
+				ce->resume = entry;
+				ce->resume_step = ce->steps_len;
+			}
+		}
+		BLI_mutex_unlock(&modifier_cache_lock);
+	}
+
+	if (!ce->valid) {
+		/* Step can't be cached, don't keep anything for it. */
+		step->is_constructive = false;
+	}
+
+	ce->steps_len++;
+}
+
+/**
+ * Get copies of the stored results to continue evaluation from.
+ * Returns the modifier they are the result of, evaluation continues after it,
+ * or NULL if the whole stack has to be evaluated.
+ */
+ModifierData *BKE_modifier_cache_eval_restore(
+        ModifierCacheEval *ce,
+        DerivedMesh **r_dm, DerivedMesh **r_orcodm, DerivedMesh **r_clothorcodm,
+        CustomDataMask *r_append_mask)
+{
+	ModifierCacheEntry *entry = ce->resume;
+	int i;
+
+	ce->cache->steps_total = ce->steps_len;
+	ce->cache->steps_reused = ce->resume_step + 1;
+
+	if (entry == NULL) {
+		return NULL;
+	}
+
+	for (i = 0; i < entry->errors_len; i++) {
+		if (entry->errors[i]) {
+			modifier_setError(ce->steps[i].md, "%s", entry->errors[i]);
+		}
+	}
+
+	*r_dm = CDDM_copy(entry->dm);
+	*r_orcodm = entry->orcodm ? CDDM_copy(entry->orcodm) : NULL;
+	*r_clothorcodm = entry->clothorcodm ? CDDM_copy(entry->clothorcodm) : NULL;
+	*r_append_mask = entry->append_mask;
+
+	if (G.debug & G_DEBUG_MODIFIER_CACHE) {
+		printf("modifier cache %s: resuming after '%s' (%d of %d steps)\n",
+		       ce->ob->id.name + 2, entry->md->name, ce->resume_step + 1, ce->steps_len);
+	}
+
+	return entry->md;
+}
+
+/* Store the result of a constructive modifier, when it can be reused later. */
+void BKE_modifier_cache_eval_store(
+        ModifierCacheEval *ce, ModifierData *md,
+        DerivedMesh *dm, DerivedMesh *orcodm, DerivedMesh *clothorcodm,
+        CustomDataMask append_mask)
+{
+	ModifierStackCache *cache = ce->cache;
+	ModifierCacheStep *step = NULL;
+	ModifierCacheEntry *entry;
+	size_t mem;
+	int i;
+
+	for (i = ce->resume_step + 1; i < ce->steps_len; i++) {
+		if (ce->steps[i].md == md) {
+			step = &ce->steps[i];
+			break;
+		}
+	}
+
+	if (step == NULL || !step->is_constructive) {
+		return;
+	}
+
+	/* Only plain meshes, other types (CCG) are drawn in their own way. */
+	if (dm == NULL || dm->type != DM_TYPE_CDDM ||
+	    (orcodm && orcodm->type != DM_TYPE_CDDM) ||
+	    (clothorcodm && clothorcodm->type != DM_TYPE_CDDM))
+	{
+		return;
+	}
+
+	mem = modifier_cache_dm_size(dm) + modifier_cache_dm_size(orcodm) + modifier_cache_dm_size(clothorcodm);
+
+	BLI_mutex_lock(&modifier_cache_lock);
+
+	entry = modifier_cache_entry_find(cache, md);
+
+	/* First time this key is seen, only remember it: if it changes again on
+	 * the next evaluation (animation, time dependent inputs) storing is wasted. */
+	if (entry == NULL || entry->key != step->key) {
+		if (entry) {
+			modifier_cache_entry_free(cache, entry);
+		}
+
+		entry = MEM_callocN(sizeof(*entry), __func__);
+		entry->md = md;
+		entry->key = step->key;
+		entry->used = true;
+		entry->last_used = ++modifier_cache_clock;
+		BLI_addtail(&cache->entries, entry);
+
+		BLI_mutex_unlock(&modifier_cache_lock);
+		return;
+	}
+
+	modifier_cache_entry_free(cache, entry);
+
+	/* Make room by dropping older results, of this or other objects. */
+	if (!modifier_cache_evict(mem)) {
+		BLI_mutex_unlock(&modifier_cache_lock);
+		return;
+	}
+
+	atomic_add_and_fetch_z(&modifier_cache_mem, mem);
+	cache->mem_in_use += mem;
+
+	entry = MEM_callocN(sizeof(*entry), __func__);
+	entry->md = md;
+	entry->key = step->key;
+	entry->used = true;
+	entry->last_used = ++modifier_cache_clock;
+	entry->mem = mem;
+	BLI_addtail(&cache->entries, entry);
+
+	BLI_mutex_unlock(&modifier_cache_lock);
+
+	/* The entry is used, so no other thread frees it while copying. */
+	entry->dm = CDDM_copy(dm);
+	entry->orcodm = orcodm ? CDDM_copy(orcodm) : NULL;
+	entry->clothorcodm = clothorcodm ? CDDM_copy(clothorcodm) : NULL;
+	entry->append_mask = append_mask;
+
+	entry->errors_len = (int)(step - ce->steps) + 1;
+	entry->errors = MEM_calloc_arrayN((size_t)entry->errors_len, sizeof(*entry->errors), __func__);
+	for (i = 0; i < entry->errors_len; i++) {
+		if (ce->steps[i].md->error) {
+			entry->errors[i] = BLI_strdup(ce->steps[i].md->error);
+		}
+	}
+}
+
+/* Free results which were not used by this evaluation. */
+void BKE_modifier_cache_eval_end(ModifierCacheEval *ce)
+{
+	ModifierStackCache *cache = ce->cache;
+	ModifierCacheEntry *entry, *entry_next;
+
+	BLI_mutex_lock(&modifier_cache_lock);
+	for (entry = cache->entries.first; entry; entry = entry_next) {
+		entry_next = entry->next;
+
+		if (entry->used) {
+			entry->used = false;
+		}
+		else {
+			modifier_cache_entry_free(cache, entry);
+		}
+	}
+	BLI_mutex_unlock(&modifier_cache_lock);
+
+	MEM_SAFE_FREE(ce->steps);
+	MEM_freeN(ce);
+}
+
+/** \} */
@@ -78,7 +78,9 @@ typedef enum {
 } DispOp;
 
 static void multires_mvert_to_ss(DerivedMesh *dm, MVert *mvert);
-static void multiresModifier_disp_run(DerivedMesh *dm, Mesh *me, DerivedMesh *dm2, DispOp op, CCGElem **oldGridData, int totlvl);
+static void multiresModifier_disp_run(
+        DerivedMesh *dm, Mesh *me, DerivedMesh *dm2, DispOp op, CCGElem **oldGridData, int totlvl,
+        const BLI_bitmap *poly_mask);
 
 /** Customdata **/
 
@@ -530,10 +532,10 @@ static void multires_reallocate_mdisps(int totloop, MDisps *mdisps, int lvl)
 {
 	int i;
 
-	/* reallocate displacements to be filled in */
+	/* reset displacements to be filled in, grids are left unallocated (zero displacement)
+	 * until a non-zero displacement is calculated for them */
 	for (i = 0; i < totloop; ++i) {
 		int totdisp = multires_grid_tot[lvl];
-		float (*disps)[3] = MEM_calloc_arrayN(totdisp, 3 * sizeof(float), "multires disps");
 
 		if (mdisps[i].disps)
 			MEM_freeN(mdisps[i].disps);
@@ -541,12 +543,33 @@ static void multires_reallocate_mdisps(int totloop, MDisps *mdisps, int lvl)
 		if (mdisps[i].level && mdisps[i].hidden)
 			multires_mdisps_subdivide_hidden(&mdisps[i], lvl);
 
-		mdisps[i].disps = disps;
+		mdisps[i].disps = NULL;
 		mdisps[i].totdisp = totdisp;
 		mdisps[i].level = lvl;
 	}
 }
 
+/* grids which were never displaced are kept unallocated (NULL disps) */
+static bool multires_mdisps_has_displacement(const MDisps *mdisps, int totloop)
+{
+	int i;
+
+	for (i = 0; i < totloop; ++i) {
+		if (mdisps[i].disps)
+			return true;
+	}
+
+	return false;
+}
+
+static float (*multires_mdisps_ensure_disps(MDisps *mdisp))[3]
+{
+	if (mdisp->disps == NULL)
+		mdisp->disps = MEM_calloc_arrayN(mdisp->totdisp, 3 * sizeof(float), "multires disps");
+
+	return mdisp->disps;
+}
+
 static void multires_copy_grid(float (*gridA)[3], float (*gridB)[3], int sizeA, int sizeB)
 {
 	int x, y, j, skip;
@@ -642,12 +665,19 @@ static void multires_del_higher(MultiresModifierData *mmd, Object *ob, int lvl)
 					float (*disps)[3], (*ndisps)[3], (*hdisps)[3];
 					int totdisp = multires_grid_tot[lvl];
 
-					disps = MEM_calloc_arrayN(totdisp, 3 * sizeof(float), "multires disps");
+					/* sparse grids stay sparse, there is nothing to downsample */
+					if (mdisp->disps) {
+						disps = MEM_calloc_arrayN(totdisp, 3 * sizeof(float), "multires disps");
+
+						ndisps = disps;
+						hdisps = mdisp->disps;
 
-					ndisps = disps;
-					hdisps = mdisp->disps;
+						multires_copy_grid(ndisps, hdisps, nsize, hsize);
+
+						MEM_freeN(mdisp->disps);
+						mdisp->disps = disps;
+					}
 
-					multires_copy_grid(ndisps, hdisps, nsize, hsize);
 					if (mdisp->hidden) {
 						BLI_bitmap *gh =
 						    multires_mdisps_downsample_hidden(mdisp->hidden,
@@ -657,11 +687,6 @@ static void multires_del_higher(MultiresModifierData *mmd, Object *ob, int lvl)
 						mdisp->hidden = gh;
 					}
 
-					ndisps += nsize * nsize;
-					hdisps += hsize * hsize;
-
-					MEM_freeN(mdisp->disps);
-					mdisp->disps = disps;
 					mdisp->totdisp = totdisp;
 					mdisp->level = lvl;
 
@@ -872,7 +897,7 @@ void multiresModifier_base_apply(MultiresModifierData *mmd, Object *ob)
 	cddm->release(cddm);
 
 	/* calc disps */
-	multiresModifier_disp_run(dispdm, me, NULL, CALC_DISPLACEMENTS, origdm->getGridData(origdm), totlvl);
+	multiresModifier_disp_run(dispdm, me, NULL, CALC_DISPLACEMENTS, origdm->getGridData(origdm), totlvl, NULL);
 
 	origdm->release(origdm);
 	dispdm->release(dispdm);
@@ -895,7 +920,7 @@ static void multires_subdivide(MultiresModifierData *mmd, Object *ob, int totlvl
 	if (!mdisps)
 		mdisps = multires_mdisps_initialize_hidden(me, totlvl);
 
-	if (mdisps->disps && !updateblock && lvl != 0) {
+	if (multires_mdisps_has_displacement(mdisps, me->totloop) && !updateblock && lvl != 0) {
 		/* upsample */
 		DerivedMesh *lowdm, *cddm, *highdm;
 		CCGElem **highGridData, **lowGridData, **subGridData;
@@ -945,7 +970,7 @@ static void multires_subdivide(MultiresModifierData *mmd, Object *ob, int totlvl
 		multires_reallocate_mdisps(me->totloop, mdisps, totlvl);
 
 		/* compute displacements */
-		multiresModifier_disp_run(highdm, me, NULL, CALC_DISPLACEMENTS, subGridData, totlvl);
+		multiresModifier_disp_run(highdm, me, NULL, CALC_DISPLACEMENTS, subGridData, totlvl, NULL);
 
 		/* free */
 		highdm->release(highdm);
@@ -1015,6 +1040,7 @@ typedef struct MultiresThreadedData {
 	int *gridOffset;
 	int gridSize, dGridSize, dSkip;
 	float (*smat)[3];
+	const BLI_bitmap *poly_mask;
 } MultiresThreadedData;
 
 static void multires_disp_run_cb(
@@ -1039,6 +1065,9 @@ static void multires_disp_run_cb(
 	const int numVerts = mpoly[pidx].totloop;
 	int S, x, y, gIndex = gridOffset[pidx];
 
+	if (tdata->poly_mask && !BLI_BITMAP_TEST(tdata->poly_mask, pidx))
+		return;
+
 	for (S = 0; S < numVerts; ++S, ++gIndex) {
 		GridPaintMask *gpm = grid_paint_mask ? &grid_paint_mask[gIndex] : NULL;
 		MDisps *mdisp = &mdisps[mpoly[pidx].loopstart + S];
@@ -1061,32 +1090,43 @@ static void multires_disp_run_cb(
 			for (x = 0; x < gridSize; x++) {
 				float *co = CCG_grid_elem_co(key, grid, x, y);
 				float *sco = CCG_grid_elem_co(key, subgrid, x, y);
-				float *data = dispgrid[dGridSize * y * dSkip + x * dSkip];
+				const int dindex = dGridSize * y * dSkip + x * dSkip;
 				float mat[3][3], disp[3], d[3], mask;
 
-				/* construct tangent space matrix */
-				grid_tangent_matrix(mat, key, x, y, subgrid);
-
 				switch (op) {
 					case APPLY_DISPLACEMENTS:
 						/* Convert displacement to object space
 						 * and add to grid points */
-						mul_v3_m3v3(disp, mat, data);
-						add_v3_v3v3(co, sco, disp);
+						if (dispgrid) {
+							grid_tangent_matrix(mat, key, x, y, subgrid);
+							mul_v3_m3v3(disp, mat, dispgrid[dindex]);
+							add_v3_v3v3(co, sco, disp);
+						}
+						else {
+							copy_v3_v3(co, sco);
+						}
 						break;
 					case CALC_DISPLACEMENTS:
 						/* Calculate displacement between new and old
 						 * grid points and convert to tangent space */
 						sub_v3_v3v3(disp, co, sco);
-						invert_m3(mat);
-						mul_v3_m3v3(data, mat, disp);
+						if (dispgrid || !is_zero_v3(disp)) {
+							dispgrid = multires_mdisps_ensure_disps(mdisp);
+							grid_tangent_matrix(mat, key, x, y, subgrid);
+							invert_m3(mat);
+							mul_v3_m3v3(dispgrid[dindex], mat, disp);
+						}
 						break;
 					case ADD_DISPLACEMENTS:
 						/* Convert subdivided displacements to tangent
 						 * space and add to the original displacements */
-						invert_m3(mat);
-						mul_v3_m3v3(d, mat, co);
-						add_v3_v3(data, d);
+						if (dispgrid || !is_zero_v3(co)) {
+							dispgrid = multires_mdisps_ensure_disps(mdisp);
+							grid_tangent_matrix(mat, key, x, y, subgrid);
+							invert_m3(mat);
+							mul_v3_m3v3(d, mat, co);
+							add_v3_v3(dispgrid[dindex], d);
+						}
 						break;
 				}
 
@@ -1117,7 +1157,9 @@ static void multires_disp_run_cb(
 /* XXX WARNING: subsurf elements from dm and oldGridData *must* be of the same format (size),
  *              because this code uses CCGKey's info from dm to access oldGridData's normals
  *              (through the call to grid_tangent_matrix())! */
-static void multiresModifier_disp_run(DerivedMesh *dm, Mesh *me, DerivedMesh *dm2, DispOp op, CCGElem **oldGridData, int totlvl)
+static void multiresModifier_disp_run(
+        DerivedMesh *dm, Mesh *me, DerivedMesh *dm2, DispOp op, CCGElem **oldGridData, int totlvl,
+        const BLI_bitmap *poly_mask)
 {
 	CCGDerivedMesh *ccgdm = (CCGDerivedMesh *)dm;
 	CCGElem **gridData, **subGridData;
@@ -1162,11 +1204,12 @@ static void multiresModifier_disp_run(DerivedMesh *dm, Mesh *me, DerivedMesh *dm
 	if (key.has_mask)
 		grid_paint_mask = CustomData_get_layer(&me->ldata, CD_GRID_PAINT_MASK);
 
-	/* when adding new faces in edit mode, need to allocate disps */
+	/* grids without disps (new faces from edit mode, or never displaced) are zero
+	 * displacement, they only get allocated once a displacement is calculated for them */
 	for (i = 0; i < totloop; ++i) {
 		if (mdisps[i].disps == NULL) {
-			multires_reallocate_mdisps(totloop, mdisps, totlvl);
-			break;
+			mdisps[i].totdisp = multires_grid_tot[totlvl];
+			mdisps[i].level = totlvl;
 		}
 	}
 
@@ -1185,7 +1228,8 @@ static void multiresModifier_disp_run(DerivedMesh *dm, Mesh *me, DerivedMesh *dm
 	    .gridOffset = gridOffset,
 	    .gridSize = gridSize,
 	    .dGridSize = dGridSize,
-	    .dSkip = dSkip
+	    .dSkip = dSkip,
+	    .poly_mask = poly_mask
 	};
 
 	BLI_task_parallel_range(0, totpoly, &data, multires_disp_run_cb, &settings);
@@ -1196,6 +1240,41 @@ static void multiresModifier_disp_run(DerivedMesh *dm, Mesh *me, DerivedMesh *dm
 	}
 }
 
+/**
+ * Faces whose displacements have to be recalculated after the grids of \a modified_polys changed.
+ * Stitching and subdividing the difference reaches into the faces sharing a vertex with a
+ * modified face, so those are included as well.
+ */
+static BLI_bitmap *multires_modified_polys_expand(const Mesh *me, const BLI_bitmap *modified_polys)
+{
+	BLI_bitmap *vert_tag = BLI_BITMAP_NEW(me->totvert, __func__);
+	BLI_bitmap *poly_mask = BLI_BITMAP_NEW(me->totpoly, __func__);
+	int i, j;
+
+	for (i = 0; i < me->totpoly; i++) {
+		if (BLI_BITMAP_TEST(modified_polys, i)) {
+			const MLoop *ml = &me->mloop[me->mpoly[i].loopstart];
+			for (j = 0; j < me->mpoly[i].totloop; j++, ml++) {
+				BLI_BITMAP_ENABLE(vert_tag, ml->v);
+			}
+		}
+	}
+
+	for (i = 0; i < me->totpoly; i++) {
+		const MLoop *ml = &me->mloop[me->mpoly[i].loopstart];
+		for (j = 0; j < me->mpoly[i].totloop; j++, ml++) {
+			if (BLI_BITMAP_TEST(vert_tag, ml->v)) {
+				BLI_BITMAP_ENABLE(poly_mask, i);
+				break;
+			}
+		}
+	}
+
+	MEM_freeN(vert_tag);
+
+	return poly_mask;
+}
+
 void multires_modifier_update_mdisps(struct DerivedMesh *dm)
 {
 	CCGDerivedMesh *ccgdm = (CCGDerivedMesh *)dm;
@@ -1203,6 +1282,7 @@ void multires_modifier_update_mdisps(struct DerivedMesh *dm)
 	Mesh *me;
 	MDisps *mdisps;
 	MultiresModifierData *mmd;
+	BLI_bitmap *poly_mask = NULL;
 
 	ob = ccgdm->multires.ob;
 	me = ccgdm->multires.ob->data;
@@ -1211,6 +1291,12 @@ void multires_modifier_update_mdisps(struct DerivedMesh *dm)
 	CustomData_external_read(&me->ldata, &me->id, CD_MASK_MDISPS, me->totloop);
 	mdisps = CustomData_get_layer(&me->ldata, CD_MDISPS);
 
+	/* only the faces touched by sculpting need their displacements recalculated,
+	 * without tracking info (or a different topology) everything is updated */
+	if (ccgdm->multires.modified_polys && ccgSubSurf_getNumFaces(ccgdm->ss) == me->totpoly) {
+		poly_mask = multires_modified_polys_expand(me, ccgdm->multires.modified_polys);
+	}
+
 	if (mdisps) {
 		int lvl = ccgdm->multires.lvl;
 		int totlvl = ccgdm->multires.totlvl;
@@ -1274,7 +1360,7 @@ void multires_modifier_update_mdisps(struct DerivedMesh *dm)
 			ccgSubSurf_updateLevels(ss, lvl, NULL, 0);
 
 			/* add to displacements */
-			multiresModifier_disp_run(highdm, me, NULL, ADD_DISPLACEMENTS, subGridData, mmd->totlvl);
+			multiresModifier_disp_run(highdm, me, NULL, ADD_DISPLACEMENTS, subGridData, mmd->totlvl, poly_mask);
 
 			/* free */
 			highdm->release(highdm);
@@ -1293,11 +1379,14 @@ void multires_modifier_update_mdisps(struct DerivedMesh *dm)
 			subdm = subsurf_dm_create_local(ob, cddm, mmd->totlvl, mmd->simple, 0, mmd->flags & eMultiresModifierFlag_PlainUv, has_mask);
 			cddm->release(cddm);
 
-			multiresModifier_disp_run(dm, me, NULL, CALC_DISPLACEMENTS, subdm->getGridData(subdm), mmd->totlvl);
+			multiresModifier_disp_run(dm, me, NULL, CALC_DISPLACEMENTS, subdm->getGridData(subdm), mmd->totlvl, poly_mask);
 
 			subdm->release(subdm);
 		}
 	}
+
+	if (poly_mask)
+		MEM_freeN(poly_mask);
 }
 
 void multires_modifier_update_hidden(DerivedMesh *dm)
@@ -1521,7 +1610,7 @@ DerivedMesh *multires_make_derived_from_derived(DerivedMesh *dm,
 	CustomData_external_read(&me->ldata, &me->id, CD_MASK_MDISPS, me->totloop);
 
 	/*run displacement*/
-	multiresModifier_disp_run(result, ob->data, dm, APPLY_DISPLACEMENTS, subGridData, mmd->totlvl);
+	multiresModifier_disp_run(result, ob->data, dm, APPLY_DISPLACEMENTS, subGridData, mmd->totlvl, NULL);
 
 	/* copy hidden elements for this level */
 	if (ccgdm)
@@ -2251,7 +2340,8 @@ static void multires_apply_smat_cb(
 	for (S = 0; S < numVerts; ++S, ++gIndex, mdisp++) {
 		CCGElem *grid = gridData[gIndex];
 		CCGElem *subgrid = subGridData[gIndex];
-		float (*dispgrid)[3] = mdisp->disps;
+		/* scaling displaces sparse grids as well */
+		float (*dispgrid)[3] = multires_mdisps_ensure_disps(mdisp);
 
 		for (y = 0; y < gridSize; y++) {
 			for (x = 0; x < gridSize; x++) {
@@ -2410,14 +2500,9 @@ void multires_topology_changed(Mesh *me)
 	}
 
 	for (i = 0; i < me->totloop; i++, mdisp++) {
-		/* allocate memory for mdisp, the whole disp layer would be erased otherwise */
-		if (!mdisp->totdisp || !mdisp->disps) {
-			if (grid) {
-				mdisp->totdisp = grid;
-				mdisp->disps = MEM_calloc_arrayN(3 * sizeof(float),  mdisp->totdisp, "mdisp topology");
-			}
-
-			continue;
+		/* new grids are left unallocated (zero displacement), only their size is set */
+		if (!mdisp->totdisp && grid) {
+			mdisp->totdisp = grid;
 		}
 	}
 }
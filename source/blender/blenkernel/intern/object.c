@@ -100,6 +100,7 @@
 #include "BKE_editmesh.h"
 #include "BKE_mball.h"
 #include "BKE_modifier.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_multires.h"
 #include "BKE_node.h"
 #include "BKE_object.h"
@@ -396,6 +397,9 @@ void BKE_object_free_caches(Object *object)
 		}
 	}
 
+	/* Free intermediate results of the modifier stack. */
+	BKE_modifier_cache_clear(object);
+
 	/* Tag object for update, so once memory critical operation is over and
 	 * scene update routines are back to it's business the object will be
 	 * guaranteed to be in a known state.
@@ -455,6 +459,8 @@ void BKE_object_free(Object *ob)
 
 	BLI_freelistN(&ob->lodlevels);
 
+	BKE_modifier_cache_free(ob);
+
 	/* Free runtime curves data. */
 	if (ob->curve_cache) {
 		BKE_curve_bevelList_free(&ob->curve_cache->bev);
@@ -946,7 +952,6 @@ ParticleSystem *BKE_object_copy_particlesystem(ParticleSystem *psys, const int f
 	psysn->pdd = NULL;
 	psysn->effectors = NULL;
 	psysn->tree = NULL;
-	psysn->bvhtree = NULL;
 
 	BLI_listbase_clear(&psysn->pathcachebufs);
 	BLI_listbase_clear(&psysn->childcachebufs);
@@ -1187,6 +1192,7 @@ void BKE_object_copy_data(Main *UNUSED(bmain), Object *ob_dst, const Object *ob_
 
 	/* Do not copy runtime curve data. */
 	ob_dst->curve_cache = NULL;
+	ob_dst->modifier_cache = NULL;
 
 	/* Do not copy object's preview (mostly due to the fact renderers create temp copy of objects). */
 	if ((flag & LIB_ID_COPY_NO_PREVIEW) == 0 && false) {  /* XXX TODO temp hack */
@@ -55,6 +55,7 @@
 #include "BKE_lattice.h"
 #include "BKE_main.h"
 #include "BKE_material.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_object.h"
 #include "BKE_particle.h"
 #include "BKE_pointcache.h"
@@ -153,6 +154,9 @@ void BKE_object_handle_data_update(
 	if (G.debug & G_DEBUG_DEPSGRAPH_EVAL)
 		printf("recalcdata %s\n", ob->id.name + 2);
 
+	/* Let users of this object's data know it changed, see modifier_cache.c. */
+	BKE_modifier_cache_tag_evaluated(ob);
+
 	/* TODO(sergey): Only used by legacy depsgraph. */
 	if (adt) {
 		/* evaluate drivers - datalevel */
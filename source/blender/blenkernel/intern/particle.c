@@ -595,7 +595,6 @@ void psys_free(Object *ob, ParticleSystem *psys)
 
 		BLI_freelistN(&psys->targets);
 
-		BLI_bvhtree_free(psys->bvhtree);
 		BLI_kdtree_free(psys->tree);
 
 		if (psys->fluid_springs)
@@ -104,8 +104,6 @@
 
 #endif // WITH_MOD_FLUID
 
-static ThreadRWMutex psys_bvhtree_rwlock = BLI_RWLOCK_INITIALIZER;
-
 /************************************************/
 /*			Reacting to system events			*/
 /************************************************/
@@ -1237,43 +1235,6 @@ void psys_get_pointcache_start_end(Scene *scene, ParticleSystem *psys, int *sfra
 /************************************************/
 /*			Effectors							*/
 /************************************************/
-static void psys_update_particle_bvhtree(ParticleSystem *psys, float cfra)
-{
-	if (psys) {
-		PARTICLE_P;
-		int totpart = 0;
-		bool need_rebuild;
-
-		BLI_rw_mutex_lock(&psys_bvhtree_rwlock, THREAD_LOCK_READ);
-		need_rebuild = !psys->bvhtree || psys->bvhtree_frame != cfra;
-		BLI_rw_mutex_unlock(&psys_bvhtree_rwlock);
-
-		if (need_rebuild) {
-			LOOP_SHOWN_PARTICLES {
-				totpart++;
-			}
-
-			BLI_rw_mutex_lock(&psys_bvhtree_rwlock, THREAD_LOCK_WRITE);
-
-			BLI_bvhtree_free(psys->bvhtree);
-			psys->bvhtree = BLI_bvhtree_new(totpart, 0.0, 4, 6);
-
-			LOOP_SHOWN_PARTICLES {
-				if (pa->alive == PARS_ALIVE) {
-					if (pa->state.time == cfra)
-						BLI_bvhtree_insert(psys->bvhtree, p, pa->prev_state.co, 1);
-					else
-						BLI_bvhtree_insert(psys->bvhtree, p, pa->state.co, 1);
-				}
-			}
-			BLI_bvhtree_balance(psys->bvhtree);
-
-			psys->bvhtree_frame = cfra;
-
-			BLI_rw_mutex_unlock(&psys_bvhtree_rwlock);
-		}
-	}
-}
 void psys_update_particle_tree(ParticleSystem *psys, float cfra)
 {
 	if (psys) {
@@ -1479,6 +1440,27 @@ static ParticleSpring *sph_spring_add(ParticleSystem *psys, ParticleSpring *spri
 
 	return psys->fluid_springs + psys->tot_fluidsprings - 1;
 }
+/* Springs created from a parallel loop go to the thread's own buffer, which is
+ * appended to the particle system afterwards (see sph_springs_flush). */
+static void sph_spring_buffer_add(SPHData *sphdata, const ParticleSpring *spring)
+{
+	if (sphdata->tot_new_springs == sphdata->alloc_new_springs) {
+		sphdata->alloc_new_springs = max_ii(sphdata->alloc_new_springs * 2, PSYS_FLUID_SPRINGS_INITIAL_SIZE);
+		sphdata->new_springs = MEM_reallocN_id(sphdata->new_springs, sphdata->alloc_new_springs * sizeof(ParticleSpring), __func__);
+	}
+
+	sphdata->new_springs[sphdata->tot_new_springs++] = *spring;
+}
+static void sph_springs_flush(ParticleSystem *psys, SPHData *sphdata)
+{
+	int i;
+
+	for (i = 0; i < sphdata->tot_new_springs; i++)
+		sph_spring_add(psys, sphdata->new_springs + i);
+
+	MEM_SAFE_FREE(sphdata->new_springs);
+	sphdata->tot_new_springs = sphdata->alloc_new_springs = 0;
+}
 static void sph_spring_delete(ParticleSystem *psys, int j)
 {
 	if (j != psys->tot_fluidsprings - 1)
@@ -1551,6 +1533,172 @@ static EdgeHash *sph_springhash_build(ParticleSystem *psys)
 	return springhash;
 }
 
+/* ---------------------------------------------------------------------
+ * Uniform grid for neighbor search
+ *
+ * Particles are bucketed into cubic cells of the largest interaction radius,
+ * cell coordinates are hashed into a table of at least twice the particle count.
+ * A counting sort by hash bucket stores positions and indices contiguously per
+ * bucket, so a range query only visits the cells overlapping the search sphere.
+ * The grid is rebuilt every step, iterating the particles in grid order keeps
+ * neighboring particles on the same thread and in cache.
+ * --------------------------------------------------------------------- */
+
+typedef struct SPHGrid {
+	float inv_cell_size;
+	unsigned int table_mask;
+	unsigned int *bucket_start;		/* table size + 1 offsets into the sorted arrays */
+
+	/* particles in the grid, sorted by bucket */
+	int totpoint;
+	float (*co)[3];
+
+	/* all particles of the system, the ones in the grid first (in bucket order),
+	 * followed by the ones that are not (dead, unborn, unexisting), in index order */
+	int totpart;
+	int *index;
+} SPHGrid;
+
+BLI_INLINE int sph_grid_coord(const SPHGrid *grid, float x)
+{
+	/* clamp to avoid integer overflow for far away particles */
+	return (int)floorf(clamp_f(x * grid->inv_cell_size, -1.0e9f, 1.0e9f));
+}
+
+BLI_INLINE unsigned int sph_grid_hash(const SPHGrid *grid, int x, int y, int z)
+{
+	return (((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u) ^ ((unsigned int)z * 83492791u)) & grid->table_mask;
+}
+
+/* only particles which take part in the simulation are searched for neighbors */
+BLI_INLINE bool sph_grid_use_particle(const ParticleData *pa)
+{
+	return (pa->alive == PARS_ALIVE) && !(pa->flag & (PARS_UNEXIST | PARS_NO_DISP));
+}
+
+BLI_INLINE unsigned int sph_grid_hash_co(const SPHGrid *grid, const float co[3])
+{
+	return sph_grid_hash(grid, sph_grid_coord(grid, co[0]), sph_grid_coord(grid, co[1]), sph_grid_coord(grid, co[2]));
+}
+
+SPHGrid *psys_sph_grid_build(ParticleSystem *psys, float cell_size, float cfra)
+{
+	SPHGrid *grid = MEM_callocN(sizeof(SPHGrid), "SPHGrid");
+	unsigned int *bucket, *bucket_fill;
+	unsigned int table_size;
+	int p, totpoint = 0, tail;
+
+	grid->inv_cell_size = 1.0f / max_ff(cell_size, 1e-5f);
+	grid->totpart = psys->totpart;
+
+	for (p = 0; p < psys->totpart; p++) {
+		if (sph_grid_use_particle(&psys->particles[p])) {
+			totpoint++;
+		}
+	}
+
+	table_size = power_of_2_max_u((unsigned int)max_ii(totpoint * 2, 1));
+	grid->table_mask = table_size - 1;
+	grid->totpoint = totpoint;
+	grid->bucket_start = MEM_callocN(sizeof(unsigned int) * (table_size + 1), "SPHGrid buckets");
+	grid->co = MEM_mallocN(sizeof(*grid->co) * max_ii(totpoint, 1), "SPHGrid co");
+	grid->index = MEM_mallocN(sizeof(int) * max_ii(psys->totpart, 1), "SPHGrid index");
+
+	/* counting sort by bucket, using the particle positions at the start of the step */
+	bucket = MEM_mallocN(sizeof(unsigned int) * max_ii(psys->totpart, 1), __func__);
+	for (p = 0; p < psys->totpart; p++) {
+		ParticleData *pa = psys->particles + p;
+		if (sph_grid_use_particle(pa)) {
+			const float *co = (pa->state.time == cfra) ? pa->prev_state.co : pa->state.co;
+			bucket[p] = sph_grid_hash_co(grid, co);
+			grid->bucket_start[bucket[p] + 1]++;
+		}
+	}
+	for (p = 0; p < (int)table_size; p++) {
+		grid->bucket_start[p + 1] += grid->bucket_start[p];
+	}
+
+	bucket_fill = MEM_mallocN(sizeof(unsigned int) * table_size, __func__);
+	memcpy(bucket_fill, grid->bucket_start, sizeof(unsigned int) * table_size);
+
+	tail = totpoint;
+	for (p = 0; p < psys->totpart; p++) {
+		ParticleData *pa = psys->particles + p;
+		if (sph_grid_use_particle(pa)) {
+			const float *co = (pa->state.time == cfra) ? pa->prev_state.co : pa->state.co;
+			const unsigned int i = bucket_fill[bucket[p]]++;
+			copy_v3_v3(grid->co[i], co);
+			grid->index[i] = p;
+		}
+		else {
+			grid->index[tail++] = p;
+		}
+	}
+
+	MEM_freeN(bucket_fill);
+	MEM_freeN(bucket);
+
+	return grid;
+}
+
+void psys_sph_grid_free(SPHGrid *grid)
+{
+	MEM_freeN(grid->bucket_start);
+	MEM_freeN(grid->co);
+	MEM_freeN(grid->index);
+	MEM_freeN(grid);
+}
+
+/* Same semantics as BLI_bvhtree_range_query: callback gets the query point and the squared distance. */
+void psys_sph_grid_range_query(const SPHGrid *grid, const float co[3], float radius, BVHTree_RangeQuery callback, void *userdata)
+{
+	const float radius_sq = radius * radius;
+	int min[3], max[3], x, y, z, i;
+	float dist_sq;
+
+	for (i = 0; i < 3; i++) {
+		min[i] = sph_grid_coord(grid, co[i] - radius);
+		max[i] = sph_grid_coord(grid, co[i] + radius);
+	}
+
+	/* huge search radius compared to the cells, a linear scan is cheaper */
+	if ((double)(max[0] - min[0] + 1) * (double)(max[1] - min[1] + 1) * (double)(max[2] - min[2] + 1) > (double)grid->totpoint) {
+		for (i = 0; i < grid->totpoint; i++) {
+			dist_sq = len_squared_v3v3(co, grid->co[i]);
+			if (dist_sq <= radius_sq) {
+				callback(userdata, grid->index[i], co, dist_sq);
+			}
+		}
+		return;
+	}
+
+	for (z = min[2]; z <= max[2]; z++) {
+		for (y = min[1]; y <= max[1]; y++) {
+			for (x = min[0]; x <= max[0]; x++) {
+				const unsigned int b = sph_grid_hash(grid, x, y, z);
+
+				for (i = grid->bucket_start[b]; i < (int)grid->bucket_start[b + 1]; i++) {
+					const float *pco = grid->co[i];
+
+					dist_sq = len_squared_v3v3(co, pco);
+					if (dist_sq > radius_sq) {
+						continue;
+					}
+					/* other cells can share the bucket, only report each particle from its own cell */
+					if (sph_grid_coord(grid, pco[0]) != x ||
+					    sph_grid_coord(grid, pco[1]) != y ||
+					    sph_grid_coord(grid, pco[2]) != z)
+					{
+						continue;
+					}
+
+					callback(userdata, grid->index[i], co, dist_sq);
+				}
+			}
+		}
+	}
+}
+
 #define SPH_NEIGHBORS 512
 typedef struct SPHNeighbor {
 	ParticleSystem *psys;
@@ -1572,7 +1720,7 @@ typedef struct SPHRangeData {
 	int use_size;
 } SPHRangeData;
 
-static void sph_evaluate_func(BVHTree *tree, ParticleSystem **psys, float co[3], SPHRangeData *pfr, float interaction_radius, BVHTree_RangeQuery callback)
+static void sph_evaluate_func(BVHTree *tree, ParticleSystem **psys, SPHGrid **grid, float co[3], SPHRangeData *pfr, float interaction_radius, BVHTree_RangeQuery callback)
 {
 	int i;
 
@@ -1587,12 +1735,8 @@ static void sph_evaluate_func(BVHTree *tree, ParticleSystem **psys, float co[3],
 			BLI_bvhtree_range_query(tree, co, interaction_radius, callback, pfr);
 			break;
 		}
-		else {
-			BLI_rw_mutex_lock(&psys_bvhtree_rwlock, THREAD_LOCK_READ);
-
-			BLI_bvhtree_range_query(psys[i]->bvhtree, co, interaction_radius, callback, pfr);
-
-			BLI_rw_mutex_unlock(&psys_bvhtree_rwlock);
+		else if (grid[i]) {
+			psys_sph_grid_range_query(grid[i], co, interaction_radius, callback, pfr);
 		}
 	}
 }
@@ -1705,7 +1849,7 @@ static void sph_force_cb(void *sphdata_v, ParticleKey *state, float *force, floa
 	pfr.pa = pa;
 	pfr.mass = sphdata->mass;
 
-	sph_evaluate_func( NULL, psys, state->co, &pfr, interaction_radius, sph_density_accum_cb);
+	sph_evaluate_func(NULL, psys, sphdata->grid, state->co, &pfr, interaction_radius, sph_density_accum_cb);
 
 	density = data[0];
 	near_density = data[1];
@@ -1762,8 +1906,8 @@ static void sph_force_cb(void *sphdata_v, ParticleKey *state, float *force, floa
 					temp_spring.rest_length = (fluid->flag & SPH_CURRENT_REST_LENGTH) ? rij : rest_length;
 					temp_spring.delete_flag = 0;
 
-					/* sph_spring_add is not thread-safe. - z0r */
-					sph_spring_add(psys[0], &temp_spring);
+					/* added to the fluid springs once the parallel loop is done */
+					sph_spring_buffer_add(sphdata, &temp_spring);
 				}
 			}
 			else {/* PART_SPRING_HOOKES - Hooke's spring force */
@@ -1876,7 +2020,7 @@ static void sphclassical_force_cb(void *sphdata_v, ParticleKey *state, float *fo
 	pfr.h = h;
 	pfr.pa = pa;
 
-	sph_evaluate_func(NULL, psys, state->co, &pfr, interaction_radius, sphclassical_neighbour_accum_cb);
+	sph_evaluate_func(NULL, psys, sphdata->grid, state->co, &pfr, interaction_radius, sphclassical_neighbour_accum_cb);
 	pressure =  stiffness * (pow7f(pa->sphdensity / rest_density) - 1.0f);
 
 	/* multiply by mass so that we return a force, not accel */
@@ -1954,7 +2098,7 @@ static void sphclassical_calc_dens(ParticleData *pa, float UNUSED(dfra), SPHData
 	pfr.pa = pa;
 	pfr.mass = sphdata->mass;
 
-	sph_evaluate_func( NULL, psys, pa->state.co, &pfr, interaction_radius, sphclassical_density_accum_cb);
+	sph_evaluate_func(NULL, psys, sphdata->grid, pa->state.co, &pfr, interaction_radius, sphclassical_density_accum_cb);
 	pa->sphdensity = min_ff(max_ff(data[0], fluid->rest_density * 0.9f), fluid->rest_density * 1.1f);
 }
 
@@ -1974,6 +2118,12 @@ void psys_sph_init(ParticleSimulationData *sim, SPHData *sphdata)
 		sphdata->gravity = NULL;
 	sphdata->eh = sph_springhash_build(sim->psys);
 
+	/* neighbors are searched in the bvhtree passed to psys_sph_density, unless
+	 * grids are built with sph_grids_build */
+	memset(sphdata->grid, 0, sizeof(sphdata->grid));
+	sphdata->new_springs = NULL;
+	sphdata->tot_new_springs = sphdata->alloc_new_springs = 0;
+
 	// These per-particle values should be overridden later, but just for
 	// completeness we give them default values now.
 	sphdata->pa = NULL;
@@ -1995,10 +2145,41 @@ void psys_sph_init(ParticleSimulationData *sim, SPHData *sphdata)
 
 void psys_sph_finalise(SPHData *sphdata)
 {
+	int i;
+
 	if (sphdata->eh) {
 		BLI_edgehash_free(sphdata->eh, NULL);
 		sphdata->eh = NULL;
 	}
+
+	for (i = 0; i < 10; i++) {
+		if (sphdata->grid[i]) {
+			psys_sph_grid_free(sphdata->grid[i]);
+			sphdata->grid[i] = NULL;
+		}
+	}
+
+	MEM_SAFE_FREE(sphdata->new_springs);
+}
+
+/* Build the neighbor search grids of all coupled systems, with cells sized for
+ * the largest interaction radius of the simulated system. */
+static void sph_grids_build(SPHData *sphdata, float cfra)
+{
+	ParticleSystem **psys = sphdata->psys;
+	SPHFluidSettings *fluid = psys[0]->part->fluid;
+	float cell_size = fluid->radius;
+	int i;
+
+	if (fluid->flag & SPH_FAC_RADIUS) {
+		float size = psys[0]->part->size;
+		for (i = 0; i < psys[0]->totpart; i++)
+			size = max_ff(size, psys[0]->particles[i].size);
+		cell_size *= 4.0f * size;
+	}
+
+	for (i = 0; i < 10 && psys[i]; i++)
+		sphdata->grid[i] = psys_sph_grid_build(psys[i], cell_size, cfra);
 }
 /* Sample the density field at a point in space. */
 void psys_sph_density(BVHTree *tree, SPHData *sphdata, float co[3], float vars[2])
@@ -2015,7 +2196,7 @@ void psys_sph_density(BVHTree *tree, SPHData *sphdata, float co[3], float vars[2
 	pfr.h = interaction_radius * sphdata->hfac;
 	pfr.mass = sphdata->mass;
 
-	sph_evaluate_func(tree, psys, co, &pfr, interaction_radius, sphdata->density_cb);
+	sph_evaluate_func(tree, psys, sphdata->grid, co, &pfr, interaction_radius, sphdata->density_cb);
 
 	vars[0] = pfr.data[0];
 	vars[1] = pfr.data[1];
@@ -3379,15 +3560,19 @@ typedef struct DynamicStepSolverTaskData {
 	float timestep;
 	float dtime;
 
+	/* SPH: particles in neighbor search grid order */
+	const int *sph_order;
+
 	SpinLock spin;
 } DynamicStepSolverTaskData;
 
 static void dynamics_step_sph_ddr_task_cb_ex(
         void *__restrict userdata,
-        const int p,
+        const int i,
         const ParallelRangeTLS *__restrict tls)
 {
 	DynamicStepSolverTaskData *data = userdata;
+	const int p = data->sph_order[i];
 	ParticleSimulationData *sim = data->sim;
 	ParticleSystem *psys = sim->psys;
 	ParticleSettings *part = psys->part;
@@ -3418,6 +3603,16 @@ static void dynamics_step_sph_ddr_task_cb_ex(
 	}
 }
 
+static void dynamics_step_sph_ddr_task_finalize(
+        void *__restrict userdata,
+        void *__restrict userdata_chunk)
+{
+	DynamicStepSolverTaskData *data = userdata;
+	SPHData *sphdata = userdata_chunk;
+
+	sph_springs_flush(data->sim->psys, sphdata);
+}
+
 static void dynamics_step_sph_classical_basic_integrate_task_cb_ex(
         void *__restrict userdata,
         const int p,
@@ -3438,10 +3633,11 @@ static void dynamics_step_sph_classical_basic_integrate_task_cb_ex(
 
 static void dynamics_step_sph_classical_calc_density_task_cb_ex(
         void *__restrict userdata,
-        const int p,
+        const int i,
         const ParallelRangeTLS *__restrict tls)
 {
 	DynamicStepSolverTaskData *data = userdata;
+	const int p = data->sph_order[i];
 	ParticleSimulationData *sim = data->sim;
 	ParticleSystem *psys = sim->psys;
 
@@ -3458,10 +3654,11 @@ static void dynamics_step_sph_classical_calc_density_task_cb_ex(
 
 static void dynamics_step_sph_classical_integrate_task_cb_ex(
         void *__restrict userdata,
-        const int p,
+        const int i,
         const ParallelRangeTLS *__restrict tls)
 {
 	DynamicStepSolverTaskData *data = userdata;
+	const int p = data->sph_order[i];
 	ParticleSimulationData *sim = data->sim;
 	ParticleSystem *psys = sim->psys;
 	ParticleSettings *part = psys->part;
@@ -3554,17 +3751,6 @@ static void dynamics_step(ParticleSimulationData *sim, float cfra)
 			}
 			break;
 		}
-		case PART_PHYS_FLUID:
-		{
-			ParticleTarget *pt = psys->targets.first;
-			psys_update_particle_bvhtree(psys, cfra);
-
-			for (; pt; pt=pt->next) {  /* Updating others systems particle tree for fluid-fluid interaction */
-				if (pt->ob)
-					psys_update_particle_bvhtree(BLI_findlink(&pt->ob->particlesystem, pt->psys-1), cfra);
-			}
-			break;
-		}
 	}
 	/* initialize all particles for dynamics */
 	LOOP_SHOWN_PARTICLES {
@@ -3646,9 +3832,11 @@ static void dynamics_step(ParticleSimulationData *sim, float cfra)
 		{
 			SPHData sphdata;
 			psys_sph_init(sim, &sphdata);
+			sph_grids_build(&sphdata, cfra);
 
 			DynamicStepSolverTaskData task_data = {
 			    .sim = sim, .cfra = cfra, .timestep = timestep, .dtime = dtime,
+			    .sph_order = sphdata.grid[0]->index,
 			};
 
 			BLI_spin_init(&task_data.spin);
@@ -3662,6 +3850,7 @@ static void dynamics_step(ParticleSimulationData *sim, float cfra)
 				settings.use_threading = (psys->totpart > 100);
 				settings.userdata_chunk = &sphdata;
 				settings.userdata_chunk_size = sizeof(sphdata);
+				settings.func_finalize = dynamics_step_sph_ddr_task_finalize;
 				BLI_task_parallel_range(
 				        0, psys->totpart,
 				        &task_data,
@@ -30,6 +30,8 @@
 #include "BLI_heap.h"
 #include "BLI_math.h"
 #include "BLI_memarena.h"
+#include "BLI_stack.h"
+#include "BLI_task.h"
 
 #include "BKE_ccg.h"
 #include "BKE_DerivedMesh.h"
@@ -745,8 +747,16 @@ typedef struct {
 	int cd_vert_mask_offset;
 	int cd_vert_node_offset;
 	int cd_face_node_offset;
+	/* when set, edges are collected here instead of being added to the queue,
+	 * used for creating the queue from multiple threads (see #edge_queue_nodes_add) */
+	BLI_Stack *candidates;
 } EdgeQueueContext;
 
+typedef struct EdgeQueueCandidate {
+	BMEdge *e;
+	float priority;
+} EdgeQueueCandidate;
+
 /* only tag'd edges are in the queue */
 #ifdef USE_EDGEQUEUE_TAG
 #  define EDGE_QUEUE_TEST(e)   (BM_elem_flag_test((CHECK_TYPE_INLINE(e, BMEdge *),    e), BM_ELEM_TAG))
@@ -822,6 +832,20 @@ static bool check_mask(EdgeQueueContext *eq_ctx, BMVert *v)
 	return BM_ELEM_CD_GET_FLOAT(v, eq_ctx->cd_vert_mask_offset) < 1.0f;
 }
 
+static void edge_queue_insert_nocheck(
+        EdgeQueueContext *eq_ctx, BMEdge *e,
+        float priority)
+{
+	BMVert **pair = BLI_mempool_alloc(eq_ctx->pool);
+	pair[0] = e->v1;
+	pair[1] = e->v2;
+	BLI_heap_insert(eq_ctx->q->heap, priority, pair);
+#ifdef USE_EDGEQUEUE_TAG
+	BLI_assert(EDGE_QUEUE_TEST(e) == false);
+	EDGE_QUEUE_ENABLE(e);
+#endif
+}
+
 static void edge_queue_insert(
         EdgeQueueContext *eq_ctx, BMEdge *e,
         float priority)
@@ -837,14 +861,13 @@ static void edge_queue_insert(
 	    !(BM_elem_flag_test_bool(e->v1, BM_ELEM_HIDDEN) ||
 	      BM_elem_flag_test_bool(e->v2, BM_ELEM_HIDDEN)))
 	{
-		BMVert **pair = BLI_mempool_alloc(eq_ctx->pool);
-		pair[0] = e->v1;
-		pair[1] = e->v2;
-		BLI_heap_insert(eq_ctx->q->heap, priority, pair);
-#ifdef USE_EDGEQUEUE_TAG
-		BLI_assert(EDGE_QUEUE_TEST(e) == false);
-		EDGE_QUEUE_ENABLE(e);
-#endif
+		if (eq_ctx->candidates) {
+			EdgeQueueCandidate candidate = {e, priority};
+			BLI_stack_push(eq_ctx->candidates, &candidate);
+		}
+		else {
+			edge_queue_insert_nocheck(eq_ctx, e, priority);
+		}
 	}
 }
 
@@ -994,6 +1017,95 @@ static void short_edge_queue_face_add(
 	}
 }
 
+typedef struct EdgeQueueNodesData {
+	EdgeQueueContext *eq_ctx;
+	PBVHNode **nodes;
+	/* one per node, NULL when not threaded */
+	BLI_Stack **node_candidates;
+	void (*face_add)(EdgeQueueContext *eq_ctx, BMFace *f);
+} EdgeQueueNodesData;
+
+static void edge_queue_nodes_add_task_cb(
+        void *__restrict userdata,
+        const int n,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	EdgeQueueNodesData *data = userdata;
+	PBVHNode *node = data->nodes[n];
+	EdgeQueueContext eq_ctx_node = *data->eq_ctx;
+	GSetIterator gs_iter;
+
+	if (data->node_candidates) {
+		/* the heap, mempool and edge tags are shared, only collect edges here */
+		eq_ctx_node.candidates = data->node_candidates[n] = BLI_stack_new(sizeof(EdgeQueueCandidate), __func__);
+	}
+
+	/* Check each face */
+	GSET_ITER (gs_iter, node->bm_faces) {
+		BMFace *f = BLI_gsetIterator_getKey(&gs_iter);
+
+		data->face_add(&eq_ctx_node, f);
+	}
+}
+
+/* Add edges from faces of all leaf nodes marked for topology update,
+ * nodes are checked in parallel and their edges added to the queue after. */
+static void edge_queue_nodes_add(
+        EdgeQueueContext *eq_ctx, PBVH *bvh,
+        void (*face_add)(EdgeQueueContext *eq_ctx, BMFace *f))
+{
+	PBVHNode **nodes = MEM_mallocN(sizeof(*nodes) * bvh->totnode, __func__);
+	int totnode = 0;
+
+	for (int n = 0; n < bvh->totnode; n++) {
+		PBVHNode *node = &bvh->nodes[n];
+
+		/* Check leaf nodes marked for topology update */
+		if ((node->flag & PBVH_Leaf) &&
+		    (node->flag & PBVH_UpdateTopology) &&
+		    !(node->flag & PBVH_FullyHidden))
+		{
+			nodes[totnode++] = node;
+		}
+	}
+
+	EdgeQueueNodesData data = {
+	    .eq_ctx = eq_ctx, .nodes = nodes,
+	    .face_add = face_add,
+	};
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (totnode > PBVH_THREADED_LIMIT);
+
+	if (settings.use_threading) {
+		data.node_candidates = MEM_mallocN(sizeof(*data.node_candidates) * totnode, __func__);
+	}
+
+	BLI_task_parallel_range(0, totnode, &data, edge_queue_nodes_add_task_cb, &settings);
+
+	if (data.node_candidates) {
+		for (int n = 0; n < totnode; n++) {
+			BLI_Stack *candidates = data.node_candidates[n];
+			while (!BLI_stack_is_empty(candidates)) {
+				EdgeQueueCandidate candidate;
+				BLI_stack_pop(candidates, &candidate);
+#ifdef USE_EDGEQUEUE_TAG
+				/* edges shared between nodes (or faces) are collected more than once */
+				if (EDGE_QUEUE_TEST(candidate.e)) {
+					continue;
+				}
+#endif
+				edge_queue_insert_nocheck(eq_ctx, candidate.e, candidate.priority);
+			}
+			BLI_stack_free(candidates);
+		}
+		MEM_freeN(data.node_candidates);
+	}
+
+	MEM_freeN(nodes);
+}
+
 /* Create a priority queue containing vertex pairs connected by a long
  * edge as defined by PBVH.bm_max_edge_len.
  *
@@ -1036,24 +1148,7 @@ static void long_edge_queue_create(
 	pbvh_bmesh_edge_tag_verify(bvh);
 #endif
 
-	for (int n = 0; n < bvh->totnode; n++) {
-		PBVHNode *node = &bvh->nodes[n];
-
-		/* Check leaf nodes marked for topology update */
-		if ((node->flag & PBVH_Leaf) &&
-		    (node->flag & PBVH_UpdateTopology) &&
-		    !(node->flag & PBVH_FullyHidden))
-		{
-			GSetIterator gs_iter;
-
-			/* Check each face */
-			GSET_ITER (gs_iter, node->bm_faces) {
-				BMFace *f = BLI_gsetIterator_getKey(&gs_iter);
-
-				long_edge_queue_face_add(eq_ctx, f);
-			}
-		}
-	}
+	edge_queue_nodes_add(eq_ctx, bvh, long_edge_queue_face_add);
 }
 
 /* Create a priority queue containing vertex pairs connected by a
@@ -1094,24 +1189,7 @@ static void short_edge_queue_create(
 		eq_ctx->q->edge_queue_tri_in_range = edge_queue_tri_in_sphere;
 	}
 
-	for (int n = 0; n < bvh->totnode; n++) {
-		PBVHNode *node = &bvh->nodes[n];
-
-		/* Check leaf nodes marked for topology update */
-		if ((node->flag & PBVH_Leaf) &&
-		    (node->flag & PBVH_UpdateTopology) &&
-		    !(node->flag & PBVH_FullyHidden))
-		{
-			GSetIterator gs_iter;
-
-			/* Check each face */
-			GSET_ITER (gs_iter, node->bm_faces) {
-				BMFace *f = BLI_gsetIterator_getKey(&gs_iter);
-
-				short_edge_queue_face_add(eq_ctx, f);
-			}
-		}
-	}
+	edge_queue_nodes_add(eq_ctx, bvh, short_edge_queue_face_add);
 }
 
 /*************************** Topology update **************************/
@@ -25,6 +25,9 @@
  *  \ingroup bli
  */
 
+/* don't use threads for fewer nodes than this */
+#define PBVH_THREADED_LIMIT 4
+
 /* Axis-aligned bounding box */
 typedef struct {
 	float bmin[3], bmax[3];
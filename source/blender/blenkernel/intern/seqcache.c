@@ -27,20 +27,39 @@
  */
 
 #include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "zlib.h"
 
 #include "BLI_sys_types.h"  /* for intptr_t */
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
+#include "DNA_color_types.h"
 #include "DNA_sequence_types.h"
 #include "DNA_scene_types.h"
+#include "DNA_userdef_types.h"
 
 #include "IMB_moviecache.h"
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
+#include "IMB_colormanagement.h"
 
+#include "BLI_fileops.h"
+#include "BLI_fileops_types.h"
+#include "BLI_hash_mm2a.h"
 #include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
 
+#include "BKE_main.h"
 #include "BKE_sequencer.h"
 #include "BKE_scene.h"
 
@@ -66,10 +85,56 @@ typedef struct SeqPreprocessCache {
 	ListBase elems;
 } SeqPreprocessCache;
 
+/* On-disk tier below the memory cache, so rendered frames survive eviction and
+ * reopening the file. Files are stored per scene and strip:
+ *
+ *   <cache_dir>/<blend_file>_seq_cache/<scene>/<strip cache_id>/<frame>-<type>-<size>-<view>-<hash>.dcf
+ *
+ * The hash covers all strip settings affecting the image, including effect and modifier
+ * settings and the modification time of source files, so files written for different
+ * settings or sources are not picked up. Edits which invalidate a strip also remove its files. */
+
+#define DCACHE_FNAME_FORMAT "%d-%d-%dx%d-%d-%d-%08x.dcf"
+#define DCACHE_DIRNAME_FORMAT "%08x"
+#define DCACHE_FILE_EXT ".dcf"
+#define DCACHE_VERSION 3
+
+typedef struct SeqDiskCacheHeader {
+	char magic[4];
+	int version;
+	unsigned int settings_hash;
+	int x, y;
+	int channels;
+	int is_float;
+	int planes;
+	unsigned int size;             /* uncompressed size of the pixel data */
+	unsigned int size_compressed;  /* size of the pixel data in the file */
+	char colorspace[64];           /* MAX_COLORSPACE_NAME */
+} SeqDiskCacheHeader;
+
+typedef struct SeqDiskCacheFile {
+	struct SeqDiskCacheFile *next, *prev;
+	char path[FILE_MAX];
+	size_t size;
+} SeqDiskCacheFile;
+
+typedef struct SeqDiskCache {
+	char root[FILE_MAX];
+	ListBase files;  /* oldest first */
+	size_t size_total;
+} SeqDiskCache;
+
 static struct MovieCache *moviecache = NULL;
 static struct SeqPreprocessCache *preprocess_cache = NULL;
+static struct SeqDiskCache *disk_cache = NULL;
+static ThreadMutex disk_cache_lock = BLI_MUTEX_INITIALIZER;
 
 static void preprocessed_cache_destruct(void);
+static void seq_disk_cache_free(void);
+static void seq_disk_cache_cleanup_sequence(Sequence *seq);
+static ImBuf *seq_disk_cache_read(const SeqRenderData *context, Sequence *seq, float cfra, eSeqStripElemIBuf type);
+static void seq_disk_cache_write(const SeqRenderData *context, Sequence *seq, float cfra, eSeqStripElemIBuf type,
+                                 ImBuf *ibuf);
 
 static bool seq_cmp_render_data(const SeqRenderData *a, const SeqRenderData *b)
 {
@@ -123,14 +188,19 @@ static bool seqcache_hashcmp(const void *a_, const void *b_)
 
 void BKE_sequencer_cache_destruct(void)
 {
+	BKE_sequencer_prefetch_stop();
+
 	if (moviecache)
 		IMB_moviecache_free(moviecache);
 
 	preprocessed_cache_destruct();
+	seq_disk_cache_free();
 }
 
 void BKE_sequencer_cache_cleanup(void)
 {
+	BKE_sequencer_prefetch_stop();
+
 	if (moviecache) {
 		IMB_moviecache_free(moviecache);
 		moviecache = IMB_moviecache_create("seqcache", sizeof(SeqCacheKey), seqcache_hashhash, seqcache_hashcmp);
@@ -151,42 +221,77 @@ void BKE_sequencer_cache_cleanup_sequence(Sequence *seq)
 {
 	if (moviecache)
 		IMB_moviecache_cleanup(moviecache, seqcache_key_check_seq, seq);
+
+	seq_disk_cache_cleanup_sequence(seq);
+}
+
+static void seqcache_key_init(SeqCacheKey *key, const SeqRenderData *context, Sequence *seq, float cfra,
+                              eSeqStripElemIBuf type)
+{
+	key->seq = seq;
+	key->context = *context;
+	key->cfra = cfra - seq->start;
+	key->type = type;
+
+	/* the prefetch worker renders a copy of the strips,
+	 * its frames are for the viewer of the original ones */
+	if (context->is_prefetch_render) {
+		key->seq = BKE_sequencer_prefetch_get_original_sequence(context, seq);
+		key->context.scene = BKE_sequencer_prefetch_get_original_scene(context);
+		key->context.is_prefetch_render = false;
+	}
+}
+
+static void seqcache_put_memory(const SeqRenderData *context, Sequence *seq, float cfra, eSeqStripElemIBuf type,
+                                ImBuf *i)
+{
+	SeqCacheKey key;
+
+	if (!moviecache) {
+		moviecache = IMB_moviecache_create("seqcache", sizeof(SeqCacheKey), seqcache_hashhash, seqcache_hashcmp);
+	}
+
+	seqcache_key_init(&key, context, seq, cfra, type);
+
+	IMB_moviecache_put(moviecache, &key, i);
 }
 
 struct ImBuf *BKE_sequencer_cache_get(const SeqRenderData *context, Sequence *seq, float cfra, eSeqStripElemIBuf type)
 {
-	if (moviecache && seq) {
+	ImBuf *ibuf = NULL;
+
+	if (seq == NULL) {
+		return NULL;
+	}
+
+	if (moviecache) {
 		SeqCacheKey key;
 
-		key.seq = seq;
-		key.context = *context;
-		key.cfra = cfra - seq->start;
-		key.type = type;
+		seqcache_key_init(&key, context, seq, cfra, type);
 
-		return IMB_moviecache_get(moviecache, &key);
+		ibuf = IMB_moviecache_get(moviecache, &key);
 	}
 
-	return NULL;
+	if (ibuf == NULL) {
+		ibuf = seq_disk_cache_read(context, seq, cfra, type);
+
+		/* keep it in memory, without writing it back to disk */
+		if (ibuf) {
+			seqcache_put_memory(context, seq, cfra, type, ibuf);
+		}
+	}
+
+	return ibuf;
 }
 
 void BKE_sequencer_cache_put(const SeqRenderData *context, Sequence *seq, float cfra, eSeqStripElemIBuf type, ImBuf *i)
 {
-	SeqCacheKey key;
-
 	if (i == NULL || context->skip_cache) {
 		return;
 	}
 
-	if (!moviecache) {
-		moviecache = IMB_moviecache_create("seqcache", sizeof(SeqCacheKey), seqcache_hashhash, seqcache_hashcmp);
-	}
-
-	key.seq = seq;
-	key.context = *context;
-	key.cfra = cfra - seq->start;
-	key.type = type;
-
-	IMB_moviecache_put(moviecache, &key, i);
+	seqcache_put_memory(context, seq, cfra, type, i);
+	seq_disk_cache_write(context, seq, cfra, type, i);
 }
 
 void BKE_sequencer_preprocessed_cache_cleanup(void)
@@ -222,6 +327,10 @@ ImBuf *BKE_sequencer_preprocessed_cache_get(const SeqRenderData *context, Sequen
 	if (!preprocess_cache)
 		return NULL;
 
+	/* only holds the frame the viewer is at */
+	if (context->is_prefetch_render)
+		return NULL;
+
 	if (preprocess_cache->cfra != cfra)
 		return NULL;
 
@@ -246,6 +355,9 @@ void BKE_sequencer_preprocessed_cache_put(const SeqRenderData *context, Sequence
 {
 	SeqPreprocessCacheElem *elem;
 
+	if (context->is_prefetch_render)
+		return;
+
 	if (!preprocess_cache) {
 		preprocess_cache = MEM_callocN(sizeof(SeqPreprocessCache), "sequencer preprocessed cache");
 	}
@@ -285,3 +397,677 @@ void BKE_sequencer_preprocessed_cache_cleanup_sequence(Sequence *seq)
 		}
 	}
 }
+
+/* ******************** disk cache ******************** */
+
+/* strip flags which affect the rendered image */
+#define DCACHE_SEQ_FLAG_MASK \
+	(SEQ_FILTERY | SEQ_MUTE | SEQ_REVERSE_FRAMES | SEQ_FLIPX | SEQ_FLIPY | SEQ_MAKE_FLOAT | SEQ_USE_PROXY | \
+	 SEQ_USE_TRANSFORM | SEQ_USE_CROP | SEQ_USE_EFFECT_DEFAULT_FADE | SEQ_USE_LINEAR_MODIFIERS | SEQ_USE_VIEWS)
+
+static bool seq_disk_cache_is_enabled(const SeqRenderData *context, Sequence *seq, float cfra)
+{
+	Editing *ed = context->scene->ed;
+
+	if (ed == NULL || (ed->cache_flag & SEQ_CACHE_DISK_CACHE_ENABLE) == 0) {
+		return false;
+	}
+
+	/* cache location is derived from the file path */
+	if (context->bmain == NULL || context->bmain->name[0] == '\0') {
+		return false;
+	}
+
+	if (context->is_proxy_render || cfra != floorf(cfra)) {
+		return false;
+	}
+
+	/* output of these depends on other data-blocks, changes to which are not tracked here */
+	if (ELEM(seq->type, SEQ_TYPE_SCENE, SEQ_TYPE_MOVIECLIP, SEQ_TYPE_MASK)) {
+		return false;
+	}
+
+	/* strips of files which were not versioned */
+	if (seq->cache_id == 0) {
+		return false;
+	}
+
+	return true;
+}
+
+static void seq_disk_cache_hash_str(BLI_HashMurmur2A *mm2, const char *str)
+{
+	BLI_hash_mm2a_add(mm2, (const unsigned char *)str, strlen(str));
+}
+
+static void seq_disk_cache_hash_curve_mapping(BLI_HashMurmur2A *mm2, const CurveMapping *cumap)
+{
+	int i;
+
+	BLI_hash_mm2a_add_int(mm2, cumap->flag);
+	BLI_hash_mm2a_add(mm2, (const unsigned char *)&cumap->clipr, sizeof(cumap->clipr));
+	BLI_hash_mm2a_add(mm2, (const unsigned char *)cumap->black, sizeof(cumap->black));
+	BLI_hash_mm2a_add(mm2, (const unsigned char *)cumap->white, sizeof(cumap->white));
+
+	for (i = 0; i < CM_TOT; i++) {
+		const CurveMap *cuma = &cumap->cm[i];
+
+		BLI_hash_mm2a_add_int(mm2, cuma->totpoint);
+		BLI_hash_mm2a_add_int(mm2, cuma->flag);
+		BLI_hash_mm2a_add(mm2, (const unsigned char *)cuma->ext_in, sizeof(cuma->ext_in));
+		BLI_hash_mm2a_add(mm2, (const unsigned char *)cuma->ext_out, sizeof(cuma->ext_out));
+		if (cuma->curve) {
+			BLI_hash_mm2a_add(mm2, (const unsigned char *)cuma->curve, sizeof(*cuma->curve) * (size_t)cuma->totpoint);
+		}
+	}
+}
+
+static void seq_disk_cache_hash_modifier(BLI_HashMurmur2A *mm2, SequenceModifierData *smd)
+{
+	const SequenceModifierTypeInfo *smti = BKE_sequence_modifier_type_info_get(smd->type);
+
+	BLI_hash_mm2a_add_int(mm2, smd->type);
+	BLI_hash_mm2a_add_int(mm2, smd->flag);
+	BLI_hash_mm2a_add_int(mm2, smd->mask_input_type);
+	BLI_hash_mm2a_add_int(mm2, smd->mask_time);
+	BLI_hash_mm2a_add_int(mm2, smd->mask_sequence ? smd->mask_sequence->cache_id : 0);
+
+	if (smti == NULL) {
+		return;
+	}
+
+	switch (smd->type) {
+		case seqModifierType_Curves:
+			seq_disk_cache_hash_curve_mapping(mm2, &((CurvesModifierData *)smd)->curve_mapping);
+			break;
+		case seqModifierType_HueCorrect:
+			seq_disk_cache_hash_curve_mapping(mm2, &((HueCorrectModifierData *)smd)->curve_mapping);
+			break;
+		default:
+			/* settings follow the common data, none of the other modifiers store pointers */
+			BLI_hash_mm2a_add(mm2, (const unsigned char *)(smd + 1),
+			                  (size_t)smti->struct_size - sizeof(SequenceModifierData));
+			break;
+	}
+}
+
+static void seq_disk_cache_hash_effect(BLI_HashMurmur2A *mm2, Sequence *seq)
+{
+	BLI_hash_mm2a_add(mm2, (const unsigned char *)&seq->effect_fader, sizeof(seq->effect_fader));
+	BLI_hash_mm2a_add(mm2, (const unsigned char *)&seq->speed_fader, sizeof(seq->speed_fader));
+
+	if (seq->effectdata == NULL) {
+		return;
+	}
+
+	if (seq->type == SEQ_TYPE_SPEED) {
+		/* the frame map is derived from the settings */
+		const SpeedControlVars *v = seq->effectdata;
+		BLI_hash_mm2a_add(mm2, (const unsigned char *)&v->globalSpeed, sizeof(v->globalSpeed));
+		BLI_hash_mm2a_add_int(mm2, v->flags);
+	}
+	else {
+		/* all other effect settings are plain values */
+		BLI_hash_mm2a_add(mm2, (const unsigned char *)seq->effectdata, MEM_allocN_len(seq->effectdata));
+	}
+}
+
+/* Modification time and size of the file the frame is read from. */
+static void seq_disk_cache_hash_source_file(BLI_HashMurmur2A *mm2, const SeqRenderData *context,
+                                            Sequence *seq, float cfra)
+{
+	StripElem *s_elem = NULL;
+	char path[FILE_MAX];
+	BLI_stat_t st;
+
+	if (seq->type == SEQ_TYPE_MOVIE) {
+		s_elem = seq->strip->stripdata;
+	}
+	else if (seq->type == SEQ_TYPE_IMAGE) {
+		s_elem = BKE_sequencer_give_stripelem(seq, (int)cfra);
+	}
+
+	if (s_elem == NULL) {
+		return;
+	}
+
+	BLI_join_dirfile(path, sizeof(path), seq->strip->dir, s_elem->name);
+	BLI_path_abs(path, context->bmain->name);
+
+	if (BLI_stat(path, &st) == 0) {
+		const int64_t mtime = (int64_t)st.st_mtime, size = (int64_t)st.st_size;
+		BLI_hash_mm2a_add(mm2, (const unsigned char *)&mtime, sizeof(mtime));
+		BLI_hash_mm2a_add(mm2, (const unsigned char *)&size, sizeof(size));
+	}
+	else {
+		BLI_hash_mm2a_add_int(mm2, -1);
+	}
+}
+
+static void seq_disk_cache_hash_strip(BLI_HashMurmur2A *mm2, const SeqRenderData *context, Sequence *seq,
+                                      float cfra);
+
+/* Strips rendered below seq in its channel stack, which its composite or an
+ * adjustment or multicam strip is made of. */
+static void seq_disk_cache_hash_stack(BLI_HashMurmur2A *mm2, const SeqRenderData *context, Sequence *seq,
+                                      float cfra)
+{
+	ListBase *seqbase = BKE_sequence_seqbase(&context->scene->ed->seqbase, seq);
+	Sequence *seq_below;
+
+	if (seqbase == NULL) {
+		return;
+	}
+
+	for (seq_below = seqbase->first; seq_below; seq_below = seq_below->next) {
+		if (seq_below->machine < seq->machine && seq_below->startdisp <= cfra && seq_below->enddisp > cfra) {
+			seq_disk_cache_hash_strip(mm2, context, seq_below, cfra);
+		}
+	}
+}
+
+/* Everything the image of seq is made of besides its own settings. */
+static void seq_disk_cache_hash_inputs(BLI_HashMurmur2A *mm2, const SeqRenderData *context, Sequence *seq,
+                                       float cfra)
+{
+	SequenceModifierData *smd;
+	Sequence *seq_child;
+
+	if (seq->seq1) {
+		seq_disk_cache_hash_strip(mm2, context, seq->seq1, cfra);
+	}
+	if (seq->seq2) {
+		seq_disk_cache_hash_strip(mm2, context, seq->seq2, cfra);
+	}
+	if (seq->seq3) {
+		seq_disk_cache_hash_strip(mm2, context, seq->seq3, cfra);
+	}
+
+	if (ELEM(seq->type, SEQ_TYPE_ADJUSTMENT, SEQ_TYPE_MULTICAM)) {
+		seq_disk_cache_hash_stack(mm2, context, seq, cfra);
+	}
+
+	if (seq->type == SEQ_TYPE_META) {
+		for (seq_child = seq->seqbase.first; seq_child; seq_child = seq_child->next) {
+			seq_disk_cache_hash_strip(mm2, context, seq_child, cfra);
+		}
+	}
+
+	for (smd = seq->modifiers.first; smd; smd = smd->next) {
+		if (smd->mask_sequence) {
+			seq_disk_cache_hash_strip(mm2, context, smd->mask_sequence, cfra);
+		}
+	}
+}
+
+/* Settings of the strip and, recursively, of the strips it takes input from. Animated
+ * values are hashed as evaluated for the frame which is rendered, edits of their animation
+ * remove cached files instead. */
+static void seq_disk_cache_hash_strip(BLI_HashMurmur2A *mm2, const SeqRenderData *context, Sequence *seq,
+                                      float cfra)
+{
+	Strip *strip = seq->strip;
+	SequenceModifierData *smd;
+
+	BLI_hash_mm2a_add_int(mm2, seq->cache_id);
+	BLI_hash_mm2a_add_int(mm2, seq->type);
+	BLI_hash_mm2a_add_int(mm2, seq->flag & DCACHE_SEQ_FLAG_MASK);
+	BLI_hash_mm2a_add_int(mm2, seq->machine);
+	/* placement relative to the strip which is cached */
+	BLI_hash_mm2a_add_int(mm2, (int)(cfra - seq->start));
+	BLI_hash_mm2a_add_int(mm2, seq->len);
+	BLI_hash_mm2a_add_int(mm2, seq->startofs);
+	BLI_hash_mm2a_add_int(mm2, seq->endofs);
+	BLI_hash_mm2a_add_int(mm2, seq->startstill);
+	BLI_hash_mm2a_add_int(mm2, seq->endstill);
+	BLI_hash_mm2a_add_int(mm2, seq->anim_startofs);
+	BLI_hash_mm2a_add_int(mm2, seq->anim_endofs);
+	BLI_hash_mm2a_add_int(mm2, seq->streamindex);
+	BLI_hash_mm2a_add_int(mm2, seq->multicam_source);
+	BLI_hash_mm2a_add_int(mm2, seq->blend_mode);
+	BLI_hash_mm2a_add_int(mm2, seq->alpha_mode);
+	BLI_hash_mm2a_add_int(mm2, seq->views_format);
+	BLI_hash_mm2a_add(mm2, (const unsigned char *)&seq->blend_opacity, sizeof(seq->blend_opacity));
+	BLI_hash_mm2a_add(mm2, (const unsigned char *)&seq->mul, sizeof(seq->mul));
+	BLI_hash_mm2a_add(mm2, (const unsigned char *)&seq->sat, sizeof(seq->sat));
+	BLI_hash_mm2a_add(mm2, (const unsigned char *)&seq->strobe, sizeof(seq->strobe));
+
+	if (seq->stereo3d_format) {
+		BLI_hash_mm2a_add(mm2, (const unsigned char *)seq->stereo3d_format, sizeof(*seq->stereo3d_format));
+	}
+
+	if (strip) {
+		seq_disk_cache_hash_str(mm2, strip->dir);
+		seq_disk_cache_hash_str(mm2, strip->colorspace_settings.name);
+
+		if (strip->stripdata) {
+			size_t tot_elem = MEM_allocN_len(strip->stripdata) / sizeof(StripElem);
+			size_t i;
+
+			for (i = 0; i < tot_elem; i++) {
+				seq_disk_cache_hash_str(mm2, strip->stripdata[i].name);
+			}
+
+			seq_disk_cache_hash_source_file(mm2, context, seq, cfra);
+		}
+		if (strip->crop) {
+			BLI_hash_mm2a_add(mm2, (const unsigned char *)strip->crop, sizeof(*strip->crop));
+		}
+		if (strip->transform) {
+			BLI_hash_mm2a_add(mm2, (const unsigned char *)strip->transform, sizeof(*strip->transform));
+		}
+	}
+
+	if (seq->type & SEQ_TYPE_EFFECT) {
+		seq_disk_cache_hash_effect(mm2, seq);
+	}
+
+	for (smd = seq->modifiers.first; smd; smd = smd->next) {
+		seq_disk_cache_hash_modifier(mm2, smd);
+	}
+
+	seq_disk_cache_hash_inputs(mm2, context, seq, cfra);
+}
+
+/* Hash of everything affecting the image of the strip at cfra, the strips
+ * it is made of included. */
+static unsigned int seq_disk_cache_settings_hash(const SeqRenderData *context, Sequence *seq, float cfra,
+                                                 eSeqStripElemIBuf type)
+{
+	BLI_HashMurmur2A mm2;
+
+	BLI_hash_mm2a_init(&mm2, DCACHE_VERSION);
+
+	BLI_hash_mm2a_add_int(&mm2, context->motion_blur_samples);
+	BLI_hash_mm2a_add(&mm2, (const unsigned char *)&context->motion_blur_shutter, sizeof(float));
+	seq_disk_cache_hash_str(&mm2, context->scene->sequencer_colorspace_settings.name);
+
+	seq_disk_cache_hash_strip(&mm2, context, seq, cfra);
+
+	/* the composite includes the strips below */
+	if (type == SEQ_STRIPELEM_IBUF_COMP) {
+		seq_disk_cache_hash_stack(&mm2, context, seq, cfra);
+	}
+
+	return BLI_hash_mm2a_end(&mm2);
+}
+
+static void seq_disk_cache_root_get(Main *bmain, char r_root[FILE_MAX])
+{
+	char dir[FILE_MAX], name[FILE_MAX];
+
+	if (U.sequencer_disk_cache_dir[0]) {
+		BLI_strncpy(dir, U.sequencer_disk_cache_dir, sizeof(dir));
+		BLI_path_abs(dir, bmain->name);
+	}
+	else {
+		BLI_split_dir_part(bmain->name, dir, sizeof(dir));
+	}
+
+	BLI_strncpy(name, BLI_path_basename(bmain->name), sizeof(name));
+	BLI_path_extension_replace(name, sizeof(name), "_seq_cache");
+
+	BLI_join_dirfile(r_root, FILE_MAX, dir, name);
+}
+
+static void seq_disk_cache_file_path_get(const char *root, const SeqRenderData *context, Sequence *seq,
+                                         float cfra, eSeqStripElemIBuf type, unsigned int settings_hash,
+                                         char r_path[FILE_MAX])
+{
+	char scene_name[MAX_ID_NAME], seq_name[16], filename[FILE_MAXFILE];
+
+	BLI_strncpy(scene_name, context->scene->id.name + 2, sizeof(scene_name));
+	BLI_filename_make_safe(scene_name);
+	BLI_snprintf(seq_name, sizeof(seq_name), DCACHE_DIRNAME_FORMAT, (unsigned int)seq->cache_id);
+
+	BLI_snprintf(filename, sizeof(filename), DCACHE_FNAME_FORMAT,
+	             (int)(cfra - seq->start), (int)type, context->rectx, context->recty,
+	             context->preview_render_size, context->view_id, settings_hash);
+
+	BLI_join_dirfile(r_path, FILE_MAX, root, scene_name);
+	BLI_path_append(r_path, FILE_MAX, seq_name);
+	BLI_path_append(r_path, FILE_MAX, filename);
+}
+
+static void seq_disk_cache_file_add(SeqDiskCache *dcache, const char *path, size_t size)
+{
+	SeqDiskCacheFile *file = MEM_callocN(sizeof(SeqDiskCacheFile), "sequencer disk cache file");
+
+	BLI_strncpy(file->path, path, sizeof(file->path));
+	file->size = size;
+
+	BLI_addtail(&dcache->files, file);
+	dcache->size_total += size;
+}
+
+static void seq_disk_cache_file_delete(SeqDiskCache *dcache, SeqDiskCacheFile *file)
+{
+	BLI_delete(file->path, false, false);
+
+	dcache->size_total -= file->size;
+	BLI_freelinkN(&dcache->files, file);
+}
+
+typedef struct SeqDiskCacheScanFile {
+	char path[FILE_MAX];
+	size_t size;
+	int64_t mtime;
+} SeqDiskCacheScanFile;
+
+static int seq_disk_cache_scan_file_cmp(const void *a_, const void *b_)
+{
+	const SeqDiskCacheScanFile *a = a_;
+	const SeqDiskCacheScanFile *b = b_;
+
+	if (a->mtime < b->mtime) return -1;
+	if (a->mtime > b->mtime) return 1;
+	return 0;
+}
+
+static void seq_disk_cache_scan_dir(const char *dir, int depth, SeqDiskCacheScanFile **files,
+                                    unsigned int *tot_files, unsigned int *alloc_files)
+{
+	struct direntry *filelist;
+	unsigned int i, nrentries;
+
+	if (!BLI_is_dir(dir)) {
+		return;
+	}
+
+	nrentries = BLI_filelist_dir_contents(dir, &filelist);
+
+	for (i = 0; i < nrentries; i++) {
+		const struct direntry *entry = &filelist[i];
+
+		if (FILENAME_IS_CURRPAR(entry->relname)) {
+			continue;
+		}
+
+		if (S_ISDIR(entry->type)) {
+			if (depth > 0) {
+				seq_disk_cache_scan_dir(entry->path, depth - 1, files, tot_files, alloc_files);
+			}
+		}
+		else if (BLI_path_extension_check(entry->relname, DCACHE_FILE_EXT)) {
+			SeqDiskCacheScanFile *file;
+
+			if (*tot_files == *alloc_files) {
+				*alloc_files = max_ii(64, *alloc_files * 2);
+				*files = MEM_reallocN(*files, sizeof(SeqDiskCacheScanFile) * (*alloc_files));
+			}
+
+			file = &(*files)[(*tot_files)++];
+			BLI_strncpy(file->path, entry->path, sizeof(file->path));
+			file->size = (size_t)entry->s.st_size;
+			file->mtime = (int64_t)entry->s.st_mtime;
+		}
+	}
+
+	BLI_filelist_free(filelist, nrentries);
+}
+
+/* Get disk cache of the file being edited, collecting files stored by previous sessions.
+ * Should be called with disk_cache_lock held. */
+static SeqDiskCache *seq_disk_cache_ensure(Main *bmain)
+{
+	SeqDiskCacheScanFile *files = NULL;
+	unsigned int i, tot_files = 0, alloc_files = 0;
+	char root[FILE_MAX];
+
+	seq_disk_cache_root_get(bmain, root);
+
+	if (disk_cache && STREQ(disk_cache->root, root)) {
+		return disk_cache;
+	}
+
+	seq_disk_cache_free();
+
+	disk_cache = MEM_callocN(sizeof(SeqDiskCache), "sequencer disk cache");
+	BLI_strncpy(disk_cache->root, root, sizeof(disk_cache->root));
+
+	/* <root>/<scene>/<strip>/<files> */
+	seq_disk_cache_scan_dir(root, 2, &files, &tot_files, &alloc_files);
+
+	if (files) {
+		qsort(files, tot_files, sizeof(SeqDiskCacheScanFile), seq_disk_cache_scan_file_cmp);
+
+		for (i = 0; i < tot_files; i++) {
+			seq_disk_cache_file_add(disk_cache, files[i].path, files[i].size);
+		}
+
+		MEM_freeN(files);
+	}
+
+	return disk_cache;
+}
+
+static void seq_disk_cache_free(void)
+{
+	if (disk_cache) {
+		BLI_freelistN(&disk_cache->files);
+		MEM_freeN(disk_cache);
+		disk_cache = NULL;
+	}
+}
+
+/* Remove oldest files until the cache fits the limit from user preferences. */
+static void seq_disk_cache_enforce_limit(SeqDiskCache *dcache)
+{
+	const size_t limit = (size_t)max_ii(U.sequencer_disk_cache_size_limit, 1) * 1024 * 1024 * 1024;
+
+	while (dcache->size_total > limit && dcache->files.first) {
+		seq_disk_cache_file_delete(dcache, dcache->files.first);
+	}
+}
+
+static void seq_disk_cache_cleanup_sequence(Sequence *seq)
+{
+	SeqDiskCacheFile *file, *file_next;
+	char seq_name[16];
+
+	if (disk_cache == NULL || seq->cache_id == 0) {
+		return;
+	}
+
+	BLI_snprintf(seq_name, sizeof(seq_name), DCACHE_DIRNAME_FORMAT, (unsigned int)seq->cache_id);
+
+	BLI_mutex_lock(&disk_cache_lock);
+
+	for (file = disk_cache->files.first; file; file = file_next) {
+		char dir[FILE_MAX];
+
+		file_next = file->next;
+
+		BLI_split_dir_part(file->path, dir, sizeof(dir));
+		BLI_del_slash(dir);
+
+		if (STREQ(BLI_path_basename(dir), seq_name)) {
+			seq_disk_cache_file_delete(disk_cache, file);
+		}
+	}
+
+	BLI_mutex_unlock(&disk_cache_lock);
+}
+
+static ImBuf *seq_disk_cache_read_file(FILE *fp, unsigned int settings_hash)
+{
+	SeqDiskCacheHeader header;
+	ImBuf *ibuf;
+	unsigned char *data_compressed;
+	size_t size_max;
+	uLongf size;
+
+	if (fread(&header, sizeof(header), 1, fp) != 1 ||
+	    !STREQLEN(header.magic, "BSDC", 4) ||
+	    header.version != DCACHE_VERSION ||
+	    header.settings_hash != settings_hash ||
+	    header.x <= 0 || header.y <= 0)
+	{
+		return NULL;
+	}
+
+	/* pixels are always allocated with 4 channels */
+	size_max = (size_t)header.x * header.y * (header.is_float ? 4 * sizeof(float) : sizeof(unsigned int));
+	if (header.size > size_max) {
+		return NULL;
+	}
+
+	ibuf = IMB_allocImBuf(header.x, header.y, header.planes, header.is_float ? IB_rectfloat : IB_rect);
+	if (ibuf == NULL) {
+		return NULL;
+	}
+
+	data_compressed = MEM_mallocN(header.size_compressed, "sequencer disk cache data");
+	size = header.size;
+
+	if (fread(data_compressed, header.size_compressed, 1, fp) != 1 ||
+	    uncompress(header.is_float ? (Bytef *)ibuf->rect_float : (Bytef *)ibuf->rect, &size,
+	               data_compressed, header.size_compressed) != Z_OK ||
+	    size != header.size)
+	{
+		MEM_freeN(data_compressed);
+		IMB_freeImBuf(ibuf);
+		return NULL;
+	}
+
+	MEM_freeN(data_compressed);
+
+	ibuf->channels = header.channels;
+	header.colorspace[sizeof(header.colorspace) - 1] = '\0';
+
+	if (header.is_float) {
+		IMB_colormanagement_assign_float_colorspace(ibuf, header.colorspace);
+	}
+	else {
+		IMB_colormanagement_assign_rect_colorspace(ibuf, header.colorspace);
+	}
+
+	return ibuf;
+}
+
+/* Path of the cache file for the frame, files themselves are read and written
+ * without the lock held: they are only ever created by renaming complete ones. */
+static void seq_disk_cache_path_get(const SeqRenderData *context, Sequence *seq, float cfra,
+                                    eSeqStripElemIBuf type, unsigned int settings_hash, char r_path[FILE_MAX])
+{
+	SeqDiskCache *dcache;
+
+	BLI_mutex_lock(&disk_cache_lock);
+	dcache = seq_disk_cache_ensure(context->bmain);
+	seq_disk_cache_file_path_get(dcache->root, context, seq, cfra, type, settings_hash, r_path);
+	BLI_mutex_unlock(&disk_cache_lock);
+}
+
+static ImBuf *seq_disk_cache_read(const SeqRenderData *context, Sequence *seq, float cfra, eSeqStripElemIBuf type)
+{
+	ImBuf *ibuf = NULL;
+	unsigned int settings_hash;
+	char path[FILE_MAX];
+	FILE *fp;
+
+	if (!seq_disk_cache_is_enabled(context, seq, cfra)) {
+		return NULL;
+	}
+
+	settings_hash = seq_disk_cache_settings_hash(context, seq, cfra, type);
+	seq_disk_cache_path_get(context, seq, cfra, type, settings_hash, path);
+
+	fp = BLI_fopen(path, "rb");
+	if (fp) {
+		ibuf = seq_disk_cache_read_file(fp, settings_hash);
+		fclose(fp);
+	}
+
+	return ibuf;
+}
+
+static bool seq_disk_cache_write_file(FILE *fp, ImBuf *ibuf, unsigned int settings_hash)
+{
+	SeqDiskCacheHeader header = {{0}};
+	const void *data = ibuf->rect_float ? (void *)ibuf->rect_float : (void *)ibuf->rect;
+	const char *colorspace;
+	unsigned char *data_compressed;
+	uLongf size_compressed;
+	bool ok;
+
+	memcpy(header.magic, "BSDC", 4);
+	header.version = DCACHE_VERSION;
+	header.settings_hash = settings_hash;
+	header.x = ibuf->x;
+	header.y = ibuf->y;
+	header.channels = ibuf->channels;
+	header.planes = ibuf->planes;
+	header.is_float = (ibuf->rect_float != NULL);
+	header.size = (unsigned int)((size_t)ibuf->x * ibuf->y *
+	                             (header.is_float ? ibuf->channels * sizeof(float) : sizeof(unsigned int)));
+
+	colorspace = header.is_float ? IMB_colormanagement_get_float_colorspace(ibuf) :
+	                               IMB_colormanagement_get_rect_colorspace(ibuf);
+	BLI_strncpy(header.colorspace, colorspace, sizeof(header.colorspace));
+
+	size_compressed = compressBound(header.size);
+	data_compressed = MEM_mallocN(size_compressed, "sequencer disk cache data");
+
+	ok = (compress2(data_compressed, &size_compressed, data, header.size,
+	                U.sequencer_disk_cache_compression) == Z_OK);
+
+	if (ok) {
+		header.size_compressed = (unsigned int)size_compressed;
+		ok = (fwrite(&header, sizeof(header), 1, fp) == 1) &&
+		     (fwrite(data_compressed, size_compressed, 1, fp) == 1);
+	}
+
+	MEM_freeN(data_compressed);
+
+	return ok;
+}
+
+static void seq_disk_cache_write(const SeqRenderData *context, Sequence *seq, float cfra, eSeqStripElemIBuf type,
+                                 ImBuf *ibuf)
+{
+	static unsigned int temp_counter = 0;
+	unsigned int settings_hash;
+	char path[FILE_MAX], path_temp[FILE_MAX];
+	FILE *fp;
+	bool ok;
+
+	if (!seq_disk_cache_is_enabled(context, seq, cfra)) {
+		return;
+	}
+
+	if (ibuf->rect == NULL && ibuf->rect_float == NULL) {
+		return;
+	}
+
+	settings_hash = seq_disk_cache_settings_hash(context, seq, cfra, type);
+	seq_disk_cache_path_get(context, seq, cfra, type, settings_hash, path);
+
+	if (BLI_exists(path)) {
+		return;
+	}
+
+	/* Write to a temporary file first, so interrupted writes never leave a broken file behind.
+	 * Named uniquely, the same frame might be written by the prefetch worker and a viewer. */
+	BLI_snprintf(path_temp, sizeof(path_temp), "%s@%u", path, atomic_add_and_fetch_u(&temp_counter, 1));
+
+	if (!BLI_make_existing_file(path_temp) || (fp = BLI_fopen(path_temp, "wb")) == NULL) {
+		return;
+	}
+
+	ok = seq_disk_cache_write_file(fp, ibuf, settings_hash);
+	fclose(fp);
+
+	BLI_mutex_lock(&disk_cache_lock);
+
+	if (ok && !BLI_exists(path) && BLI_rename(path_temp, path) == 0) {
+		SeqDiskCache *dcache = seq_disk_cache_ensure(context->bmain);
+
+		seq_disk_cache_file_add(dcache, path, BLI_file_size(path));
+		seq_disk_cache_enforce_limit(dcache);
+	}
+	else {
+		BLI_delete(path_temp, false, false);
+	}
+
+	BLI_mutex_unlock(&disk_cache_lock);
+}
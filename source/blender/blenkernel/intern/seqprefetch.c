@@ -0,0 +1,562 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenkernel/intern/seqprefetch.c
+ *  \ingroup bke
+ *
+ * Background rendering of sequencer frames ahead of the playhead.
+ *
+ * A single worker thread renders frames following the one which was last
+ * requested by the viewer. It never touches the strips of the scene being
+ * edited: when it is started a private copy of the scene's strips and of their
+ * animation is made, which the worker evaluates for every frame it renders.
+ * Results are stored in the regular sequencer cache under the original strips,
+ * so they are picked up by playback. Edits which invalidate the cache stop the
+ * worker and the copy is made again on the next request.
+ *
+ * Data-blocks used by strips (movie clips, masks, fonts) are still shared, so
+ * every render of the sequencer, whether by the worker, viewers or the render
+ * pipeline, has to hold the prefetch lock.
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_anim_types.h"
+#include "DNA_sequence_types.h"
+#include "DNA_scene_types.h"
+#include "DNA_userdef_types.h"
+
+#include "BLI_ghash.h"
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+#include "IMB_moviecache.h"
+
+#include "BKE_animsys.h"
+#include "BKE_fcurve.h"
+#include "BKE_library.h"
+#include "BKE_sequencer.h"
+
+typedef struct SeqPrefetchState {
+	/* Render settings of the viewer which requested prefetching. */
+	SeqRenderData context;
+	int chanshown;
+
+	/* Frame last requested by the viewer and the last frame the worker
+	 * rendered (or found in the cache) for the current context. */
+	int cfra;
+	int cfra_done;
+	int num_frames;
+
+	/* Set when the worker is not allowed to render anymore. */
+	bool stop;
+	/* Set when the memory cache limit is reached, cleared on new requests. */
+	bool cache_full;
+	bool running;
+
+	/* Private copy of the scene the worker renders from, and the mapping of the
+	 * copied strips back to the original ones. Only changed while the worker
+	 * isn't running. */
+	Scene *scene_orig;
+	Scene *scene_copy;
+	GHash *seq_orig;
+
+	ListBase threads;
+} SeqPrefetchState;
+
+static SeqPrefetchState prefetch = {{NULL}};
+
+/* Protects the state above and the render lock owner below. */
+static ThreadMutex prefetch_state_lock = BLI_MUTEX_INITIALIZER;
+static ThreadCondition prefetch_state_cond = PTHREAD_COND_INITIALIZER;
+
+/* Serializes starting and stopping of the worker. */
+static ThreadMutex prefetch_control_lock = BLI_MUTEX_INITIALIZER;
+
+/* Held while the sequencer renders a frame. It may be taken again by the thread
+ * already holding it, rendering of scene strips can end up rendering the
+ * sequencer of another scene. */
+static ThreadMutex prefetch_render_lock = BLI_MUTEX_INITIALIZER;
+static pthread_t prefetch_render_owner;
+static int prefetch_render_depth = 0;
+
+static bool seq_prefetch_render_lock_is_owned(void)
+{
+	bool owned;
+
+	BLI_mutex_lock(&prefetch_state_lock);
+	owned = (prefetch_render_depth > 0) && pthread_equal(pthread_self(), prefetch_render_owner);
+	BLI_mutex_unlock(&prefetch_state_lock);
+
+	return owned;
+}
+
+static void seq_prefetch_render_lock(void)
+{
+	if (seq_prefetch_render_lock_is_owned()) {
+		/* Only the owner changes the depth while it is non-zero. */
+		BLI_mutex_lock(&prefetch_state_lock);
+		prefetch_render_depth++;
+		BLI_mutex_unlock(&prefetch_state_lock);
+		return;
+	}
+
+	BLI_mutex_lock(&prefetch_render_lock);
+
+	BLI_mutex_lock(&prefetch_state_lock);
+	prefetch_render_owner = pthread_self();
+	prefetch_render_depth = 1;
+	BLI_mutex_unlock(&prefetch_state_lock);
+}
+
+static void seq_prefetch_render_unlock(void)
+{
+	bool release;
+
+	BLI_mutex_lock(&prefetch_state_lock);
+	BLI_assert(prefetch_render_depth > 0 && pthread_equal(pthread_self(), prefetch_render_owner));
+	release = (--prefetch_render_depth == 0);
+	BLI_mutex_unlock(&prefetch_state_lock);
+
+	if (release) {
+		BLI_mutex_unlock(&prefetch_render_lock);
+	}
+}
+
+static bool seq_prefetch_context_equal(const SeqRenderData *a, const SeqRenderData *b)
+{
+	return ((a->bmain == b->bmain) &&
+	        (a->scene == b->scene) &&
+	        (a->rectx == b->rectx) &&
+	        (a->recty == b->recty) &&
+	        (a->preview_render_size == b->preview_render_size) &&
+	        (a->view_id == b->view_id));
+}
+
+/* Scene strips render through the render pipeline and OpenGL,
+ * neither of which can be used from the worker thread. */
+static bool seq_prefetch_seqbase_is_supported(ListBase *seqbase)
+{
+	Sequence *seq;
+
+	for (seq = seqbase->first; seq; seq = seq->next) {
+		if (seq->type == SEQ_TYPE_SCENE) {
+			return false;
+		}
+		if (seq->type == SEQ_TYPE_META && !seq_prefetch_seqbase_is_supported(&seq->seqbase)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Only keyframes of the sequencer are evaluated by the worker, drivers and
+ * the NLA might depend on other data-blocks which it can't access. */
+static bool seq_prefetch_animdata_is_supported(AnimData *adt)
+{
+	FCurve *fcu;
+
+	if (adt == NULL) {
+		return true;
+	}
+
+	if (adt->nla_tracks.first && (adt->flag & ADT_NLA_EVAL_OFF) == 0) {
+		return false;
+	}
+
+	for (fcu = adt->drivers.first; fcu; fcu = fcu->next) {
+		if (fcu->rna_path && STRPREFIX(fcu->rna_path, "sequence_editor.")) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static AnimData *seq_prefetch_animdata_copy(AnimData *adt)
+{
+	AnimData *adt_copy;
+	bAction *act_copy;
+	FCurve *fcu;
+
+	if (adt == NULL || adt->action == NULL) {
+		return NULL;
+	}
+
+	act_copy = MEM_callocN(sizeof(bAction), "prefetch action");
+	act_copy->idroot = ID_SCE;
+
+	for (fcu = adt->action->curves.first; fcu; fcu = fcu->next) {
+		if (fcu->rna_path && STRPREFIX(fcu->rna_path, "sequence_editor.")) {
+			BLI_addtail(&act_copy->curves, copy_fcurve(fcu));
+		}
+	}
+
+	adt_copy = MEM_callocN(sizeof(AnimData), "prefetch animdata");
+	adt_copy->action = act_copy;
+	adt_copy->act_influence = 1.0f;
+
+	return adt_copy;
+}
+
+static void seq_prefetch_animdata_free(AnimData *adt)
+{
+	if (adt) {
+		free_fcurves(&adt->action->curves);
+		MEM_freeN(adt->action);
+		MEM_freeN(adt);
+	}
+}
+
+/* Copies are linked to their originals through Sequence.tmp by the duplication. */
+static void seq_prefetch_seqbase_map(ListBase *seqbase, ListBase *seqbasep, Editing *ed_copy, GHash *seq_orig)
+{
+	Sequence *seq;
+
+	for (seq = seqbase->first; seq; seq = seq->next) {
+		Sequence *seq_copy = seq->tmp;
+
+		/* the disk cache is keyed by this */
+		seq_copy->cache_id = seq->cache_id;
+
+		BLI_ghash_insert(seq_orig, seq_copy, seq);
+
+		if (seq->type == SEQ_TYPE_META) {
+			if (&seq->seqbase == seqbasep) {
+				ed_copy->seqbasep = &seq_copy->seqbase;
+			}
+			seq_prefetch_seqbase_map(&seq->seqbase, seqbasep, ed_copy, seq_orig);
+		}
+	}
+}
+
+/* Has to be called from the main thread, while the worker isn't running. */
+static void seq_prefetch_scene_copy(Scene *scene)
+{
+	Editing *ed = scene->ed;
+	Scene *scene_copy;
+	Editing *ed_copy;
+
+	/* Everything but the strips and animation is shared with the original,
+	 * none of which is changed by rendering. */
+	scene_copy = MEM_dupallocN(scene);
+	scene_copy->id.tag |= LIB_TAG_NO_MAIN | LIB_TAG_NO_USER_REFCOUNT;
+	scene_copy->id.py_instance = NULL;
+	scene_copy->adt = seq_prefetch_animdata_copy(scene->adt);
+
+	ed_copy = MEM_dupallocN(ed);
+	BLI_listbase_clear(&ed_copy->seqbase);
+	BLI_listbase_clear(&ed_copy->metastack);
+	ed_copy->seqbasep = &ed_copy->seqbase;
+	ed_copy->act_seq = NULL;
+	scene_copy->ed = ed_copy;
+
+	BKE_sequence_base_dupli_recursive(
+	        scene, scene_copy, &ed_copy->seqbase, &ed->seqbase, SEQ_DUPE_ALL | SEQ_DUPE_NO_SOUND,
+	        LIB_ID_CREATE_NO_USER_REFCOUNT);
+
+	prefetch.seq_orig = BLI_ghash_ptr_new(__func__);
+	seq_prefetch_seqbase_map(&ed->seqbase, ed->seqbasep, ed_copy, prefetch.seq_orig);
+
+	prefetch.scene_orig = scene;
+	prefetch.scene_copy = scene_copy;
+}
+
+static void seq_prefetch_scene_free(Scene *scene_copy, GHash *seq_orig)
+{
+	BKE_sequencer_editing_free_ex(scene_copy, false, false);
+	seq_prefetch_animdata_free(scene_copy->adt);
+	MEM_freeN(scene_copy);
+
+	BLI_ghash_free(seq_orig, NULL, NULL);
+}
+
+/* Rough upper bound of the memory one prefetched frame occupies in the cache. */
+static size_t seq_prefetch_frame_size(const SeqRenderData *context)
+{
+	return (size_t)context->rectx * (size_t)context->recty * 4 * sizeof(float);
+}
+
+/* Returns the next frame to render, or false when the worker has to wait. */
+static bool seq_prefetch_next_frame(int *r_cfra)
+{
+	const Scene *scene = prefetch.scene_copy;
+	int cfra = max_ii(prefetch.cfra, prefetch.cfra_done) + 1;
+
+	if (prefetch.cache_full) {
+		return false;
+	}
+
+	if (cfra > prefetch.cfra + prefetch.num_frames || cfra > scene->r.efra) {
+		return false;
+	}
+
+	*r_cfra = cfra;
+	return true;
+}
+
+static void *seq_prefetch_thread(void *UNUSED(data))
+{
+	BLI_mutex_lock(&prefetch_state_lock);
+
+	while (!prefetch.stop) {
+		SeqRenderData context;
+		Scene *scene_copy;
+		ImBuf *ibuf;
+		int chanshown, cfra;
+		bool stop;
+
+		if (!seq_prefetch_next_frame(&cfra)) {
+			BLI_condition_wait(&prefetch_state_cond, &prefetch_state_lock);
+			continue;
+		}
+
+		if (!IMB_moviecache_has_space(seq_prefetch_frame_size(&prefetch.context))) {
+			/* Don't push out frames which were prefetched but not played yet. */
+			prefetch.cache_full = true;
+			continue;
+		}
+
+		context = prefetch.context;
+		chanshown = prefetch.chanshown;
+		scene_copy = prefetch.scene_copy;
+		BLI_mutex_unlock(&prefetch_state_lock);
+
+		context.scene = scene_copy;
+		context.is_prefetch_render = true;
+
+		seq_prefetch_render_lock();
+
+		/* Don't start a frame when stopping was requested meanwhile. */
+		BLI_mutex_lock(&prefetch_state_lock);
+		stop = prefetch.stop;
+		BLI_mutex_unlock(&prefetch_state_lock);
+
+		ibuf = NULL;
+		if (!stop) {
+			scene_copy->r.cfra = cfra;
+			BKE_animsys_evaluate_animdata(scene_copy, &scene_copy->id, scene_copy->adt, (float)cfra, ADT_RECALC_ANIM);
+
+			ibuf = BKE_sequencer_give_ibuf(&context, (float)cfra, chanshown);
+		}
+
+		seq_prefetch_render_unlock();
+
+		if (ibuf) {
+			IMB_freeImBuf(ibuf);
+		}
+
+		BLI_mutex_lock(&prefetch_state_lock);
+
+		/* Context might have changed while rendering, only account
+		 * the frame if it's still for the current viewer. */
+		context.scene = prefetch.scene_orig;
+		if (seq_prefetch_context_equal(&context, &prefetch.context) &&
+		    chanshown == prefetch.chanshown)
+		{
+			prefetch.cfra_done = max_ii(prefetch.cfra_done, cfra);
+		}
+	}
+
+	BLI_mutex_unlock(&prefetch_state_lock);
+
+	return NULL;
+}
+
+/* Caller holds the control lock. */
+static void seq_prefetch_stop_ex(void)
+{
+	Scene *scene_copy;
+	GHash *seq_orig;
+
+	BLI_mutex_lock(&prefetch_state_lock);
+
+	if (!prefetch.running) {
+		BLI_mutex_unlock(&prefetch_state_lock);
+		return;
+	}
+
+	prefetch.stop = true;
+	BLI_condition_notify_one(&prefetch_state_cond);
+	BLI_mutex_unlock(&prefetch_state_lock);
+
+	BLI_threadpool_end(&prefetch.threads);
+
+	BLI_mutex_lock(&prefetch_state_lock);
+	scene_copy = prefetch.scene_copy;
+	seq_orig = prefetch.seq_orig;
+	prefetch.scene_orig = NULL;
+	prefetch.scene_copy = NULL;
+	prefetch.seq_orig = NULL;
+	prefetch.running = false;
+	memset(&prefetch.context, 0, sizeof(prefetch.context));
+	BLI_mutex_unlock(&prefetch_state_lock);
+
+	/* Freeing strips stops prefetching again, which returns early by now. */
+	seq_prefetch_scene_free(scene_copy, seq_orig);
+}
+
+/* Request frames following cfra to be rendered in the background.
+ * Cheap to call on every redraw, the worker is started on first use.
+ * Has to be called from the main thread. */
+void BKE_sequencer_prefetch_start(const SeqRenderData *context, float cfra, int chanshown)
+{
+	Scene *scene = context->scene;
+	Editing *ed = BKE_sequencer_editing_get(scene, false);
+	bool running;
+
+	if (ed == NULL || U.prefetchframes <= 0 || context->skip_cache || context->is_proxy_render) {
+		return;
+	}
+
+	/* The worker might be waiting for the lock. */
+	if (seq_prefetch_render_lock_is_owned()) {
+		return;
+	}
+
+	if (!seq_prefetch_seqbase_is_supported(&ed->seqbase) || !seq_prefetch_animdata_is_supported(scene->adt) ||
+	    (chanshown < 0 && !BLI_listbase_is_empty(&ed->metastack)))
+	{
+		BKE_sequencer_prefetch_stop();
+		return;
+	}
+
+	BLI_mutex_lock(&prefetch_control_lock);
+
+	BLI_mutex_lock(&prefetch_state_lock);
+	running = prefetch.running;
+	BLI_mutex_unlock(&prefetch_state_lock);
+
+	if (running && prefetch.scene_orig != scene) {
+		/* The copy is of another scene. */
+		seq_prefetch_stop_ex();
+		running = false;
+	}
+
+	if (!running) {
+		seq_prefetch_scene_copy(scene);
+	}
+
+	BLI_mutex_lock(&prefetch_state_lock);
+
+	if (!seq_prefetch_context_equal(context, &prefetch.context) || chanshown != prefetch.chanshown ||
+	    (int)cfra < prefetch.cfra)
+	{
+		/* Seek or different viewer, start over from the new frame. */
+		prefetch.cfra_done = (int)cfra;
+	}
+
+	prefetch.context = *context;
+	prefetch.chanshown = chanshown;
+	prefetch.cfra = (int)cfra;
+	prefetch.num_frames = U.prefetchframes;
+	prefetch.cache_full = false;
+	prefetch.stop = false;
+
+	/* The worker only ever renders with its own copy of the context,
+	 * OpenGL resources of the viewer are not to be used from there. */
+	prefetch.context.gpu_offscreen = NULL;
+	prefetch.context.gpu_fx = NULL;
+
+	if (!prefetch.running) {
+		prefetch.running = true;
+		BLI_threadpool_init(&prefetch.threads, seq_prefetch_thread, 1);
+		BLI_threadpool_insert(&prefetch.threads, NULL);
+	}
+
+	BLI_condition_notify_one(&prefetch_state_cond);
+	BLI_mutex_unlock(&prefetch_state_lock);
+
+	BLI_mutex_unlock(&prefetch_control_lock);
+}
+
+/* Stop the worker, waiting for the frame which is currently being rendered.
+ * Called when strips are changed or freed, the frames rendered ahead would
+ * be outdated. Does nothing when called by the thread holding the prefetch
+ * lock: the worker can't be rendering then, and it might be the worker itself
+ * changing its copy of the strips. */
+void BKE_sequencer_prefetch_stop(void)
+{
+	bool running;
+
+	if (seq_prefetch_render_lock_is_owned()) {
+		return;
+	}
+
+	BLI_mutex_lock(&prefetch_state_lock);
+	running = prefetch.running;
+	BLI_mutex_unlock(&prefetch_state_lock);
+
+	if (!running) {
+		return;
+	}
+
+	BLI_mutex_lock(&prefetch_control_lock);
+	seq_prefetch_stop_ex();
+	BLI_mutex_unlock(&prefetch_control_lock);
+}
+
+bool BKE_sequencer_prefetch_is_running(void)
+{
+	bool running;
+
+	BLI_mutex_lock(&prefetch_state_lock);
+	running = prefetch.running && !prefetch.stop;
+	BLI_mutex_unlock(&prefetch_state_lock);
+
+	return running;
+}
+
+/* Original of a strip of the copy the worker renders from, frames rendered
+ * by the worker are cached under these. Only valid for prefetch renders. */
+Sequence *BKE_sequencer_prefetch_get_original_sequence(const SeqRenderData *context, Sequence *seq)
+{
+	BLI_assert(context->is_prefetch_render);
+	UNUSED_VARS_NDEBUG(context);
+
+	return BLI_ghash_lookup(prefetch.seq_orig, seq);
+}
+
+Scene *BKE_sequencer_prefetch_get_original_scene(const SeqRenderData *context)
+{
+	BLI_assert(context->is_prefetch_render);
+	UNUSED_VARS_NDEBUG(context);
+
+	return prefetch.scene_orig;
+}
+
+/* Every render of the sequencer needs to hold this lock. */
+void BKE_sequencer_prefetch_lock(void)
+{
+	seq_prefetch_render_lock();
+}
+
+void BKE_sequencer_prefetch_unlock(void)
+{
+	seq_prefetch_render_unlock();
+}
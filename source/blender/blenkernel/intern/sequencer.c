@@ -36,6 +36,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "DNA_sequence_types.h"
 #include "DNA_movieclip_types.h"
 #include "DNA_mask_types.h"
@@ -46,14 +48,18 @@
 
 #include "BLI_math.h"
 #include "BLI_fileops.h"
+#include "BLI_hash_mm2a.h"
 #include "BLI_listbase.h"
 #include "BLI_linklist.h"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
 #include "BLI_string_utf8.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
+#include "PIL_time.h"
+
 #ifdef WIN32
 #  include "BLI_winstuff.h"
 #else
@@ -79,8 +85,6 @@
 
 #include "RE_pipeline.h"
 
-#include <pthread.h>
-
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
 #include "IMB_colormanagement.h"
@@ -202,6 +206,9 @@ static void seq_free_strip(Strip *strip)
 /* only give option to skip cache locally (static func) */
 static void BKE_sequence_free_ex(Scene *scene, Sequence *seq, const bool do_cache, const bool do_id_user)
 {
+	/* the prefetch worker renders from the scene's strips */
+	BKE_sequencer_prefetch_stop();
+
 	if (seq->strip)
 		seq_free_strip(seq->strip);
 
@@ -268,6 +275,8 @@ void BKE_sequence_free(Scene *scene, Sequence *seq)
 /* Function to free imbuf and anim data on changes */
 void BKE_sequence_free_anim(Sequence *seq)
 {
+	BKE_sequencer_prefetch_stop();
+
 	while (seq->anims.last) {
 		StripAnim *sanim = seq->anims.last;
 
@@ -454,7 +463,8 @@ Editing *BKE_sequencer_editing_ensure(Scene *scene)
 	return scene->ed;
 }
 
-void BKE_sequencer_editing_free(Scene *scene, const bool do_id_user)
+/* do_cache is false for copies of strips which never were in the cache */
+void BKE_sequencer_editing_free_ex(Scene *scene, const bool do_cache, const bool do_id_user)
 {
 	Editing *ed = scene->ed;
 	Sequence *seq;
@@ -462,8 +472,10 @@ void BKE_sequencer_editing_free(Scene *scene, const bool do_id_user)
 	if (ed == NULL)
 		return;
 
-	/* this may not be the active scene!, could be smarter about this */
-	BKE_sequencer_cache_cleanup();
+	if (do_cache) {
+		/* this may not be the active scene!, could be smarter about this */
+		BKE_sequencer_cache_cleanup();
+	}
 
 	SEQ_BEGIN (ed, seq)
 	{
@@ -479,6 +491,11 @@ void BKE_sequencer_editing_free(Scene *scene, const bool do_id_user)
 	scene->ed = NULL;
 }
 
+void BKE_sequencer_editing_free(Scene *scene, const bool do_id_user)
+{
+	BKE_sequencer_editing_free_ex(scene, true, do_id_user);
+}
+
 /*********************** Sequencer color space functions  *************************/
 
 static void sequencer_imbuf_assign_spaces(Scene *scene, ImBuf *ibuf)
@@ -603,6 +620,7 @@ void BKE_sequencer_new_render_data(
 	r_context->motion_blur_shutter = 0;
 	r_context->skip_cache = false;
 	r_context->is_proxy_render = false;
+	r_context->is_prefetch_render = false;
 	r_context->view_id = 0;
 	r_context->gpu_offscreen = NULL;
 	r_context->gpu_samples = (scene->r.mode & R_OSA) ? scene->r.osa : 0;
@@ -2065,6 +2083,102 @@ void BKE_sequencer_proxy_rebuild(SeqIndexBuildContext *context, short *stop, sho
 	}
 }
 
+typedef struct SeqProxyRebuildTask {
+	SeqIndexBuildContext *context;
+	short *stop;
+	short do_update;
+	float progress;
+	unsigned int *num_done;
+} SeqProxyRebuildTask;
+
+static void seq_proxy_rebuild_task(TaskPool *__restrict UNUSED(pool), void *taskdata, int UNUSED(threadid))
+{
+	SeqProxyRebuildTask *task = taskdata;
+
+	if (!*task->stop) {
+		IMB_anim_index_rebuild(task->context->index_context, task->stop, &task->do_update, &task->progress);
+	}
+
+	task->progress = 1.0f;
+	atomic_add_and_fetch_u(task->num_done, 1);
+}
+
+/* Movie strips are indexed by their own decoder, independent from the rest of
+ * the sequencer, so several of them could be processed at once. */
+static bool seq_proxy_rebuild_is_threadsafe(SeqIndexBuildContext *context)
+{
+	return context->seq->type == SEQ_TYPE_MOVIE && context->index_context != NULL;
+}
+
+/* Rebuild all the contexts of the queue created by BKE_sequencer_proxy_rebuild_context,
+ * building proxies of several movie strips in parallel. */
+void BKE_sequencer_proxy_rebuild_queue(ListBase *queue, short *stop, short *do_update, float *progress)
+{
+	TaskScheduler *task_scheduler = BLI_task_scheduler_get();
+	TaskPool *task_pool;
+	SeqProxyRebuildTask *tasks;
+	unsigned int num_tasks = 0, num_done = 0;
+	LinkData *link;
+
+	/* Other strips are rendered by the sequencer itself, which is not re-entrant. */
+	for (link = queue->first; link; link = link->next) {
+		SeqIndexBuildContext *context = link->data;
+
+		if (seq_proxy_rebuild_is_threadsafe(context)) {
+			num_tasks++;
+		}
+		else {
+			BKE_sequencer_proxy_rebuild(context, stop, do_update, progress);
+		}
+
+		if (*stop) {
+			return;
+		}
+	}
+
+	if (num_tasks == 0) {
+		return;
+	}
+
+	tasks = MEM_callocN(sizeof(SeqProxyRebuildTask) * num_tasks, "seq proxy rebuild tasks");
+	task_pool = BLI_task_pool_create(task_scheduler, NULL);
+	num_tasks = 0;
+
+	for (link = queue->first; link; link = link->next) {
+		SeqIndexBuildContext *context = link->data;
+
+		if (seq_proxy_rebuild_is_threadsafe(context)) {
+			SeqProxyRebuildTask *task = &tasks[num_tasks++];
+
+			task->context = context;
+			task->stop = stop;
+			task->num_done = &num_done;
+
+			BLI_task_pool_push(task_pool, seq_proxy_rebuild_task, task, false, TASK_PRIORITY_LOW);
+		}
+	}
+
+	/* Report overall progress while the strips are being processed. */
+	while (atomic_add_and_fetch_u(&num_done, 0) != num_tasks) {
+		float total_progress = 0.0f;
+		unsigned int i;
+
+		for (i = 0; i < num_tasks; i++) {
+			total_progress += tasks[i].progress;
+		}
+
+		*progress = total_progress / num_tasks;
+		*do_update = true;
+
+		PIL_sleep_ms(50);
+	}
+
+	BLI_task_pool_work_and_wait(task_pool);
+	BLI_task_pool_free(task_pool);
+
+	MEM_freeN(tasks);
+}
+
 void BKE_sequencer_proxy_rebuild_finish(SeqIndexBuildContext *context, bool stop)
 {
 	if (context->index_context) {
@@ -3736,14 +3850,6 @@ static ImBuf *seq_render_strip_stack(
 		return NULL;
 	}
 
-#if 0 /* commentind since this breaks keyframing, since it resets the value on draw */
-	if (scene->r.cfra != cfra) {
-		/* XXX for prefetch and overlay offset!..., very bad!!! */
-		AnimData *adt = BKE_animdata_from_id(&scene->id);
-		BKE_animsys_evaluate_animdata(scene, &scene->id, adt, cfra, ADT_RECALC_ANIM);
-	}
-#endif
-
 	out = BKE_sequencer_cache_get(context, seq_arr[count - 1],  cfra, SEQ_STRIPELEM_IBUF_COMP);
 
 	if (out) {
@@ -3909,158 +4015,6 @@ ImBuf *BKE_sequencer_give_ibuf_direct(const SeqRenderData *context, float cfra,
 	return seq_render_strip(context, &state, seq, cfra);
 }
 
-/* *********************** threading api ******************* */
-
-static ListBase running_threads;
-static ListBase prefetch_wait;
-static ListBase prefetch_done;
-
-static pthread_mutex_t queue_lock          = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t wakeup_lock         = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t wakeup_cond          = PTHREAD_COND_INITIALIZER;
-
-//static pthread_mutex_t prefetch_ready_lock = PTHREAD_MUTEX_INITIALIZER;
-//static pthread_cond_t  prefetch_ready_cond = PTHREAD_COND_INITIALIZER;
-
-static pthread_mutex_t frame_done_lock     = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t frame_done_cond      = PTHREAD_COND_INITIALIZER;
-
-static volatile bool seq_thread_shutdown = true;
-static volatile int seq_last_given_monoton_cfra = 0;
-static int monoton_cfra = 0;
-
-typedef struct PrefetchThread {
-	struct PrefetchThread *next, *prev;
-
-	Scene *scene;
-	struct PrefetchQueueElem *current;
-	pthread_t pthread;
-	int running;
-
-} PrefetchThread;
-
-typedef struct PrefetchQueueElem {
-	struct PrefetchQueueElem *next, *prev;
-
-	int rectx;
-	int recty;
-	float cfra;
-	int chanshown;
-	int preview_render_size;
-
-	int monoton_cfra;
-
-	ImBuf *ibuf;
-} PrefetchQueueElem;
-
-void BKE_sequencer_give_ibuf_prefetch_request(const SeqRenderData *context, float cfra, int chanshown)
-{
-	PrefetchQueueElem *e;
-	if (seq_thread_shutdown) {
-		return;
-	}
-
-	e = MEM_callocN(sizeof(PrefetchQueueElem), "prefetch_queue_elem");
-	e->rectx = context->rectx;
-	e->recty = context->recty;
-	e->cfra = cfra;
-	e->chanshown = chanshown;
-	e->preview_render_size = context->preview_render_size;
-	e->monoton_cfra = monoton_cfra++;
-
-	pthread_mutex_lock(&queue_lock);
-	BLI_addtail(&prefetch_wait, e);
-	pthread_mutex_unlock(&queue_lock);
-
-	pthread_mutex_lock(&wakeup_lock);
-	pthread_cond_signal(&wakeup_cond);
-	pthread_mutex_unlock(&wakeup_lock);
-}
-
-ImBuf *BKE_sequencer_give_ibuf_threaded(const SeqRenderData *context, float cfra, int chanshown)
-{
-	PrefetchQueueElem *e = NULL;
-	bool found_something = false;
-
-	if (seq_thread_shutdown) {
-		return BKE_sequencer_give_ibuf(context, cfra, chanshown);
-	}
-
-	while (!e) {
-		bool success = false;
-		pthread_mutex_lock(&queue_lock);
-
-		for (e = prefetch_done.first; e; e = e->next) {
-			if (cfra == e->cfra &&
-			    chanshown == e->chanshown &&
-			    context->rectx == e->rectx &&
-			    context->recty == e->recty &&
-			    context->preview_render_size == e->preview_render_size)
-			{
-				success = true;
-				found_something = true;
-				break;
-			}
-		}
-
-		if (!e) {
-			for (e = prefetch_wait.first; e; e = e->next) {
-				if (cfra == e->cfra &&
-				    chanshown == e->chanshown &&
-				    context->rectx == e->rectx &&
-				    context->recty == e->recty &&
-				    context->preview_render_size == e->preview_render_size)
-				{
-					found_something = true;
-					break;
-				}
-			}
-		}
-
-		if (!e) {
-			PrefetchThread *tslot;
-
-			for (tslot = running_threads.first;
-			     tslot;
-			     tslot = tslot->next)
-			{
-				if (tslot->current &&
-				    cfra == tslot->current->cfra &&
-				    chanshown == tslot->current->chanshown &&
-				    context->rectx == tslot->current->rectx &&
-				    context->recty == tslot->current->recty &&
-				    context->preview_render_size == tslot->current->preview_render_size)
-				{
-					found_something = true;
-					break;
-				}
-			}
-		}
-
-		/* e->ibuf is unrefed by render thread on next round. */
-
-		if (e) {
-			seq_last_given_monoton_cfra = e->monoton_cfra;
-		}
-
-		pthread_mutex_unlock(&queue_lock);
-
-		if (!success) {
-			e = NULL;
-
-			if (!found_something) {
-				fprintf(stderr, "SEQ-THREAD: Requested frame not in queue ???\n");
-				break;
-			}
-			pthread_mutex_lock(&frame_done_lock);
-			pthread_cond_wait(&frame_done_cond, &frame_done_lock);
-			pthread_mutex_unlock(&frame_done_lock);
-		}
-	}
-
-	return e ? e->ibuf : NULL;
-}
-
 /* check whether sequence cur depends on seq */
 bool BKE_sequence_check_depend(Sequence *seq, Sequence *cur)
 {
@@ -4110,6 +4064,9 @@ static void sequence_invalidate_cache(Scene *scene, Sequence *seq, bool invalida
 {
 	Editing *ed = scene->ed;
 
+	/* frames rendered ahead might use the sequence being changed */
+	BKE_sequencer_prefetch_stop();
+
 	/* invalidate cache for current sequence */
 	if (invalidate_self) {
 		/* Animation structure holds some buffers inside,
@@ -5120,9 +5077,30 @@ Sequence *BKE_sequence_alloc(ListBase *lb, int cfra, int machine)
 
 	seq->stereo3d_format = MEM_callocN(sizeof(Stereo3dFormat), "Sequence Stereo Format");
 
+	BKE_sequence_cache_id_init(seq);
+
 	return seq;
 }
 
+/* Random identifier for the strip's files in the sequencer disk cache,
+ * new strips and copies get their own so they don't share cached frames. */
+void BKE_sequence_cache_id_init(Sequence *seq)
+{
+	static uint32_t counter = 0;
+	struct {
+		double time;
+		uintptr_t seq;
+		uint32_t counter;
+	} seed = {PIL_check_seconds_timer(), (uintptr_t)seq, atomic_add_and_fetch_uint32(&counter, 1)};
+
+	seq->cache_id = (int)BLI_hash_mm2((const unsigned char *)&seed, sizeof(seed), 0);
+
+	/* zero means not assigned yet */
+	if (seq->cache_id == 0) {
+		seq->cache_id = 1;
+	}
+}
+
 void BKE_sequence_alpha_mode_from_extension(Sequence *seq)
 {
 	if (seq->strip && seq->strip->stripdata) {
@@ -5437,6 +5415,8 @@ static Sequence *seq_dupli(const Scene *scene_src, Scene *scene_dst, Sequence *s
 	seq->tmp = seqn;
 	seqn->strip = MEM_dupallocN(seq->strip);
 
+	BKE_sequence_cache_id_init(seqn);
+
 	seqn->stereo3d_format = MEM_dupallocN(seq->stereo3d_format);
 
 	/* XXX: add F-Curve duplication stuff? */
@@ -5473,7 +5453,8 @@ static Sequence *seq_dupli(const Scene *scene_src, Scene *scene_dst, Sequence *s
 	}
 	else if (seq->type == SEQ_TYPE_SCENE) {
 		seqn->strip->stripdata = NULL;
-		if (seq->scene_sound)
+		seqn->scene_sound = NULL;
+		if (seq->scene_sound && (dupe_flag & SEQ_DUPE_NO_SOUND) == 0)
 			seqn->scene_sound = BKE_sound_scene_add_scene_sound_defaults(scene_dst, seqn);
 	}
 	else if (seq->type == SEQ_TYPE_MOVIECLIP) {
@@ -5490,7 +5471,8 @@ static Sequence *seq_dupli(const Scene *scene_src, Scene *scene_dst, Sequence *s
 	else if (seq->type == SEQ_TYPE_SOUND_RAM) {
 		seqn->strip->stripdata =
 		        MEM_dupallocN(seq->strip->stripdata);
-		if (seq->scene_sound)
+		seqn->scene_sound = NULL;
+		if (seq->scene_sound && (dupe_flag & SEQ_DUPE_NO_SOUND) == 0)
 			seqn->scene_sound = BKE_sound_add_scene_sound_defaults(scene_dst, seqn);
 
 		if ((flag & LIB_ID_CREATE_NO_USER_REFCOUNT) == 0) {
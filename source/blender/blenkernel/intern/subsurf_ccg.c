@@ -806,6 +806,12 @@ static void ss_sync_from_derivedmesh(CCGSubSurf *ss,
 	else
 #endif
 	{
+#ifdef WITH_OPENSUBDIV
+		if (ccgSubSurf_getUseOpenSubdivEvaluator(ss)) {
+			/* Compares against the previous sync, so has to happen before it. */
+			ccgSubSurf_checkTopologyChanged(ss, dm);
+		}
+#endif
 		ss_sync_ccg_from_derivedmesh(ss, dm, vertexCos, use_flat_subdiv);
 	}
 }
@@ -1806,6 +1812,21 @@ static void ccgDM_drawVerts(DerivedMesh *dm)
 	glEnd();
 }
 
+/* Remember which base faces had their grids modified by sculpting,
+ * so only their displacements need to be recalculated on release. */
+static void ccgdm_multires_tag_modified_faces(CCGDerivedMesh *ccgdm, CCGFace **faces, int totface)
+{
+	int i;
+
+	if (ccgdm->multires.modified_polys == NULL) {
+		ccgdm->multires.modified_polys = BLI_BITMAP_NEW(ccgSubSurf_getNumFaces(ccgdm->ss), __func__);
+	}
+
+	for (i = 0; i < totface; i++) {
+		BLI_BITMAP_ENABLE(ccgdm->multires.modified_polys, POINTER_AS_INT(ccgSubSurf_getFaceFaceHandle(faces[i])));
+	}
+}
+
 static void ccgdm_pbvh_update(CCGDerivedMesh *ccgdm)
 {
 	if (ccgdm->pbvh && ccgDM_use_grid_pbvh(ccgdm)) {
@@ -1814,6 +1835,9 @@ static void ccgdm_pbvh_update(CCGDerivedMesh *ccgdm)
 
 		BKE_pbvh_get_grid_updates(ccgdm->pbvh, 1, (void ***)&faces, &totface);
 		if (totface) {
+			if (ccgdm->multires.mmd) {
+				ccgdm_multires_tag_modified_faces(ccgdm, faces, totface);
+			}
 			ccgSubSurf_updateFromFaces(ccgdm->ss, 0, faces, totface);
 			ccgSubSurf_updateNormals(ccgdm->ss, faces, totface);
 			MEM_freeN(faces);
@@ -4020,6 +4044,46 @@ static void ccgDM_foreachMappedFaceCenter(
 	}
 }
 
+/* Guards SubsurfModifierData.renderCache, renders of different scenes
+ * (or a render and a bake) can evaluate the same modifier in parallel. */
+static ThreadMutex subsurf_render_cache_lock = BLI_MUTEX_INITIALIZER;
+
+static CCGSubSurf *subsurf_render_cache_take(SubsurfModifierData *smd)
+{
+	CCGSubSurf *ss;
+
+	BLI_mutex_lock(&subsurf_render_cache_lock);
+	ss = smd->renderCache;
+	smd->renderCache = NULL;
+	BLI_mutex_unlock(&subsurf_render_cache_lock);
+
+	return ss;
+}
+
+/* Keep ss for the next frame, unless another render put its own back first. */
+static void subsurf_render_cache_give_back(SubsurfModifierData *smd, CCGSubSurf *ss)
+{
+	BLI_mutex_lock(&subsurf_render_cache_lock);
+	if (smd->renderCache == NULL) {
+		smd->renderCache = ss;
+		ss = NULL;
+	}
+	BLI_mutex_unlock(&subsurf_render_cache_lock);
+
+	if (ss) {
+		ccgSubSurf_free(ss);
+	}
+}
+
+void subsurf_free_render_cache(SubsurfModifierData *smd)
+{
+	CCGSubSurf *ss = subsurf_render_cache_take(smd);
+
+	if (ss) {
+		ccgSubSurf_free(ss);
+	}
+}
+
 static void ccgDM_release(DerivedMesh *dm)
 {
 	CCGDerivedMesh *ccgdm = (CCGDerivedMesh *) dm;
@@ -4034,6 +4098,28 @@ static void ccgDM_release(DerivedMesh *dm)
 				ccgdm->multires.mmd = NULL;
 			}
 
+			if (ccgdm->multires.mmd && ccgdm->multires.modified_polys) {
+				/* Grids tagged for update but not yet flushed are modified as well.
+				 * Only trust the tracked faces while the PBVH is still alive, otherwise
+				 * fall back to updating all displacements. */
+				Object *ob = ccgdm->multires.ob;
+
+				if (ccgdm->pbvh && ob->sculpt && ob->sculpt->pbvh == ccgdm->pbvh) {
+					CCGFace **faces;
+					int totface;
+
+					BKE_pbvh_get_grid_updates(ccgdm->pbvh, 0, (void ***)&faces, &totface);
+					if (totface) {
+						ccgdm_multires_tag_modified_faces(ccgdm, faces, totface);
+						MEM_freeN(faces);
+					}
+				}
+				else {
+					MEM_freeN(ccgdm->multires.modified_polys);
+					ccgdm->multires.modified_polys = NULL;
+				}
+			}
+
 			if (ccgdm->multires.mmd) {
 				if (ccgdm->multires.modified_flags & MULTIRES_COORDS_MODIFIED)
 					multires_modifier_update_mdisps(dm);
@@ -4042,6 +4128,9 @@ static void ccgDM_release(DerivedMesh *dm)
 			}
 		}
 
+		if (ccgdm->multires.modified_polys)
+			MEM_freeN(ccgdm->multires.modified_polys);
+
 		if (ccgdm->ehash)
 			BLI_edgehash_free(ccgdm->ehash, NULL);
 
@@ -4060,7 +4149,8 @@ static void ccgDM_release(DerivedMesh *dm)
 			}
 			MEM_freeN(ccgdm->gridHidden);
 		}
-		if (ccgdm->freeSS) ccgSubSurf_free(ccgdm->ss);
+		if (ccgdm->render_cache_smd) subsurf_render_cache_give_back(ccgdm->render_cache_smd, ccgdm->ss);
+		else if (ccgdm->freeSS) ccgSubSurf_free(ccgdm->ss);
 		if (ccgdm->pmap) MEM_freeN(ccgdm->pmap);
 		if (ccgdm->pmap_mem) MEM_freeN(ccgdm->pmap_mem);
 		MEM_freeN(ccgdm->edgeFlags);
@@ -5147,6 +5237,19 @@ static bool subsurf_use_gpu_backend(SubsurfFlags flags)
 #endif
 }
 
+#ifdef WITH_OPENSUBDIV
+/* Evaluate the limit surface with OpenSubdiv on the CPU, into regular CCG
+ * grids. Paint masks are not evaluated, so sculpting keeps using the legacy
+ * subdivision, as does edit mode where the cage is needed.
+ */
+static bool subsurf_use_cpu_evaluator(SubsurfModifierData *smd, SubsurfFlags flags, bool use_gpu_backend)
+{
+	return (smd->flags & eSubsurfModifierFlag_OpenSubdivCPU) != 0 &&
+	       (flags & (SUBSURF_FOR_EDIT_MODE | SUBSURF_ALLOC_PAINT_MASK)) == 0 &&
+	       use_gpu_backend == false;
+}
+#endif
+
 struct DerivedMesh *subsurf_make_derived_from_derived(
         struct DerivedMesh *dm,
         struct SubsurfModifierData *smd,
@@ -5159,6 +5262,9 @@ struct DerivedMesh *subsurf_make_derived_from_derived(
 	int drawInteriorEdges = !(smd->flags & eSubsurfModifierFlag_ControlEdges);
 	CCGDerivedMesh *result;
 	bool use_gpu_backend = subsurf_use_gpu_backend(flags);
+#ifdef WITH_OPENSUBDIV
+	bool use_cpu_evaluator = subsurf_use_cpu_evaluator(smd, flags, use_gpu_backend);
+#endif
 
 	/* note: editmode calculation can only run once per
 	 * modifier stack evaluation (uses freed cache) [#36299] */
@@ -5189,14 +5295,38 @@ struct DerivedMesh *subsurf_make_derived_from_derived(
 		if (levels == 0)
 			return dm;
 
-		ss = _getSubSurf(NULL, levels, 3, useSimple | CCG_USE_ARENA | CCG_CALC_NORMALS);
+#ifdef WITH_OPENSUBDIV
+		if (use_cpu_evaluator) {
+			/* Keep the evaluator for the next frame, re-creating refiner and
+			 * stencil tables is what costs most. Not using an arena, since
+			 * syncing reallocates the element maps.
+			 * The result owns it until released, so parallel renders of the
+			 * same modifier never share one.
+			 */
+			ss = _getSubSurf(subsurf_render_cache_take(smd), levels, 3, useSimple | CCG_CALC_NORMALS);
+			ccgSubSurf_setUseOpenSubdivEvaluator(ss, true);
 
-		ss_sync_from_derivedmesh(ss, dm, vertCos, useSimple, useSubsurfUv);
+			ss_sync_from_derivedmesh(ss, dm, vertCos, useSimple, useSubsurfUv);
 
-		result = getCCGDerivedMesh(ss,
-		                           drawInteriorEdges, useSubsurfUv, dm, false);
+			result = getCCGDerivedMesh(ss,
+			                           drawInteriorEdges, useSubsurfUv, dm, false);
 
-		result->freeSS = 1;
+			result->render_cache_smd = smd;
+		}
+		else
+#endif
+		{
+			subsurf_free_render_cache(smd);
+
+			ss = _getSubSurf(NULL, levels, 3, useSimple | CCG_USE_ARENA | CCG_CALC_NORMALS);
+
+			ss_sync_from_derivedmesh(ss, dm, vertCos, useSimple, useSubsurfUv);
+
+			result = getCCGDerivedMesh(ss,
+			                           drawInteriorEdges, useSubsurfUv, dm, false);
+
+			result->freeSS = 1;
+		}
 	}
 	else {
 		int useIncremental = (smd->flags & eSubsurfModifierFlag_Incremental);
@@ -5246,6 +5376,12 @@ struct DerivedMesh *subsurf_make_derived_from_derived(
 				if (use_gpu_backend) {
 					prevSS = smd->mCache;
 				}
+				else if (use_cpu_evaluator && ccgSubSurf_getUseOpenSubdivEvaluator(smd->mCache)) {
+					/* Cached evaluator is only valid for the same topology,
+					 * which is checked on sync.
+					 */
+					prevSS = smd->mCache;
+				}
 				else
 #endif
 				{
@@ -5258,9 +5394,17 @@ struct DerivedMesh *subsurf_make_derived_from_derived(
 			if (flags & SUBSURF_ALLOC_PAINT_MASK)
 				ccg_flags |= CCG_ALLOC_MASK;
 
+#ifdef WITH_OPENSUBDIV
+			if (use_cpu_evaluator) {
+				/* Kept between evaluations, see render case above. */
+				ccg_flags &= ~CCG_USE_ARENA;
+			}
+#endif
+
 			ss = _getSubSurf(prevSS, levels, 3, ccg_flags);
 #ifdef WITH_OPENSUBDIV
 			ccgSubSurf_setSkipGrids(ss, use_gpu_backend);
+			ccgSubSurf_setUseOpenSubdivEvaluator(ss, use_cpu_evaluator);
 #endif
 			ss_sync_from_derivedmesh(ss, dm, vertCos, useSimple, useSubsurfUv);
 
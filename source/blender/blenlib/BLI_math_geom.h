@@ -474,6 +474,7 @@ bool form_factor_visible_quad(const float p[3], const float n[3],
                               float q0[3], float q1[3], float q2[3], float q3[3]);
 float form_factor_hemi_poly(float p[3], float n[3],
                             float v1[3], float v2[3], float v3[3], float v4[3]);
+double solid_angle_tri_v3(const float p[3], const float v1[3], const float v2[3], const float v3[3]);
 
 void axis_dominant_v3_to_m3_negate(float r_mat[3][3], const float normal[3]);
 void axis_dominant_v3_to_m3(float r_mat[3][3], const float normal[3]);
@@ -498,6 +499,11 @@ MINLINE float shell_v2v2_mid_normalized_to_dist(const float a[2], const float b[
 
 float cubic_tangent_factor_circle_v3(const float tan_l[3], const float tan_r[3]);
 
+/****************************** Robust Predicates *****************************/
+
+double orient2d_robust_v2(const float a[2], const float b[2], const float c[2]);
+double orient3d_robust_v3(const float a[3], const float b[3], const float c[3], const float d[3]);
+
 /**************************** Inline Definitions ******************************/
 
 #if BLI_MATH_DO_INLINE
@@ -4876,6 +4876,40 @@ float form_factor_hemi_poly(float p[3], float n[3], float v1[3], float v2[3], fl
 	return contrib;
 }
 
+/**
+ * Signed solid angle of triangle \a v1, \a v2, \a v3 seen from \a p,
+ * positive when the triangle winds counter-clockwise seen from \a p.
+ * Summed over a closed mesh and divided by 4 pi this is the winding number of \a p,
+ * see: "A Closed Form for the Solid Angle of a Triangle", Van Oosterom & Strackee.
+ */
+double solid_angle_tri_v3(const float p[3], const float v1[3], const float v2[3], const float v3[3])
+{
+	double a[3], b[3], c[3];
+	double la, lb, lc, det, div;
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		a[i] = (double)v1[i] - (double)p[i];
+		b[i] = (double)v2[i] - (double)p[i];
+		c[i] = (double)v3[i] - (double)p[i];
+	}
+
+	la = sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+	lb = sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2]);
+	lc = sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]);
+
+	det = (a[0] * (b[1] * c[2] - b[2] * c[1]) +
+	       a[1] * (b[2] * c[0] - b[0] * c[2]) +
+	       a[2] * (b[0] * c[1] - b[1] * c[0]));
+
+	div = (la * lb * lc +
+	       (a[0] * b[0] + a[1] * b[1] + a[2] * b[2]) * lc +
+	       (b[0] * c[0] + b[1] * c[1] + b[2] * c[2]) * la +
+	       (c[0] * a[0] + c[1] * a[1] + c[2] * a[2]) * lb);
+
+	return 2.0 * atan2(det, div);
+}
+
 /**
  * Evaluate if entire quad is a proper convex quad
  */
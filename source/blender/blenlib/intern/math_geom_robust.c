@@ -0,0 +1,357 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenlib/intern/math_geom_robust.c
+ *  \ingroup bli
+ *
+ * Orientation tests which always return the correct sign.
+ *
+ * The determinant is first evaluated in double precision, only when the
+ * result is too close to zero to be trusted it's evaluated again exactly,
+ * using the floating-point expansion arithmetic described in
+ * "Adaptive Precision Floating-Point Arithmetic and Fast Robust Geometric
+ * Predicates", Jonathan Richard Shewchuk, 1997.
+ *
+ * Single precision input is converted to double without any loss,
+ * the exact path relies on IEEE round-to-nearest arithmetic
+ * (don't build this file with fast-math).
+ */
+
+#include <math.h>
+
+#include "BLI_utildefines.h"
+#include "BLI_math_geom.h"
+
+#include "BLI_strict_flags.h"
+
+/* 2^-53, half a unit in the last place of 1.0. */
+#define PREDICATE_EPSILON 1.1102230246251565e-16
+
+/* Error bounds of the double precision evaluations, see the paper. */
+#define ORIENT2D_ERRBOUND ((3.0 + 16.0 * PREDICATE_EPSILON) * PREDICATE_EPSILON)
+#define ORIENT3D_ERRBOUND ((7.0 + 56.0 * PREDICATE_EPSILON) * PREDICATE_EPSILON)
+
+/* -------------------------------------------------------------------- */
+/** \name Expansion Arithmetic
+ *
+ * An expansion is a sum of doubles with non-overlapping bits,
+ * stored from the smallest to the largest magnitude.
+ * \{ */
+
+BLI_INLINE void fast_two_sum(const double a, const double b, double *r_x, double *r_y)
+{
+	const double x = a + b;
+	*r_x = x;
+	*r_y = b - (x - a);
+}
+
+BLI_INLINE void two_sum(const double a, const double b, double *r_x, double *r_y)
+{
+	const double x = a + b;
+	const double b_virt = x - a;
+	const double a_virt = x - b_virt;
+	*r_x = x;
+	*r_y = (a - a_virt) + (b - b_virt);
+}
+
+BLI_INLINE void two_product(const double a, const double b, double *r_x, double *r_y)
+{
+	const double x = a * b;
+	*r_x = x;
+	*r_y = fma(a, b, -x);
+}
+
+/* h = e + f, h needs room for elen + flen items. */
+static int expansion_sum(const int elen, const double *e, const int flen, const double *f, double *h)
+{
+	double q, q_new, hh;
+	int e_index = 0, f_index = 0, h_index = 0;
+	double e_now = e[0], f_now = f[0];
+
+#define E_NEXT (e_now = (++e_index < elen) ? e[e_index] : 0.0)
+#define F_NEXT (f_now = (++f_index < flen) ? f[f_index] : 0.0)
+
+	if ((f_now > e_now) == (f_now > -e_now)) {
+		q = e_now;
+		E_NEXT;
+	}
+	else {
+		q = f_now;
+		F_NEXT;
+	}
+
+	if ((e_index < elen) && (f_index < flen)) {
+		if ((f_now > e_now) == (f_now > -e_now)) {
+			fast_two_sum(e_now, q, &q_new, &hh);
+			E_NEXT;
+		}
+		else {
+			fast_two_sum(f_now, q, &q_new, &hh);
+			F_NEXT;
+		}
+		q = q_new;
+		if (hh != 0.0) {
+			h[h_index++] = hh;
+		}
+
+		while ((e_index < elen) && (f_index < flen)) {
+			if ((f_now > e_now) == (f_now > -e_now)) {
+				two_sum(q, e_now, &q_new, &hh);
+				E_NEXT;
+			}
+			else {
+				two_sum(q, f_now, &q_new, &hh);
+				F_NEXT;
+			}
+			q = q_new;
+			if (hh != 0.0) {
+				h[h_index++] = hh;
+			}
+		}
+	}
+
+	while (e_index < elen) {
+		two_sum(q, e_now, &q_new, &hh);
+		E_NEXT;
+		q = q_new;
+		if (hh != 0.0) {
+			h[h_index++] = hh;
+		}
+	}
+
+	while (f_index < flen) {
+		two_sum(q, f_now, &q_new, &hh);
+		F_NEXT;
+		q = q_new;
+		if (hh != 0.0) {
+			h[h_index++] = hh;
+		}
+	}
+
+	if ((q != 0.0) || (h_index == 0)) {
+		h[h_index++] = q;
+	}
+
+#undef E_NEXT
+#undef F_NEXT
+
+	return h_index;
+}
+
+/* h = e * b, h needs room for 2 * elen items. */
+static int expansion_scale(const int elen, const double *e, const double b, double *h)
+{
+	double q, hh, sum, product_hi, product_lo;
+	int e_index, h_index = 0;
+
+	two_product(e[0], b, &q, &hh);
+	if (hh != 0.0) {
+		h[h_index++] = hh;
+	}
+
+	for (e_index = 1; e_index < elen; e_index++) {
+		two_product(e[e_index], b, &product_hi, &product_lo);
+		two_sum(q, product_lo, &sum, &hh);
+		if (hh != 0.0) {
+			h[h_index++] = hh;
+		}
+		fast_two_sum(product_hi, sum, &q, &hh);
+		if (hh != 0.0) {
+			h[h_index++] = hh;
+		}
+	}
+
+	if ((q != 0.0) || (h_index == 0)) {
+		h[h_index++] = q;
+	}
+
+	return h_index;
+}
+
+/* h = a * b - c * d, h needs room for 4 items. */
+static int expansion_two_product_diff(const double a, const double b, const double c, const double d, double h[4])
+{
+	double ab[2], cd[2];
+
+	two_product(a, b, &ab[1], &ab[0]);
+	two_product(c, d, &cd[1], &cd[0]);
+	cd[0] = -cd[0];
+	cd[1] = -cd[1];
+
+	return expansion_sum(2, ab, 2, cd, h);
+}
+
+static void expansion_negate(const int elen, double *e)
+{
+	int i;
+	for (i = 0; i < elen; i++) {
+		e[i] = -e[i];
+	}
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Exact Determinants
+ * \{ */
+
+static double orient2d_exact(const double a[2], const double b[2], const double c[2])
+{
+	double a_terms[4], b_terms[4], c_terms[4];
+	double v[8], w[12];
+	int a_len, b_len, c_len, v_len, w_len;
+
+	a_len = expansion_two_product_diff(a[0], b[1], a[0], c[1], a_terms);
+	b_len = expansion_two_product_diff(b[0], c[1], b[0], a[1], b_terms);
+	c_len = expansion_two_product_diff(c[0], a[1], c[0], b[1], c_terms);
+
+	v_len = expansion_sum(a_len, a_terms, b_len, b_terms, v);
+	w_len = expansion_sum(v_len, v, c_len, c_terms, w);
+
+	return w[w_len - 1];
+}
+
+static double orient3d_exact(const double a[3], const double b[3], const double c[3], const double d[3])
+{
+	double ab[4], bc[4], cd[4], da[4], ac[4], bd[4];
+	int ab_len, bc_len, cd_len, da_len, ac_len, bd_len;
+	double temp[8];
+	int temp_len;
+	double abc[12], bcd[12], cda[12], dab[12];
+	int abc_len, bcd_len, cda_len, dab_len;
+	double a_det[24], b_det[24], c_det[24], d_det[24];
+	int a_len, b_len, c_len, d_len;
+	double ab_det[48], cd_det[48];
+	int ab_det_len, cd_det_len;
+	double det[96];
+	int det_len;
+
+	ab_len = expansion_two_product_diff(a[0], b[1], b[0], a[1], ab);
+	bc_len = expansion_two_product_diff(b[0], c[1], c[0], b[1], bc);
+	cd_len = expansion_two_product_diff(c[0], d[1], d[0], c[1], cd);
+	da_len = expansion_two_product_diff(d[0], a[1], a[0], d[1], da);
+	ac_len = expansion_two_product_diff(a[0], c[1], c[0], a[1], ac);
+	bd_len = expansion_two_product_diff(b[0], d[1], d[0], b[1], bd);
+
+	temp_len = expansion_sum(cd_len, cd, da_len, da, temp);
+	cda_len = expansion_sum(temp_len, temp, ac_len, ac, cda);
+	temp_len = expansion_sum(da_len, da, ab_len, ab, temp);
+	dab_len = expansion_sum(temp_len, temp, bd_len, bd, dab);
+
+	expansion_negate(bd_len, bd);
+	expansion_negate(ac_len, ac);
+
+	temp_len = expansion_sum(ab_len, ab, bc_len, bc, temp);
+	abc_len = expansion_sum(temp_len, temp, ac_len, ac, abc);
+	temp_len = expansion_sum(bc_len, bc, cd_len, cd, temp);
+	bcd_len = expansion_sum(temp_len, temp, bd_len, bd, bcd);
+
+	a_len = expansion_scale(bcd_len, bcd, a[2], a_det);
+	b_len = expansion_scale(cda_len, cda, -b[2], b_det);
+	c_len = expansion_scale(dab_len, dab, c[2], c_det);
+	d_len = expansion_scale(abc_len, abc, -d[2], d_det);
+
+	ab_det_len = expansion_sum(a_len, a_det, b_len, b_det, ab_det);
+	cd_det_len = expansion_sum(c_len, c_det, d_len, d_det, cd_det);
+	det_len = expansion_sum(ab_det_len, ab_det, cd_det_len, cd_det, det);
+
+	return det[det_len - 1];
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Public API
+ * \{ */
+
+/**
+ * Positive when \a a, \a b, \a c are in counter-clockwise order, negative when clockwise,
+ * zero when co-linear. The sign is exact, the value approximates twice the signed area.
+ */
+double orient2d_robust_v2(const float a[2], const float b[2], const float c[2])
+{
+	const double ad[2] = {a[0], a[1]};
+	const double bd[2] = {b[0], b[1]};
+	const double cd[2] = {c[0], c[1]};
+	const double det_left  = (ad[0] - cd[0]) * (bd[1] - cd[1]);
+	const double det_right = (ad[1] - cd[1]) * (bd[0] - cd[0]);
+	const double det = det_left - det_right;
+	double det_sum;
+
+	if (det_left > 0.0) {
+		if (det_right <= 0.0) {
+			return det;
+		}
+		det_sum = det_left + det_right;
+	}
+	else if (det_left < 0.0) {
+		if (det_right >= 0.0) {
+			return det;
+		}
+		det_sum = -det_left - det_right;
+	}
+	else {
+		return det;
+	}
+
+	if (fabs(det) >= ORIENT2D_ERRBOUND * det_sum) {
+		return det;
+	}
+
+	return orient2d_exact(ad, bd, cd);
+}
+
+/**
+ * Positive when \a d lies below the plane through \a a, \a b, \a c
+ * (seen from above they are in counter-clockwise order), negative when above,
+ * zero when all four points are co-planar.
+ * The sign is exact, the value approximates six times the signed volume.
+ */
+double orient3d_robust_v3(const float a[3], const float b[3], const float c[3], const float d[3])
+{
+	const double ad[3] = {a[0], a[1], a[2]};
+	const double bd[3] = {b[0], b[1], b[2]};
+	const double cd[3] = {c[0], c[1], c[2]};
+	const double dd[3] = {d[0], d[1], d[2]};
+
+	const double adx = ad[0] - dd[0], ady = ad[1] - dd[1], adz = ad[2] - dd[2];
+	const double bdx = bd[0] - dd[0], bdy = bd[1] - dd[1], bdz = bd[2] - dd[2];
+	const double cdx = cd[0] - dd[0], cdy = cd[1] - dd[1], cdz = cd[2] - dd[2];
+
+	const double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+	const double cdxady = cdx * ady, adxcdy = adx * cdy;
+	const double adxbdy = adx * bdy, bdxady = bdx * ady;
+
+	const double det = (adz * (bdxcdy - cdxbdy) +
+	                    bdz * (cdxady - adxcdy) +
+	                    cdz * (adxbdy - bdxady));
+
+	const double permanent = ((fabs(bdxcdy) + fabs(cdxbdy)) * fabs(adz) +
+	                          (fabs(cdxady) + fabs(adxcdy)) * fabs(bdz) +
+	                          (fabs(adxbdy) + fabs(bdxady)) * fabs(cdz));
+
+	if (fabs(det) > ORIENT3D_ERRBOUND * permanent) {
+		return det;
+	}
+
+	return orient3d_exact(ad, bd, cd, dd);
+}
+
+/** \} */
@@ -30,6 +30,10 @@
 #include <assert.h>
 #include "BLI_math.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "BLI_strict_flags.h"
 
 /******************************** Quaternions ********************************/
@@ -1898,6 +1902,14 @@ void add_weighted_dq_dq(DualQuat *dqsum, const DualQuat *dq, float weight)
 	}
 
 	/* interpolate rotation and translation */
+#ifdef __SSE2__
+	{
+		/* called for every bone influencing every vertex by armature deform */
+		const __m128 w = _mm_set1_ps(weight);
+		_mm_storeu_ps(dqsum->quat, _mm_add_ps(_mm_loadu_ps(dqsum->quat), _mm_mul_ps(w, _mm_loadu_ps(dq->quat))));
+		_mm_storeu_ps(dqsum->trans, _mm_add_ps(_mm_loadu_ps(dqsum->trans), _mm_mul_ps(w, _mm_loadu_ps(dq->trans))));
+	}
+#else
 	dqsum->quat[0] += weight * dq->quat[0];
 	dqsum->quat[1] += weight * dq->quat[1];
 	dqsum->quat[2] += weight * dq->quat[2];
@@ -1907,17 +1919,32 @@ void add_weighted_dq_dq(DualQuat *dqsum, const DualQuat *dq, float weight)
 	dqsum->trans[1] += weight * dq->trans[1];
 	dqsum->trans[2] += weight * dq->trans[2];
 	dqsum->trans[3] += weight * dq->trans[3];
+#endif
 
 	/* interpolate scale - but only if needed */
 	if (dq->scale_weight) {
-		float wmat[4][4];
-
 		if (flipped) /* we don't want negative weights for scaling */
 			weight = -weight;
 
-		copy_m4_m4(wmat, (float(*)[4])dq->scale);
-		mul_m4_fl(wmat, weight);
-		add_m4_m4m4(dqsum->scale, dqsum->scale, wmat);
+#ifdef __SSE2__
+		{
+			const __m128 w = _mm_set1_ps(weight);
+			int i;
+
+			for (i = 0; i < 4; i++) {
+				_mm_storeu_ps(dqsum->scale[i],
+				              _mm_add_ps(_mm_loadu_ps(dqsum->scale[i]), _mm_mul_ps(w, _mm_loadu_ps(dq->scale[i]))));
+			}
+		}
+#else
+		{
+			float wmat[4][4];
+
+			copy_m4_m4(wmat, (float(*)[4])dq->scale);
+			mul_m4_fl(wmat, weight);
+			add_m4_m4m4(dqsum->scale, dqsum->scale, wmat);
+		}
+#endif
 		dqsum->scale_weight += weight;
 	}
 }
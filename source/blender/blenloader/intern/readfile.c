@@ -4411,7 +4411,6 @@ static void direct_link_particlesystems(FileData *fd, ListBase *particles)
 		}
 
 		psys->tree = NULL;
-		psys->bvhtree = NULL;
 	}
 	return;
 }
@@ -4560,7 +4559,7 @@ static void direct_link_dverts(FileData *fd, int count, MDeformVert *mdverts)
 	}
 }
 
-static void direct_link_mdisps(FileData *fd, int count, MDisps *mdisps, int external)
+static void direct_link_mdisps(FileData *fd, int count, MDisps *mdisps, int UNUSED(external))
 {
 	if (mdisps) {
 		int i;
@@ -4569,6 +4568,8 @@ static void direct_link_mdisps(FileData *fd, int count, MDisps *mdisps, int exte
 			mdisps[i].disps = newdataadr(fd, mdisps[i].disps);
 			mdisps[i].hidden = newdataadr(fd, mdisps[i].hidden);
 
+			/* grids which were never displaced are stored without disps (sparse),
+			 * they keep totdisp so they can be allocated once written to */
 			if (mdisps[i].totdisp && !mdisps[i].level) {
 				/* this calculation is only correct for loop mdisps;
 				 * if loading pre-BMesh face mdisps this will be
@@ -4583,8 +4584,6 @@ static void direct_link_mdisps(FileData *fd, int count, MDisps *mdisps, int exte
 				/* this does swap for data written at write_mdisps() - readfile.c */
 				BLI_endian_switch_float_array(*mdisps[i].disps, mdisps[i].totdisp * 3);
 			}
-			if (!external && !mdisps[i].disps)
-				mdisps[i].totdisp = 0;
 		}
 	}
 }
@@ -5138,12 +5137,13 @@ static void direct_link_modifiers(FileData *fd, ListBase *lb)
 		if (md->type == eModifierType_Subsurf) {
 			SubsurfModifierData *smd = (SubsurfModifierData *)md;
 
-			smd->emCache = smd->mCache = NULL;
+			smd->emCache = smd->mCache = smd->renderCache = NULL;
 		}
 		else if (md->type == eModifierType_Armature) {
 			ArmatureModifierData *amd = (ArmatureModifierData *)md;
 
 			amd->prevCos = NULL;
+			amd->weights_cache = NULL;
 		}
 		else if (md->type == eModifierType_Cloth) {
 			ClothModifierData *clmd = (ClothModifierData *)md;
@@ -5678,6 +5678,7 @@ static void direct_link_object(FileData *fd, Object *ob)
 
 	/* Runtime curve data  */
 	ob->curve_cache = NULL;
+	ob->modifier_cache = NULL;
 
 	/* in case this value changes in future, clamp else we get undefined behavior */
 	CLAMP(ob->rotmode, ROT_MODE_MIN, ROT_MODE_MAX);
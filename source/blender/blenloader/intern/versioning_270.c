@@ -1846,6 +1846,21 @@ void blo_do_versions_270(FileData *fd, Library *UNUSED(lib), Main *bmain)
 			}
 		}
 	}
+
+	{
+		/* Versioning code until next subversion bump goes here. */
+		if (!DNA_struct_elem_find(fd->filesdna, "Sequence", "int", "cache_id")) {
+			for (Scene *sce = bmain->scene.first; sce != NULL; sce = sce->id.next) {
+				Sequence *seq;
+
+				SEQ_BEGIN (sce->ed, seq)
+				{
+					BKE_sequence_cache_id_init(seq);
+				}
+				SEQ_END
+			}
+		}
+	}
 }
 
 void do_versions_after_linking_270(Main *bmain)
@@ -462,7 +462,13 @@ static void loop_interp_multires_cb(
 			md_src = BM_ELEM_CD_GET_VOID_P(l_iter, cd_loop_mdisp_offset);
 
 			if (mdisp_in_mdispquad(l_dst, l_iter, f_src_center, co, res, src_axis_x, src_axis_y, uv)) {
-				old_mdisps_bilinear(md_dst->disps[iy * res + ix], md_src->disps, res, uv[0], uv[1]);
+				if (md_src->disps && md_src->totdisp == md_dst->totdisp) {
+					old_mdisps_bilinear(md_dst->disps[iy * res + ix], md_src->disps, res, uv[0], uv[1]);
+				}
+				else {
+					/* sparse grid, never displaced (or empty) */
+					zero_v3(md_dst->disps[iy * res + ix]);
+				}
 				bm_loop_flip_disp(src_axis_x, src_axis_y, axis_x, axis_y, md_dst->disps[iy * res + ix]);
 
 				break;
@@ -486,12 +492,21 @@ void BM_loop_interp_multires_ex(
 	md_dst = BM_ELEM_CD_GET_VOID_P(l_dst, cd_loop_mdisp_offset);
 	compute_mdisp_quad(l_dst, f_dst_center, v1, v2, v3, v4, e1, e2);
 
-	/* if no disps data allocate a new grid, the size of the first grid in f_src. */
+	/* if no disps data allocate a new grid, the size of the first non-empty grid in f_src. */
 	if (!md_dst->totdisp) {
-		const MDisps *md_src = BM_ELEM_CD_GET_VOID_P(BM_FACE_FIRST_LOOP(f_src), cd_loop_mdisp_offset);
+		const BMLoop *l_iter, *l_first;
+
+		l_iter = l_first = BM_FACE_FIRST_LOOP(f_src);
+		do {
+			const MDisps *md_src = BM_ELEM_CD_GET_VOID_P(l_iter, cd_loop_mdisp_offset);
+
+			if (md_src->totdisp) {
+				md_dst->totdisp = md_src->totdisp;
+				md_dst->level = md_src->level;
+				break;
+			}
+		} while ((l_iter = l_iter->next) != l_first);
 
-		md_dst->totdisp = md_src->totdisp;
-		md_dst->level = md_src->level;
 		if (md_dst->totdisp) {
 			md_dst->disps = MEM_callocN(sizeof(float) * 3 * md_dst->totdisp, __func__);
 		}
@@ -499,6 +514,9 @@ void BM_loop_interp_multires_ex(
 			return;
 		}
 	}
+	else if (md_dst->disps == NULL) {
+		md_dst->disps = MEM_callocN(sizeof(float) * 3 * md_dst->totdisp, __func__);
+	}
 
 	mdisp_axis_from_quad(v1, v2, v3, v4, axis_x, axis_y);
 
@@ -562,6 +580,17 @@ void BM_face_interp_multires(BMesh *bm, BMFace *f_dst, const BMFace *f_src)
 	}
 }
 
+/**
+ * Grids which were never displaced are stored sparse (NULL disps),
+ * allocate them when they are about to be written to.
+ */
+static void bm_mdisps_ensure_allocated(MDisps *md)
+{
+	if (md->disps == NULL && md->totdisp) {
+		md->disps = MEM_callocN(sizeof(float) * 3 * md->totdisp, __func__);
+	}
+}
+
 /**
  * smooths boundaries between multires grids,
  * including some borders in adjacent faces
@@ -576,7 +605,6 @@ void BM_face_multires_bounds_smooth(BMesh *bm, BMFace *f)
 		return;
 
 	BM_ITER_ELEM (l, &liter, f, BM_LOOPS_OF_FACE) {
-		MDisps *mdp = BM_ELEM_CD_GET_VOID_P(l->prev, cd_loop_mdisp_offset);
 		MDisps *mdl = BM_ELEM_CD_GET_VOID_P(l, cd_loop_mdisp_offset);
 		MDisps *mdn = BM_ELEM_CD_GET_VOID_P(l->next, cd_loop_mdisp_offset);
 		float co1[3];
@@ -598,7 +626,14 @@ void BM_face_multires_bounds_smooth(BMesh *bm, BMFace *f)
 		 * </pre>
 		 */
 
-		sides = (int)sqrt(mdp->totdisp);
+		/* nothing to smooth against empty grids */
+		if (!mdl->totdisp || mdl->totdisp != mdn->totdisp)
+			continue;
+
+		bm_mdisps_ensure_allocated(mdl);
+		bm_mdisps_ensure_allocated(mdn);
+
+		sides = (int)sqrt(mdl->totdisp);
 		for (y = 0; y < sides; y++) {
 			mid_v3_v3v3(co1, mdn->disps[y * sides], mdl->disps[y]);
 
@@ -637,6 +672,12 @@ void BM_face_multires_bounds_smooth(BMesh *bm, BMFace *f)
 		else
 			mdl2 = BM_ELEM_CD_GET_VOID_P(l->radial_next->next, cd_loop_mdisp_offset);
 
+		if (!mdl1->totdisp || mdl1->totdisp != mdl2->totdisp)
+			continue;
+
+		bm_mdisps_ensure_allocated(mdl1);
+		bm_mdisps_ensure_allocated(mdl2);
+
 		sides = (int)sqrt(mdl1->totdisp);
 		for (y = 0; y < sides; y++) {
 			int a1, a2, o1, o2;
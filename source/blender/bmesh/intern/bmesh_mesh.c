@@ -501,6 +501,86 @@ void BM_mesh_normals_update(BMesh *bm)
 	MEM_freeN(edgevec);
 }
 
+typedef struct BMPartialNormalsData {
+	BMVert **verts;
+	BMFace **faces;
+} BMPartialNormalsData;
+
+static void mesh_faces_calc_normals_partial_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	const BMPartialNormalsData *data = userdata;
+
+	BM_face_normal_update(data->faces[index]);
+}
+
+static void mesh_verts_calc_normals_partial_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	const BMPartialNormalsData *data = userdata;
+	BMVert *v = data->verts[index];
+
+	zero_v3(v->no);
+
+	/* Gather the weighted face normals, unlike #bm_mesh_verts_calc_normals
+	 * each vertex is only written by its own task so no locking is needed.
+	 * The weights match, the angle between the two edges meeting at the corner. */
+	if (v->e) {
+		BMEdge *e_iter, *e_first;
+		e_iter = e_first = v->e;
+		do {
+			if (e_iter->l) {
+				BMLoop *l_iter, *l_first;
+				l_iter = l_first = e_iter->l;
+				do {
+					/* Each corner of 'v' is visited once, through the loop starting at 'v'. */
+					if (l_iter->v == v) {
+						float e1diff[3], e2diff[3];
+						sub_v3_v3v3(e1diff, l_iter->prev->v->co, v->co);
+						sub_v3_v3v3(e2diff, l_iter->next->v->co, v->co);
+						normalize_v3(e1diff);
+						normalize_v3(e2diff);
+
+						const float fac = saacos(dot_v3v3(e1diff, e2diff));
+						madd_v3_v3fl(v->no, l_iter->f->no, fac);
+					}
+				} while ((l_iter = l_iter->radial_next) != l_first);
+			}
+		} while ((e_iter = BM_DISK_EDGE_NEXT(e_iter, v)) != e_first);
+	}
+
+	if (UNLIKELY(normalize_v3(v->no) == 0.0f)) {
+		normalize_v3_v3(v->no, v->co);
+	}
+}
+
+/**
+ * A version of #BM_mesh_normals_update that updates a subset of geometry,
+ * used to avoid the overhead of updating everything.
+ */
+void BM_mesh_normals_update_with_partial(BMesh *UNUSED(bm), const BMPartialUpdate *bmpinfo)
+{
+	BLI_assert(bmpinfo->params.do_normals);
+
+	BMPartialNormalsData data = {
+	    .verts = bmpinfo->verts,
+	    .faces = bmpinfo->faces,
+	};
+	ParallelRangeSettings settings;
+
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (bmpinfo->faces_len >= BM_OMP_LIMIT);
+	BLI_task_parallel_range(0, bmpinfo->faces_len, &data, mesh_faces_calc_normals_partial_cb, &settings);
+
+	/* Face normals must be complete before any vertex reads them. */
+	settings.use_threading = (bmpinfo->verts_len >= BM_OMP_LIMIT);
+	BLI_task_parallel_range(0, bmpinfo->verts_len, &data, mesh_verts_calc_normals_partial_cb, &settings);
+}
+
 /**
  * \brief BMesh Compute Normals from/to external data.
  *
@@ -1062,10 +1142,6 @@ static void UNUSED_FUNCTION(bm_mdisps_space_set)(Object *ob, BMesh *bm, int from
 			BM_ITER_ELEM (l, &liter, f, BM_LOOPS_OF_FACE) {
 				MDisps *lmd = CustomData_bmesh_get(&bm->ldata, l->head.data, CD_MDISPS);
 
-				if (!lmd->disps) {
-					printf("%s: warning - 'lmd->disps' == NULL\n", __func__);
-				}
-
 				if (lmd->disps && lmd->totdisp == mdisps->totdisp) {
 					memcpy(lmd->disps, mdisps->disps, sizeof(float) * 3 * lmd->totdisp);
 				}
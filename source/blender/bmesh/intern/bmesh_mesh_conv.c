@@ -86,6 +86,8 @@
 #include "BLI_listbase.h"
 #include "BLI_alloca.h"
 #include "BLI_math_vector.h"
+#include "BLI_mempool.h"
+#include "BLI_task.h"
 
 #include "BKE_mesh.h"
 #include "BKE_customdata.h"
@@ -217,6 +219,115 @@ static BMFace *bm_face_create_from_mpoly(
 }
 
 
+/* -------------------------------------------------------------------- */
+/* Mesh -> BMesh custom-data
+ *
+ * Creating elements links them into disk and radial cycles and allocates from
+ * the mempools, so this is done serially. The custom-data blocks are
+ * allocated along with the elements, filling them in is done in parallel. */
+
+BLI_INLINE void bm_elem_cd_alloc(CustomData *data, void **block)
+{
+	*block = (data->totsize > 0) ? BLI_mempool_alloc(data->pool) : NULL;
+}
+
+typedef struct BMFromMeshCDData {
+	BMesh *bm;
+	Mesh *me;
+	BMVert **vtable;
+	BMEdge **etable;
+	BMFace **ftable;
+
+	int cd_vert_bweight_offset;
+	int cd_edge_bweight_offset;
+	int cd_edge_crease_offset;
+	int cd_shape_key_offset;
+	int cd_shape_keyindex_offset;
+
+	const float (**shape_key_table)[3];
+	int tot_shape_keys;
+
+	bool calc_face_normal;
+} BMFromMeshCDData;
+
+static void bm_from_me_verts_cd_cb(void *__restrict userdata, const int i,
+                                   const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	const BMFromMeshCDData *data = userdata;
+	const MVert *mvert = &data->me->mvert[i];
+	BMVert *v = data->vtable[i];
+
+	CustomData_to_bmesh_block(&data->me->vdata, &data->bm->vdata, i, &v->head.data, true);
+
+	if (data->cd_vert_bweight_offset != -1) {
+		BM_ELEM_CD_SET_FLOAT(v, data->cd_vert_bweight_offset, (float)mvert->bweight / 255.0f);
+	}
+
+	/* set shape key original index */
+	if (data->cd_shape_keyindex_offset != -1) {
+		BM_ELEM_CD_SET_INT(v, data->cd_shape_keyindex_offset, i);
+	}
+
+	/* set shapekey data */
+	if (data->tot_shape_keys) {
+		float (*co_dst)[3] = BM_ELEM_CD_GET_VOID_P(v, data->cd_shape_key_offset);
+		for (int j = 0; j < data->tot_shape_keys; j++, co_dst++) {
+			copy_v3_v3(*co_dst, data->shape_key_table[j][i]);
+		}
+	}
+}
+
+static void bm_from_me_edges_cd_cb(void *__restrict userdata, const int i,
+                                   const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	const BMFromMeshCDData *data = userdata;
+	const MEdge *medge = &data->me->medge[i];
+	BMEdge *e = data->etable[i];
+
+	CustomData_to_bmesh_block(&data->me->edata, &data->bm->edata, i, &e->head.data, true);
+
+	if (data->cd_edge_bweight_offset != -1) {
+		BM_ELEM_CD_SET_FLOAT(e, data->cd_edge_bweight_offset, (float)medge->bweight / 255.0f);
+	}
+	if (data->cd_edge_crease_offset != -1) {
+		BM_ELEM_CD_SET_FLOAT(e, data->cd_edge_crease_offset, (float)medge->crease / 255.0f);
+	}
+}
+
+static void bm_from_me_faces_cd_cb(void *__restrict userdata, const int i,
+                                   const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	const BMFromMeshCDData *data = userdata;
+	BMFace *f = data->ftable[i];
+	BMLoop *l_iter, *l_first;
+
+	if (f == NULL) {
+		/* skipped bad face */
+		return;
+	}
+
+	int j = data->me->mpoly[i].loopstart;
+	l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+	do {
+		CustomData_to_bmesh_block(&data->me->ldata, &data->bm->ldata, j++, &l_iter->head.data, true);
+	} while ((l_iter = l_iter->next) != l_first);
+
+	CustomData_to_bmesh_block(&data->me->pdata, &data->bm->pdata, i, &f->head.data, true);
+
+	if (data->calc_face_normal) {
+		BM_face_normal_update(f);
+	}
+}
+
+static void bm_from_me_cd_run(int tot, BMFromMeshCDData *data, TaskParallelRangeFunc func)
+{
+	ParallelRangeSettings settings;
+
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (tot >= BM_OMP_LIMIT);
+	BLI_task_parallel_range(0, tot, data, func, &settings);
+}
+
 /**
  * \brief Mesh -> BMesh
  * \param bm: The mesh to write into, while this is typically a newly created BMesh,
@@ -347,6 +458,18 @@ void BM_mesh_bm_from_me(
 	const int cd_shape_keyindex_offset = is_new && (tot_shape_keys || params->add_key_index) ?
 	          CustomData_get_offset(&bm->vdata, CD_SHAPE_KEYINDEX) : -1;
 
+	BMFromMeshCDData cd_data = {
+		.bm = bm, .me = me,
+		.cd_vert_bweight_offset = cd_vert_bweight_offset,
+		.cd_edge_bweight_offset = cd_edge_bweight_offset,
+		.cd_edge_crease_offset = cd_edge_crease_offset,
+		.cd_shape_key_offset = cd_shape_key_offset,
+		.cd_shape_keyindex_offset = cd_shape_keyindex_offset,
+		.shape_key_table = shape_key_table,
+		.tot_shape_keys = tot_shape_keys,
+		.calc_face_normal = params->calc_face_normal,
+	};
+
 	vtable = MEM_mallocN(sizeof(BMVert **) * me->totvert, __func__);
 
 	for (i = 0, mvert = me->mvert; i < me->totvert; i++, mvert++) {
@@ -363,26 +486,16 @@ void BM_mesh_bm_from_me(
 
 		normal_short_to_float_v3(v->no, mvert->no);
 
-		/* Copy Custom Data */
-		CustomData_to_bmesh_block(&me->vdata, &bm->vdata, i, &v->head.data, true);
-
-		if (cd_vert_bweight_offset != -1) BM_ELEM_CD_SET_FLOAT(v, cd_vert_bweight_offset, (float)mvert->bweight / 255.0f);
-
-		/* set shape key original index */
-		if (cd_shape_keyindex_offset != -1) BM_ELEM_CD_SET_INT(v, cd_shape_keyindex_offset, i);
-
-		/* set shapekey data */
-		if (tot_shape_keys) {
-			float (*co_dst)[3] = BM_ELEM_CD_GET_VOID_P(v, cd_shape_key_offset);
-			for (int j = 0; j < tot_shape_keys; j++, co_dst++) {
-				copy_v3_v3(*co_dst, shape_key_table[j][i]);
-			}
-		}
+		/* Custom Data is copied below */
+		bm_elem_cd_alloc(&bm->vdata, &v->head.data);
 	}
 	if (is_new) {
 		bm->elem_index_dirty &= ~BM_VERT; /* added in order, clear dirty flag */
 	}
 
+	cd_data.vtable = vtable;
+	bm_from_me_cd_run(me->totvert, &cd_data, bm_from_me_verts_cd_cb);
+
 	etable = MEM_mallocN(sizeof(BMEdge **) * me->totedge, __func__);
 
 	medge = me->medge;
@@ -398,21 +511,18 @@ void BM_mesh_bm_from_me(
 			BM_edge_select_set(bm, e, true);
 		}
 
-		/* Copy Custom Data */
-		CustomData_to_bmesh_block(&me->edata, &bm->edata, i, &e->head.data, true);
-
-		if (cd_edge_bweight_offset != -1) BM_ELEM_CD_SET_FLOAT(e, cd_edge_bweight_offset, (float)medge->bweight / 255.0f);
-		if (cd_edge_crease_offset  != -1) BM_ELEM_CD_SET_FLOAT(e, cd_edge_crease_offset,  (float)medge->crease  / 255.0f);
-
+		/* Custom Data is copied below */
+		bm_elem_cd_alloc(&bm->edata, &e->head.data);
 	}
 	if (is_new) {
 		bm->elem_index_dirty &= ~BM_EDGE; /* added in order, clear dirty flag */
 	}
 
-	/* only needed for selection. */
-	if (me->mselect && me->totselect != 0) {
-		ftable = MEM_mallocN(sizeof(BMFace **) * me->totpoly, __func__);
-	}
+	cd_data.etable = etable;
+	bm_from_me_cd_run(me->totedge, &cd_data, bm_from_me_edges_cd_cb);
+
+	/* used for custom-data and selection */
+	ftable = MEM_mallocN(sizeof(BMFace **) * me->totpoly, __func__);
 
 	mloop = me->mloop;
 	mp = me->mpoly;
@@ -420,11 +530,8 @@ void BM_mesh_bm_from_me(
 		BMLoop *l_iter;
 		BMLoop *l_first;
 
-		f = bm_face_create_from_mpoly(mp, mloop + mp->loopstart,
-		                              bm, vtable, etable);
-		if (ftable != NULL) {
-			ftable[i] = f;
-		}
+		f = ftable[i] = bm_face_create_from_mpoly(mp, mloop + mp->loopstart,
+		                                          bm, vtable, etable);
 
 		if (UNLIKELY(f == NULL)) {
 			printf("%s: Warning! Bad face in mesh"
@@ -447,27 +554,24 @@ void BM_mesh_bm_from_me(
 		f->mat_nr = mp->mat_nr;
 		if (i == me->act_face) bm->act_face = f;
 
-		int j = mp->loopstart;
 		l_iter = l_first = BM_FACE_FIRST_LOOP(f);
 		do {
 			/* don't use 'j' since we may have skipped some faces, hence some loops. */
 			BM_elem_index_set(l_iter, totloops++); /* set_ok */
 
-			/* Save index of correspsonding MLoop */
-			CustomData_to_bmesh_block(&me->ldata, &bm->ldata, j++, &l_iter->head.data, true);
+			/* Custom Data is copied below */
+			bm_elem_cd_alloc(&bm->ldata, &l_iter->head.data);
 		} while ((l_iter = l_iter->next) != l_first);
 
-		/* Copy Custom Data */
-		CustomData_to_bmesh_block(&me->pdata, &bm->pdata, i, &f->head.data, true);
-
-		if (params->calc_face_normal) {
-			BM_face_normal_update(f);
-		}
+		bm_elem_cd_alloc(&bm->pdata, &f->head.data);
 	}
 	if (is_new) {
 		bm->elem_index_dirty &= ~(BM_FACE | BM_LOOP); /* added in order, clear dirty flag */
 	}
 
+	cd_data.ftable = ftable;
+	bm_from_me_cd_run(me->totpoly, &cd_data, bm_from_me_faces_cd_cb);
+
 	/* -------------------------------------------------------------------- */
 	/* MSelect clears the array elements (avoid adding multiple times).
 	 *
@@ -504,9 +608,7 @@ void BM_mesh_bm_from_me(
 
 	MEM_freeN(vtable);
 	MEM_freeN(etable);
-	if (ftable) {
-		MEM_freeN(ftable);
-	}
+	MEM_freeN(ftable);
 }
 
 
@@ -590,6 +692,110 @@ BLI_INLINE void bmesh_quick_edgedraw_flag(MEdge *med, BMEdge *e)
 	}
 }
 
+/* -------------------------------------------------------------------- */
+/* BMesh -> Mesh, every domain is written in parallel using the element tables */
+
+typedef struct BMToMeshData {
+	BMesh *bm;
+	Mesh *me;
+	MVert *mvert;
+	MEdge *medge;
+	MPoly *mpoly;
+	MLoop *mloop;
+
+	int cd_vert_bweight_offset;
+	int cd_edge_bweight_offset;
+	int cd_edge_crease_offset;
+} BMToMeshData;
+
+static void bm_to_me_verts_cb(void *__restrict userdata, const int i,
+                              const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	const BMToMeshData *data = userdata;
+	BMVert *v = data->bm->vtable[i];
+	MVert *mvert = &data->mvert[i];
+
+	copy_v3_v3(mvert->co, v->co);
+	normal_float_to_short_v3(mvert->no, v->no);
+
+	mvert->flag = BM_vert_flag_to_mflag(v);
+
+	/* copy over customdat */
+	CustomData_from_bmesh_block(&data->bm->vdata, &data->me->vdata, v->head.data, i);
+
+	if (data->cd_vert_bweight_offset != -1) mvert->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(v, data->cd_vert_bweight_offset);
+
+	BM_CHECK_ELEMENT(v);
+}
+
+static void bm_to_me_edges_cb(void *__restrict userdata, const int i,
+                              const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	const BMToMeshData *data = userdata;
+	BMEdge *e = data->bm->etable[i];
+	MEdge *med = &data->medge[i];
+
+	med->v1 = BM_elem_index_get(e->v1);
+	med->v2 = BM_elem_index_get(e->v2);
+
+	med->flag = BM_edge_flag_to_mflag(e);
+
+	/* copy over customdata */
+	CustomData_from_bmesh_block(&data->bm->edata, &data->me->edata, e->head.data, i);
+
+	bmesh_quick_edgedraw_flag(med, e);
+
+	if (data->cd_edge_crease_offset  != -1) med->crease  = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, data->cd_edge_crease_offset);
+	if (data->cd_edge_bweight_offset != -1) med->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, data->cd_edge_bweight_offset);
+
+	BM_CHECK_ELEMENT(e);
+}
+
+/* expects MPoly.loopstart to be set */
+static void bm_to_me_faces_cb(void *__restrict userdata, const int i,
+                              const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	const BMToMeshData *data = userdata;
+	BMFace *f = data->bm->ftable[i];
+	MPoly *mpoly = &data->mpoly[i];
+	BMLoop *l_iter, *l_first;
+	int j = mpoly->loopstart;
+	MLoop *mloop = &data->mloop[j];
+
+	mpoly->totloop = f->len;
+	mpoly->mat_nr = f->mat_nr;
+	mpoly->flag = BM_face_flag_to_mflag(f);
+
+	l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+	do {
+		mloop->e = BM_elem_index_get(l_iter->e);
+		mloop->v = BM_elem_index_get(l_iter->v);
+
+		/* copy over customdata */
+		CustomData_from_bmesh_block(&data->bm->ldata, &data->me->ldata, l_iter->head.data, j);
+
+		j++;
+		mloop++;
+		BM_CHECK_ELEMENT(l_iter);
+		BM_CHECK_ELEMENT(l_iter->e);
+		BM_CHECK_ELEMENT(l_iter->v);
+	} while ((l_iter = l_iter->next) != l_first);
+
+	/* copy over customdata */
+	CustomData_from_bmesh_block(&data->bm->pdata, &data->me->pdata, f->head.data, i);
+
+	BM_CHECK_ELEMENT(f);
+}
+
+static void bm_to_me_run(int tot, BMToMeshData *data, TaskParallelRangeFunc func)
+{
+	ParallelRangeSettings settings;
+
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (tot >= BM_OMP_LIMIT);
+	BLI_task_parallel_range(0, tot, data, func, &settings);
+}
+
 /**
  *
  * \param bmain May be NULL in case \a calc_object_remap parameter option is set.
@@ -601,10 +807,8 @@ void BM_mesh_bm_to_me(
 	MLoop *mloop;
 	MPoly *mpoly;
 	MVert *mvert, *oldverts;
-	MEdge *med, *medge;
-	BMVert *v, *eve;
-	BMEdge *e;
-	BMFace *f;
+	MEdge *medge;
+	BMVert *eve;
 	BMIter iter;
 	int i, j, ototvert;
 
@@ -675,83 +879,32 @@ void BM_mesh_bm_to_me(
 	/* this is called again, 'dotess' arg is used there */
 	BKE_mesh_update_customdata_pointers(me, 0);
 
-	i = 0;
-	BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
-		copy_v3_v3(mvert->co, v->co);
-		normal_float_to_short_v3(mvert->no, v->no);
-
-		mvert->flag = BM_vert_flag_to_mflag(v);
-
-		BM_elem_index_set(v, i); /* set_inline */
-
-		/* copy over customdat */
-		CustomData_from_bmesh_block(&bm->vdata, &me->vdata, v->head.data, i);
-
-		if (cd_vert_bweight_offset != -1) mvert->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(v, cd_vert_bweight_offset);
+	/* Element indices are needed for edges and loops, tables to fill in every domain in parallel. */
+	BM_mesh_elem_index_ensure(bm, BM_VERT | BM_EDGE | BM_FACE);
+	BM_mesh_elem_table_ensure(bm, BM_VERT | BM_EDGE | BM_FACE);
 
-		i++;
-		mvert++;
-
-		BM_CHECK_ELEMENT(v);
+	j = 0;
+	for (i = 0; i < bm->totface; i++) {
+		mpoly[i].loopstart = j;
+		j += bm->ftable[i]->len;
 	}
-	bm->elem_index_dirty &= ~BM_VERT;
-
-	med = medge;
-	i = 0;
-	BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
-		med->v1 = BM_elem_index_get(e->v1);
-		med->v2 = BM_elem_index_get(e->v2);
-
-		med->flag = BM_edge_flag_to_mflag(e);
-
-		BM_elem_index_set(e, i); /* set_inline */
-
-		/* copy over customdata */
-		CustomData_from_bmesh_block(&bm->edata, &me->edata, e->head.data, i);
 
-		bmesh_quick_edgedraw_flag(med, e);
-
-		if (cd_edge_crease_offset  != -1) med->crease  = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, cd_edge_crease_offset);
-		if (cd_edge_bweight_offset != -1) med->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, cd_edge_bweight_offset);
-
-		i++;
-		med++;
-		BM_CHECK_ELEMENT(e);
+	{
+		BMToMeshData data = {
+			.bm = bm, .me = me,
+			.mvert = mvert, .medge = medge, .mpoly = mpoly, .mloop = mloop,
+			.cd_vert_bweight_offset = cd_vert_bweight_offset,
+			.cd_edge_bweight_offset = cd_edge_bweight_offset,
+			.cd_edge_crease_offset = cd_edge_crease_offset,
+		};
+
+		bm_to_me_run(bm->totvert, &data, bm_to_me_verts_cb);
+		bm_to_me_run(bm->totedge, &data, bm_to_me_edges_cb);
+		bm_to_me_run(bm->totface, &data, bm_to_me_faces_cb);
 	}
-	bm->elem_index_dirty &= ~BM_EDGE;
-
-	i = 0;
-	j = 0;
-	BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
-		BMLoop *l_iter, *l_first;
-		mpoly->loopstart = j;
-		mpoly->totloop = f->len;
-		mpoly->mat_nr = f->mat_nr;
-		mpoly->flag = BM_face_flag_to_mflag(f);
-
-		l_iter = l_first = BM_FACE_FIRST_LOOP(f);
-		do {
-			mloop->e = BM_elem_index_get(l_iter->e);
-			mloop->v = BM_elem_index_get(l_iter->v);
-
-			/* copy over customdata */
-			CustomData_from_bmesh_block(&bm->ldata, &me->ldata, l_iter->head.data, j);
-
-			j++;
-			mloop++;
-			BM_CHECK_ELEMENT(l_iter);
-			BM_CHECK_ELEMENT(l_iter->e);
-			BM_CHECK_ELEMENT(l_iter->v);
-		} while ((l_iter = l_iter->next) != l_first);
-
-		if (f == bm->act_face) me->act_face = i;
-
-		/* copy over customdata */
-		CustomData_from_bmesh_block(&bm->pdata, &me->pdata, f->head.data, i);
 
-		i++;
-		mpoly++;
-		BM_CHECK_ELEMENT(f);
+	if (bm->act_face) {
+		me->act_face = BM_elem_index_get(bm->act_face);
 	}
 
 	/* patch hook indices and vertex parents */
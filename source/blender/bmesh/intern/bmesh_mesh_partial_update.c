@@ -0,0 +1,188 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/bmesh/intern/bmesh_mesh_partial_update.c
+ *  \ingroup bmesh
+ *
+ * Generate data needed for partially updating mesh information.
+ * Currently this is used for normals and tessellation.
+ *
+ * Transform is the main target for this functionality, the vertices being moved
+ * are known up front, so normals and triangles only need to be recalculated for
+ * the faces using those vertices (and the vertices of those faces).
+ *
+ * \note To avoid interfering with element tags used by callers,
+ * bitmaps are used instead of #BM_ELEM_TAG.
+ */
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_bitmap.h"
+#include "BLI_math_base.h"
+#include "BLI_utildefines.h"
+
+#include "bmesh.h"
+
+/**
+ * Grow by 1.5x (rounding up).
+ *
+ * \note Use conservative reallocation since the initial sizes reserved
+ * may be close to (or exactly) the number of elements needed.
+ */
+#define GROW(len_alloc) ((len_alloc) + ((len_alloc) - ((len_alloc) / 2)))
+#define GROW_ARRAY(mem, len_alloc) \
+	{ \
+		mem = MEM_reallocN(mem, (sizeof(*mem)) * ((len_alloc) = GROW(len_alloc))); \
+	} ((void)0)
+
+#define GROW_ARRAY_AS_NEEDED(mem, len_alloc, index) \
+	if (UNLIKELY(len_alloc == index)) { \
+		GROW_ARRAY(mem, len_alloc); \
+	} ((void)0)
+
+BLI_INLINE bool partial_elem_vert_ensure(
+        BMPartialUpdate *bmpinfo, BLI_bitmap *verts_tag, BMVert *v)
+{
+	const int i = BM_elem_index_get(v);
+	if (!BLI_BITMAP_TEST(verts_tag, i)) {
+		BLI_BITMAP_ENABLE(verts_tag, i);
+		GROW_ARRAY_AS_NEEDED(bmpinfo->verts, bmpinfo->verts_len_alloc, bmpinfo->verts_len);
+		bmpinfo->verts[bmpinfo->verts_len++] = v;
+		return true;
+	}
+	return false;
+}
+
+BLI_INLINE bool partial_elem_face_ensure(
+        BMPartialUpdate *bmpinfo, BLI_bitmap *faces_tag, BMFace *f)
+{
+	const int i = BM_elem_index_get(f);
+	if (!BLI_BITMAP_TEST(faces_tag, i)) {
+		BLI_BITMAP_ENABLE(faces_tag, i);
+		GROW_ARRAY_AS_NEEDED(bmpinfo->faces, bmpinfo->faces_len_alloc, bmpinfo->faces_len);
+		bmpinfo->faces[bmpinfo->faces_len++] = f;
+		return true;
+	}
+	return false;
+}
+
+/**
+ * All Mesh elements that need updating when the vertices in \a verts_mask have moved.
+ *
+ * \param verts_mask: Bitmap of vertex indices (as set by #BM_mesh_elem_index_ensure).
+ * \param verts_mask_count: The number of enabled bits in \a verts_mask, used to reserve memory.
+ *
+ * \note When \a params->do_tessellate is set, the existing tessellation must be up to date,
+ * only the triangles of the affected faces are written by #BM_mesh_calc_tessellation_with_partial.
+ */
+BMPartialUpdate *BM_mesh_partial_create_from_verts(
+        BMesh *bm, const BMPartialUpdate_Params *params,
+        const BLI_bitmap *verts_mask, const int verts_mask_count)
+{
+	/* The size of these arrays aren't known yet, use a rough estimate. */
+	const int default_verts_len_alloc = min_ii(bm->totvert, max_ii(1, verts_mask_count));
+	const int default_faces_len_alloc = min_ii(bm->totface, max_ii(1, verts_mask_count));
+
+	BMPartialUpdate *bmpinfo = MEM_callocN(sizeof(*bmpinfo), __func__);
+
+	bmpinfo->params = *params;
+
+	BM_mesh_elem_index_ensure(bm, BM_VERT | BM_FACE);
+	BM_mesh_elem_table_ensure(bm, BM_VERT);
+
+	BLI_bitmap *verts_tag = BLI_BITMAP_NEW((size_t)bm->totvert, __func__);
+	BLI_bitmap *faces_tag = BLI_BITMAP_NEW((size_t)bm->totface, __func__);
+
+	bmpinfo->verts_len_alloc = max_ii(1, default_verts_len_alloc);
+	bmpinfo->verts = MEM_mallocN((sizeof(BMVert *) * (size_t)bmpinfo->verts_len_alloc), __func__);
+
+	bmpinfo->faces_len_alloc = max_ii(1, default_faces_len_alloc);
+	bmpinfo->faces = MEM_mallocN((sizeof(BMFace *) * (size_t)bmpinfo->faces_len_alloc), __func__);
+
+	/* Faces using the moved vertices. */
+	for (int i = 0; i < bm->totvert; i++) {
+		if (!BLI_BITMAP_TEST(verts_mask, i)) {
+			continue;
+		}
+		BMVert *v = bm->vtable[i];
+
+		/* Loose vertices still need their normal updated. */
+		partial_elem_vert_ensure(bmpinfo, verts_tag, v);
+
+		if (v->e != NULL) {
+			BMEdge *e_iter, *e_first;
+			e_iter = e_first = v->e;
+			do {
+				if (e_iter->l) {
+					BMLoop *l_iter, *l_first;
+					l_iter = l_first = e_iter->l;
+					do {
+						partial_elem_face_ensure(bmpinfo, faces_tag, l_iter->f);
+					} while ((l_iter = l_iter->radial_next) != l_first);
+				}
+			} while ((e_iter = BM_DISK_EDGE_NEXT(e_iter, v)) != e_first);
+		}
+	}
+
+	/* The normals of every vertex of those faces depend on the changed face normals. */
+	if (params->do_normals) {
+		for (int i = 0; i < bmpinfo->faces_len; i++) {
+			BMFace *f = bmpinfo->faces[i];
+			BMLoop *l_iter, *l_first;
+			l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+			do {
+				partial_elem_vert_ensure(bmpinfo, verts_tag, l_iter->v);
+			} while ((l_iter = l_iter->next) != l_first);
+		}
+	}
+
+	if (params->do_tessellate) {
+		/* Each face writes (len - 2) triangles, in face order.
+		 * Walk all faces once instead of relying on loop indices which callers may have changed. */
+		int *face_tri_offset_all = MEM_mallocN(sizeof(int) * (size_t)max_ii(1, bm->totface), __func__);
+		BMIter iter;
+		BMFace *f;
+		int i, tri_offset = 0;
+
+		BM_ITER_MESH_INDEX (f, &iter, bm, BM_FACES_OF_MESH, i) {
+			face_tri_offset_all[i] = tri_offset;
+			tri_offset += max_ii(f->len - 2, 0);
+		}
+
+		bmpinfo->faces_tri_offset = MEM_mallocN(sizeof(int) * (size_t)max_ii(1, bmpinfo->faces_len), __func__);
+		for (i = 0; i < bmpinfo->faces_len; i++) {
+			bmpinfo->faces_tri_offset[i] = face_tri_offset_all[BM_elem_index_get(bmpinfo->faces[i])];
+		}
+		MEM_freeN(face_tri_offset_all);
+	}
+
+	MEM_freeN(verts_tag);
+	MEM_freeN(faces_tag);
+
+	return bmpinfo;
+}
+
+void BM_mesh_partial_destroy(BMPartialUpdate *bmpinfo)
+{
+	MEM_freeN(bmpinfo->verts);
+	MEM_freeN(bmpinfo->faces);
+	MEM_SAFE_FREE(bmpinfo->faces_tri_offset);
+	MEM_freeN(bmpinfo);
+}
@@ -0,0 +1,67 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __BMESH_MESH_PARTIAL_UPDATE_H__
+#define __BMESH_MESH_PARTIAL_UPDATE_H__
+
+/** \file blender/bmesh/intern/bmesh_mesh_partial_update.h
+ *  \ingroup bmesh
+ */
+
+#include "BLI_bitmap.h"
+
+typedef struct BMPartialUpdate_Params {
+	bool do_normals;
+	bool do_tessellate;
+} BMPartialUpdate_Params;
+
+/**
+ * Cached data to speed up partial updates.
+ *
+ * Hints:
+ *
+ * - Avoid creating this data for single updates,
+ *   it should be created and reused across multiple updates to gain a significant benefit
+ *   (while transforming geometry for example).
+ *
+ * - Partial updates are only valid while the topology is unchanged,
+ *   the data must be freed and recreated whenever elements are added or removed.
+ */
+typedef struct BMPartialUpdate {
+	BMVert **verts;
+	BMFace **faces;
+	int verts_len, verts_len_alloc;
+	int faces_len, faces_len_alloc;
+
+	/* Offset of each face in the tessellation array, aligned with 'faces' (do_tessellate only). */
+	int *faces_tri_offset;
+
+	/* Store the parameters used in creation so invalid use can be asserted. */
+	BMPartialUpdate_Params params;
+} BMPartialUpdate;
+
+BMPartialUpdate *BM_mesh_partial_create_from_verts(
+        BMesh *bm, const BMPartialUpdate_Params *params,
+        const BLI_bitmap *verts_mask, const int verts_mask_count)
+        ATTR_NONNULL(1, 2, 3) ATTR_WARN_UNUSED_RESULT;
+
+void BM_mesh_partial_destroy(BMPartialUpdate *bmpinfo) ATTR_NONNULL(1);
+
+#endif /* __BMESH_MESH_PARTIAL_UPDATE_H__ */
@@ -74,6 +74,8 @@ extern "C" {
  */
 
 struct GHashIterator;
+struct Heap;
+struct MemArena;
 
 BLI_INLINE BMFlagLayer *BMO_elem_flag_from_header(BMHeader *ele_head)
 {
@@ -568,6 +570,27 @@ bool  BMO_iter_map_value_bool(BMOIter *iter);
 	     ele; \
 	     BM_CHECK_TYPE_ELEM_ASSIGN(ele) = BMO_iter_step(iter), i_++)
 
+/* Parallel evaluation for operators.
+ *
+ * Topology editing isn't thread-safe, operators working on independent faces (or face groups)
+ * split their work into a read-only pass over all items which runs in parallel,
+ * storing results in per-item slots owned by the caller, then apply them in a serial pass.
+ *
+ * Each thread has its own scratch memory, freed once all items are done. */
+typedef struct BMOParallelTLS {
+	struct MemArena *arena;
+	struct Heap *heap;
+} BMOParallelTLS;
+
+typedef void (*BMOParallelRangeFunc)(
+        void *__restrict userdata, const int index, BMOParallelTLS *__restrict tls);
+
+void BMO_parallel_range(
+        const int totitem, void *userdata, BMOParallelRangeFunc func,
+        const bool use_threading);
+struct MemArena *BMO_parallel_tls_arena_ensure(BMOParallelTLS *tls);
+struct Heap     *BMO_parallel_tls_heap_ensure(BMOParallelTLS *tls);
+
 extern const int BMO_OPSLOT_TYPEINFO[BMO_OP_SLOT_TOTAL_TYPES];
 
 int BMO_opcode_from_opname(const char *opname);
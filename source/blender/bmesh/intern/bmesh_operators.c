@@ -34,6 +34,8 @@
 #include "BLI_memarena.h"
 #include "BLI_mempool.h"
 #include "BLI_listbase.h"
+#include "BLI_heap.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -1934,3 +1936,82 @@ bool BMO_op_callf(BMesh *bm, const int flag, const char *fmt, ...)
 	va_end(list);
 	return true;
 }
+
+/* -------------------------------------------------------------------- */
+/** \name Parallel Evaluation
+ * \{ */
+
+typedef struct BMOParallelRangeData {
+	void *userdata;
+	BMOParallelRangeFunc func;
+} BMOParallelRangeData;
+
+static void bmo_parallel_range_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict tls)
+{
+	BMOParallelRangeData *data = userdata;
+
+	data->func(data->userdata, index, tls->userdata_chunk);
+}
+
+static void bmo_parallel_range_finalize(
+        void *__restrict UNUSED(userdata),
+        void *__restrict userdata_chunk)
+{
+	BMOParallelTLS *tls = userdata_chunk;
+
+	if (tls->arena) {
+		BLI_memarena_free(tls->arena);
+	}
+	if (tls->heap) {
+		BLI_heap_free(tls->heap, NULL);
+	}
+}
+
+/**
+ * Run \a func for every index in `[0, totitem)`, see #BMOParallelTLS.
+ *
+ * \note \a func must not change the topology, element data used by other items
+ * or anything else shared between threads.
+ */
+void BMO_parallel_range(
+        const int totitem, void *userdata, BMOParallelRangeFunc func,
+        const bool use_threading)
+{
+	BMOParallelRangeData data = {
+		.userdata = userdata,
+		.func = func,
+	};
+	BMOParallelTLS tls = {NULL};
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = use_threading;
+	settings.userdata_chunk = &tls;
+	settings.userdata_chunk_size = sizeof(tls);
+	settings.func_finalize = bmo_parallel_range_finalize;
+	BLI_task_parallel_range(0, totitem, &data, bmo_parallel_range_cb, &settings);
+}
+
+/**
+ * Per-thread scratch memory, callers should clear it once done with an item.
+ */
+MemArena *BMO_parallel_tls_arena_ensure(BMOParallelTLS *tls)
+{
+	if (tls->arena == NULL) {
+		tls->arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
+	}
+	return tls->arena;
+}
+
+Heap *BMO_parallel_tls_heap_ensure(BMOParallelTLS *tls)
+{
+	if (tls->heap == NULL) {
+		tls->heap = BLI_heap_new();
+	}
+	return tls->heap;
+}
+
+/** \} */
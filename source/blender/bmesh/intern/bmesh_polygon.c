@@ -41,6 +41,7 @@
 #include "BLI_linklist.h"
 #include "BLI_edgehash.h"
 #include "BLI_heap.h"
+#include "BLI_task.h"
 
 #include "bmesh.h"
 #include "bmesh_tools.h"
@@ -900,6 +901,122 @@ bool BM_face_point_inside_test(const BMFace *f, const float co[3])
 	return isect_point_poly_v2(co_2d, projverts, f->len, false);
 }
 
+/**
+ * Calculate the triangles #BM_face_triangulate creates for \a f, without changing the mesh.
+ *
+ * \param r_tris: Written with `f->len - 2` triangles,
+ * indices are loops in face order (starting at #BM_FACE_FIRST_LOOP).
+ *
+ * \note This only reads the mesh, so it can run on multiple faces in parallel
+ * as long as each thread uses its own \a pf_arena and \a pf_heap.
+ */
+void BM_face_triangulate_calc_tris(
+        const BMFace *f,
+        const int quad_method,
+        const int ngon_method,
+        uint (*r_tris)[3],
+        /* use for ngons only! */
+        MemArena *pf_arena,
+
+        /* use for MOD_TRIANGULATE_NGON_BEAUTY only! */
+        struct Heap *pf_heap)
+{
+	const bool use_beauty = (ngon_method == MOD_TRIANGULATE_NGON_BEAUTY);
+
+	BLI_assert(f->len > 3);
+
+	if (f->len == 4) {
+		/* the split is defined by the two loops the new edge runs between,
+		 * indices of: l_first, l_first->next, l_first->next->next, l_first->prev */
+		int i_v1, i_v2;
+
+		switch (quad_method) {
+			case MOD_TRIANGULATE_QUAD_FIXED:
+			{
+				i_v1 = 0;
+				i_v2 = 2;
+				break;
+			}
+			case MOD_TRIANGULATE_QUAD_ALTERNATE:
+			{
+				i_v1 = 1;
+				i_v2 = 3;
+				break;
+			}
+			case MOD_TRIANGULATE_QUAD_SHORTEDGE:
+			case MOD_TRIANGULATE_QUAD_BEAUTY:
+			default:
+			{
+				const BMLoop *l_first = BM_FACE_FIRST_LOOP(f);
+				const BMLoop *l_v1, *l_v2, *l_v3, *l_v4;
+				bool split_24;
+
+				l_v1 = l_first->next;
+				l_v2 = l_first->next->next;
+				l_v3 = l_first->prev;
+				l_v4 = l_first;
+
+				if (quad_method == MOD_TRIANGULATE_QUAD_SHORTEDGE) {
+					float d1, d2;
+					d1 = len_squared_v3v3(l_v4->v->co, l_v2->v->co);
+					d2 = len_squared_v3v3(l_v1->v->co, l_v3->v->co);
+					split_24 = ((d2 - d1) > 0.0f);
+				}
+				else {
+					/* first check if the quad is concave on either diagonal */
+					const int flip_flag = is_quad_flip_v3(l_v1->v->co, l_v2->v->co, l_v3->v->co, l_v4->v->co);
+					if (UNLIKELY(flip_flag & (1 << 0))) {
+						split_24 = true;
+					}
+					else if (UNLIKELY(flip_flag & (1 << 1))) {
+						split_24 = false;
+					}
+					else {
+						split_24 = (BM_verts_calc_rotate_beauty(l_v1->v, l_v2->v, l_v3->v, l_v4->v, 0, 0) > 0.0f);
+					}
+				}
+
+				/* named confusingly, l_v1 is in fact the second vertex */
+				if (split_24) {
+					i_v1 = 0;  /* l_v4 */
+					i_v2 = 2;  /* l_v2 */
+				}
+				else {
+					i_v1 = 1;  /* l_v1 */
+					i_v2 = 3;  /* l_v3 */
+				}
+				break;
+			}
+		}
+
+		ARRAY_SET_ITEMS(r_tris[0], i_v1, (i_v1 + 1) % 4, i_v2);
+		ARRAY_SET_ITEMS(r_tris[1], i_v1, i_v2, (i_v2 + 1) % 4);
+	}
+	else {
+		const BMLoop *l_iter;
+		float axis_mat[3][3];
+		float (*projverts)[2] = BLI_array_alloca(projverts, f->len);
+		int i;
+
+		axis_dominant_v3_to_m3_negate(axis_mat, f->no);
+
+		for (i = 0, l_iter = BM_FACE_FIRST_LOOP(f); i < f->len; i++, l_iter = l_iter->next) {
+			mul_v2_m3v3(projverts[i], axis_mat, l_iter->v->co);
+		}
+
+		BLI_polyfill_calc_arena(projverts, f->len, 1, r_tris,
+		                        pf_arena);
+
+		if (use_beauty) {
+			BLI_polyfill_beautify(
+			        projverts, f->len, r_tris,
+			        pf_arena, pf_heap);
+		}
+
+		BLI_memarena_clear(pf_arena);
+	}
+}
+
 /**
  * \brief BMESH TRIANGULATE FACE
  *
@@ -917,13 +1034,16 @@ bool BM_face_point_inside_test(const BMFace *f, const float co[3])
  * and in that case we would have to remove all faces including the one passed,
  * which causes complications adding/removing faces while looking over them.
  *
+ * \param tris_precalc: Optional result of #BM_face_triangulate_calc_tris for this face,
+ * used so the triangles can be calculated up front (in parallel).
+ *
  * \note The number of faces is _almost_ always (f->len - 3),
  *       However there may be faces that already occupying the
  *       triangles we would make, so the caller must check \a r_faces_new_tot.
  *
  * \note use_tag tags new flags and edges.
  */
-void BM_face_triangulate(
+void BM_face_triangulate_ex(
         BMesh *bm, BMFace *f,
         BMFace **r_faces_new,
         int     *r_faces_new_tot,
@@ -937,12 +1057,12 @@ void BM_face_triangulate(
         MemArena *pf_arena,
 
         /* use for MOD_TRIANGULATE_NGON_BEAUTY only! */
-        struct Heap *pf_heap)
+        struct Heap *pf_heap,
+        const uint (*tris_precalc)[3])
 {
 	const int cd_loop_mdisp_offset = CustomData_get_offset(&bm->ldata, CD_MDISPS);
-	const bool use_beauty = (ngon_method == MOD_TRIANGULATE_NGON_BEAUTY);
 	BMLoop *l_first, *l_new;
-	BMFace *f_new;
+	BMFace *f_new = NULL;
 	int nf_i = 0;
 	int ne_i = 0;
 
@@ -955,108 +1075,27 @@ void BM_face_triangulate(
 
 	{
 		BMLoop **loops = BLI_array_alloca(loops, f->len);
-		uint (*tris)[3] = BLI_array_alloca(tris, f->len);
+		const uint (*tris)[3];
 		const int totfilltri = f->len - 2;
 		const int last_tri = f->len - 3;
 		int i;
 		/* for mdisps */
 		float f_center[3];
 
-		if (f->len == 4) {
-			/* even though we're not using BLI_polyfill, fill in 'tris' and 'loops'
-			 * so we can share code to handle face creation afterwards. */
-			BMLoop *l_v1, *l_v2;
-
-			l_first = BM_FACE_FIRST_LOOP(f);
-
-			switch (quad_method) {
-				case MOD_TRIANGULATE_QUAD_FIXED:
-				{
-					l_v1 = l_first;
-					l_v2 = l_first->next->next;
-					break;
-				}
-				case MOD_TRIANGULATE_QUAD_ALTERNATE:
-				{
-					l_v1 = l_first->next;
-					l_v2 = l_first->prev;
-					break;
-				}
-				case MOD_TRIANGULATE_QUAD_SHORTEDGE:
-				case MOD_TRIANGULATE_QUAD_BEAUTY:
-				default:
-				{
-					BMLoop *l_v3, *l_v4;
-					bool split_24;
-
-					l_v1 = l_first->next;
-					l_v2 = l_first->next->next;
-					l_v3 = l_first->prev;
-					l_v4 = l_first;
-
-					if (quad_method == MOD_TRIANGULATE_QUAD_SHORTEDGE) {
-						float d1, d2;
-						d1 = len_squared_v3v3(l_v4->v->co, l_v2->v->co);
-						d2 = len_squared_v3v3(l_v1->v->co, l_v3->v->co);
-						split_24 = ((d2 - d1) > 0.0f);
-					}
-					else {
-						/* first check if the quad is concave on either diagonal */
-						const int flip_flag = is_quad_flip_v3(l_v1->v->co, l_v2->v->co, l_v3->v->co, l_v4->v->co);
-						if (UNLIKELY(flip_flag & (1 << 0))) {
-							split_24 = true;
-						}
-						else if (UNLIKELY(flip_flag & (1 << 1))) {
-							split_24 = false;
-						}
-						else {
-							split_24 = (BM_verts_calc_rotate_beauty(l_v1->v, l_v2->v, l_v3->v, l_v4->v, 0, 0) > 0.0f);
-						}
-					}
-
-					/* named confusingly, l_v1 is in fact the second vertex */
-					if (split_24) {
-						l_v1 = l_v4;
-						//l_v2 = l_v2;
-					}
-					else {
-						//l_v1 = l_v1;
-						l_v2 = l_v3;
-					}
-					break;
-				}
-			}
-
-			loops[0] = l_v1;
-			loops[1] = l_v1->next;
-			loops[2] = l_v2;
-			loops[3] = l_v2->next;
-
-			ARRAY_SET_ITEMS(tris[0], 0, 1, 2);
-			ARRAY_SET_ITEMS(tris[1], 0, 2, 3);
+		if (tris_precalc) {
+			tris = tris_precalc;
 		}
 		else {
-			BMLoop *l_iter;
-			float axis_mat[3][3];
-			float (*projverts)[2] = BLI_array_alloca(projverts, f->len);
-
-			axis_dominant_v3_to_m3_negate(axis_mat, f->no);
+			uint (*tris_calc)[3] = BLI_array_alloca(tris_calc, f->len);
+			BM_face_triangulate_calc_tris(f, quad_method, ngon_method, tris_calc, pf_arena, pf_heap);
+			tris = (const uint (*)[3])tris_calc;
+		}
 
+		{
+			BMLoop *l_iter;
 			for (i = 0, l_iter = BM_FACE_FIRST_LOOP(f); i < f->len; i++, l_iter = l_iter->next) {
 				loops[i] = l_iter;
-				mul_v2_m3v3(projverts[i], axis_mat, l_iter->v->co);
 			}
-
-			BLI_polyfill_calc_arena(projverts, f->len, 1, tris,
-			                        pf_arena);
-
-			if (use_beauty) {
-				BLI_polyfill_beautify(
-				        projverts, f->len, tris,
-				        pf_arena, pf_heap);
-			}
-
-			BLI_memarena_clear(pf_arena);
 		}
 
 		if (cd_loop_mdisp_offset != -1) {
@@ -1155,6 +1194,29 @@ void BM_face_triangulate(
 	}
 }
 
+void BM_face_triangulate(
+        BMesh *bm, BMFace *f,
+        BMFace **r_faces_new,
+        int     *r_faces_new_tot,
+        BMEdge **r_edges_new,
+        int     *r_edges_new_tot,
+        LinkNode **r_faces_double,
+        const int quad_method,
+        const int ngon_method,
+        const bool use_tag,
+        MemArena *pf_arena,
+        struct Heap *pf_heap)
+{
+	BM_face_triangulate_ex(
+	        bm, f,
+	        r_faces_new, r_faces_new_tot,
+	        r_edges_new, r_edges_new_tot,
+	        r_faces_double,
+	        quad_method, ngon_method, use_tag,
+	        pf_arena, pf_heap,
+	        NULL);
+}
+
 /**
  * each pair of loops defines a new edge, a split.  this function goes
  * through and sets pairs that are geometrically invalid to null.  a
@@ -1348,6 +1410,103 @@ void BM_face_as_array_loop_quad(BMFace *f, BMLoop *r_loops[4])
 }
 
 
+/* faces per task, below this the tessellation is done on the calling thread */
+#define BM_TESS_PARALLEL_THRESHOLD 1024
+
+/**
+ * Tessellation of a single face, writes `efa->len - 2` triangles (none for degenerate faces).
+ *
+ * \param pf_arena_p: Scratch memory for ngons, allocated on first use, owned by the caller.
+ * \return The number of triangles written.
+ */
+BLI_INLINE int bm_face_calc_tessellation(
+        BMFace *efa, BMLoop *(*looptris)[3],
+        MemArena **pf_arena_p)
+{
+	int i = 0;
+
+	/* don't consider two-edged faces */
+	if (UNLIKELY(efa->len < 3)) {
+		/* do nothing */
+	}
+	else if (efa->len == 3) {
+		/* no need to ensure the loop order, we know its ok */
+		BMLoop *l;
+		BMLoop **l_ptr = looptris[i++];
+		l_ptr[0] = l = BM_FACE_FIRST_LOOP(efa);
+		l_ptr[1] = l = l->next;
+		l_ptr[2] = l->next;
+	}
+	else if (efa->len == 4) {
+		BMLoop *l;
+		BMLoop **l_ptr_a = looptris[i++];
+		BMLoop **l_ptr_b = looptris[i++];
+		(l_ptr_a[0] = l_ptr_b[0] = l = BM_FACE_FIRST_LOOP(efa));
+		(l_ptr_a[1]              = l = l->next);
+		(l_ptr_a[2] = l_ptr_b[1] = l = l->next);
+		(             l_ptr_b[2] = l->next);
+
+		if (UNLIKELY(is_quad_flip_v3_first_third_fast(
+		                     l_ptr_a[0]->v->co,
+		                     l_ptr_a[1]->v->co,
+		                     l_ptr_a[2]->v->co,
+		                     l_ptr_b[2]->v->co)))
+		{
+			/* flip out of degenerate 0-2 state. */
+			l_ptr_a[2] = l_ptr_b[2];
+			l_ptr_b[0] = l_ptr_a[1];
+		}
+	}
+	else {
+		int j;
+
+		BMLoop *l_iter;
+		BMLoop *l_first;
+		BMLoop **l_arr;
+
+		float axis_mat[3][3];
+		float (*projverts)[2];
+		uint (*tris)[3];
+
+		const int totfilltri = efa->len - 2;
+		MemArena *pf_arena;
+
+		if (UNLIKELY(*pf_arena_p == NULL)) {
+			*pf_arena_p = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
+		}
+		pf_arena = *pf_arena_p;
+
+		tris = BLI_memarena_alloc(pf_arena, sizeof(*tris) * totfilltri);
+		l_arr = BLI_memarena_alloc(pf_arena, sizeof(*l_arr) * efa->len);
+		projverts = BLI_memarena_alloc(pf_arena, sizeof(*projverts) * efa->len);
+
+		axis_dominant_v3_to_m3_negate(axis_mat, efa->no);
+
+		j = 0;
+		l_iter = l_first = BM_FACE_FIRST_LOOP(efa);
+		do {
+			l_arr[j] = l_iter;
+			mul_v2_m3v3(projverts[j], axis_mat, l_iter->v->co);
+			j++;
+		} while ((l_iter = l_iter->next) != l_first);
+
+		BLI_polyfill_calc_arena(projverts, efa->len, 1, tris, pf_arena);
+
+		for (j = 0; j < totfilltri; j++) {
+			BMLoop **l_ptr = looptris[i++];
+			uint *tri = tris[j];
+
+			l_ptr[0] = l_arr[tri[0]];
+			l_ptr[1] = l_arr[tri[1]];
+			l_ptr[2] = l_arr[tri[2]];
+		}
+
+		BLI_memarena_clear(pf_arena);
+	}
+
+	return i;
+}
+
 /**
  * \brief BM_mesh_calc_tessellation get the looptris and its number from a certain bmesh
  * \param looptris
@@ -1356,10 +1515,6 @@ void BM_face_as_array_loop_quad(BMFace *f, BMLoop *r_loops[4])
  */
 void BM_mesh_calc_tessellation(BMesh *bm, BMLoop *(*looptris)[3], int *r_looptris_tot)
 {
-	/* use this to avoid locking pthread for _every_ polygon
-	 * and calling the fill function */
-#define USE_TESSFACE_SPEEDUP
-
 	/* this assumes all faces can be scan-filled, which isn't always true,
 	 * worst case we over alloc a little which is acceptable */
 #ifndef NDEBUG
@@ -1373,136 +1528,240 @@ void BM_mesh_calc_tessellation(BMesh *bm, BMLoop *(*looptris)[3], int *r_looptri
 	MemArena *arena = NULL;
 
 	BM_ITER_MESH (efa, &iter, bm, BM_FACES_OF_MESH) {
-		/* don't consider two-edged faces */
-		if (UNLIKELY(efa->len < 3)) {
-			/* do nothing */
-		}
+		i += bm_face_calc_tessellation(efa, &looptris[i], &arena);
+	}
 
-#ifdef USE_TESSFACE_SPEEDUP
+	if (arena) {
+		BLI_memarena_free(arena);
+		arena = NULL;
+	}
 
-		/* no need to ensure the loop order, we know its ok */
+	*r_looptris_tot = i;
 
-		else if (efa->len == 3) {
-#if 0
-			int j;
-			BM_ITER_ELEM_INDEX (l, &liter, efa, BM_LOOPS_OF_FACE, j) {
-				looptris[i][j] = l;
-			}
-			i += 1;
-#else
-			/* more cryptic but faster */
-			BMLoop *l;
-			BMLoop **l_ptr = looptris[i++];
-			l_ptr[0] = l = BM_FACE_FIRST_LOOP(efa);
-			l_ptr[1] = l = l->next;
-			l_ptr[2] = l->next;
-#endif
-		}
-		else if (efa->len == 4) {
-#if 0
-			BMLoop *ltmp[4];
-			int j;
-			BLI_array_grow_items(looptris, 2);
-			BM_ITER_ELEM_INDEX (l, &liter, efa, BM_LOOPS_OF_FACE, j) {
-				ltmp[j] = l;
-			}
+	BLI_assert(i <= looptris_tot);
+}
 
-			looptris[i][0] = ltmp[0];
-			looptris[i][1] = ltmp[1];
-			looptris[i][2] = ltmp[2];
-			i += 1;
+struct TessPartialData {
+	BMFace **faces;
+	const int *faces_tri_offset;
+	BMLoop *(*looptris)[3];
+};
 
-			looptris[i][0] = ltmp[0];
-			looptris[i][1] = ltmp[2];
-			looptris[i][2] = ltmp[3];
-			i += 1;
+static void bm_mesh_calc_tessellation_partial_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict tls)
+{
+	const struct TessPartialData *data = userdata;
+	MemArena **pf_arena_p = tls->userdata_chunk;
+
+	bm_face_calc_tessellation(data->faces[index], &data->looptris[data->faces_tri_offset[index]], pf_arena_p);
+}
+
+static void bm_mesh_calc_tessellation_partial_finalize(
+        void *__restrict UNUSED(userdata),
+        void *__restrict userdata_chunk)
+{
+	MemArena **pf_arena_p = userdata_chunk;
+
+	if (*pf_arena_p) {
+		BLI_memarena_free(*pf_arena_p);
+	}
+}
+
+/**
+ * A version of #BM_mesh_calc_tessellation that only re-tessellates the faces in \a bmpinfo,
+ * leaving the triangles of all other faces untouched.
+ *
+ * \note \a looptris must hold a complete tessellation from #BM_mesh_calc_tessellation
+ * and the topology must not have changed since \a bmpinfo was created.
+ */
+void BM_mesh_calc_tessellation_with_partial(BMesh *UNUSED(bm), BMLoop *(*looptris)[3], const BMPartialUpdate *bmpinfo)
+{
+	BLI_assert(bmpinfo->params.do_tessellate);
+
+	struct TessPartialData data = {
+		.faces = bmpinfo->faces,
+		.faces_tri_offset = bmpinfo->faces_tri_offset,
+		.looptris = looptris,
+	};
+	MemArena *pf_arena = NULL;
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (bmpinfo->faces_len >= BM_TESS_PARALLEL_THRESHOLD);
+	settings.min_iter_per_thread = BM_TESS_PARALLEL_THRESHOLD / 4;
+	settings.userdata_chunk = &pf_arena;
+	settings.userdata_chunk_size = sizeof(pf_arena);
+	settings.func_finalize = bm_mesh_calc_tessellation_partial_finalize;
+	BLI_task_parallel_range(0, bmpinfo->faces_len, &data, bm_mesh_calc_tessellation_partial_cb, &settings);
+}
+
+
+/**
+ * Beautified tessellation of a single face, writes `efa->len - 2` triangles (none for degenerate faces).
+ *
+ * \param pf_arena_p, pf_heap_p: Scratch memory for ngons, allocated on first use, owned by the caller.
+ * \return The number of triangles written.
+ */
+static int bm_face_calc_tessellation_beauty(
+        BMFace *efa, BMLoop *(*looptris)[3],
+        MemArena **pf_arena_p, Heap **pf_heap_p)
+{
+	int i = 0;
+
+	/* don't consider two-edged faces */
+	if (UNLIKELY(efa->len < 3)) {
+		/* do nothing */
+	}
+	else if (efa->len == 3) {
+		BMLoop *l;
+		BMLoop **l_ptr = looptris[i++];
+		l_ptr[0] = l = BM_FACE_FIRST_LOOP(efa);
+		l_ptr[1] = l = l->next;
+		l_ptr[2] = l->next;
+	}
+	else if (efa->len == 4) {
+		BMLoop *l_v1 = BM_FACE_FIRST_LOOP(efa);
+		BMLoop *l_v2 = l_v1->next;
+		BMLoop *l_v3 = l_v2->next;
+		BMLoop *l_v4 = l_v1->prev;
+
+		/* #BM_verts_calc_rotate_beauty performs excessive checks we don't need!
+		 * It's meant for rotating edges, it also calculates a new normal.
+		 *
+		 * Use #BLI_polyfill_beautify_quad_rotate_calc since we have the normal.
+		 */
+#if 0
+		const bool split_13 = (BM_verts_calc_rotate_beauty(
+		        l_v1->v, l_v2->v, l_v3->v, l_v4->v, 0, 0) < 0.0f);
 #else
-			/* more cryptic but faster */
-			BMLoop *l;
-			BMLoop **l_ptr_a = looptris[i++];
-			BMLoop **l_ptr_b = looptris[i++];
-			(l_ptr_a[0] = l_ptr_b[0] = l = BM_FACE_FIRST_LOOP(efa));
-			(l_ptr_a[1]              = l = l->next);
-			(l_ptr_a[2] = l_ptr_b[1] = l = l->next);
-			(             l_ptr_b[2] = l->next);
+		float axis_mat[3][3], v_quad[4][2];
+		axis_dominant_v3_to_m3(axis_mat, efa->no);
+		mul_v2_m3v3(v_quad[0], axis_mat, l_v1->v->co);
+		mul_v2_m3v3(v_quad[1], axis_mat, l_v2->v->co);
+		mul_v2_m3v3(v_quad[2], axis_mat, l_v3->v->co);
+		mul_v2_m3v3(v_quad[3], axis_mat, l_v4->v->co);
+
+		const bool split_13 = BLI_polyfill_beautify_quad_rotate_calc(
+		        v_quad[0], v_quad[1], v_quad[2], v_quad[3]) < 0.0f;
 #endif
 
-			if (UNLIKELY(is_quad_flip_v3_first_third_fast(
-			                     l_ptr_a[0]->v->co,
-			                     l_ptr_a[1]->v->co,
-			                     l_ptr_a[2]->v->co,
-			                     l_ptr_b[2]->v->co)))
-			{
-				/* flip out of degenerate 0-2 state. */
-				l_ptr_a[2] = l_ptr_b[2];
-				l_ptr_b[0] = l_ptr_a[1];
-			}
-		}
-
-#endif /* USE_TESSFACE_SPEEDUP */
+		BMLoop **l_ptr_a = looptris[i++];
+		BMLoop **l_ptr_b = looptris[i++];
+		if (split_13) {
+			l_ptr_a[0] = l_v1;
+			l_ptr_a[1] = l_v2;
+			l_ptr_a[2] = l_v3;
 
+			l_ptr_b[0] = l_v1;
+			l_ptr_b[1] = l_v3;
+			l_ptr_b[2] = l_v4;
+		}
 		else {
-			int j;
+			l_ptr_a[0] = l_v1;
+			l_ptr_a[1] = l_v2;
+			l_ptr_a[2] = l_v4;
 
-			BMLoop *l_iter;
-			BMLoop *l_first;
-			BMLoop **l_arr;
+			l_ptr_b[0] = l_v2;
+			l_ptr_b[1] = l_v3;
+			l_ptr_b[2] = l_v4;
+		}
+	}
+	else {
+		int j;
 
-			float axis_mat[3][3];
-			float (*projverts)[2];
-			uint (*tris)[3];
+		BMLoop *l_iter;
+		BMLoop *l_first;
+		BMLoop **l_arr;
 
-			const int totfilltri = efa->len - 2;
+		float axis_mat[3][3];
+		float (*projverts)[2];
+		unsigned int (*tris)[3];
 
-			if (UNLIKELY(arena == NULL)) {
-				arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
-			}
+		const int totfilltri = efa->len - 2;
+		MemArena *pf_arena;
 
-			tris = BLI_memarena_alloc(arena, sizeof(*tris) * totfilltri);
-			l_arr = BLI_memarena_alloc(arena, sizeof(*l_arr) * efa->len);
-			projverts = BLI_memarena_alloc(arena, sizeof(*projverts) * efa->len);
+		if (UNLIKELY(*pf_arena_p == NULL)) {
+			*pf_arena_p = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
+			*pf_heap_p = BLI_heap_new_ex(BLI_POLYFILL_ALLOC_NGON_RESERVE);
+		}
+		pf_arena = *pf_arena_p;
 
-			axis_dominant_v3_to_m3_negate(axis_mat, efa->no);
+		tris = BLI_memarena_alloc(pf_arena, sizeof(*tris) * totfilltri);
+		l_arr = BLI_memarena_alloc(pf_arena, sizeof(*l_arr) * efa->len);
+		projverts = BLI_memarena_alloc(pf_arena, sizeof(*projverts) * efa->len);
 
-			j = 0;
-			l_iter = l_first = BM_FACE_FIRST_LOOP(efa);
-			do {
-				l_arr[j] = l_iter;
-				mul_v2_m3v3(projverts[j], axis_mat, l_iter->v->co);
-				j++;
-			} while ((l_iter = l_iter->next) != l_first);
+		axis_dominant_v3_to_m3_negate(axis_mat, efa->no);
 
-			BLI_polyfill_calc_arena(projverts, efa->len, 1, tris, arena);
+		j = 0;
+		l_iter = l_first = BM_FACE_FIRST_LOOP(efa);
+		do {
+			l_arr[j] = l_iter;
+			mul_v2_m3v3(projverts[j], axis_mat, l_iter->v->co);
+			j++;
+		} while ((l_iter = l_iter->next) != l_first);
 
-			for (j = 0; j < totfilltri; j++) {
-				BMLoop **l_ptr = looptris[i++];
-				uint *tri = tris[j];
+		BLI_polyfill_calc_arena(projverts, efa->len, 1, tris, pf_arena);
 
-				l_ptr[0] = l_arr[tri[0]];
-				l_ptr[1] = l_arr[tri[1]];
-				l_ptr[2] = l_arr[tri[2]];
-			}
+		BLI_polyfill_beautify(projverts, efa->len, tris, pf_arena, *pf_heap_p);
 
-			BLI_memarena_clear(arena);
+		for (j = 0; j < totfilltri; j++) {
+			BMLoop **l_ptr = looptris[i++];
+			unsigned int *tri = tris[j];
+
+			l_ptr[0] = l_arr[tri[0]];
+			l_ptr[1] = l_arr[tri[1]];
+			l_ptr[2] = l_arr[tri[2]];
 		}
-	}
 
-	if (arena) {
-		BLI_memarena_free(arena);
-		arena = NULL;
+		BLI_memarena_clear(pf_arena);
 	}
 
-	*r_looptris_tot = i;
-
-	BLI_assert(i <= looptris_tot);
+	return i;
+}
 
-#undef USE_TESSFACE_SPEEDUP
+struct TessBeautyData {
+	BMFace **ftable;
+	BMLoop *(*looptris)[3];
+	/* per face offset into 'looptris' */
+	const int *face_tri_offset;
+};
+
+struct TessBeautyChunk {
+	MemArena *pf_arena;
+	Heap *pf_heap;
+};
+
+static void bm_mesh_calc_tessellation_beauty_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict tls)
+{
+	const struct TessBeautyData *data = userdata;
+	struct TessBeautyChunk *chunk = tls->userdata_chunk;
 
+	bm_face_calc_tessellation_beauty(
+	        data->ftable[index], &data->looptris[data->face_tri_offset[index]],
+	        &chunk->pf_arena, &chunk->pf_heap);
 }
 
+static void bm_mesh_calc_tessellation_beauty_finalize(
+        void *__restrict UNUSED(userdata),
+        void *__restrict userdata_chunk)
+{
+	struct TessBeautyChunk *chunk = userdata_chunk;
+
+	if (chunk->pf_arena) {
+		BLI_memarena_free(chunk->pf_arena);
+		BLI_heap_free(chunk->pf_heap, NULL);
+	}
+}
 
 /**
  * A version of #BM_mesh_calc_tessellation that avoids degenerate triangles.
+ *
+ * Large meshes are tessellated in parallel, the result is the same as when done on a single thread.
  */
 void BM_mesh_calc_tessellation_beauty(BMesh *bm, BMLoop *(*looptris)[3], int *r_looptris_tot)
 {
@@ -1512,131 +1771,60 @@ void BM_mesh_calc_tessellation_beauty(BMesh *bm, BMLoop *(*looptris)[3], int *r_
 	const int looptris_tot = poly_to_tri_count(bm->totface, bm->totloop);
 #endif
 
-	BMIter iter;
-	BMFace *efa;
 	int i = 0;
 
-	MemArena *pf_arena = NULL;
-
-	/* use_beauty */
-	Heap *pf_heap = NULL;
-
-	BM_ITER_MESH (efa, &iter, bm, BM_FACES_OF_MESH) {
-		/* don't consider two-edged faces */
-		if (UNLIKELY(efa->len < 3)) {
-			/* do nothing */
-		}
-		else if (efa->len == 3) {
-			BMLoop *l;
-			BMLoop **l_ptr = looptris[i++];
-			l_ptr[0] = l = BM_FACE_FIRST_LOOP(efa);
-			l_ptr[1] = l = l->next;
-			l_ptr[2] = l->next;
-		}
-		else if (efa->len == 4) {
-			BMLoop *l_v1 = BM_FACE_FIRST_LOOP(efa);
-			BMLoop *l_v2 = l_v1->next;
-			BMLoop *l_v3 = l_v2->next;
-			BMLoop *l_v4 = l_v1->prev;
-
-			/* #BM_verts_calc_rotate_beauty performs excessive checks we don't need!
-			 * It's meant for rotating edges, it also calculates a new normal.
-			 *
-			 * Use #BLI_polyfill_beautify_quad_rotate_calc since we have the normal.
-			 */
-#if 0
-			const bool split_13 = (BM_verts_calc_rotate_beauty(
-			        l_v1->v, l_v2->v, l_v3->v, l_v4->v, 0, 0) < 0.0f);
-#else
-			float axis_mat[3][3], v_quad[4][2];
-			axis_dominant_v3_to_m3(axis_mat, efa->no);
-			mul_v2_m3v3(v_quad[0], axis_mat, l_v1->v->co);
-			mul_v2_m3v3(v_quad[1], axis_mat, l_v2->v->co);
-			mul_v2_m3v3(v_quad[2], axis_mat, l_v3->v->co);
-			mul_v2_m3v3(v_quad[3], axis_mat, l_v4->v->co);
-
-			const bool split_13 = BLI_polyfill_beautify_quad_rotate_calc(
-			        v_quad[0], v_quad[1], v_quad[2], v_quad[3]) < 0.0f;
-#endif
+	if (bm->totface >= BM_TESS_PARALLEL_THRESHOLD) {
+		int *face_tri_offset = MEM_mallocN(sizeof(*face_tri_offset) * (size_t)bm->totface, __func__);
+		int index;
 
-			BMLoop **l_ptr_a = looptris[i++];
-			BMLoop **l_ptr_b = looptris[i++];
-			if (split_13) {
-				l_ptr_a[0] = l_v1;
-				l_ptr_a[1] = l_v2;
-				l_ptr_a[2] = l_v3;
+		BM_mesh_elem_table_ensure(bm, BM_FACE);
 
-				l_ptr_b[0] = l_v1;
-				l_ptr_b[1] = l_v3;
-				l_ptr_b[2] = l_v4;
-			}
-			else {
-				l_ptr_a[0] = l_v1;
-				l_ptr_a[1] = l_v2;
-				l_ptr_a[2] = l_v4;
-
-				l_ptr_b[0] = l_v2;
-				l_ptr_b[1] = l_v3;
-				l_ptr_b[2] = l_v4;
+		for (index = 0; index < bm->totface; index++) {
+			const int len = bm->ftable[index]->len;
+			face_tri_offset[index] = i;
+			if (LIKELY(len >= 3)) {
+				i += len - 2;
 			}
 		}
-		else {
-			int j;
 
-			BMLoop *l_iter;
-			BMLoop *l_first;
-			BMLoop **l_arr;
-
-			float axis_mat[3][3];
-			float (*projverts)[2];
-			unsigned int (*tris)[3];
-
-			const int totfilltri = efa->len - 2;
-
-			if (UNLIKELY(pf_arena == NULL)) {
-				pf_arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
-				pf_heap = BLI_heap_new_ex(BLI_POLYFILL_ALLOC_NGON_RESERVE);
-			}
-
-			tris = BLI_memarena_alloc(pf_arena, sizeof(*tris) * totfilltri);
-			l_arr = BLI_memarena_alloc(pf_arena, sizeof(*l_arr) * efa->len);
-			projverts = BLI_memarena_alloc(pf_arena, sizeof(*projverts) * efa->len);
-
-			axis_dominant_v3_to_m3_negate(axis_mat, efa->no);
-
-			j = 0;
-			l_iter = l_first = BM_FACE_FIRST_LOOP(efa);
-			do {
-				l_arr[j] = l_iter;
-				mul_v2_m3v3(projverts[j], axis_mat, l_iter->v->co);
-				j++;
-			} while ((l_iter = l_iter->next) != l_first);
-
-			BLI_polyfill_calc_arena(projverts, efa->len, 1, tris, pf_arena);
-
-			BLI_polyfill_beautify(projverts, efa->len, tris, pf_arena, pf_heap);
+		struct TessBeautyData data = {
+			.ftable = bm->ftable,
+			.looptris = looptris,
+			.face_tri_offset = face_tri_offset,
+		};
+		struct TessBeautyChunk chunk = {NULL};
+
+		ParallelRangeSettings settings;
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.min_iter_per_thread = BM_TESS_PARALLEL_THRESHOLD / 4;
+		settings.userdata_chunk = &chunk;
+		settings.userdata_chunk_size = sizeof(chunk);
+		settings.func_finalize = bm_mesh_calc_tessellation_beauty_finalize;
+		BLI_task_parallel_range(0, bm->totface, &data, bm_mesh_calc_tessellation_beauty_cb, &settings);
+
+		MEM_freeN(face_tri_offset);
+	}
+	else {
+		BMIter iter;
+		BMFace *efa;
 
-			for (j = 0; j < totfilltri; j++) {
-				BMLoop **l_ptr = looptris[i++];
-				unsigned int *tri = tris[j];
+		MemArena *pf_arena = NULL;
 
-				l_ptr[0] = l_arr[tri[0]];
-				l_ptr[1] = l_arr[tri[1]];
-				l_ptr[2] = l_arr[tri[2]];
-			}
+		/* use_beauty */
+		Heap *pf_heap = NULL;
 
-			BLI_memarena_clear(pf_arena);
+		BM_ITER_MESH (efa, &iter, bm, BM_FACES_OF_MESH) {
+			i += bm_face_calc_tessellation_beauty(efa, &looptris[i], &pf_arena, &pf_heap);
 		}
-	}
 
-	if (pf_arena) {
-		BLI_memarena_free(pf_arena);
+		if (pf_arena) {
+			BLI_memarena_free(pf_arena);
 
-		BLI_heap_free(pf_heap, NULL);
+			BLI_heap_free(pf_heap, NULL);
+		}
 	}
 
 	*r_looptris_tot = i;
 
 	BLI_assert(i <= looptris_tot);
-
 }
@@ -28,11 +28,14 @@
  */
 
 struct Heap;
+struct BMPartialUpdate;
 
 #include "BLI_compiler_attrs.h"
 
 void  BM_mesh_calc_tessellation(BMesh *bm, BMLoop *(*looptris)[3], int *r_looptris_tot);
 void  BM_mesh_calc_tessellation_beauty(BMesh *bm, BMLoop *(*looptris)[3], int *r_looptris_tot);
+void  BM_mesh_calc_tessellation_with_partial(
+        BMesh *bm, BMLoop *(*looptris)[3], const struct BMPartialUpdate *bmpinfo);
 
 void  BM_face_calc_tessellation(
         const BMFace *f, const bool use_fixed_quad,
@@ -74,6 +77,26 @@ void  BM_face_normal_flip_ex(
 void  BM_face_normal_flip(BMesh *bm, BMFace *f) ATTR_NONNULL();
 bool  BM_face_point_inside_test(const BMFace *f, const float co[3]) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
 
+void  BM_face_triangulate_calc_tris(
+        const BMFace *f,
+        const int quad_method, const int ngon_method,
+        uint (*r_tris)[3],
+        struct MemArena *pf_arena,
+        struct Heap *pf_heap
+        ) ATTR_NONNULL(1, 4);
+void  BM_face_triangulate_ex(
+        BMesh *bm, BMFace *f,
+        BMFace **r_faces_new,
+        int     *r_faces_new_tot,
+        BMEdge **r_edges_new,
+        int     *r_edges_new_tot,
+        struct LinkNode **r_faces_double,
+        const int quad_method, const int ngon_method,
+        const bool use_tag,
+        struct MemArena *pf_arena,
+        struct Heap *pf_heap,
+        const uint (*tris_precalc)[3]
+        ) ATTR_NONNULL(1, 2);
 void  BM_face_triangulate(
         BMesh *bm, BMFace *f,
         BMFace **r_faces_new,
@@ -188,18 +188,20 @@ static int recalc_face_normals_find_index(BMesh *bm, BMFace **faces, const int f
 }
 
 /**
- * Given an array of faces, recalculate their normals.
+ * Given an array of faces, calculate which of them need flipping so their winding matches,
+ * tagging them with #FACE_FLIP.
  * this functions assumes all faces in the array are connected by edges.
  *
+ * \note Only the faces in the array are read or tagged (they are connected by manifold edges only),
+ * so separate groups can be calculated in parallel.
+ *
  * \param bm
  * \param faces  Array of connected faces.
  * \param faces_len  Length of \a faces
- * \param oflag  Flag to check before doing the actual face flipping.
  */
-static void bmo_recalc_face_normals_array(BMesh *bm, BMFace **faces, const int faces_len, const short oflag)
+static void bmo_recalc_face_normals_array_calc(BMesh *bm, BMFace **faces, const int faces_len)
 {
-	int i, f_start_index;
-	const short oflag_flip = oflag | FACE_FLIP;
+	int f_start_index;
 	bool is_flip;
 
 	BMFace *f;
@@ -240,8 +242,21 @@ static void bmo_recalc_face_normals_array(BMesh *bm, BMFace **faces, const int f
 	}
 
 	BLI_LINKSTACK_FREE(fstack);
+}
+
+/**
+ * Apply flipping to oflag'd faces.
+ *
+ * \note Flipping changes the radial cycles of edges shared with other groups,
+ * so this runs on a single thread.
+ *
+ * \param oflag  Flag to check before doing the actual face flipping.
+ */
+static void bmo_recalc_face_normals_array_apply(BMesh *bm, BMFace **faces, const int faces_len, const short oflag)
+{
+	const short oflag_flip = oflag | FACE_FLIP;
+	int i;
 
-	/* apply flipping to oflag'd faces */
 	for (i = 0; i < faces_len; i++) {
 		if (BMO_face_flag_test(bm, faces[i], oflag_flip) == oflag_flip) {
 			BM_face_normal_flip(bm, faces[i]);
@@ -250,24 +265,47 @@ static void bmo_recalc_face_normals_array(BMesh *bm, BMFace **faces, const int f
 	}
 }
 
+typedef struct RecalcFaceNormalsData {
+	BMesh *bm;
+	BMFace **faces;
+	const int (*group_index)[2];
+	const bool *group_is_calc;
+} RecalcFaceNormalsData;
+
+static void bmo_recalc_face_normals_group_cb(
+        void *__restrict userdata, const int index, BMOParallelTLS *__restrict UNUSED(tls))
+{
+	const RecalcFaceNormalsData *data = userdata;
+
+	if (data->group_is_calc[index]) {
+		const int fg_sta = data->group_index[index][0];
+		const int fg_len = data->group_index[index][1];
+		bmo_recalc_face_normals_array_calc(data->bm, &data->faces[fg_sta], fg_len);
+	}
+}
+
 /*
  * put normal to the outside, and set the first direction flags in edges
  *
  * then check the object, and set directions / direction-flags: but only for edges with 1 or 2 faces
  * this is in fact the 'select connected'
  *
- * in case all faces were not done: start over with 'find the ultimate ...' */
+ * in case all faces were not done: start over with 'find the ultimate ...'
+ *
+ * Each group of connected faces is calculated in parallel, flipping is done afterwards.
+ */
 
 void bmo_recalc_face_normals_exec(BMesh *bm, BMOperator *op)
 {
 	int *groups_array = MEM_mallocN(sizeof(*groups_array) * bm->totface, __func__);
-	BMFace **faces_grp = MEM_mallocN(sizeof(*faces_grp) * bm->totface, __func__);
+	BMFace **faces = MEM_mallocN(sizeof(*faces) * bm->totface, __func__);
 
 	int (*group_index)[2];
 	const int group_tot = BM_mesh_calc_face_groups(
 	        bm, groups_array, &group_index,
 	        bmo_recalc_normal_loop_filter_cb, NULL,
 	        0, BM_EDGE);
+	bool *group_is_calc = MEM_mallocN(sizeof(*group_is_calc) * (size_t)max_ii(group_tot, 1), __func__);
 	int i;
 
 	BMO_slot_buffer_flag_enable(bm, op->slots_in, "faces", BM_FACE, FACE_FLAG);
@@ -281,19 +319,32 @@ void bmo_recalc_face_normals_exec(BMesh *bm, BMOperator *op)
 		bool is_calc = false;
 
 		for (j = 0; j < fg_len; j++) {
-			faces_grp[j] = BM_face_at_index(bm, groups_array[fg_sta + j]);
+			faces[fg_sta + j] = BM_face_at_index(bm, groups_array[fg_sta + j]);
 
 			if (is_calc == false) {
-				is_calc = BMO_face_flag_test_bool(bm, faces_grp[j], FACE_FLAG);
+				is_calc = BMO_face_flag_test_bool(bm, faces[fg_sta + j], FACE_FLAG);
 			}
 		}
 
-		if (is_calc) {
-			bmo_recalc_face_normals_array(bm, faces_grp, fg_len, FACE_FLAG);
+		group_is_calc[i] = is_calc;
+	}
+
+	RecalcFaceNormalsData data = {
+		.bm = bm,
+		.faces = faces,
+		.group_index = (const int (*)[2])group_index,
+		.group_is_calc = group_is_calc,
+	};
+	BMO_parallel_range(group_tot, &data, bmo_recalc_face_normals_group_cb, bm->totface >= BM_OMP_LIMIT);
+
+	for (i = 0; i < group_tot; i++) {
+		if (group_is_calc[i]) {
+			bmo_recalc_face_normals_array_apply(bm, &faces[group_index[i][0]], group_index[i][1], FACE_FLAG);
 		}
 	}
 
-	MEM_freeN(faces_grp);
+	MEM_freeN(faces);
+	MEM_freeN(group_is_calc);
 
 	MEM_freeN(groups_array);
 	MEM_freeN(group_index);
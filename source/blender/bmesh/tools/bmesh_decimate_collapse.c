@@ -40,6 +40,8 @@
 #include "BLI_edgehash.h"
 #include "BLI_polyfill_2d.h"
 #include "BLI_polyfill_2d_beautify.h"
+#include "BLI_sort_utils.h"
+#include "BLI_task.h"
 #include "BLI_utildefines_stack.h"
 
 
@@ -83,6 +85,44 @@ typedef enum CD_UseFlag {
 /* BMesh Helper Functions
  * ********************** */
 
+static void bm_decim_face_quadric(BMFace *f, Quadric *r_q)
+{
+	float center[3];
+	double plane_db[4];
+
+	BM_face_calc_center_mean(f, center);
+	copy_v3db_v3fl(plane_db, f->no);
+	plane_db[3] = -dot_v3db_v3fl(plane_db, center);
+
+	BLI_quadric_from_plane(r_q, plane_db);
+}
+
+/**
+ * \return false when the boundary edge has no usable plane.
+ */
+static bool bm_decim_edge_boundary_quadric(BMEdge *e, Quadric *r_q)
+{
+	float edge_vector[3];
+	float edge_plane[3];
+	double edge_plane_db[4];
+	sub_v3_v3v3(edge_vector, e->v2->co, e->v1->co);
+
+	cross_v3_v3v3(edge_plane, edge_vector, e->l->f->no);
+	copy_v3db_v3fl(edge_plane_db, edge_plane);
+
+	if (normalize_v3_d(edge_plane_db) > (double)FLT_EPSILON) {
+		float center[3];
+
+		mid_v3_v3v3(center, e->v1->co, e->v2->co);
+
+		edge_plane_db[3] = -dot_v3db_v3fl(edge_plane_db, center);
+		BLI_quadric_from_plane(r_q, edge_plane_db);
+		BLI_quadric_mul(r_q, BOUNDARY_PRESERVE_WEIGHT);
+		return true;
+	}
+	return false;
+}
+
 /**
  * \param vquadrics must be calloc'd
  */
@@ -96,15 +136,9 @@ static void bm_decim_build_quadrics(BMesh *bm, Quadric *vquadrics)
 		BMLoop *l_first;
 		BMLoop *l_iter;
 
-		float center[3];
-		double plane_db[4];
 		Quadric q;
 
-		BM_face_calc_center_mean(f, center);
-		copy_v3db_v3fl(plane_db, f->no);
-		plane_db[3] = -dot_v3db_v3fl(plane_db, center);
-
-		BLI_quadric_from_plane(&q, plane_db);
+		bm_decim_face_quadric(f, &q);
 
 		l_iter = l_first = BM_FACE_FIRST_LOOP(f);
 		do {
@@ -115,25 +149,8 @@ static void bm_decim_build_quadrics(BMesh *bm, Quadric *vquadrics)
 	/* boundary edges */
 	BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
 		if (UNLIKELY(BM_edge_is_boundary(e))) {
-			float edge_vector[3];
-			float edge_plane[3];
-			double edge_plane_db[4];
-			sub_v3_v3v3(edge_vector, e->v2->co, e->v1->co);
-			f = e->l->f;
-
-			cross_v3_v3v3(edge_plane, edge_vector, f->no);
-			copy_v3db_v3fl(edge_plane_db, edge_plane);
-
-			if (normalize_v3_d(edge_plane_db) > (double)FLT_EPSILON) {
-				Quadric q;
-				float center[3];
-
-				mid_v3_v3v3(center, e->v1->co, e->v2->co);
-
-				edge_plane_db[3] = -dot_v3db_v3fl(edge_plane_db, center);
-				BLI_quadric_from_plane(&q, edge_plane_db);
-				BLI_quadric_mul(&q, BOUNDARY_PRESERVE_WEIGHT);
-
+			Quadric q;
+			if (bm_decim_edge_boundary_quadric(e, &q)) {
 				BLI_quadric_add_qu_qu(&vquadrics[BM_elem_index_get(e->v1)], &q);
 				BLI_quadric_add_qu_qu(&vquadrics[BM_elem_index_get(e->v2)], &q);
 			}
@@ -248,11 +265,14 @@ static float bm_decim_build_edge_cost_single__topology(BMEdge *e)
 
 #endif  /* USE_TOPOLOGY_FALLBACK */
 
-static void bm_decim_build_edge_cost_single(
+/**
+ * \return false when the edge can't be collapsed.
+ */
+static bool bm_decim_calc_edge_cost(
         BMEdge *e,
         const Quadric *vquadrics,
         const float *vweights, const float vweight_factor,
-        Heap *eheap, HeapNode **eheap_table)
+        float *r_cost)
 {
 	float cost;
 
@@ -260,7 +280,7 @@ static void bm_decim_build_edge_cost_single(
 	             ((vweights[BM_elem_index_get(e->v1)] == 0.0f) ||
 	              (vweights[BM_elem_index_get(e->v2)] == 0.0f))))
 	{
-		goto clear;
+		return false;
 	}
 
 	/* check we can collapse, some edges we better not touch */
@@ -270,7 +290,7 @@ static void bm_decim_build_edge_cost_single(
 		}
 		else {
 			/* only collapse tri's */
-			goto clear;
+			return false;
 		}
 	}
 	else if (BM_edge_is_manifold(e)) {
@@ -279,11 +299,11 @@ static void bm_decim_build_edge_cost_single(
 		}
 		else {
 			/* only collapse tri's */
-			goto clear;
+			return false;
 		}
 	}
 	else {
-		goto clear;
+		return false;
 	}
 	/* end sanity check */
 
@@ -337,14 +357,27 @@ static void bm_decim_build_edge_cost_single(
 		}
 	}
 
-	BLI_heap_insert_or_update(eheap, &eheap_table[BM_elem_index_get(e)], cost, e);
-	return;
+	*r_cost = cost;
+	return true;
+}
 
-clear:
-	if (eheap_table[BM_elem_index_get(e)]) {
-		BLI_heap_remove(eheap, eheap_table[BM_elem_index_get(e)]);
+static void bm_decim_build_edge_cost_single(
+        BMEdge *e,
+        const Quadric *vquadrics,
+        const float *vweights, const float vweight_factor,
+        Heap *eheap, HeapNode **eheap_table)
+{
+	float cost;
+
+	if (bm_decim_calc_edge_cost(e, vquadrics, vweights, vweight_factor, &cost)) {
+		BLI_heap_insert_or_update(eheap, &eheap_table[BM_elem_index_get(e)], cost, e);
+	}
+	else {
+		if (eheap_table[BM_elem_index_get(e)]) {
+			BLI_heap_remove(eheap, eheap_table[BM_elem_index_get(e)]);
+		}
+		eheap_table[BM_elem_index_get(e)] = NULL;
 	}
-	eheap_table[BM_elem_index_get(e)] = NULL;
 }
 
 
@@ -354,6 +387,10 @@ static void bm_decim_invalid_edge_cost_single(
         BMEdge *e,
         Heap *eheap, HeapNode **eheap_table)
 {
+	if (eheap == NULL) {
+		/* parallel collapse, see: #bm_decim_collapse_parallel */
+		return;
+	}
 	BLI_assert(eheap_table[BM_elem_index_get(e)] == NULL);
 	eheap_table[BM_elem_index_get(e)] = BLI_heap_insert(eheap, COST_INVALID, e);
 }
@@ -366,10 +403,10 @@ static void bm_decim_build_edge_cost(
 {
 	BMIter iter;
 	BMEdge *e;
-	uint i;
 
-	BM_ITER_MESH_INDEX (e, &iter, bm, BM_EDGES_OF_MESH, i) {
-		eheap_table[i] = NULL;  /* keep sanity check happy */
+	/* index lookups, since edge indices may have gaps after collapsing in parallel */
+	BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
+		eheap_table[BM_elem_index_get(e)] = NULL;  /* keep sanity check happy */
 		bm_decim_build_edge_cost_single(e, vquadrics, vweights, vweight_factor, eheap, eheap_table);
 	}
 }
@@ -1208,7 +1245,7 @@ static bool bm_decim_edge_collapse(
 		copy_v3_v3(v_other->co, optimize_co);
 
 		/* remove eheap */
-		for (i = 0; i < 2; i++) {
+		for (i = 0; (i < 2) && eheap; i++) {
 			/* highly unlikely 'eheap_table[ke_other[i]]' would be NULL, but do for sanity sake */
 			if ((e_clear_other[i] != -1) && (eheap_table[e_clear_other[i]] != NULL)) {
 				BLI_heap_remove(eheap, eheap_table[e_clear_other[i]]);
@@ -1230,6 +1267,10 @@ static bool bm_decim_edge_collapse(
 		BM_vert_normal_update(v_other);
 #endif
 
+		if (eheap == NULL) {
+			/* parallel collapse recalculates all costs between passes */
+			return true;
+		}
 
 		/* update error costs and the eheap */
 		if (LIKELY(v_other->e)) {
@@ -1276,6 +1317,277 @@ static bool bm_decim_edge_collapse(
 }
 
 
+/* Parallel Collapse
+ * ***************** */
+
+/**
+ * Faster, approximate alternative to the heap based collapse,
+ * intended for very dense meshes (scans for example).
+ *
+ * Rather then collapsing the single cheapest edge at a time and updating the heap,
+ * each pass calculates the cost of all edges in parallel, then collapses the cheapest edges in order.
+ * Edges around each collapse are locked for the rest of the pass,
+ * since their costs are out of date until the next pass.
+ * The collapse its self is still done on a single thread since BMesh topology editing isn't thread-safe.
+ *
+ * Once few collapses remain the regular heap based collapse finishes off,
+ * this also handles edges skipped because of degenerate results.
+ */
+
+/* stop batching and switch to the heap for the remaining collapses,
+ * (also once less than 1/8th of the faces are left to remove, where passes become small) */
+#define PARALLEL_FIXUP_FACE_TOT 1024
+/* number of edge costs to sample when picking the cost threshold for each pass */
+#define PARALLEL_COST_SAMPLE_TOT 4096
+
+enum {
+	/* neighborhood was changed by a collapse in this pass */
+	EDGE_PARALLEL_LOCK  = (1 << 0),
+	/* collapse failed, skip for the remaining passes (the heap will check it again) */
+	EDGE_PARALLEL_SKIP  = (1 << 1),
+};
+
+typedef struct DecimParallelData {
+	BMVert **verts;
+	BMEdge **edges;
+	Quadric *vquadrics;
+	const float *vweights;
+	float vweight_factor;
+	/* original edge index aligned */
+	float *ecosts;
+	char *eflag;
+} DecimParallelData;
+
+static void bm_decim_build_quadrics_vert_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	DecimParallelData *data = userdata;
+	BMVert *v = data->verts[index];
+	Quadric *vq = &data->vquadrics[BM_elem_index_get(v)];
+	BMEdge *e_iter, *e_first;
+	BMIter liter;
+	BMLoop *l;
+
+	/* calculating face quadrics per vertex means faces are calculated multiple times,
+	 * but avoids having to store a quadric per face or lock the vertex quadrics */
+	BM_ITER_ELEM (l, &liter, v, BM_LOOPS_OF_VERT) {
+		Quadric q;
+		bm_decim_face_quadric(l->f, &q);
+		BLI_quadric_add_qu_qu(vq, &q);
+	}
+
+	/* boundary edges */
+	if ((e_iter = e_first = v->e)) {
+		do {
+			if (UNLIKELY(BM_edge_is_boundary(e_iter))) {
+				Quadric q;
+				if (bm_decim_edge_boundary_quadric(e_iter, &q)) {
+					BLI_quadric_add_qu_qu(vq, &q);
+				}
+			}
+		} while ((e_iter = bmesh_disk_edge_next(e_iter, v)) != e_first);
+	}
+}
+
+/**
+ * Threaded version of #bm_decim_build_quadrics,
+ * results only differ by the order values are added in.
+ *
+ * \param vquadrics must be calloc'd
+ */
+static void bm_decim_build_quadrics_parallel(BMesh *bm, Quadric *vquadrics)
+{
+	DecimParallelData data = {NULL};
+
+	BM_mesh_elem_table_ensure(bm, BM_VERT);
+	data.verts = bm->vtable;
+	data.vquadrics = vquadrics;
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (bm->totvert >= BM_OMP_LIMIT);
+	BLI_task_parallel_range(0, bm->totvert, &data, bm_decim_build_quadrics_vert_cb, &settings);
+}
+
+static void bm_decim_edge_cost_parallel_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	DecimParallelData *data = userdata;
+	BMEdge *e = data->edges[index];
+	const int e_index = BM_elem_index_get(e);
+	float cost;
+
+	data->eflag[e_index] &= ~EDGE_PARALLEL_LOCK;
+
+	if ((data->eflag[e_index] & EDGE_PARALLEL_SKIP) == 0 &&
+	    bm_decim_calc_edge_cost(e, data->vquadrics, data->vweights, data->vweight_factor, &cost))
+	{
+		float optimize_co[3];
+		bm_decim_calc_target_co_fl(e, optimize_co, data->vquadrics);
+
+		/* check here so edges which would flip faces aren't taking up space in the pass */
+		if (bm_edge_collapse_is_degenerate_flip(e, optimize_co) == false) {
+			data->ecosts[e_index] = cost;
+			return;
+		}
+	}
+
+	data->ecosts[e_index] = COST_INVALID;
+}
+
+/**
+ * Estimate the cost below which there are \a collapse_tot edges, from a sample of edges.
+ */
+static float bm_decim_parallel_cost_threshold(BMesh *bm, const float *ecosts, const int collapse_tot)
+{
+	float *samples = MEM_mallocN(sizeof(*samples) * PARALLEL_COST_SAMPLE_TOT, __func__);
+	const int stride = max_ii(bm->totedge / PARALLEL_COST_SAMPLE_TOT, 1);
+	int samples_len = 0;
+	float threshold;
+	int i;
+
+	for (i = 0; (i < bm->totedge) && (samples_len < PARALLEL_COST_SAMPLE_TOT); i += stride) {
+		const float cost = ecosts[BM_elem_index_get(bm->etable[i])];
+		if (cost != COST_INVALID) {
+			samples[samples_len++] = cost;
+		}
+	}
+
+	if (samples_len == 0) {
+		threshold = COST_INVALID;
+	}
+	else {
+		const int sample_index = min_ii(collapse_tot / stride, samples_len - 1);
+		qsort(samples, samples_len, sizeof(*samples), BLI_sortutil_cmp_float);
+		threshold = samples[sample_index];
+	}
+
+	MEM_freeN(samples);
+	return threshold;
+}
+
+static void bm_decim_parallel_vert_lock(BMVert *v, char *eflag)
+{
+	BMEdge *e_iter, *e_first;
+	BMIter liter;
+	BMLoop *l;
+
+	e_iter = e_first = v->e;
+	do {
+		eflag[BM_elem_index_get(e_iter)] |= EDGE_PARALLEL_LOCK;
+	} while ((e_iter = bmesh_disk_edge_next(e_iter, v)) != e_first);
+
+	/* the edges around the face fan also have their costs recalculated by the heap collapse */
+	BM_ITER_ELEM (l, &liter, v, BM_LOOPS_OF_VERT) {
+		eflag[BM_elem_index_get(l->next->e)] |= EDGE_PARALLEL_LOCK;
+	}
+}
+
+static void bm_decim_collapse_parallel(
+        BMesh *bm, const int face_tot_target, const int tot_edge_orig,
+        Quadric *vquadrics,
+        float *vweights, const float vweight_factor,
+        const CD_UseFlag customdata_flag)
+{
+	DecimParallelData data = {NULL};
+	/* original edge index aligned, only valid for edges which aren't locked */
+	BMEdge **edges_orig = MEM_mallocN(sizeof(*edges_orig) * tot_edge_orig, __func__);
+	struct SortIntByFloat *edges_sort = MEM_mallocN(sizeof(*edges_sort) * bm->totedge, __func__);
+
+	data.vquadrics = vquadrics;
+	data.vweights = vweights;
+	data.vweight_factor = vweight_factor;
+	data.ecosts = MEM_mallocN(sizeof(*data.ecosts) * tot_edge_orig, __func__);
+	data.eflag = MEM_callocN(sizeof(*data.eflag) * tot_edge_orig, __func__);
+
+	while (bm->totface - face_tot_target > max_ii(PARALLEL_FIXUP_FACE_TOT, bm->totface / 8)) {
+		/* only collapse half of what remains each pass (each collapse removes 2 faces),
+		 * so costs are re-evaluated before the more expensive edges are collapsed */
+		const int collapse_max = max_ii((bm->totface - face_tot_target) / 4, 1);
+		int edges_sort_len = 0;
+		int collapse_tot = 0;
+		float threshold;
+		int i;
+
+		BM_mesh_elem_table_ensure(bm, BM_EDGE);
+		data.edges = bm->etable;
+
+		ParallelRangeSettings settings;
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.use_threading = (bm->totedge >= BM_OMP_LIMIT);
+		BLI_task_parallel_range(0, bm->totedge, &data, bm_decim_edge_cost_parallel_cb, &settings);
+
+		/* over-estimate since some edges will be locked */
+		threshold = bm_decim_parallel_cost_threshold(bm, data.ecosts, collapse_max * 2);
+		if (threshold == COST_INVALID) {
+			break;
+		}
+
+		for (i = 0; i < bm->totedge; i++) {
+			BMEdge *e = bm->etable[i];
+			const int e_index = BM_elem_index_get(e);
+			edges_orig[e_index] = e;
+			if (data.ecosts[e_index] <= threshold) {
+				edges_sort[edges_sort_len].sort_value = data.ecosts[e_index];
+				edges_sort[edges_sort_len].data = e_index;
+				edges_sort_len++;
+			}
+		}
+
+		qsort(edges_sort, edges_sort_len, sizeof(*edges_sort), BLI_sortutil_cmp_float);
+
+		for (i = 0; (i < edges_sort_len) && (collapse_tot < collapse_max); i++) {
+			const int e_index = edges_sort[i].data;
+			float optimize_co[3];
+			BMEdge *e;
+
+			if (bm->totface <= face_tot_target) {
+				break;
+			}
+
+			/* locked edges may have been removed by an earlier collapse, don't access */
+			if (data.eflag[e_index] & EDGE_PARALLEL_LOCK) {
+				continue;
+			}
+
+			e = edges_orig[e_index];
+			bm_decim_parallel_vert_lock(e->v1, data.eflag);
+			bm_decim_parallel_vert_lock(e->v2, data.eflag);
+
+			if (bm_decim_edge_collapse(
+			        bm, e, vquadrics, vweights, vweight_factor, NULL, NULL,
+#ifdef USE_SYMMETRY
+			        NULL,
+#endif
+			        customdata_flag,
+			        optimize_co, true))
+			{
+				collapse_tot++;
+			}
+			else {
+				data.eflag[e_index] |= EDGE_PARALLEL_SKIP;
+			}
+		}
+
+		if (collapse_tot == 0) {
+			break;
+		}
+	}
+
+	MEM_freeN(edges_orig);
+	MEM_freeN(edges_sort);
+	MEM_freeN(data.ecosts);
+	MEM_freeN(data.eflag);
+}
+
+#undef PARALLEL_FIXUP_FACE_TOT
+#undef PARALLEL_COST_SAMPLE_TOT
+
+
 /* Main Decimate Function
  * ********************** */
 
@@ -1287,13 +1599,16 @@ static bool bm_decim_edge_collapse(
  *        a vertex group is the usual source for this.
  * \param symmetry_axis: Axis of symmetry, -1 to disable mirror decimate.
  * \param symmetry_eps: Threshold when matching mirror verts.
+ * \param use_fast: Collapse independent edges in batches using multiple threads,
+ *        faster on dense meshes at the cost of some quality (not supported with symmetry).
  */
 void BM_mesh_decimate_collapse(
         BMesh *bm,
         const float factor,
         float *vweights, float vweight_factor,
         const bool do_triangulate,
-        const int symmetry_axis, const float symmetry_eps)
+        const int symmetry_axis, const float symmetry_eps,
+        const bool use_fast)
 {
 	Heap *eheap;             /* edge heap */
 	HeapNode **eheap_table;  /* edge index aligned table pointing to the eheap */
@@ -1325,13 +1640,39 @@ void BM_mesh_decimate_collapse(
 	tot_edge_orig = bm->totedge;
 
 
+#ifdef USE_CUSTOMDATA
+	/* initialize customdata flag, we only need math for loops */
+	if (CustomData_has_interp(&bm->vdata))  customdata_flag |= CD_DO_VERT;
+	if (CustomData_has_interp(&bm->edata))  customdata_flag |= CD_DO_EDGE;
+	if (CustomData_has_math(&bm->ldata))    customdata_flag |= CD_DO_LOOP;
+#endif
+
+	face_tot_target = bm->totface * factor;
+
 	/* build initial edge collapse cost data */
-	bm_decim_build_quadrics(bm, vquadrics);
+#ifdef USE_SYMMETRY
+	if (use_fast && (use_symmetry == false))
+#else
+	if (use_fast)
+#endif
+	{
+		bm_decim_build_quadrics_parallel(bm, vquadrics);
+		bm->elem_index_dirty |= BM_ALL;
 
-	bm_decim_build_edge_cost(bm, vquadrics, vweights, vweight_factor, eheap, eheap_table);
+		bm_decim_collapse_parallel(
+		        bm, face_tot_target, tot_edge_orig, vquadrics, vweights, vweight_factor,
+		        customdata_flag);
 
-	face_tot_target = bm->totface * factor;
-	bm->elem_index_dirty |= BM_ALL;
+		/* the heap handles the remaining collapses */
+		bm_decim_build_edge_cost(bm, vquadrics, vweights, vweight_factor, eheap, eheap_table);
+	}
+	else {
+		bm_decim_build_quadrics(bm, vquadrics);
+
+		bm_decim_build_edge_cost(bm, vquadrics, vweights, vweight_factor, eheap, eheap_table);
+
+		bm->elem_index_dirty |= BM_ALL;
+	}
 
 #ifdef USE_SYMMETRY
 	edge_symmetry_map = (use_symmetry) ? bm_edge_symmetry_map(bm, symmetry_axis, symmetry_eps) : NULL;
@@ -1339,13 +1680,6 @@ void BM_mesh_decimate_collapse(
 	UNUSED_VARS(symmetry_axis, symmetry_eps);
 #endif
 
-#ifdef USE_CUSTOMDATA
-	/* initialize customdata flag, we only need math for loops */
-	if (CustomData_has_interp(&bm->vdata))  customdata_flag |= CD_DO_VERT;
-	if (CustomData_has_interp(&bm->edata))  customdata_flag |= CD_DO_EDGE;
-	if (CustomData_has_math(&bm->ldata))    customdata_flag |= CD_DO_LOOP;
-#endif
-
 	/* iterative edge collapse and maintain the eheap */
 #ifdef USE_SYMMETRY
 	if (use_symmetry == false)
@@ -33,6 +33,12 @@
  * Unsupported:
  * - Intersecting between different meshes.
  * - No support for holes (cutting a hole into a single face).
+ *
+ * Exact mode (\a use_exact argument):
+ * - Triangle pairs are rejected and edge/triangle crossings classified using
+ *   exact orientation predicates, epsilon is only used for snapping to nearby elements.
+ * - Inside/outside of boolean islands uses the generalized winding number instead of ray-casting,
+ *   which tolerates small gaps and overlapping parts in the operands.
  */
 
 #include "MEM_guardedalloc.h"
@@ -51,6 +57,7 @@
 
 #include "BLI_kdopbvh.h"
 #include "BLI_buffer.h"
+#include "BLI_task.h"
 
 #include "bmesh.h"
 #include "intern/bmesh_private.h"
@@ -144,6 +151,7 @@ struct ISectState {
 	MemArena *mem_arena;
 
 	struct ISectEpsilon epsilon;
+	bool use_exact;
 };
 
 /**
@@ -302,12 +310,55 @@ static enum ISectType intersect_line_tri(
         const float p0[3], const float p1[3],
         const float *t_cos[3], const float t_nor[3],
         float r_ix[3],
-        const struct ISectEpsilon *e)
+        const struct ISectEpsilon *e, const bool use_exact)
 {
 	float p_dir[3];
 	uint i_t0;
 	float fac;
 
+	if (use_exact) {
+		const double side_p0 = orient3d_robust_v3(UNPACK3(t_cos), p0);
+		const double side_p1 = orient3d_robust_v3(UNPACK3(t_cos), p1);
+
+		/* both end-points strictly on one side of the triangle plane */
+		if ((side_p0 > 0.0 && side_p1 > 0.0) || (side_p0 < 0.0 && side_p1 < 0.0)) {
+			return IX_NONE;
+		}
+
+		if ((side_p0 != 0.0) && (side_p1 != 0.0)) {
+			const double side_e0 = orient3d_robust_v3(p0, p1, t_cos[0], t_cos[1]);
+			const double side_e1 = orient3d_robust_v3(p0, p1, t_cos[1], t_cos[2]);
+			const double side_e2 = orient3d_robust_v3(p0, p1, t_cos[2], t_cos[0]);
+
+			if ((side_e0 > 0.0 && side_e1 > 0.0 && side_e2 > 0.0) ||
+			    (side_e0 < 0.0 && side_e1 < 0.0 && side_e2 < 0.0))
+			{
+				/* crosses the triangle interior, only snap when very close to existing elements */
+				fac = (float)(side_p0 / (side_p0 - side_p1));
+				if ((fac >= e->eps_margin) && (fac <= 1.0f - e->eps_margin)) {
+					interp_v3_v3v3(r_ix, p0, p1, fac);
+					if ((min_fff(len_squared_v3v3(t_cos[0], r_ix),
+					             len_squared_v3v3(t_cos[1], r_ix),
+					             len_squared_v3v3(t_cos[2], r_ix)) >= e->eps_margin_sq) &&
+					    (min_fff(dist_squared_to_line_segment_v3(r_ix, t_cos[0], t_cos[1]),
+					             dist_squared_to_line_segment_v3(r_ix, t_cos[1], t_cos[2]),
+					             dist_squared_to_line_segment_v3(r_ix, t_cos[2], t_cos[0])) >= e->eps_margin_sq))
+					{
+						return IX_EDGE_TRI;
+					}
+				}
+			}
+			else if (((side_e0 > 0.0) || (side_e1 > 0.0) || (side_e2 > 0.0)) &&
+			         ((side_e0 < 0.0) || (side_e1 < 0.0) || (side_e2 < 0.0)))
+			{
+				/* passes the triangle plane strictly outside the triangle */
+				return IX_NONE;
+			}
+		}
+
+		/* touching or co-planar, the epsilon checks below handle snapping */
+	}
+
 	sub_v3_v3v3(p_dir, p0, p1);
 	normalize_v3(p_dir);
 
@@ -439,7 +490,7 @@ static BMVert *bm_isect_edge_tri(
 		}
 	}
 
-	*r_side = intersect_line_tri(e_v0->co, e_v1->co, t_cos, t_nor, ix, &s->epsilon);
+	*r_side = intersect_line_tri(e_v0->co, e_v1->co, t_cos, t_nor, ix, &s->epsilon, s->use_exact);
 	if (*r_side != IX_NONE) {
 		BMVert *iv;
 		BMEdge *e;
@@ -971,8 +1022,138 @@ static int isect_bvhtree_point_v3(
 	return num_isect;
 }
 
+struct OverlapFilterData {
+	struct BMLoop *(*looptris)[3];
+	bool use_exact;
+};
+
+/* Runs from the BVH overlap threads, only reads the mesh. */
+static bool bm_isect_tri_tri_overlap_cb(void *userdata, int index_a, int index_b, int UNUSED(thread))
+{
+	const struct OverlapFilterData *data = userdata;
+	BMLoop **l_a = data->looptris[index_a];
+	BMLoop **l_b = data->looptris[index_b];
+	const float *t_a_cos[3] = {UNPACK3_EX(, l_a, ->v->co)};
+	const float *t_b_cos[3] = {UNPACK3_EX(, l_b, ->v->co)};
+	uint i;
+
+	/* skipped by #bm_isect_tri_tri */
+	for (i = 0; i < 3; i++) {
+		if (ELEM(l_a[i]->v, l_b[0]->v, l_b[1]->v, l_b[2]->v)) {
+			return false;
+		}
+	}
+
+	if (data->use_exact) {
+		double side_a[3], side_b[3];
+
+		for (i = 0; i < 3; i++) {
+			side_a[i] = orient3d_robust_v3(UNPACK3(t_b_cos), t_a_cos[i]);
+			side_b[i] = orient3d_robust_v3(UNPACK3(t_a_cos), t_b_cos[i]);
+		}
+
+		/* one triangle strictly on one side of the others plane */
+		if ((side_a[0] > 0.0 && side_a[1] > 0.0 && side_a[2] > 0.0) ||
+		    (side_a[0] < 0.0 && side_a[1] < 0.0 && side_a[2] < 0.0) ||
+		    (side_b[0] > 0.0 && side_b[1] > 0.0 && side_b[2] > 0.0) ||
+		    (side_b[0] < 0.0 && side_b[1] < 0.0 && side_b[2] < 0.0))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
 #endif  /* USE_BVH */
 
+struct BoolGroupData {
+	BMFace **ftable;
+	const int *groups_array;
+	const int (*group_index)[2];
+	int (*test_fn)(BMFace *f, void *user_data);
+	void *user_data;
+
+	/* original triangles of both operands */
+	const float **looptri_coords;
+	const char *looptri_side;
+	int looptris_tot;
+#ifdef USE_BVH
+	BVHTree *tree_pair[2];
+#endif
+	bool use_exact;
+
+	/* per group, side is -1 for skipped groups, otherwise the side to test against */
+	int *group_side;
+	float (*group_co)[3];
+	bool *group_inside;
+	/* exact mode, per group solid angle sum */
+	double *group_winding;
+	int group_tot;
+};
+
+static void bm_isect_group_test_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	struct BoolGroupData *data = userdata;
+	/* for now assume this is an OK face to test with (not degenerate!) */
+	BMFace *f = data->ftable[data->groups_array[data->group_index[i][0]]];
+	int side = data->test_fn(f, data->user_data);
+
+	if (side == -1) {
+		data->group_side[i] = -1;
+		return;
+	}
+	BLI_assert(ELEM(side, 0, 1));
+	side = !side;
+	data->group_side[i] = side;
+
+	// BM_face_calc_center_mean(f, co);
+	BM_face_calc_point_in_face(f, data->group_co[i]);
+
+	if (data->use_exact == false) {
+#ifdef USE_BVH
+		const int hits = isect_bvhtree_point_v3(data->tree_pair[side], data->looptri_coords, data->group_co[i]);
+		data->group_inside[i] = ((hits & 1) == 1);
+#endif
+	}
+}
+
+static void bm_isect_group_winding_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict tls)
+{
+	const struct BoolGroupData *data = userdata;
+	double *winding = tls->userdata_chunk;
+	const float **t_cos = &data->looptri_coords[i * 3];
+	const int t_side = data->looptri_side[i];
+	int g;
+
+	if (t_side == -1) {
+		return;
+	}
+
+	for (g = 0; g < data->group_tot; g++) {
+		if (data->group_side[g] == t_side) {
+			winding[g] += solid_angle_tri_v3(data->group_co[g], t_cos[0], t_cos[1], t_cos[2]);
+		}
+	}
+}
+
+static void bm_isect_group_winding_finalize(void *__restrict userdata, void *__restrict userdata_chunk)
+{
+	struct BoolGroupData *data = userdata;
+	const double *winding = userdata_chunk;
+	int g;
+
+	for (g = 0; g < data->group_tot; g++) {
+		data->group_winding[g] += winding[g];
+	}
+}
+
 /**
  * Intersect tessellated faces
  * leaving the resulting edges tagged.
@@ -987,7 +1168,7 @@ bool BM_mesh_intersect(
         int (*test_fn)(BMFace *f, void *user_data), void *user_data,
         const bool use_self, const bool use_separate, const bool use_dissolve, const bool use_island_connect,
         const bool use_partial_connect, const bool use_edge_tag, const int boolean_mode,
-        const float eps)
+        const float eps, const bool use_exact)
 {
 	struct ISectState s;
 	const int totface_orig = bm->totface;
@@ -997,6 +1178,8 @@ bool BM_mesh_intersect(
 
 	/* needed for boolean, since cutting up faces moves the loops within the face */
 	const float **looptri_coords = NULL;
+	/* exact boolean, side of each triangle before cutting (-1 when skipped) */
+	char *looptri_side = NULL;
 
 #ifdef USE_BVH
 	BVHTree *tree_a, *tree_b;
@@ -1021,6 +1204,8 @@ bool BM_mesh_intersect(
 
 	s.mem_arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
 
+	s.use_exact = use_exact;
+
 	/* setup epsilon from base */
 	s.epsilon.eps = eps;
 	s.epsilon.eps2x = eps * 2.0f;
@@ -1074,6 +1259,13 @@ bool BM_mesh_intersect(
 			cos[j++] = looptris[i][2]->v->co;
 		}
 		looptri_coords = (const float **)cos;
+
+		if (use_exact) {
+			looptri_side = MEM_mallocN((size_t)looptris_tot * sizeof(*looptri_side), __func__);
+			for (i = 0; i < looptris_tot; i++) {
+				looptri_side[i] = (char)test_fn(looptris[i][0]->f, user_data);
+			}
+		}
 	}
 
 #ifdef USE_BVH
@@ -1114,7 +1306,14 @@ bool BM_mesh_intersect(
 		tree_b = tree_a;
 	}
 
-	overlap = BLI_bvhtree_overlap(tree_b, tree_a, &tree_overlap_tot, NULL, NULL);
+	{
+		/* cheap rejection of pairs that can't intersect, done in the overlap threads */
+		struct OverlapFilterData overlap_data = {
+			.looptris = looptris,
+			.use_exact = use_exact,
+		};
+		overlap = BLI_bvhtree_overlap(tree_b, tree_a, &tree_overlap_tot, bm_isect_tri_tri_overlap_cb, &overlap_data);
+	}
 
 	if (overlap) {
 		uint i;
@@ -1541,8 +1740,6 @@ bool BM_mesh_intersect(
 #endif  /* USE_SEPARATE */
 
 	if ((boolean_mode != BMESH_ISECT_BOOLEAN_NONE)) {
-		BVHTree *tree_pair[2] = {tree_a, tree_b};
-
 		/* group vars */
 		int *groups_array;
 		int (*group_index)[2];
@@ -1569,41 +1766,80 @@ bool BM_mesh_intersect(
 		printf("%s: Total face-groups: %d\n", __func__, group_tot);
 #endif
 
-		/* Check if island is inside/outside */
+		/* Check if islands are inside/outside, the tests only read the mesh so run in parallel. */
+		struct BoolGroupData group_data = {
+			.ftable = ftable,
+			.groups_array = groups_array,
+			.group_index = (const int (*)[2])group_index,
+			.test_fn = test_fn,
+			.user_data = user_data,
+			.looptri_coords = looptri_coords,
+			.looptri_side = looptri_side,
+			.looptris_tot = looptris_tot,
+			.tree_pair = {tree_a, tree_b},
+			.use_exact = use_exact,
+			.group_side = MEM_mallocN(sizeof(int) * (size_t)group_tot, __func__),
+			.group_co = MEM_mallocN(sizeof(float[3]) * (size_t)group_tot, __func__),
+			.group_inside = MEM_callocN(sizeof(bool) * (size_t)group_tot, __func__),
+			.group_tot = group_tot,
+		};
+
+		{
+			ParallelRangeSettings settings;
+			BLI_parallel_range_settings_defaults(&settings);
+			settings.use_threading = (group_tot > 1);
+			BLI_task_parallel_range(0, group_tot, &group_data, bm_isect_group_test_cb, &settings);
+		}
+
+		if (use_exact && (group_tot != 0)) {
+			/* Generalized winding number of each island point w.r.t. the other operand,
+			 * summed per thread over all triangles of the original geometry. */
+			double *winding_chunk = MEM_callocN(sizeof(double) * (size_t)group_tot, __func__);
+			ParallelRangeSettings settings;
+
+			group_data.group_winding = MEM_callocN(sizeof(double) * (size_t)group_tot, __func__);
+
+			BLI_parallel_range_settings_defaults(&settings);
+			settings.use_threading = (looptris_tot > 1024);
+			settings.userdata_chunk = winding_chunk;
+			settings.userdata_chunk_size = sizeof(double) * (size_t)group_tot;
+			settings.func_finalize = bm_isect_group_winding_finalize;
+			BLI_task_parallel_range(0, looptris_tot, &group_data, bm_isect_group_winding_cb, &settings);
+
+			for (i = 0; i < group_tot; i++) {
+				/* sign depends on the normals of the other operand, allow both */
+				const double winding = group_data.group_winding[i] / (4.0 * M_PI);
+				group_data.group_inside[i] = (fabs(winding) > 0.5);
+			}
+
+			MEM_freeN(group_data.group_winding);
+			MEM_freeN(winding_chunk);
+		}
+
 		for (i = 0; i < group_tot; i++) {
 			int fg     = group_index[i][0];
 			int fg_end = group_index[i][1] + fg;
 			bool do_remove, do_flip;
 
 			{
-				/* for now assyme this is an OK face to test with (not degenerate!) */
-				BMFace *f = ftable[groups_array[fg]];
-				float co[3];
-				int hits;
-				int side = test_fn(f, user_data);
+				const int side = group_data.group_side[i];
+				const bool is_inside = group_data.group_inside[i];
 
 				if (side == -1) {
 					continue;
 				}
-				BLI_assert(ELEM(side, 0, 1));
-				side = !side;
-
-				// BM_face_calc_center_mean(f, co);
-				BM_face_calc_point_in_face(f, co);
-
-				hits = isect_bvhtree_point_v3(tree_pair[side], looptri_coords, co);
 
 				switch (boolean_mode) {
 					case BMESH_ISECT_BOOLEAN_ISECT:
-						do_remove = ((hits & 1) != 1);
+						do_remove = (is_inside == false);
 						do_flip = false;
 						break;
 					case BMESH_ISECT_BOOLEAN_UNION:
-						do_remove = ((hits & 1) == 1);
+						do_remove = is_inside;
 						do_flip = false;
 						break;
 					case BMESH_ISECT_BOOLEAN_DIFFERENCE:
-						do_remove = ((hits & 1) == 1) == side;
+						do_remove = is_inside == (side != 0);
 						do_flip = (side == 0);
 						break;
 				}
@@ -1611,9 +1847,10 @@ bool BM_mesh_intersect(
 #ifdef USE_BOOLEAN_RAYCAST_DRAW
 				{
 					uint colors[4] = {0x00000000, 0xffffffff, 0xff000000, 0x0000ff};
+					const float *co = group_data.group_co[i];
 					float co_other[3] = {UNPACK3(co)};
 					co_other[0] += 1000.0f;
-					bl_debug_color_set(colors[(hits & 1) == 1]);
+					bl_debug_color_set(colors[is_inside]);
 					bl_debug_draw_edge_add(co, co_other);
 				}
 #endif
@@ -1636,6 +1873,10 @@ bool BM_mesh_intersect(
 			has_edit_boolean |= (do_flip || do_remove);
 		}
 
+		MEM_freeN(group_data.group_side);
+		MEM_freeN(group_data.group_co);
+		MEM_freeN(group_data.group_inside);
+
 		MEM_freeN(groups_array);
 		MEM_freeN(group_index);
 
@@ -1682,6 +1923,9 @@ bool BM_mesh_intersect(
 
 	if (boolean_mode != BMESH_ISECT_BOOLEAN_NONE) {
 		MEM_freeN((void *)looptri_coords);
+		if (looptri_side) {
+			MEM_freeN(looptri_side);
+		}
 
 		/* no booleans, just free immediate */
 		BLI_bvhtree_free(tree_a);
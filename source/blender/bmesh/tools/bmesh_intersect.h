@@ -31,7 +31,7 @@ bool BM_mesh_intersect(
         int (*test_fn)(BMFace *f, void *user_data), void *user_data,
         const bool use_self, const bool use_separate, const bool use_dissolve, const bool use_island_connect,
         const bool use_partial_connect, const bool use_edge_tag, const int boolean_mode,
-        const float eps);
+        const float eps, const bool use_exact);
 
 enum {
 	BMESH_ISECT_BOOLEAN_NONE = -1,
@@ -33,6 +33,7 @@
 
 #include "BLI_utildefines.h"
 #include "BLI_alloca.h"
+#include "BLI_math_base.h"
 #include "BLI_memarena.h"
 #include "BLI_heap.h"
 #include "BLI_linklist.h"
@@ -54,23 +55,21 @@ static void bm_face_triangulate_mapping(
         const bool use_tag,
         BMOperator *op, BMOpSlot *slot_facemap_out, BMOpSlot *slot_facemap_double_out,
 
-        MemArena *pf_arena,
-        /* use for MOD_TRIANGULATE_NGON_BEAUTY only! */
-        struct Heap *pf_heap)
+        const uint (*tris)[3])
 {
 	int faces_array_tot = face->len - 3;
 	BMFace  **faces_array = BLI_array_alloca(faces_array, faces_array_tot);
 	LinkNode *faces_double = NULL;
 	BLI_assert(face->len > 3);
 
-	BM_face_triangulate(
+	BM_face_triangulate_ex(
 	        bm, face,
 	        faces_array, &faces_array_tot,
 	        NULL, NULL,
 	        &faces_double,
 	        quad_method, ngon_method, use_tag,
-	        pf_arena,
-	        pf_heap);
+	        NULL, NULL,
+	        tris);
 
 	if (faces_array_tot) {
 		int i;
@@ -89,66 +88,130 @@ static void bm_face_triangulate_mapping(
 }
 
 
+/* Faces triangulated per batch, bounds the memory used for triangles calculated up front. */
+#define TRIANGULATE_BATCH_SIZE (1 << 16)
+/* Below this the triangles are calculated on the calling thread. */
+#define TRIANGULATE_PARALLEL_THRESHOLD 1024
+
+typedef struct TriangulateCalcData {
+	BMFace **faces;
+	const int *faces_tri_offset;
+	uint (*tris)[3];
+	int quad_method, ngon_method;
+} TriangulateCalcData;
+
+static void bm_mesh_triangulate_calc_cb(
+        void *__restrict userdata, const int index, BMOParallelTLS *__restrict tls)
+{
+	const TriangulateCalcData *data = userdata;
+	BMFace *face = data->faces[index];
+	MemArena *pf_arena = NULL;
+	Heap *pf_heap = NULL;
+
+	if (face->len > 4) {
+		pf_arena = BMO_parallel_tls_arena_ensure(tls);
+		if (data->ngon_method == MOD_TRIANGULATE_NGON_BEAUTY) {
+			pf_heap = BMO_parallel_tls_heap_ensure(tls);
+		}
+	}
+
+	BM_face_triangulate_calc_tris(
+	        face, data->quad_method, data->ngon_method,
+	        &data->tris[data->faces_tri_offset[index]],
+	        pf_arena, pf_heap);
+}
+
+/**
+ * Triangles are calculated in parallel (see #BMO_parallel_range),
+ * the faces are then split on the calling thread in the same order as before.
+ */
 void BM_mesh_triangulate(
         BMesh *bm, const int quad_method, const int ngon_method, const bool tag_only,
         BMOperator *op, BMOpSlot *slot_facemap_out, BMOpSlot *slot_facemap_double_out)
 {
 	BMIter iter;
 	BMFace *face;
-	MemArena *pf_arena;
-	Heap *pf_heap;
-
-	pf_arena = BLI_memarena_new(BLI_POLYFILL_ARENA_SIZE, __func__);
+	BMFace **faces;
+	int faces_len = 0;
+	LinkNode *faces_double = NULL;
 
-	if (ngon_method == MOD_TRIANGULATE_NGON_BEAUTY) {
-		pf_heap = BLI_heap_new_ex(BLI_POLYFILL_ALLOC_NGON_RESERVE);
+	faces = MEM_mallocN(sizeof(*faces) * (size_t)max_ii(bm->totface, 1), __func__);
+	BM_ITER_MESH (face, &iter, bm, BM_FACES_OF_MESH) {
+		if (face->len > 3) {
+			if (tag_only == false || BM_elem_flag_test(face, BM_ELEM_TAG)) {
+				faces[faces_len++] = face;
+			}
+		}
 	}
-	else {
-		pf_heap = NULL;
+
+	if (faces_len == 0) {
+		MEM_freeN(faces);
+		return;
 	}
 
-	if (slot_facemap_out) {
-		/* same as below but call: bm_face_triangulate_mapping() */
-		BM_ITER_MESH (face, &iter, bm, BM_FACES_OF_MESH) {
-			if (face->len > 3) {
-				if (tag_only == false || BM_elem_flag_test(face, BM_ELEM_TAG)) {
-					bm_face_triangulate_mapping(
-					        bm, face,
-					        quad_method, ngon_method, tag_only,
-					        op, slot_facemap_out, slot_facemap_double_out,
-					        pf_arena, pf_heap);
-				}
-			}
+	int *faces_tri_offset = MEM_mallocN(sizeof(*faces_tri_offset) * (size_t)min_ii(faces_len, TRIANGULATE_BATCH_SIZE), __func__);
+	uint (*tris)[3] = NULL;
+	int tris_len_alloc = 0;
+
+	for (int batch_sta = 0; batch_sta < faces_len; batch_sta += TRIANGULATE_BATCH_SIZE) {
+		const int batch_len = min_ii(faces_len - batch_sta, TRIANGULATE_BATCH_SIZE);
+		BMFace **faces_batch = &faces[batch_sta];
+		int tris_len = 0;
+		int i;
+
+		for (i = 0; i < batch_len; i++) {
+			faces_tri_offset[i] = tris_len;
+			tris_len += faces_batch[i]->len - 2;
 		}
-	}
-	else {
-		LinkNode *faces_double = NULL;
-
-		BM_ITER_MESH (face, &iter, bm, BM_FACES_OF_MESH) {
-			if (face->len > 3) {
-				if (tag_only == false || BM_elem_flag_test(face, BM_ELEM_TAG)) {
-					BM_face_triangulate(
-					        bm, face,
-					        NULL, NULL,
-					        NULL, NULL,
-					        &faces_double,
-					        quad_method, ngon_method, tag_only,
-					        pf_arena, pf_heap);
-				}
-			}
+
+		if (tris_len > tris_len_alloc) {
+			MEM_SAFE_FREE(tris);
+			tris_len_alloc = tris_len;
+			tris = MEM_mallocN(sizeof(*tris) * (size_t)tris_len_alloc, __func__);
 		}
 
-		while (faces_double) {
-			LinkNode *next = faces_double->next;
-			BM_face_kill(bm, faces_double->link);
-			MEM_freeN(faces_double);
-			faces_double = next;
+		TriangulateCalcData data = {
+			.faces = faces_batch,
+			.faces_tri_offset = faces_tri_offset,
+			.tris = tris,
+			.quad_method = quad_method,
+			.ngon_method = ngon_method,
+		};
+		BMO_parallel_range(batch_len, &data, bm_mesh_triangulate_calc_cb,
+		                   batch_len >= TRIANGULATE_PARALLEL_THRESHOLD);
+
+		for (i = 0; i < batch_len; i++) {
+			const uint (*face_tris)[3] = (const uint (*)[3])&tris[faces_tri_offset[i]];
+			face = faces_batch[i];
+
+			if (slot_facemap_out) {
+				bm_face_triangulate_mapping(
+				        bm, face,
+				        quad_method, ngon_method, tag_only,
+				        op, slot_facemap_out, slot_facemap_double_out,
+				        face_tris);
+			}
+			else {
+				BM_face_triangulate_ex(
+				        bm, face,
+				        NULL, NULL,
+				        NULL, NULL,
+				        &faces_double,
+				        quad_method, ngon_method, tag_only,
+				        NULL, NULL,
+				        face_tris);
+			}
 		}
 	}
 
-	BLI_memarena_free(pf_arena);
-
-	if (ngon_method == MOD_TRIANGULATE_NGON_BEAUTY) {
-		BLI_heap_free(pf_heap, NULL);
+	while (faces_double) {
+		LinkNode *next = faces_double->next;
+		BM_face_kill(bm, faces_double->link);
+		MEM_freeN(faces_double);
+		faces_double = next;
 	}
+
+	MEM_freeN(faces);
+	MEM_freeN(faces_tri_offset);
+	MEM_SAFE_FREE(tris);
 }
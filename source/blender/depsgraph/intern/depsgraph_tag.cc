@@ -182,6 +182,9 @@ void DEG_id_tag_update_ex(Main *bmain, ID *id, short flag)
 	}
 	DEG_DEBUG_PRINTF(TAG, "%s: id=%s flag=%d\n", __func__, id->name, flag);
 	lib_id_recalc_tag_flag(bmain, id, flag);
+	if (flag == 0 || (flag & OB_RECALC_DATA)) {
+		id->recalc_generation++;
+	}
 	for (Scene *scene = (Scene *)bmain->scene.first;
 	     scene != NULL;
 	     scene = (Scene *)scene->id.next)
@@ -2752,7 +2752,7 @@ void init_userdef_do_versions(Main *bmain)
 	if (!USER_VERSION_ATLEAST(278, 6)) {
 		/* Clear preference flags for re-use. */
 		U.flag &= ~(
-		    USER_FLAG_DEPRECATED_1 | USER_FLAG_DEPRECATED_2 | USER_FLAG_DEPRECATED_3 |
+		    USER_MODIFIER_CACHE_DISABLE | USER_FLAG_DEPRECATED_2 | USER_FLAG_DEPRECATED_3 |
 		    USER_FLAG_DEPRECATED_6 | USER_FLAG_DEPRECATED_7 |
 		    USER_FLAG_DEPRECATED_9 | USER_DEVELOPER_UI);
 		U.uiflag &= ~(
@@ -2772,6 +2772,13 @@ void init_userdef_do_versions(Main *bmain)
 	 */
 	{
 		/* (keep this block even if it becomes empty). */
+		if (U.sequencer_disk_cache_size_limit == 0) {
+			U.sequencer_disk_cache_size_limit = 100;
+			U.sequencer_disk_cache_compression = 1;
+		}
+		if (U.modifier_cache_limit == 0) {
+			U.modifier_cache_limit = 512;
+		}
 	}
 
 	if (U.pixelsize == 0.0f)
@@ -193,7 +193,7 @@ static int edbm_intersect_exec(bContext *C, wmOperator *op)
 	        test_fn, NULL,
 	        use_self, use_separate_all, true, true, true, true,
 	        -1,
-	        eps);
+	        eps, false);
 
 	if (use_separate_cut) {
 		/* detach selected/un-selected faces */
@@ -283,7 +283,7 @@ static int edbm_intersect_boolean_exec(bContext *C, wmOperator *op)
 	        test_fn, NULL,
 	        false, false, true, true, false, true,
 	        boolean_operation,
-	        eps);
+	        eps, false);
 
 
 	if (has_isect) {
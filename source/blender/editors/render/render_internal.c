@@ -243,11 +243,11 @@ static void image_buffer_rect_update(RenderJob *rj, RenderResult *rr, ImBuf *ibu
 		display_settings = &scene->display_settings;
 	}
 
-	IMB_partial_display_buffer_update(ibuf, rectf, NULL,
-	                                  linear_stride, linear_offset_x, linear_offset_y,
-	                                  view_settings, display_settings,
-	                                  rxmin, rymin, rxmin + xmax, rymin + ymax,
-	                                  rr->do_exr_tile);
+	IMB_partial_display_buffer_update_threaded(ibuf, rectf, NULL,
+	                                           linear_stride, linear_offset_x, linear_offset_y,
+	                                           view_settings, display_settings,
+	                                           rxmin, rymin, rxmin + xmax, rymin + ymax,
+	                                           rr->do_exr_tile);
 }
 
 /* ****************************** render invoking ***************** */
@@ -545,7 +545,9 @@ static void screen_opengl_render_apply(OGLRender *oglrender)
 			context.gpu_fx = oglrender->fx;
 			context.gpu_full_samples = oglrender->ofs_full_samples;
 
+			BKE_sequencer_prefetch_lock();
 			oglrender->seq_data.ibufs_arr[view_id] = BKE_sequencer_give_ibuf(&context, CFRA, chanshown);
+			BKE_sequencer_prefetch_unlock();
 		}
 	}
 
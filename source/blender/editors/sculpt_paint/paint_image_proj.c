@@ -109,6 +109,8 @@
 
 #include "paint_intern.h"
 
+#include "atomic_ops.h"
+
 static void partial_redraw_array_init(ImagePaintPartialRedraw *pr);
 
 /* Defines and Structs */
@@ -317,7 +319,10 @@ typedef struct ProjPaintState {
 	int thread_tot;
 	int bucketMin[2];
 	int bucketMax[2];
-	int context_bucket_x, context_bucket_y; /* must lock threads while accessing these */
+	/* buckets touched by the brush, threads take the next one without locking */
+	int *bucket_queue;
+	unsigned int bucket_queue_len;
+	unsigned int bucket_queue_next; /* atomic */
 
 	struct CurveMapping *cavity_curve;
 	BlurKernel *blurkernel;
@@ -427,6 +432,8 @@ typedef struct {
 	unsigned short tile_width;
 	ImBuf **tmpibuf;
 	ProjPaintImage *pjima;
+	/* per thread, moved into the undo step once all threads are done */
+	ListBase *undo_tiles;
 } TileInfo;
 
 
@@ -1500,17 +1507,18 @@ static int project_paint_undo_subtiles(const TileInfo *tinf, int tx, int ty)
 
 
 	if (generate_tile) {
-		ListBase *undo_tiles = ED_image_undo_get_tiles();
+		/* the tile list is local to this thread, no need for the undo lock */
+		ListBase *undo_tiles = tinf->undo_tiles;
 		volatile void *undorect;
 		if (tinf->masked) {
 			undorect = image_undo_push_tile(
 			        undo_tiles, pjIma->ima, pjIma->ibuf, tinf->tmpibuf,
-			        tx, ty, &pjIma->maskRect[tile_index], &pjIma->valid[tile_index], true, false);
+			        tx, ty, &pjIma->maskRect[tile_index], &pjIma->valid[tile_index], false, false);
 		}
 		else {
 			undorect = image_undo_push_tile(
 			        undo_tiles, pjIma->ima, pjIma->ibuf, tinf->tmpibuf,
-			        tx, ty, NULL, &pjIma->valid[tile_index], true, false);
+			        tx, ty, NULL, &pjIma->valid[tile_index], false, false);
 		}
 
 		pjIma->ibuf->userflags |= IB_BITMAPDIRTY;
@@ -2491,7 +2499,7 @@ static bool IsectPoly2Df_twoside(const float pt[2], float uv[][2], const int tot
 static void project_paint_face_init(
         const ProjPaintState *ps,
         const int thread_index, const int bucket_index, const int tri_index, const int image_index,
-        const rctf *clip_rect, const rctf *bucket_bounds, ImBuf *ibuf, ImBuf **tmpibuf,
+        const rctf *clip_rect, const rctf *bucket_bounds, ImBuf *ibuf, ImBuf **tmpibuf, ListBase *undo_tiles,
         const bool clamp_u, const bool clamp_v)
 {
 	/* Projection vars, to get the 3D locations into screen space  */
@@ -2505,7 +2513,8 @@ static void project_paint_face_init(
 		ps->do_masking,
 		IMAPAINT_TILE_NUMBER(ibuf->x),
 		tmpibuf,
-		ps->projImages + image_index
+		ps->projImages + image_index,
+		undo_tiles,
 	};
 
 	const MLoopTri *lt = &ps->dm_mlooptri[tri_index];
@@ -2921,14 +2930,14 @@ static void project_bucket_bounds(const ProjPaintState *ps, const int bucket_x,
  * have bucket_bounds as an argument so we don't need to give bucket_x/y the rect function needs */
 static void project_bucket_init(
         const ProjPaintState *ps, const int thread_index, const int bucket_index,
-        const rctf *clip_rect, const rctf *bucket_bounds)
+        const rctf *clip_rect, const rctf *bucket_bounds,
+        ImBuf **tmpibuf, ListBase *undo_tiles)
 {
 	LinkNode *node;
 	int tri_index, image_index = 0;
 	ImBuf *ibuf = NULL;
 	Image *tpage_last = NULL, *tpage;
 	Image *ima = NULL;
-	ImBuf *tmpibuf = NULL;
 
 	if (ps->image_tot == 1) {
 		/* Simple loop, no context switching */
@@ -2938,7 +2947,7 @@ static void project_bucket_init(
 		for (node = ps->bucketFaces[bucket_index]; node; node = node->next) {
 			project_paint_face_init(
 			        ps, thread_index, bucket_index, POINTER_AS_INT(node->link), 0,
-			        clip_rect, bucket_bounds, ibuf, &tmpibuf,
+			        clip_rect, bucket_bounds, ibuf, tmpibuf, undo_tiles,
 			        (ima->tpageflag & IMA_CLAMP_U) != 0, (ima->tpageflag & IMA_CLAMP_V) != 0);
 		}
 	}
@@ -2965,14 +2974,11 @@ static void project_bucket_init(
 
 			project_paint_face_init(
 			        ps, thread_index, bucket_index, tri_index, image_index,
-			        clip_rect, bucket_bounds, ibuf, &tmpibuf,
+			        clip_rect, bucket_bounds, ibuf, tmpibuf, undo_tiles,
 			        (ima->tpageflag & IMA_CLAMP_U) != 0, (ima->tpageflag & IMA_CLAMP_V) != 0);
 		}
 	}
 
-	if (tmpibuf)
-		IMB_freeImBuf(tmpibuf);
-
 	ps->bucketFlags[bucket_index] |= PROJ_BUCKET_INIT;
 }
 
@@ -3895,6 +3901,7 @@ static void project_paint_begin(
 	ps->bucketFaces = MEM_callocN(sizeof(LinkNode *) * ps->buckets_x * ps->buckets_y, "paint-bucketFaces");
 
 	ps->bucketFlags = MEM_callocN(sizeof(char) * ps->buckets_x * ps->buckets_y, "paint-bucketFaces");
+	ps->bucket_queue = MEM_mallocN(sizeof(int) * ps->buckets_x * ps->buckets_y, "paint-bucketQueue");
 #ifndef PROJ_DEBUG_NOSEAMBLEED
 	if (ps->is_shared_user == false) {
 		proj_paint_state_seam_bleed_init(ps);
@@ -3951,6 +3958,7 @@ static void project_paint_end(ProjPaintState *ps)
 	MEM_freeN(ps->bucketRect);
 	MEM_freeN(ps->bucketFaces);
 	MEM_freeN(ps->bucketFlags);
+	MEM_freeN(ps->bucket_queue);
 
 	if (ps->is_shared_user == false) {
 
@@ -4104,9 +4112,6 @@ static bool project_bucket_iter_init(ProjPaintState *ps, const float mval_f[2])
 		if (ps->bucketMin[0] == ps->bucketMax[0] || ps->bucketMin[1] == ps->bucketMax[1]) {
 			return 0;
 		}
-
-		ps->context_bucket_x = ps->bucketMin[0];
-		ps->context_bucket_y = ps->bucketMin[1];
 	}
 	else { /* reproject: PROJ_SRC_* */
 		ps->bucketMin[0] = 0;
@@ -4114,9 +4119,28 @@ static bool project_bucket_iter_init(ProjPaintState *ps, const float mval_f[2])
 
 		ps->bucketMax[0] = ps->buckets_x;
 		ps->bucketMax[1] = ps->buckets_y;
+	}
 
-		ps->context_bucket_x = 0;
-		ps->context_bucket_y = 0;
+	/* collect the buckets up-front, so threads can take them without locking */
+	{
+		const int diameter = 2 * ps->brush_size;
+		int bucket_x, bucket_y;
+		rctf bucket_bounds;
+
+		ps->bucket_queue_len = 0;
+		ps->bucket_queue_next = 0;
+
+		for (bucket_y = ps->bucketMin[1]; bucket_y < ps->bucketMax[1]; bucket_y++) {
+			for (bucket_x = ps->bucketMin[0]; bucket_x < ps->bucketMax[0]; bucket_x++) {
+				project_bucket_bounds(ps, bucket_x, bucket_y, &bucket_bounds);
+
+				if ((ps->source != PROJ_SRC_VIEW) ||
+				    project_bucket_isect_circle(mval_f, (float)(diameter * diameter), &bucket_bounds))
+				{
+					ps->bucket_queue[ps->bucket_queue_len++] = bucket_x + (bucket_y * ps->buckets_x);
+				}
+			}
+		}
 	}
 	return 1;
 }
@@ -4124,38 +4148,20 @@ static bool project_bucket_iter_init(ProjPaintState *ps, const float mval_f[2])
 
 static bool project_bucket_iter_next(
         ProjPaintState *ps, int *bucket_index,
-        rctf *bucket_bounds, const float mval[2])
+        rctf *bucket_bounds)
 {
-	const int diameter = 2 * ps->brush_size;
-
-	if (ps->thread_tot > 1)
-		BLI_thread_lock(LOCK_CUSTOM1);
-
-	//printf("%d %d\n", ps->context_bucket_x, ps->context_bucket_y);
-
-	for (; ps->context_bucket_y < ps->bucketMax[1]; ps->context_bucket_y++) {
-		for (; ps->context_bucket_x < ps->bucketMax[0]; ps->context_bucket_x++) {
-
-			/* use bucket_bounds for project_bucket_isect_circle and project_bucket_init*/
-			project_bucket_bounds(ps, ps->context_bucket_x, ps->context_bucket_y, bucket_bounds);
+	const unsigned int queue_index = atomic_fetch_and_add_uint32(&ps->bucket_queue_next, 1);
 
-			if ((ps->source != PROJ_SRC_VIEW) ||
-			    project_bucket_isect_circle(mval, (float)(diameter * diameter), bucket_bounds))
-			{
-				*bucket_index = ps->context_bucket_x + (ps->context_bucket_y * ps->buckets_x);
-				ps->context_bucket_x++;
+	if (queue_index < ps->bucket_queue_len) {
+		*bucket_index = ps->bucket_queue[queue_index];
 
-				if (ps->thread_tot > 1)
-					BLI_thread_unlock(LOCK_CUSTOM1);
+		/* use bucket_bounds for project_bucket_isect_circle and project_bucket_init*/
+		project_bucket_bounds(
+		        ps, *bucket_index % ps->buckets_x, *bucket_index / ps->buckets_x, bucket_bounds);
 
-				return 1;
-			}
-		}
-		ps->context_bucket_x = ps->bucketMin[0];
+		return 1;
 	}
 
-	if (ps->thread_tot > 1)
-		BLI_thread_unlock(LOCK_CUSTOM1);
 	return 0;
 }
 
@@ -4173,6 +4179,10 @@ typedef struct ProjectHandle {
 	int thread_index;
 
 	struct ImagePool *pool;
+
+	/* undo tiles pushed by this thread, and the scratch buffer used to copy them */
+	ListBase undo_tiles;
+	ImBuf *tmpibuf;
 } ProjectHandle;
 
 static void do_projectpaint_clone(ProjPaintState *ps, ProjPixel *projPixel, float mask)
@@ -4521,7 +4531,7 @@ static void *do_projectpaint_thread(void *ph_v)
 
 	/* printf("brush bounds %d %d %d %d\n", bucketMin[0], bucketMin[1], bucketMax[0], bucketMax[1]); */
 
-	while (project_bucket_iter_next(ps, &bucket_index, &bucket_bounds, pos)) {
+	while (project_bucket_iter_next(ps, &bucket_index, &bucket_bounds)) {
 
 		/* Check this bucket and its faces are initialized */
 		if (ps->bucketFlags[bucket_index] == PROJ_BUCKET_NULL) {
@@ -4531,7 +4541,9 @@ static void *do_projectpaint_thread(void *ph_v)
 			clip_rect.ymin -= PROJ_PIXEL_TOLERANCE;
 			clip_rect.ymax += PROJ_PIXEL_TOLERANCE;
 			/* No pixels initialized */
-			project_bucket_init(ps, thread_index, bucket_index, &clip_rect, &bucket_bounds);
+			project_bucket_init(
+			        ps, thread_index, bucket_index, &clip_rect, &bucket_bounds,
+			        &((ProjectHandle *)ph_v)->tmpibuf, &((ProjectHandle *)ph_v)->undo_tiles);
 		}
 
 		if (ps->source != PROJ_SRC_VIEW) {
@@ -4915,6 +4927,9 @@ static bool project_paint_op(void *state, const float lastpos[2], const float po
 
 		handles[a].pool = pool;
 
+		BLI_listbase_clear(&handles[a].undo_tiles);
+		handles[a].tmpibuf = NULL;
+
 		if (ps->thread_tot > 1)
 			BLI_threadpool_insert(&threads, &handles[a]);
 	}
@@ -4927,6 +4942,16 @@ static bool project_paint_op(void *state, const float lastpos[2], const float po
 
 	BKE_image_pool_free(pool);
 
+	/* hand the undo tiles over in one go, instead of locking the undo list per tile */
+	for (a = 0; a < ps->thread_tot; a++) {
+		if (!BLI_listbase_is_empty(&handles[a].undo_tiles)) {
+			BLI_movelisttolist(ED_image_undo_get_tiles(), &handles[a].undo_tiles);
+		}
+		if (handles[a].tmpibuf) {
+			IMB_freeImBuf(handles[a].tmpibuf);
+		}
+	}
+
 	/* move threaded bounds back into ps->projectPartialRedraws */
 	for (i = 0; i < ps->image_tot; i++) {
 		int touch = 0;
@@ -5016,9 +5041,10 @@ static void paint_proj_stroke_ps(
 		}
 	}
 
+	/* GPU updates are deferred to #paint_proj_redraw,
+	 * so dirty regions of all dabs in between redraws are uploaded once. */
 	if (project_paint_op(ps, prev_pos, pos)) {
 		ps_handle->need_redraw = true;
-		project_image_refresh_tagged(ps);
 	}
 }
 
@@ -5271,6 +5297,11 @@ fail:
 void paint_proj_redraw(const bContext *C, void *ps_handle_p, bool final)
 {
 	ProjStrokeHandle *ps_handle = ps_handle_p;
+	int i;
+
+	for (i = 0; i < ps_handle->ps_views_tot; i++) {
+		project_image_refresh_tagged(ps_handle->ps_views[i]);
+	}
 
 	if (ps_handle->need_redraw) {
 		ps_handle->need_redraw = false;
@@ -1188,14 +1188,11 @@ static float brush_strength(
 	}
 }
 
-/* Return a multiplier for brush strength on a particular vertex. */
-float tex_strength(SculptSession *ss, const Brush *br,
-                   const float brush_point[3],
-                   const float len,
-                   const short vno[3],
-                   const float fno[3],
-                   const float mask,
-                   const int thread_id)
+/* Sample the brush texture at a vertex, without falloff or masking applied. */
+static float tex_strength_sample(
+        SculptSession *ss, const Brush *br,
+        const float brush_point[3],
+        const int thread_id)
 {
 	StrokeCache *cache = ss->cache;
 	const Scene *scene = cache->vc->scene;
@@ -1257,6 +1254,21 @@ float tex_strength(SculptSession *ss, const Brush *br,
 		}
 	}
 
+	return avg;
+}
+
+/* Return a multiplier for brush strength on a particular vertex. */
+float tex_strength(SculptSession *ss, const Brush *br,
+                   const float brush_point[3],
+                   const float len,
+                   const short vno[3],
+                   const float fno[3],
+                   const float mask,
+                   const int thread_id)
+{
+	StrokeCache *cache = ss->cache;
+	float avg = tex_strength_sample(ss, br, brush_point, thread_id);
+
 	/* Falloff curve */
 	avg *= BKE_brush_curve_strength(br, len, cache->radius);
 
@@ -1268,6 +1280,252 @@ float tex_strength(SculptSession *ss, const Brush *br,
 	return avg;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Batched Brush Evaluation
+ *
+ * Brushes which write one displacement per vertex into the node proxy gather the
+ * unique vertices of a node into contiguous arrays first, then run the brush test,
+ * falloff and strength as separate passes over the whole batch before scattering the
+ * result back. Each pass is a short loop over plain arrays which the compiler can
+ * vectorize, instead of going through the PBVH iterator and #tex_strength per vertex.
+ *
+ * The arrays live in the per-thread userdata chunk of the parallel range,
+ * sized for the largest node, see #sculpt_brush_batch_parallel_range.
+ * \{ */
+
+typedef struct SculptBrushBatch {
+	int totvert;
+
+	/* Index into the node proxy (#PBVHVertexIter.i). */
+	int *index;
+	/* Only set for regular meshes, used to tag vertices for update. */
+	MVert **mvert;
+	float (*co)[3];
+	float (*no)[3];
+	float *mask;
+	/* Squared distance to the brush until #sculpt_brush_batch_test finishes. */
+	float *dist;
+	float *fade;
+	/* Tool specific displacement. */
+	float (*val)[3];
+} SculptBrushBatch;
+
+typedef struct SculptBrushBatchChunk {
+	int totvert_max;
+	int _pad;
+	/* Per vertex arrays are allocated after the struct, see #sculpt_brush_batch_init. */
+} SculptBrushBatchChunk;
+
+static size_t sculpt_brush_batch_chunk_size(const int totvert)
+{
+	const size_t vert_size =
+	        sizeof(MVert *) + sizeof(float[3]) * 3 + sizeof(float) * 3 + sizeof(int);
+	/* Keep per-thread copies of the chunk aligned. */
+	return (sizeof(SculptBrushBatchChunk) + vert_size * (size_t)totvert + 15) & ~(size_t)15;
+}
+
+static void sculpt_brush_batch_init(SculptBrushBatch *batch, SculptBrushBatchChunk *chunk)
+{
+	const size_t totvert = (size_t)chunk->totvert_max;
+	char *mem = (char *)(chunk + 1);
+
+	batch->totvert = 0;
+
+	/* Largest alignment first. */
+	batch->mvert = (MVert **)mem;
+	mem += sizeof(*batch->mvert) * totvert;
+	batch->co = (float (*)[3])mem;
+	mem += sizeof(*batch->co) * totvert;
+	batch->no = (float (*)[3])mem;
+	mem += sizeof(*batch->no) * totvert;
+	batch->val = (float (*)[3])mem;
+	mem += sizeof(*batch->val) * totvert;
+	batch->mask = (float *)mem;
+	mem += sizeof(*batch->mask) * totvert;
+	batch->dist = (float *)mem;
+	mem += sizeof(*batch->dist) * totvert;
+	batch->fade = (float *)mem;
+	mem += sizeof(*batch->fade) * totvert;
+	batch->index = (int *)mem;
+}
+
+static void sculpt_brush_batch_gather(
+        SculptSession *ss, PBVHNode *node, const SculptBrushBatchChunk *chunk, SculptBrushBatch *batch)
+{
+	PBVHVertexIter vd;
+	int i = 0;
+
+	BKE_pbvh_vertex_iter_begin(ss->pbvh, node, vd, PBVH_ITER_UNIQUE)
+	{
+		BLI_assert(i < chunk->totvert_max);
+		batch->index[i] = vd.i;
+		batch->mvert[i] = vd.mvert;
+		copy_v3_v3(batch->co[i], vd.co);
+		if (vd.fno)
+			copy_v3_v3(batch->no[i], vd.fno);
+		else
+			normal_short_to_float_v3(batch->no[i], vd.no);
+		batch->mask[i] = vd.mask ? *vd.mask : 0.0f;
+		i++;
+	}
+	BKE_pbvh_vertex_iter_end;
+
+	UNUSED_VARS_NDEBUG(chunk);
+	batch->totvert = i;
+}
+
+/* Copy all per vertex data except the fade, which is only computed once the batch is final. */
+BLI_INLINE void sculpt_brush_batch_move(SculptBrushBatch *batch, const int dst, const int src)
+{
+	batch->index[dst] = batch->index[src];
+	batch->mvert[dst] = batch->mvert[src];
+	copy_v3_v3(batch->co[dst], batch->co[src]);
+	copy_v3_v3(batch->no[dst], batch->no[src]);
+	copy_v3_v3(batch->val[dst], batch->val[src]);
+	batch->mask[dst] = batch->mask[src];
+	batch->dist[dst] = batch->dist[src];
+}
+
+/**
+ * Batch version of the test returned by #sculpt_brush_test_init_with_falloff_shape,
+ * vertices outside the brush are removed and the distance is no longer squared.
+ */
+static void sculpt_brush_batch_test(
+        const SculptBrushTest *test, const char falloff_shape, SculptBrushBatch *batch)
+{
+	const int totvert = batch->totvert;
+	const float (*co)[3] = (const float (*)[3])batch->co;
+	float *dist = batch->dist;
+	int i, j;
+
+	if (falloff_shape == PAINT_FALLOFF_SHAPE_SPHERE) {
+		for (i = 0; i < totvert; i++) {
+			dist[i] = len_squared_v3v3(co[i], test->location);
+		}
+	}
+	else {
+		/* PAINT_FALLOFF_SHAPE_TUBE, same as #closest_to_plane_normalized_v3 */
+		const float *plane = test->plane_view;
+		for (i = 0; i < totvert; i++) {
+			const float side = plane_point_side_v3(plane, co[i]);
+			float co_proj[3];
+			madd_v3_v3v3fl(co_proj, co[i], plane, -side);
+			dist[i] = len_squared_v3v3(co_proj, test->location);
+		}
+	}
+
+	for (i = 0, j = 0; i < totvert; i++) {
+		if (dist[i] <= test->radius_squared && !sculpt_brush_test_clipping(test, co[i])) {
+			if (i != j) {
+				sculpt_brush_batch_move(batch, j, i);
+			}
+			j++;
+		}
+	}
+	batch->totvert = j;
+
+	for (i = 0; i < j; i++) {
+		dist[i] = sqrtf(dist[i]);
+	}
+}
+
+/**
+ * Batch version of `bstrength * tex_strength(...)`,
+ * multiplies in the same order so results match the per vertex path.
+ */
+static void sculpt_brush_batch_strength(
+        SculptSession *ss, const Brush *br, SculptBrushBatch *batch,
+        const float bstrength, const int thread_id)
+{
+	const StrokeCache *cache = ss->cache;
+	const int totvert = batch->totvert;
+	float *fade = batch->fade;
+	int i;
+
+	if (br->mtex.tex) {
+		for (i = 0; i < totvert; i++) {
+			fade[i] = tex_strength_sample(ss, br, batch->co[i], thread_id);
+		}
+	}
+	else {
+		for (i = 0; i < totvert; i++) {
+			fade[i] = 1.0f;
+		}
+	}
+
+	/* Falloff curve */
+	for (i = 0; i < totvert; i++) {
+		fade[i] *= BKE_brush_curve_strength(br, batch->dist[i], cache->radius);
+	}
+
+	if (br->flag & BRUSH_FRONTFACE) {
+		const float (*no)[3] = (const float (*)[3])batch->no;
+		for (i = 0; i < totvert; i++) {
+			const float dot = dot_v3v3(no[i], cache->view_normal);
+			fade[i] *= dot > 0 ? dot : 0;
+		}
+	}
+
+	/* Paint mask */
+	for (i = 0; i < totvert; i++) {
+		fade[i] = bstrength * (fade[i] * (1.0f - batch->mask[i]));
+	}
+}
+
+/* Scatter `val * fade` into the proxy and tag the vertices for update. */
+static void sculpt_brush_batch_apply_proxy(const SculptBrushBatch *batch, float (*proxy)[3])
+{
+	int i;
+
+	for (i = 0; i < batch->totvert; i++) {
+		mul_v3_v3fl(proxy[batch->index[i]], batch->val[i], batch->fade[i]);
+	}
+
+	for (i = 0; i < batch->totvert; i++) {
+		if (batch->mvert[i])
+			batch->mvert[i]->flag |= ME_VERT_PBVH_UPDATE;
+	}
+}
+
+/**
+ * Run a batched brush callback over \a nodes,
+ * each thread gets its own #SculptBrushBatchChunk as userdata chunk.
+ */
+static void sculpt_brush_batch_parallel_range(
+        Sculpt *sd, SculptSession *ss, PBVHNode **nodes, const int totnode,
+        void *userdata, TaskParallelRangeFunc func)
+{
+	SculptBrushBatchChunk *chunk;
+	size_t size;
+	int totvert_max = 0;
+	int n;
+
+	for (n = 0; n < totnode; n++) {
+		int uniq_verts;
+		BKE_pbvh_node_num_verts(ss->pbvh, nodes[n], &uniq_verts, NULL);
+		totvert_max = max_ii(totvert_max, uniq_verts);
+	}
+
+	size = sculpt_brush_batch_chunk_size(totvert_max);
+	chunk = MEM_mallocN(size, __func__);
+	chunk->totvert_max = totvert_max;
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = ((sd->flags & SCULPT_USE_OPENMP) && totnode > SCULPT_THREADED_LIMIT);
+	settings.userdata_chunk = chunk;
+	settings.userdata_chunk_size = size;
+	BLI_task_parallel_range(
+	            0, totnode,
+	            userdata,
+	            func,
+	            &settings);
+
+	MEM_freeN(chunk);
+}
+
+/** \} */
+
 /* Test AABB against sphere */
 bool sculpt_search_sphere_cb(PBVHNode *node, void *data_v)
 {
@@ -2062,31 +2320,28 @@ static void do_draw_brush_task_cb_ex(
 	SculptSession *ss = data->ob->sculpt;
 	const Brush *brush = data->brush;
 	const float *offset = data->offset;
+	SculptBrushBatchChunk *chunk = tls->userdata_chunk;
 
-	PBVHVertexIter vd;
+	SculptBrushBatch batch;
 	float (*proxy)[3];
+	int i;
 
 	proxy = BKE_pbvh_node_add_proxy(ss->pbvh, data->nodes[n])->co;
 
 	SculptBrushTest test;
-	SculptBrushTestFn sculpt_brush_test_sq_fn =
-	        sculpt_brush_test_init_with_falloff_shape(ss, &test, data->brush->falloff_shape);
+	sculpt_brush_test_init_with_falloff_shape(ss, &test, data->brush->falloff_shape);
 
-	BKE_pbvh_vertex_iter_begin(ss->pbvh, data->nodes[n], vd, PBVH_ITER_UNIQUE)
-	{
-		if (sculpt_brush_test_sq_fn(&test, vd.co)) {
-			/* offset vertex */
-			const float fade = tex_strength(
-			        ss, brush, vd.co, sqrtf(test.dist),
-			        vd.no, vd.fno, vd.mask ? *vd.mask : 0.0f, tls->thread_id);
-
-			mul_v3_v3fl(proxy[vd.i], offset, fade);
+	sculpt_brush_batch_init(&batch, chunk);
+	sculpt_brush_batch_gather(ss, data->nodes[n], chunk, &batch);
+	sculpt_brush_batch_test(&test, data->brush->falloff_shape, &batch);
+	sculpt_brush_batch_strength(ss, brush, &batch, 1.0f, tls->thread_id);
 
-			if (vd.mvert)
-				vd.mvert->flag |= ME_VERT_PBVH_UPDATE;
-		}
+	/* offset vertex */
+	for (i = 0; i < batch.totvert; i++) {
+		copy_v3_v3(batch.val[i], offset);
 	}
-	BKE_pbvh_vertex_iter_end;
+
+	sculpt_brush_batch_apply_proxy(&batch, proxy);
 }
 
 static void do_draw_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode)
@@ -2107,14 +2362,7 @@ static void do_draw_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode)
 	    .offset = offset,
 	};
 
-	ParallelRangeSettings settings;
-	BLI_parallel_range_settings_defaults(&settings);
-	settings.use_threading = ((sd->flags & SCULPT_USE_OPENMP) && totnode > SCULPT_THREADED_LIMIT);
-	BLI_task_parallel_range(
-	            0, totnode,
-	            &data,
-	            do_draw_brush_task_cb_ex,
-	            &settings);
+	sculpt_brush_batch_parallel_range(sd, ss, nodes, totnode, &data, do_draw_brush_task_cb_ex);
 }
 
 /**
@@ -2762,56 +3010,44 @@ static void do_inflate_brush_task_cb_ex(
 	SculptThreadedTaskData *data = userdata;
 	SculptSession *ss = data->ob->sculpt;
 	const Brush *brush = data->brush;
+	SculptBrushBatchChunk *chunk = tls->userdata_chunk;
 
-	PBVHVertexIter vd;
+	SculptBrushBatch batch;
 	float (*proxy)[3];
 	const float bstrength = ss->cache->bstrength;
+	int i;
 
 	proxy = BKE_pbvh_node_add_proxy(ss->pbvh, data->nodes[n])->co;
 
 	SculptBrushTest test;
-	SculptBrushTestFn sculpt_brush_test_sq_fn =
-	        sculpt_brush_test_init_with_falloff_shape(ss, &test, data->brush->falloff_shape);
+	sculpt_brush_test_init_with_falloff_shape(ss, &test, data->brush->falloff_shape);
 
-	BKE_pbvh_vertex_iter_begin(ss->pbvh, data->nodes[n], vd, PBVH_ITER_UNIQUE)
-	{
-		if (sculpt_brush_test_sq_fn(&test, vd.co)) {
-			const float fade = bstrength * tex_strength(
-			        ss, brush, vd.co, sqrtf(test.dist),
-			        vd.no, vd.fno, vd.mask ? *vd.mask : 0.0f, tls->thread_id);
-			float val[3];
+	sculpt_brush_batch_init(&batch, chunk);
+	sculpt_brush_batch_gather(ss, data->nodes[n], chunk, &batch);
+	sculpt_brush_batch_test(&test, data->brush->falloff_shape, &batch);
+	sculpt_brush_batch_strength(ss, brush, &batch, bstrength, tls->thread_id);
 
-			if (vd.fno)
-				copy_v3_v3(val, vd.fno);
-			else
-				normal_short_to_float_v3(val, vd.no);
+	for (i = 0; i < batch.totvert; i++) {
+		float val[3];
 
-			mul_v3_fl(val, fade * ss->cache->radius);
-			mul_v3_v3v3(proxy[vd.i], val, ss->cache->scale);
+		mul_v3_v3fl(val, batch.no[i], batch.fade[i] * ss->cache->radius);
+		mul_v3_v3v3(proxy[batch.index[i]], val, ss->cache->scale);
 
-			if (vd.mvert)
-				vd.mvert->flag |= ME_VERT_PBVH_UPDATE;
-		}
+		if (batch.mvert[i])
+			batch.mvert[i]->flag |= ME_VERT_PBVH_UPDATE;
 	}
-	BKE_pbvh_vertex_iter_end;
 }
 
 static void do_inflate_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode)
 {
+	SculptSession *ss = ob->sculpt;
 	Brush *brush = BKE_paint_brush(&sd->paint);
 
 	SculptThreadedTaskData data = {
 	    .sd = sd, .ob = ob, .brush = brush, .nodes = nodes,
 	};
 
-	ParallelRangeSettings settings;
-	BLI_parallel_range_settings_defaults(&settings);
-	settings.use_threading = ((sd->flags & SCULPT_USE_OPENMP) && totnode > SCULPT_THREADED_LIMIT);
-	BLI_task_parallel_range(
-	            0, totnode,
-	            &data,
-	            do_inflate_brush_task_cb_ex,
-	            &settings);
+	sculpt_brush_batch_parallel_range(sd, ss, nodes, totnode, &data, do_inflate_brush_task_cb_ex);
 }
 
 static void calc_sculpt_plane(
@@ -2906,71 +3142,116 @@ static bool plane_point_side_flip(
 	return d <= 0.0f;
 }
 
-static int plane_point_side(const float co[3], const float plane[4])
-{
-	float d = plane_point_side_v3(plane, co);
-	return d <= 0.0f;
-}
+/* Which side of the tool plane is affected by a batched plane brush. */
+typedef enum eSculptBatchPlaneSide {
+	SCULPT_BATCH_PLANE_ANY = 0,
+	/* Same as #plane_point_side_flip without flip. */
+	SCULPT_BATCH_PLANE_BELOW,
+	/* Same as #plane_point_side_flip with flip. */
+	SCULPT_BATCH_PLANE_BELOW_FLIP,
+	SCULPT_BATCH_PLANE_ABOVE,
+} eSculptBatchPlaneSide;
 
-static float get_offset(Sculpt *sd, SculptSession *ss)
+/**
+ * Store the offset to the tool plane in #SculptBrushBatch.val,
+ * removing vertices on the unaffected side or outside the plane trim.
+ */
+static void sculpt_brush_batch_plane_offset(
+        const StrokeCache *cache, const Brush *brush, SculptBrushBatch *batch,
+        const float plane[4], const eSculptBatchPlaneSide side)
 {
-	Brush *brush = BKE_paint_brush(&sd->paint);
+	const int totvert = batch->totvert;
+	int i, j;
 
-	float rv = brush->plane_offset;
+	for (i = 0; i < totvert; i++) {
+		const float d = plane_point_side_v3(plane, batch->co[i]);
+		float intr[3];
 
-	if (brush->flag & BRUSH_OFFSET_PRESSURE) {
-		rv *= ss->cache->pressure;
+		/* same as #closest_to_plane_normalized_v3 */
+		madd_v3_v3v3fl(intr, batch->co[i], plane, -d);
+		sub_v3_v3v3(batch->val[i], intr, batch->co[i]);
+		/* fade is only computed later, use it to keep the plane side */
+		batch->fade[i] = d;
 	}
 
-	return rv;
+	for (i = 0, j = 0; i < totvert; i++) {
+		const float d = batch->fade[i];
+		bool keep;
+
+		switch (side) {
+			case SCULPT_BATCH_PLANE_BELOW:
+				keep = (d <= 0.0f);
+				break;
+			case SCULPT_BATCH_PLANE_BELOW_FLIP:
+				keep = (-d <= 0.0f);
+				break;
+			case SCULPT_BATCH_PLANE_ABOVE:
+				keep = !(d <= 0.0f);
+				break;
+			default:
+				keep = true;
+				break;
+		}
+
+		if (keep && plane_trim(cache, brush, batch->val[i])) {
+			if (i != j) {
+				sculpt_brush_batch_move(batch, j, i);
+			}
+			j++;
+		}
+	}
+	batch->totvert = j;
 }
 
-static void do_flatten_brush_task_cb_ex(
-        void *__restrict userdata,
-        const int n,
-        const ParallelRangeTLS *__restrict tls)
+/* Shared task callback of the flatten, clay, fill and scrape brushes. */
+static void do_plane_brush_batch_task(
+        SculptThreadedTaskData *data, const int n, const ParallelRangeTLS *__restrict tls,
+        const eSculptBatchPlaneSide side, const float bstrength)
 {
-	SculptThreadedTaskData *data = userdata;
 	SculptSession *ss = data->ob->sculpt;
 	const Brush *brush = data->brush;
-	const float *area_no = data->area_no;
-	const float *area_co = data->area_co;
+	SculptBrushBatchChunk *chunk = tls->userdata_chunk;
 
-	PBVHVertexIter vd;
+	SculptBrushBatch batch;
 	float (*proxy)[3];
-	const float bstrength = ss->cache->bstrength;
 
 	proxy = BKE_pbvh_node_add_proxy(ss->pbvh, data->nodes[n])->co;
 
 	SculptBrushTest test;
-	SculptBrushTestFn sculpt_brush_test_sq_fn =
-	        sculpt_brush_test_init_with_falloff_shape(ss, &test, data->brush->falloff_shape);
+	sculpt_brush_test_init_with_falloff_shape(ss, &test, data->brush->falloff_shape);
 
-	plane_from_point_normal_v3(test.plane_tool, area_co, area_no);
+	plane_from_point_normal_v3(test.plane_tool, data->area_co, data->area_no);
 
-	BKE_pbvh_vertex_iter_begin(ss->pbvh, data->nodes[n], vd, PBVH_ITER_UNIQUE)
-	{
-		if (sculpt_brush_test_sq_fn(&test, vd.co)) {
-			float intr[3];
-			float val[3];
+	sculpt_brush_batch_init(&batch, chunk);
+	sculpt_brush_batch_gather(ss, data->nodes[n], chunk, &batch);
+	sculpt_brush_batch_test(&test, data->brush->falloff_shape, &batch);
+	sculpt_brush_batch_plane_offset(ss->cache, brush, &batch, test.plane_tool, side);
+	sculpt_brush_batch_strength(ss, brush, &batch, bstrength, tls->thread_id);
+	sculpt_brush_batch_apply_proxy(&batch, proxy);
+}
 
-			closest_to_plane_normalized_v3(intr, test.plane_tool, vd.co);
+static float get_offset(Sculpt *sd, SculptSession *ss)
+{
+	Brush *brush = BKE_paint_brush(&sd->paint);
+
+	float rv = brush->plane_offset;
 
-			sub_v3_v3v3(val, intr, vd.co);
+	if (brush->flag & BRUSH_OFFSET_PRESSURE) {
+		rv *= ss->cache->pressure;
+	}
 
-			if (plane_trim(ss->cache, brush, val)) {
-				const float fade = bstrength * tex_strength(
-				        ss, brush, vd.co, sqrtf(test.dist),
-				        vd.no, vd.fno, vd.mask ? *vd.mask : 0.0f, tls->thread_id);
+	return rv;
+}
 
-				mul_v3_v3fl(proxy[vd.i], val, fade);
+static void do_flatten_brush_task_cb_ex(
+        void *__restrict userdata,
+        const int n,
+        const ParallelRangeTLS *__restrict tls)
+{
+	SculptThreadedTaskData *data = userdata;
+	SculptSession *ss = data->ob->sculpt;
 
-				if (vd.mvert)
-					vd.mvert->flag |= ME_VERT_PBVH_UPDATE;
-			}
-		}
-	}
-	BKE_pbvh_vertex_iter_end;
+	do_plane_brush_batch_task(data, n, tls, SCULPT_BATCH_PLANE_ANY, ss->cache->bstrength);
 }
 
 static void do_flatten_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode)
@@ -3000,14 +3281,7 @@ static void do_flatten_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totno
 	    .area_no = area_no, .area_co = area_co,
 	};
 
-	ParallelRangeSettings settings;
-	BLI_parallel_range_settings_defaults(&settings);
-	settings.use_threading = ((sd->flags & SCULPT_USE_OPENMP) && totnode > SCULPT_THREADED_LIMIT);
-	BLI_task_parallel_range(
-	            0, totnode,
-	            &data,
-	            do_flatten_brush_task_cb_ex,
-	            &settings);
+	sculpt_brush_batch_parallel_range(sd, ss, nodes, totnode, &data, do_flatten_brush_task_cb_ex);
 }
 
 static void do_clay_brush_task_cb_ex(
@@ -3017,50 +3291,13 @@ static void do_clay_brush_task_cb_ex(
 {
 	SculptThreadedTaskData *data = userdata;
 	SculptSession *ss = data->ob->sculpt;
-	const Brush *brush = data->brush;
-	const float *area_no = data->area_no;
-	const float *area_co = data->area_co;
-
-	PBVHVertexIter vd;
-	float (*proxy)[3];
 	const bool flip = (ss->cache->bstrength < 0);
 	const float bstrength = flip ? -ss->cache->bstrength : ss->cache->bstrength;
 
-	proxy = BKE_pbvh_node_add_proxy(ss->pbvh, data->nodes[n])->co;
-
-	SculptBrushTest test;
-	SculptBrushTestFn sculpt_brush_test_sq_fn =
-	        sculpt_brush_test_init_with_falloff_shape(ss, &test, data->brush->falloff_shape);
-
-	plane_from_point_normal_v3(test.plane_tool, area_co, area_no);
-
-	BKE_pbvh_vertex_iter_begin(ss->pbvh, data->nodes[n], vd, PBVH_ITER_UNIQUE)
-	{
-		if (sculpt_brush_test_sq_fn(&test, vd.co)) {
-			if (plane_point_side_flip(vd.co, test.plane_tool, flip)) {
-				float intr[3];
-				float val[3];
-
-				closest_to_plane_normalized_v3(intr, test.plane_tool, vd.co);
-
-				sub_v3_v3v3(val, intr, vd.co);
-
-				if (plane_trim(ss->cache, brush, val)) {
-					/* note, the normal from the vertices is ignored,
-					 * causes glitch with planes, see: T44390 */
-					const float fade = bstrength * tex_strength(
-					        ss, brush, vd.co, sqrtf(test.dist),
-					        vd.no, vd.fno, vd.mask ? *vd.mask : 0.0f, tls->thread_id);
-
-					mul_v3_v3fl(proxy[vd.i], val, fade);
-
-					if (vd.mvert)
-						vd.mvert->flag |= ME_VERT_PBVH_UPDATE;
-				}
-			}
-		}
-	}
-	BKE_pbvh_vertex_iter_end;
+	/* note, the normal from the vertices is ignored,
+	 * causes glitch with planes, see: T44390 */
+	do_plane_brush_batch_task(
+	        data, n, tls, flip ? SCULPT_BATCH_PLANE_BELOW_FLIP : SCULPT_BATCH_PLANE_BELOW, bstrength);
 }
 
 static void do_clay_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode)
@@ -3093,14 +3330,7 @@ static void do_clay_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode)
 	    .area_no = area_no, .area_co = area_co,
 	};
 
-	ParallelRangeSettings settings;
-	BLI_parallel_range_settings_defaults(&settings);
-	settings.use_threading = ((sd->flags & SCULPT_USE_OPENMP) && totnode > SCULPT_THREADED_LIMIT);
-	BLI_task_parallel_range(
-	            0, totnode,
-	            &data,
-	            do_clay_brush_task_cb_ex,
-	            &settings);
+	sculpt_brush_batch_parallel_range(sd, ss, nodes, totnode, &data, do_clay_brush_task_cb_ex);
 }
 
 static void do_clay_strips_brush_task_cb_ex(
@@ -3227,47 +3457,8 @@ static void do_fill_brush_task_cb_ex(
 {
 	SculptThreadedTaskData *data = userdata;
 	SculptSession *ss = data->ob->sculpt;
-	const Brush *brush = data->brush;
-	const float *area_no = data->area_no;
-	const float *area_co = data->area_co;
-
-	PBVHVertexIter vd;
-	float (*proxy)[3];
-	const float bstrength = ss->cache->bstrength;
-
-	proxy = BKE_pbvh_node_add_proxy(ss->pbvh, data->nodes[n])->co;
-
-	SculptBrushTest test;
-	SculptBrushTestFn sculpt_brush_test_sq_fn =
-	        sculpt_brush_test_init_with_falloff_shape(ss, &test, data->brush->falloff_shape);
-
-	plane_from_point_normal_v3(test.plane_tool, area_co, area_no);
-
-	BKE_pbvh_vertex_iter_begin(ss->pbvh, data->nodes[n], vd, PBVH_ITER_UNIQUE)
-	{
-		if (sculpt_brush_test_sq_fn(&test, vd.co)) {
-			if (plane_point_side(vd.co, test.plane_tool)) {
-				float intr[3];
-				float val[3];
-
-				closest_to_plane_normalized_v3(intr, test.plane_tool, vd.co);
-
-				sub_v3_v3v3(val, intr, vd.co);
 
-				if (plane_trim(ss->cache, brush, val)) {
-					const float fade = bstrength * tex_strength(
-					        ss, brush, vd.co, sqrtf(test.dist),
-					        vd.no, vd.fno, vd.mask ? *vd.mask : 0.0f, tls->thread_id);
-
-					mul_v3_v3fl(proxy[vd.i], val, fade);
-
-					if (vd.mvert)
-						vd.mvert->flag |= ME_VERT_PBVH_UPDATE;
-				}
-			}
-		}
-	}
-	BKE_pbvh_vertex_iter_end;
+	do_plane_brush_batch_task(data, n, tls, SCULPT_BATCH_PLANE_BELOW, ss->cache->bstrength);
 }
 
 static void do_fill_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode)
@@ -3298,14 +3489,7 @@ static void do_fill_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode)
 	    .area_no = area_no, .area_co = area_co,
 	};
 
-	ParallelRangeSettings settings;
-	BLI_parallel_range_settings_defaults(&settings);
-	settings.use_threading = ((sd->flags & SCULPT_USE_OPENMP) && totnode > SCULPT_THREADED_LIMIT);
-	BLI_task_parallel_range(
-	            0, totnode,
-	            &data,
-	            do_fill_brush_task_cb_ex,
-	            &settings);
+	sculpt_brush_batch_parallel_range(sd, ss, nodes, totnode, &data, do_fill_brush_task_cb_ex);
 }
 
 static void do_scrape_brush_task_cb_ex(
@@ -3315,46 +3499,8 @@ static void do_scrape_brush_task_cb_ex(
 {
 	SculptThreadedTaskData *data = userdata;
 	SculptSession *ss = data->ob->sculpt;
-	const Brush *brush = data->brush;
-	const float *area_no = data->area_no;
-	const float *area_co = data->area_co;
-
-	PBVHVertexIter vd;
-	float (*proxy)[3];
-	const float bstrength = ss->cache->bstrength;
-
-	proxy = BKE_pbvh_node_add_proxy(ss->pbvh, data->nodes[n])->co;
-
-	SculptBrushTest test;
-	SculptBrushTestFn sculpt_brush_test_sq_fn =
-	        sculpt_brush_test_init_with_falloff_shape(ss, &test, data->brush->falloff_shape);
-	plane_from_point_normal_v3(test.plane_tool, area_co, area_no);
 
-	BKE_pbvh_vertex_iter_begin(ss->pbvh, data->nodes[n], vd, PBVH_ITER_UNIQUE)
-	{
-		if (sculpt_brush_test_sq_fn(&test, vd.co)) {
-			if (!plane_point_side(vd.co, test.plane_tool)) {
-				float intr[3];
-				float val[3];
-
-				closest_to_plane_normalized_v3(intr, test.plane_tool, vd.co);
-
-				sub_v3_v3v3(val, intr, vd.co);
-
-				if (plane_trim(ss->cache, brush, val)) {
-					const float fade = bstrength * tex_strength(
-					        ss, brush, vd.co, sqrtf(test.dist),
-					        vd.no, vd.fno, vd.mask ? *vd.mask : 0.0f, tls->thread_id);
-
-					mul_v3_v3fl(proxy[vd.i], val, fade);
-
-					if (vd.mvert)
-						vd.mvert->flag |= ME_VERT_PBVH_UPDATE;
-				}
-			}
-		}
-	}
-	BKE_pbvh_vertex_iter_end;
+	do_plane_brush_batch_task(data, n, tls, SCULPT_BATCH_PLANE_ABOVE, ss->cache->bstrength);
 }
 
 static void do_scrape_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode)
@@ -3385,14 +3531,7 @@ static void do_scrape_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnod
 	    .area_no = area_no, .area_co = area_co,
 	};
 
-	ParallelRangeSettings settings;
-	BLI_parallel_range_settings_defaults(&settings);
-	settings.use_threading = ((sd->flags & SCULPT_USE_OPENMP) && totnode > SCULPT_THREADED_LIMIT);
-	BLI_task_parallel_range(
-	            0, totnode,
-	            &data,
-	            do_scrape_brush_task_cb_ex,
-	            &settings);
+	sculpt_brush_batch_parallel_range(sd, ss, nodes, totnode, &data, do_scrape_brush_task_cb_ex);
 }
 
 static void do_gravity_task_cb_ex(
@@ -123,6 +123,9 @@ typedef struct SculptUndoNode {
 	/* shape keys */
 	char shapeName[sizeof(((KeyBlock *)0))->name];
 
+	/* compressed 'co' or 'mask', see #USER_UNDO_SCULPT_PACK */
+	struct SculptUndoPacked *packed;
+
 	size_t undo_size;
 } SculptUndoNode;
 
@@ -33,14 +33,21 @@
  */
 
 #include <stddef.h>
+#include <limits.h>
+
+#include "zlib.h"
 
 #include "MEM_guardedalloc.h"
 
+#include "CLG_log.h"
+
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
 #include "BLI_string.h"
 #include "BLI_listbase.h"
 #include "BLI_ghash.h"
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
 #include "BLI_task.h"
 #include "BLI_threads.h"
 
@@ -50,13 +57,16 @@
 #include "DNA_mesh_types.h"
 #include "DNA_screen_types.h"
 #include "DNA_space_types.h"
+#include "DNA_userdef_types.h"
 
+#include "BKE_appdir.h"
 #include "BKE_ccg.h"
 #include "BKE_context.h"
 #include "BKE_depsgraph.h"
 #include "BKE_multires.h"
 #include "BKE_paint.h"
 #include "BKE_key.h"
+#include "BKE_report.h"
 #include "BKE_mesh.h"
 #include "BKE_subsurf.h"
 #include "BKE_undo_system.h"
@@ -75,14 +85,470 @@
 #include "paint_intern.h"
 #include "sculpt_intern.h"
 
+static CLG_LogRef LOG = {"ed.sculpt.undo"};
 
 typedef struct UndoSculpt {
 	ListBase nodes;
 
+	/* only during push, not valid afterwards! */
+	PBVH *pbvh;
+
 	size_t undo_size;
 } UndoSculpt;
 
 static UndoSculpt *sculpt_undo_get_nodes(void);
+static UndoSculpt *sculpt_undosys_step_get_nodes(UndoStep *us_p);
+
+/* -------------------------------------------------------------------- */
+/** \name Packed Undo Nodes
+ *
+ * With #USER_UNDO_SCULPT_PACK coordinates and masks of an undo node are stored as the
+ * difference of their values after and before the stroke, compressed in a background task.
+ * Untouched vertices have a zero difference, so it compresses well.
+ *
+ * Undo reconstructs the stored values by subtracting the difference from the current mesh,
+ * redo by adding it, so the packed data never has to be updated. The difference is arithmetic
+ * rather than bitwise, multi-resolution grids are regenerated from their displacements and
+ * don't necessarily match the values at the end of the stroke exactly.
+ *
+ * Once packed data exceeds #UserDef.sculpt_undo_memory, older steps are moved to temporary files,
+ * one per undo step, deleted together with the step. Files are only open while they're written
+ * or read, so a long undo history doesn't run into the limit of open files.
+ * \{ */
+
+typedef struct SculptUndoSpillFile {
+	char filepath[FILE_MAX];
+	long size;
+	/* number of packed nodes stored in the file, it's deleted when this reaches zero */
+	int users;
+} SculptUndoSpillFile;
+
+typedef struct SculptUndoPacked {
+	void *data;          /* compressed difference, NULL when moved to the spill file */
+	size_t size;         /* size of 'data' */
+	size_t raw_size;     /* size of the difference before compression */
+	SculptUndoSpillFile *spill;  /* file holding 'data' when moved out of memory */
+	long file_offset;    /* location in the spill file, -1 while in memory */
+	bool is_compressed;
+	bool is_applied;     /* the mesh currently has the stroke applied (not undone) */
+} SculptUndoPacked;
+
+static struct {
+	TaskPool *task_pool;
+	/* number of packed nodes, the task pool is freed when this reaches zero */
+	int users;
+	/* for unique spill file names */
+	unsigned int spill_file_count;
+} sculpt_undo_pack = {NULL};
+
+static bool sculpt_undo_pack_node_supported(const SculptUndoNode *unode)
+{
+	/* deformed and shape key coordinates are restored through other arrays, keep those as is */
+	return (unode->node &&
+	        (unode->bm_entry == NULL) &&
+	        (unode->orig_co == NULL) &&
+	        (unode->shapeName[0] == '\0') &&
+	        ((unode->type == SCULPT_UNDO_COORDS && unode->co) ||
+	         (unode->type == SCULPT_UNDO_MASK && unode->mask)));
+}
+
+/* number of elements restored from 'co' or 'mask' */
+static int sculpt_undo_pack_totelem(const SculptUndoNode *unode)
+{
+	return unode->maxgrid ? unode->totgrid * unode->gridsize * unode->gridsize : unode->totvert;
+}
+
+static void **sculpt_undo_pack_raw_ptr(SculptUndoNode *unode, size_t *r_size)
+{
+	const int totelem = sculpt_undo_pack_totelem(unode);
+
+	if (unode->type == SCULPT_UNDO_COORDS) {
+		*r_size = sizeof(*unode->co) * (size_t)totelem;
+		return (void **)&unode->co;
+	}
+	else {
+		*r_size = sizeof(*unode->mask) * (size_t)totelem;
+		return (void **)&unode->mask;
+	}
+}
+
+/* Replace the stored values by their difference to the current state of the PBVH node
+ * (right after the stroke). */
+static void sculpt_undo_pack_delta_pbvh(PBVH *pbvh, SculptUndoNode *unode)
+{
+	const int totelem = sculpt_undo_pack_totelem(unode);
+	PBVHVertexIter vd;
+
+	BKE_pbvh_vertex_iter_begin(pbvh, unode->node, vd, PBVH_ITER_ALL)
+	{
+		if (vd.i < totelem) {
+			if (unode->type == SCULPT_UNDO_COORDS) {
+				sub_v3_v3v3(unode->co[vd.i], vd.co, unode->co[vd.i]);
+			}
+			else {
+				unode->mask[vd.i] = vd.mask ? *vd.mask - unode->mask[vd.i] : 0.0f;
+			}
+		}
+	}
+	BKE_pbvh_vertex_iter_end;
+}
+
+/* Turn the difference back into stored values relative to the current mesh,
+ * using the same elements as restoring does. */
+static void sculpt_undo_pack_delta_restore(SculptSession *ss, DerivedMesh *dm, SculptUndoNode *unode)
+{
+	/* going back to the state before the stroke subtracts the difference */
+	const float fac = unode->packed->is_applied ? -1.0f : 1.0f;
+
+	if (unode->maxvert) {
+		const int *index = unode->index;
+		int i;
+
+		if (unode->type == SCULPT_UNDO_COORDS) {
+			for (i = 0; i < unode->totvert; i++) {
+				madd_v3_v3v3fl(unode->co[i], ss->mvert[index[i]].co, unode->co[i], fac);
+			}
+		}
+		else {
+			for (i = 0; i < unode->totvert; i++) {
+				unode->mask[i] = ss->vmask[index[i]] + unode->mask[i] * fac;
+			}
+		}
+	}
+	else {
+		CCGElem **grids = dm->getGridData(dm);
+		const int gridarea = unode->gridsize * unode->gridsize;
+		CCGKey key;
+		int i, j, k = 0;
+
+		dm->getGridKey(dm, &key);
+
+		for (j = 0; j < unode->totgrid; j++) {
+			CCGElem *grid = grids[unode->grids[j]];
+
+			if (unode->type == SCULPT_UNDO_COORDS) {
+				for (i = 0; i < gridarea; i++, k++) {
+					madd_v3_v3v3fl(unode->co[k], CCG_elem_offset_co(&key, grid, i), unode->co[k], fac);
+				}
+			}
+			else {
+				for (i = 0; i < gridarea; i++, k++) {
+					unode->mask[k] = *CCG_elem_offset_mask(&key, grid, i) + unode->mask[k] * fac;
+				}
+			}
+		}
+	}
+}
+
+static void sculpt_undo_pack_node_task_cb(TaskPool *__restrict UNUSED(pool), void *taskdata, int UNUSED(threadid))
+{
+	SculptUndoNode *unode = taskdata;
+	SculptUndoPacked *packed = unode->packed;
+	size_t raw_size;
+	void **raw_p = sculpt_undo_pack_raw_ptr(unode, &raw_size);
+	uLongf size = compressBound((uLong)raw_size);
+	void *data = MEM_mallocN(size, "SculptUndoPacked.data");
+
+	packed->raw_size = raw_size;
+
+	if (compress2(data, &size, *raw_p, (uLong)raw_size, Z_BEST_SPEED) == Z_OK) {
+		packed->data = MEM_reallocN(data, size);
+		packed->size = size;
+		packed->is_compressed = true;
+		MEM_freeN(*raw_p);
+	}
+	else {
+		/* keep the difference uncompressed */
+		MEM_freeN(data);
+		packed->data = *raw_p;
+		packed->size = raw_size;
+		packed->is_compressed = false;
+	}
+
+	*raw_p = NULL;
+}
+
+static void sculpt_undo_pack_wait(void)
+{
+	if (sculpt_undo_pack.task_pool) {
+		BLI_task_pool_work_and_wait(sculpt_undo_pack.task_pool);
+	}
+}
+
+/**
+ * Turn the stored values of the nodes pushed by this stroke into packed differences.
+ * Must run before the mesh is modified again.
+ */
+static void sculpt_undo_pack_nodes(UndoSculpt *usculpt)
+{
+	SculptUndoNode *unode;
+
+	if (usculpt->pbvh == NULL) {
+		return;
+	}
+
+	for (unode = usculpt->nodes.first; unode; unode = unode->next) {
+		if (!sculpt_undo_pack_node_supported(unode)) {
+			continue;
+		}
+
+		if (sculpt_undo_pack.task_pool == NULL) {
+			TaskScheduler *scheduler = BLI_task_scheduler_get();
+			sculpt_undo_pack.task_pool = BLI_task_pool_create_background(scheduler, NULL);
+		}
+
+		sculpt_undo_pack_delta_pbvh(usculpt->pbvh, unode);
+
+		unode->packed = MEM_callocN(sizeof(*unode->packed), "SculptUndoPacked");
+		unode->packed->file_offset = -1;
+		unode->packed->is_applied = true;
+		sculpt_undo_pack.users += 1;
+
+		BLI_task_pool_push(
+		        sculpt_undo_pack.task_pool,
+		        sculpt_undo_pack_node_task_cb, unode, false, TASK_PRIORITY_LOW);
+	}
+}
+
+/* Creates the (empty) file, returned opened for writing in \a r_file. */
+static SculptUndoSpillFile *sculpt_undo_spill_file_create(FILE **r_file)
+{
+	SculptUndoSpillFile *spill = MEM_callocN(sizeof(*spill), "SculptUndoSpillFile");
+	char filename[64];
+
+	BLI_snprintf(filename, sizeof(filename), "sculpt_undo_%u.bin", sculpt_undo_pack.spill_file_count++);
+	BLI_join_dirfile(spill->filepath, sizeof(spill->filepath), BKE_tempdir_session(), filename);
+	*r_file = BLI_fopen(spill->filepath, "w+b");
+
+	if (*r_file == NULL) {
+		CLOG_WARN(&LOG, "failed to create '%s', keeping undo data in memory", spill->filepath);
+		MEM_freeN(spill);
+		return NULL;
+	}
+
+	return spill;
+}
+
+static void sculpt_undo_spill_file_release(SculptUndoSpillFile *spill)
+{
+	spill->users -= 1;
+	BLI_assert(spill->users >= 0);
+
+	if (spill->users == 0) {
+		BLI_delete(spill->filepath, false, false);
+		MEM_freeN(spill);
+	}
+}
+
+static bool sculpt_undo_pack_spill(SculptUndoSpillFile *spill, FILE *file, SculptUndoPacked *packed)
+{
+	if (packed->size > (size_t)(LONG_MAX - spill->size)) {
+		return false;
+	}
+
+	if ((fseek(file, spill->size, SEEK_SET) != 0) ||
+	    (fwrite(packed->data, 1, packed->size, file) != packed->size))
+	{
+		CLOG_WARN(&LOG, "failed to write to '%s', keeping undo data in memory", spill->filepath);
+		return false;
+	}
+
+	packed->spill = spill;
+	packed->file_offset = spill->size;
+	spill->size += (long)packed->size;
+	spill->users += 1;
+
+	MEM_freeN(packed->data);
+	packed->data = NULL;
+
+	return true;
+}
+
+/**
+ * Move packed data of older sculpt steps to the spill file,
+ * keeping at most #UserDef.sculpt_undo_memory of the newest packed data in memory.
+ */
+static void sculpt_undo_pack_limit_memory(UndoStack *ustack)
+{
+	const size_t memory_limit = (size_t)U.sculpt_undo_memory * 1024 * 1024;
+	size_t memory = 0;
+	bool spill_failed = false;
+	UndoStep *us;
+
+	if (sculpt_undo_pack.users == 0) {
+		return;
+	}
+
+	sculpt_undo_pack_wait();
+
+	for (us = ustack->steps.last; us; us = us->prev) {
+		UndoSculpt *usculpt;
+		SculptUndoNode *unode;
+		SculptUndoSpillFile *spill = NULL;
+		FILE *spill_file = NULL;
+		size_t step_memory = 0;
+		bool has_packed = false;
+
+		if (us->type != BKE_UNDOSYS_TYPE_SCULPT) {
+			continue;
+		}
+
+		usculpt = sculpt_undosys_step_get_nodes(us);
+
+		/* data of one step goes to a single file, so it's deleted with the step */
+		for (unode = usculpt->nodes.first; unode; unode = unode->next) {
+			if (unode->packed && unode->packed->spill) {
+				spill = unode->packed->spill;
+				break;
+			}
+		}
+
+		for (unode = usculpt->nodes.first; unode; unode = unode->next) {
+			SculptUndoPacked *packed = unode->packed;
+
+			if (packed == NULL) {
+				continue;
+			}
+
+			has_packed = true;
+
+			if (packed->data) {
+				if (memory_limit && (memory + packed->size > memory_limit) && !spill_failed) {
+					if (spill == NULL) {
+						spill = sculpt_undo_spill_file_create(&spill_file);
+					}
+					else if (spill_file == NULL) {
+						spill_file = BLI_fopen(spill->filepath, "r+b");
+						if (spill_file == NULL) {
+							CLOG_WARN(&LOG, "failed to open '%s', keeping undo data in memory", spill->filepath);
+						}
+					}
+					if (spill_file && sculpt_undo_pack_spill(spill, spill_file, packed)) {
+						continue;
+					}
+					/* don't retry every node when the disk is full */
+					spill_failed = true;
+				}
+
+				memory += packed->size;
+				step_memory += packed->size;
+			}
+		}
+
+		if (has_packed) {
+			us->data_size = step_memory;
+		}
+
+		if (spill_file) {
+			fclose(spill_file);
+		}
+
+		/* a new file that nothing could be written to */
+		if (spill && spill->users == 0) {
+			spill->users = 1;
+			sculpt_undo_spill_file_release(spill);
+		}
+	}
+}
+
+static void sculpt_undo_pack_free(SculptUndoPacked *packed)
+{
+	if (packed->data) {
+		MEM_freeN(packed->data);
+	}
+	if (packed->spill) {
+		sculpt_undo_spill_file_release(packed->spill);
+	}
+	MEM_freeN(packed);
+
+	sculpt_undo_pack.users -= 1;
+	BLI_assert(sculpt_undo_pack.users >= 0);
+
+	if (sculpt_undo_pack.users == 0) {
+		if (sculpt_undo_pack.task_pool) {
+			BLI_task_pool_free(sculpt_undo_pack.task_pool);
+			sculpt_undo_pack.task_pool = NULL;
+		}
+	}
+}
+
+/**
+ * Reconstruct the stored values of a packed node (undone or redone against the current mesh),
+ * they're released again by #sculpt_undo_unpack_node_release once restored.
+ */
+static bool sculpt_undo_unpack_node(SculptSession *ss, DerivedMesh *dm, SculptUndoNode *unode)
+{
+	SculptUndoPacked *packed = unode->packed;
+	size_t raw_size;
+	void **raw_p = sculpt_undo_pack_raw_ptr(unode, &raw_size);
+	void *data = packed->data;
+	bool ok = true;
+
+	if (raw_size != packed->raw_size) {
+		return false;
+	}
+
+	if (data == NULL) {
+		FILE *file = packed->spill ? BLI_fopen(packed->spill->filepath, "rb") : NULL;
+
+		data = MEM_mallocN(packed->size, __func__);
+		if ((file == NULL) ||
+		    (fseek(file, packed->file_offset, SEEK_SET) != 0) ||
+		    (fread(data, 1, packed->size, file) != packed->size))
+		{
+			CLOG_WARN(&LOG, "failed to read undo data from '%s'", packed->spill ? packed->spill->filepath : "");
+			ok = false;
+		}
+
+		if (file) {
+			fclose(file);
+		}
+	}
+
+	if (ok) {
+		*raw_p = MEM_mapallocN(raw_size, __func__);
+
+		if (packed->is_compressed) {
+			uLongf size = (uLongf)raw_size;
+			ok = (uncompress(*raw_p, &size, data, (uLong)packed->size) == Z_OK) && (size == raw_size);
+		}
+		else {
+			memcpy(*raw_p, data, raw_size);
+		}
+
+		if (ok) {
+			sculpt_undo_pack_delta_restore(ss, dm, unode);
+		}
+		else {
+			MEM_freeN(*raw_p);
+			*raw_p = NULL;
+		}
+	}
+
+	if (data != packed->data) {
+		MEM_freeN(data);
+	}
+
+	return ok;
+}
+
+static void sculpt_undo_unpack_node_release(SculptUndoNode *unode, bool restored)
+{
+	size_t raw_size;
+	void **raw_p = sculpt_undo_pack_raw_ptr(unode, &raw_size);
+
+	if (*raw_p) {
+		MEM_freeN(*raw_p);
+		*raw_p = NULL;
+
+		/* the mesh moved to the other side of the stroke */
+		if (restored) {
+			unode->packed->is_applied = !unode->packed->is_applied;
+		}
+	}
+}
+
+/** \} */
 
 static void update_cb(PBVHNode *node, void *rebuild)
 {
@@ -467,6 +933,53 @@ static int sculpt_undo_bmesh_restore(bContext *C,
 	return false;
 }
 
+/* check if undo data matches current data well enough to continue */
+static bool sculpt_undo_node_matches(Object *ob, SculptSession *ss, DerivedMesh *dm, SculptUndoNode *unode)
+{
+	if (!STREQ(unode->idname, ob->id.name))
+		return false;
+
+	if (unode->maxvert) {
+		if (ss->totvert != unode->maxvert)
+			return false;
+	}
+	else if (unode->maxgrid && dm->getGridData) {
+		if ((dm->getNumGrids(dm) != unode->maxgrid) ||
+		    (dm->getGridSize(dm) != unode->gridsize))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Read the packed data of all nodes which are restored, so a step is either
+ * restored completely or not at all when reading fails.
+ */
+static bool sculpt_undo_unpack_list(Object *ob, SculptSession *ss, DerivedMesh *dm, ListBase *lb)
+{
+	SculptUndoNode *unode;
+
+	for (unode = lb->first; unode; unode = unode->next) {
+		if (unode->packed && (unode->maxvert || dm->getGridData) &&
+		    sculpt_undo_node_matches(ob, ss, dm, unode))
+		{
+			if (!sculpt_undo_unpack_node(ss, dm, unode)) {
+				for (unode = lb->first; unode; unode = unode->next) {
+					if (unode->packed) {
+						sculpt_undo_unpack_node_release(unode, false);
+					}
+				}
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
 static void sculpt_undo_restore_list(bContext *C, ListBase *lb)
 {
 	Scene *scene = CTX_data_scene(C);
@@ -498,23 +1011,18 @@ static void sculpt_undo_restore_list(bContext *C, ListBase *lb)
 	if (lb->first && sculpt_undo_bmesh_restore(C, lb->first, ob, ss))
 		return;
 
+	if (!sculpt_undo_unpack_list(ob, ss, dm, lb)) {
+		BKE_report(CTX_wm_reports(C), RPT_ERROR, "Failed to read sculpt undo data, the step was not restored");
+		return;
+	}
+
 	for (unode = lb->first; unode; unode = unode->next) {
-		if (!STREQ(unode->idname, ob->id.name))
-			continue;
+		bool restored = false;
 
-		/* check if undo data matches current data well enough to
-		 * continue */
-		if (unode->maxvert) {
-			if (ss->totvert != unode->maxvert)
-				continue;
-		}
-		else if (unode->maxgrid && dm->getGridData) {
-			if ((dm->getNumGrids(dm) != unode->maxgrid) ||
-			    (dm->getGridSize(dm) != unode->gridsize))
-			{
-				continue;
-			}
+		if (!sculpt_undo_node_matches(ob, ss, dm, unode))
+			continue;
 
+		if (!unode->maxvert && unode->maxgrid && dm->getGridData) {
 			/* multi-res can't do partial updates since it doesn't flag edited vertices */
 			partial_update = false;
 		}
@@ -522,7 +1030,7 @@ static void sculpt_undo_restore_list(bContext *C, ListBase *lb)
 		switch (unode->type) {
 			case SCULPT_UNDO_COORDS:
 				if (sculpt_undo_restore_coords(C, dm, unode))
-					update = true;
+					update = restored = true;
 				break;
 			case SCULPT_UNDO_HIDDEN:
 				if (sculpt_undo_restore_hidden(C, dm, unode))
@@ -530,7 +1038,7 @@ static void sculpt_undo_restore_list(bContext *C, ListBase *lb)
 				break;
 			case SCULPT_UNDO_MASK:
 				if (sculpt_undo_restore_mask(C, dm, unode))
-					update = true;
+					update = restored = true;
 				break;
 
 			case SCULPT_UNDO_DYNTOPO_BEGIN:
@@ -539,6 +1047,10 @@ static void sculpt_undo_restore_list(bContext *C, ListBase *lb)
 				BLI_assert(!"Dynamic topology should've already been handled");
 				break;
 		}
+
+		if (unode->packed) {
+			sculpt_undo_unpack_node_release(unode, restored);
+		}
 	}
 
 	if (update || rebuild) {
@@ -613,6 +1125,8 @@ static void sculpt_undo_free_list(ListBase *lb)
 		}
 		if (unode->mask)
 			MEM_freeN(unode->mask);
+		if (unode->packed)
+			sculpt_undo_pack_free(unode->packed);
 
 		if (unode->bm_entry) {
 			BM_log_entry_drop(unode->bm_entry);
@@ -701,6 +1215,8 @@ static SculptUndoNode *sculpt_undo_alloc_node(
 	unode->type = type;
 	unode->node = node;
 
+	usculpt->pbvh = ss->pbvh;
+
 	if (node) {
 		BKE_pbvh_node_num_verts(ss->pbvh, node, &totvert, &allvert);
 		BKE_pbvh_node_get_grids(ss->pbvh, node, &grids, &totgrid,
@@ -998,6 +1514,14 @@ void sculpt_undo_push_end(void)
 	}
 
 	UndoStack *ustack = ED_undo_stack_get();
+
+	if (U.undo_flag & USER_UNDO_SCULPT_PACK) {
+		/* previous steps finished packing while this stroke was made */
+		sculpt_undo_pack_limit_memory(ustack);
+		sculpt_undo_pack_nodes(usculpt);
+	}
+	usculpt->pbvh = NULL;
+
 	BKE_undosys_step_push(ustack, NULL, NULL);
 }
 
@@ -1046,12 +1570,14 @@ static void sculpt_undosys_step_decode(struct bContext *C, UndoStep *us_p, int U
 	BLI_assert(sculpt_undosys_poll(C));
 
 	SculptUndoStep *us = (SculptUndoStep *)us_p;
+	sculpt_undo_pack_wait();
 	sculpt_undo_restore_list(C, &us->data.nodes);
 }
 
 static void sculpt_undosys_step_free(UndoStep *us_p)
 {
 	SculptUndoStep *us = (SculptUndoStep *)us_p;
+	sculpt_undo_pack_wait();
 	sculpt_undo_free_list(&us->data.nodes);
 }
 
@@ -950,12 +950,25 @@ ImBuf *sequencer_ibuf_get(struct Main *bmain, Scene *scene, SpaceSeq *sseq, int
 	 */
 	G.is_break = false;
 
-	if (special_seq_update)
-		ibuf = BKE_sequencer_give_ibuf_direct(&context, cfra + frame_ofs, special_seq_update);
-	else if (!U.prefetchframes) // XXX || (G.f & G_PLAYANIM) == 0) {
+	/* frames are only rendered ahead during playback, any other redraw
+	 * is likely caused by editing which would invalidate them anyway */
+	if (U.prefetchframes && !special_seq_update && ED_screen_animation_playing(bmain->wm.first)) {
+		BKE_sequencer_prefetch_lock();
 		ibuf = BKE_sequencer_give_ibuf(&context, cfra + frame_ofs, sseq->chanshown);
-	else
-		ibuf = BKE_sequencer_give_ibuf_threaded(&context, cfra + frame_ofs, sseq->chanshown);
+		BKE_sequencer_prefetch_unlock();
+
+		BKE_sequencer_prefetch_start(&context, cfra + frame_ofs, sseq->chanshown);
+	}
+	else {
+		BKE_sequencer_prefetch_stop();
+
+		BKE_sequencer_prefetch_lock();
+		if (special_seq_update)
+			ibuf = BKE_sequencer_give_ibuf_direct(&context, cfra + frame_ofs, special_seq_update);
+		else
+			ibuf = BKE_sequencer_give_ibuf(&context, cfra + frame_ofs, sseq->chanshown);
+		BKE_sequencer_prefetch_unlock();
+	}
 
 	/* restore state so real rendering would be canceled (if needed) */
 	G.is_break = is_break;
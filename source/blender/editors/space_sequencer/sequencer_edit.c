@@ -151,18 +151,12 @@ static void proxy_freejob(void *pjv)
 static void proxy_startjob(void *pjv, short *stop, short *do_update, float *progress)
 {
 	ProxyJob *pj = pjv;
-	LinkData *link;
-
-	for (link = pj->queue.first; link; link = link->next) {
-		struct SeqIndexBuildContext *context = link->data;
 
-		BKE_sequencer_proxy_rebuild(context, stop, do_update, progress);
+	BKE_sequencer_proxy_rebuild_queue(&pj->queue, stop, do_update, progress);
 
-		if (*stop) {
-			pj->stop = 1;
-			fprintf(stderr,  "Canceling proxy rebuild on users request...\n");
-			break;
-		}
+	if (*stop) {
+		pj->stop = 1;
+		fprintf(stderr,  "Canceling proxy rebuild on users request...\n");
 	}
 }
 
@@ -2082,6 +2076,8 @@ static int sequencer_cut_exec(bContext *C, wmOperator *op)
 
 	bool changed;
 
+	BKE_sequencer_prefetch_stop();
+
 	cut_frame = RNA_int_get(op->ptr, "frame");
 	cut_hard = RNA_enum_get(op->ptr, "type");
 	cut_side = RNA_enum_get(op->ptr, "side");
@@ -2250,6 +2246,9 @@ static int sequencer_delete_exec(bContext *C, wmOperator *UNUSED(op))
 	MetaStack *ms;
 	bool nothing_selected = true;
 
+	/* strips are about to be freed or moved, frames rendered ahead use them */
+	BKE_sequencer_prefetch_stop();
+
 	seq = BKE_sequencer_active_get(scene);
 	if (seq && seq->flag & SELECT) { /* avoid a loop since this is likely to be selected */
 		nothing_selected = false;
@@ -2497,6 +2496,8 @@ static int sequencer_meta_toggle_exec(bContext *C, wmOperator *UNUSED(op))
 	Sequence *last_seq = BKE_sequencer_active_get(scene);
 	MetaStack *ms;
 
+	BKE_sequencer_prefetch_stop();
+
 	if (last_seq && last_seq->type == SEQ_TYPE_META && last_seq->flag & SELECT) {
 		/* Enter Metastrip */
 		ms = MEM_mallocN(sizeof(MetaStack), "metastack");
@@ -2584,6 +2585,8 @@ static int sequencer_meta_make_exec(bContext *C, wmOperator *op)
 	Sequence *seq, *seqm, *next, *last_seq = BKE_sequencer_active_get(scene);
 	int channel_max = 1;
 
+	BKE_sequencer_prefetch_stop();
+
 	if (BKE_sequence_base_isolated_sel_check(ed->seqbasep) == false) {
 		BKE_report(op->reports, RPT_ERROR, "Please select all related strips");
 		return OPERATOR_CANCELLED;
@@ -2659,6 +2662,8 @@ static int sequencer_meta_separate_exec(bContext *C, wmOperator *UNUSED(op))
 
 	Sequence *seq, *last_seq = BKE_sequencer_active_get(scene); /* last_seq checks (ed == NULL) */
 
+	BKE_sequencer_prefetch_stop();
+
 	if (last_seq == NULL || last_seq->type != SEQ_TYPE_META)
 		return OPERATOR_CANCELLED;
 
@@ -61,6 +61,7 @@
 #include "BKE_image.h"
 #include "BKE_key.h"
 #include "BKE_main.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_object.h"
 #include "BKE_global.h"
 #include "BKE_paint.h"
@@ -3985,6 +3986,27 @@ static bool is_cursor_visible(Scene *scene)
 	return true;
 }
 
+/* Statistics of the modifier stack cache, see modifier_cache.c. */
+static void draw_modifier_cache_info(Object *ob, const rcti *rect)
+{
+	const float mem_total = (float)BKE_modifier_cache_mem_in_use() / (1024.0f * 1024.0f);
+	char info[128];
+
+	if (ob && ob->modifier_cache && ob->modifier_cache->steps_total) {
+		const ModifierStackCache *cache = ob->modifier_cache;
+		BLI_snprintf(info, sizeof(info), "Modifier Cache: %d/%d reused, %.1f MiB (%.1f MiB total)",
+		             cache->steps_reused, cache->steps_total,
+		             (float)cache->mem_in_use / (1024.0f * 1024.0f), mem_total);
+	}
+	else {
+		BLI_snprintf(info, sizeof(info), "Modifier Cache: %.1f MiB total", mem_total);
+	}
+
+	UI_ThemeColor(TH_TEXT_HI);
+	BLF_draw_default_ascii(rect->xmin + U.widget_unit, rect->ymax - 3 * U.widget_unit, 0.0f,
+	                       info, sizeof(info));
+}
+
 static void view3d_main_region_draw_info(const bContext *C, Scene *scene,
                                        ARegion *ar, View3D *v3d,
                                        const char *grid_unit, bool render_border)
@@ -4058,6 +4080,10 @@ static void view3d_main_region_draw_info(const bContext *C, Scene *scene,
 			                       rect.ymax - (USER_SHOW_VIEWPORTNAME ? 2 * U.widget_unit : U.widget_unit), 0.0f,
 			                       numstr[0] ? numstr : grid_unit, sizeof(numstr));
 		}
+
+		if (G.debug & G_DEBUG_MODIFIER_CACHE) {
+			draw_modifier_cache_info(OBACT, &rect);
+		}
 	}
 }
 
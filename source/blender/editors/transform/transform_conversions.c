@@ -2475,6 +2475,14 @@ static void VertsToTransData(TransInfo *t, TransData *td, TransDataExtension *tx
 	}
 }
 
+static void freeTransEditVertsPartial(TransInfo *UNUSED(t), TransCustomData *custom_data)
+{
+	if (custom_data->data) {
+		BM_mesh_partial_destroy(custom_data->data);
+		custom_data->data = NULL;
+	}
+}
+
 static void createTransEditVerts(TransInfo *t)
 {
 	TransData *tob = NULL;
@@ -2502,6 +2510,9 @@ static void createTransEditVerts(TransInfo *t)
 	/* Original index of our connected vertex when connected distances are calculated.
 	 * Optional, allocate if needed. */
 	int *dists_index = NULL;
+	/* Vertices moved by transform, used to limit normal and tessellation updates. */
+	BLI_bitmap *verts_moved = NULL;
+	int verts_moved_len = 0;
 
 	if (t->flag & T_MIRROR) {
 		EDBM_verts_mirror_cache_begin(em, 0, false, (t->flag & T_PROP_EDIT) == 0, use_topology);
@@ -2605,6 +2616,12 @@ static void createTransEditVerts(TransInfo *t)
 		}
 	}
 
+	/* With proportional editing every vertex may move, a full update is needed. */
+	if (prop_mode == 0) {
+		BM_mesh_elem_index_ensure(bm, BM_VERT);
+		verts_moved = BLI_BITMAP_NEW(bm->totvert, __func__);
+	}
+
 	/* find out which half we do */
 	if (mirror) {
 		BM_ITER_MESH (eve, &iter, bm, BM_VERTS_OF_MESH) {
@@ -2635,6 +2652,11 @@ static void createTransEditVerts(TransInfo *t)
 				if (tx)
 					tx++;
 
+				if (verts_moved) {
+					BLI_BITMAP_ENABLE(verts_moved, a);
+					verts_moved_len++;
+				}
+
 				/* selected */
 				if (BM_elem_flag_test(eve, BM_ELEM_SELECT))
 					tob->flag |= TD_SELECTED;
@@ -2680,6 +2702,11 @@ static void createTransEditVerts(TransInfo *t)
 					BMVert *vmir = EDBM_verts_mirror_get(em, eve); //t->obedit, em, eve, tob->iloc, a);
 					if (vmir && vmir != eve) {
 						tob->extra = vmir;
+
+						if (verts_moved) {
+							BLI_BITMAP_ENABLE(verts_moved, BM_elem_index_get(vmir));
+							verts_moved_len++;
+						}
 					}
 				}
 				tob++;
@@ -2701,6 +2728,16 @@ static void createTransEditVerts(TransInfo *t)
 		}
 	}
 
+	/* Only worth it when a minority of the mesh moves, otherwise the full update is as fast. */
+	if (verts_moved && (verts_moved_len < bm->totvert / 2)) {
+		const BMPartialUpdate_Params params = {
+		    .do_normals = true,
+		    .do_tessellate = true,
+		};
+		t->custom.type.data = BM_mesh_partial_create_from_verts(bm, &params, verts_moved, verts_moved_len);
+		t->custom.type.free_cb = freeTransEditVertsPartial;
+	}
+
 cleanup:
 	/* crazy space free */
 	if (quats)
@@ -2711,6 +2748,8 @@ cleanup:
 		MEM_freeN(dists);
 	if (dists_index)
 		MEM_freeN(dists_index);
+	if (verts_moved)
+		MEM_freeN(verts_moved);
 
 	if (t->flag & T_MIRROR) {
 		EDBM_verts_mirror_cache_end(em);
@@ -797,8 +797,16 @@ static void recalcData_objects(TransInfo *t)
 
 			DAG_id_tag_update(t->obedit->data, 0);  /* sets recalc flags */
 
-			EDBM_mesh_normals_update(em);
-			BKE_editmesh_tessface_calc(em);
+			/* Only the faces around the transformed vertices need updating (see createTransEditVerts). */
+			if (t->custom.type.data) {
+				const BMPartialUpdate *bmpinfo = t->custom.type.data;
+				BM_mesh_normals_update_with_partial(em->bm, bmpinfo);
+				BKE_editmesh_tessface_calc_with_partial(em, bmpinfo);
+			}
+			else {
+				EDBM_mesh_normals_update(em);
+				BKE_editmesh_tessface_calc(em);
+			}
 		}
 		else if (t->obedit->type == OB_ARMATURE) { /* no recalc flag, does pose */
 			bArmature *arm = t->obedit->data;
@@ -382,6 +382,20 @@ struct ImBuf *IMB_onehalf(struct ImBuf *ibuf1);
  */
 bool IMB_scaleImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy);
 
+typedef enum eIMBScaleFilter {
+	IMB_SCALE_FILTER_BOX = 0,
+	IMB_SCALE_FILTER_BILINEAR = 1,
+	IMB_SCALE_FILTER_BICUBIC = 2,
+	IMB_SCALE_FILTER_LANCZOS = 3,
+} eIMBScaleFilter;
+
+/**
+ * Separable filtered scaling of byte and float buffers, threaded over rows.
+ *
+ * \attention Defined in scaling.c
+ */
+bool IMB_scaleImBuf_filter(struct ImBuf *ibuf, unsigned int newx, unsigned int newy, eIMBScaleFilter filter);
+
 /**
  *
  * \attention Defined in scaling.c
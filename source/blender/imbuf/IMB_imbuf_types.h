@@ -216,7 +216,9 @@ typedef struct ImBuf {
 	unsigned int *display_buffer_flags;          /* array of per-display display buffers dirty flags */
 	struct ColormanageCache *colormanage_cache;  /* cache used by color management */
 	int colormanage_flag;
-	rcti invalid_rect;
+	rcti invalid_rect;                           /* bounds of display buffer regions which are to be updated */
+	unsigned char *invalid_tiles;                /* per-tile flags of regions inside invalid_rect, can be NULL */
+	int invalid_tiles_x, invalid_tiles_y;        /* dimensions of invalid_tiles grid */
 
 	/* information for compressed textures */
 	struct DDSData dds_data;
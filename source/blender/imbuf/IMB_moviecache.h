@@ -59,6 +59,8 @@ void IMB_moviecache_set_priority_callback(struct MovieCache *cache, MovieCacheGe
 
 void IMB_moviecache_put(struct MovieCache *cache, void *userkey, struct ImBuf *ibuf);
 bool IMB_moviecache_put_if_possible(struct MovieCache *cache, void *userkey, struct ImBuf *ibuf);
+bool IMB_moviecache_has_space(size_t size);
+bool IMB_moviecache_make_space(size_t size);
 struct ImBuf *IMB_moviecache_get(struct MovieCache *cache, void *userkey);
 bool IMB_moviecache_has_frame(struct MovieCache *cache, void *userkey);
 void IMB_moviecache_free(struct MovieCache *cache);
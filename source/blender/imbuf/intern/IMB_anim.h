@@ -147,6 +147,11 @@ struct anim {
 	int64_t last_pts;
 	int64_t next_pts;
 	AVPacket next_packet;
+
+	/* frames decoded ahead of the requested one, see anim_movie.c */
+	struct AnimDecodeAhead *decode_ahead;
+	/* decoder state doesn't match curposition, next fetch has to seek */
+	int need_seek;
 #endif
 
 	char index_dir[768];
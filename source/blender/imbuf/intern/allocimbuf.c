@@ -571,6 +571,7 @@ ImBuf *IMB_dupImBuf(const ImBuf *ibuf1)
 
 	tbuf.display_buffer_flags = NULL;
 	tbuf.colormanage_cache = NULL;
+	tbuf.invalid_tiles = NULL;
 
 	*ibuf2 = tbuf;
 
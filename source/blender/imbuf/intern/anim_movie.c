@@ -65,6 +65,7 @@
 #include "BLI_utildefines.h"
 #include "BLI_string.h"
 #include "BLI_path_util.h"
+#include "BLI_threads.h"
 
 #include "MEM_guardedalloc.h"
 
@@ -81,6 +82,7 @@
 #include "IMB_anim.h"
 #include "IMB_indexer.h"
 #include "IMB_metadata.h"
+#include "IMB_moviecache.h"
 
 #ifdef WITH_FFMPEG
 #  include "BKE_global.h"  /* ENDIAN_ORDER */
@@ -537,6 +539,24 @@ static int startffmpeg(struct anim *anim)
 
 	pCodecCtx->workaround_bugs = 1;
 
+	/* Let FFmpeg decode several frames at once (or slices of a frame for codecs
+	 * which can't do that), single threaded decoding is far from real-time
+	 * for high resolution footage.
+	 */
+	if (pCodec->capabilities & CODEC_CAP_AUTO_THREADS) {
+		pCodecCtx->thread_count = 0;
+	}
+	else {
+		pCodecCtx->thread_count = BLI_system_thread_count();
+	}
+
+	if (pCodec->capabilities & CODEC_CAP_FRAME_THREADS) {
+		pCodecCtx->thread_type = FF_THREAD_FRAME;
+	}
+	else if (pCodec->capabilities & CODEC_CAP_SLICE_THREADS) {
+		pCodecCtx->thread_type = FF_THREAD_SLICE;
+	}
+
 	if (avcodec_open2(pCodecCtx, pCodec, NULL) < 0) {
 		avformat_close_input(&pFormatCtx);
 		return -1;
@@ -589,6 +609,8 @@ static int startffmpeg(struct anim *anim)
 	anim->last_pts = -1;
 	anim->next_pts = -1;
 	anim->next_packet.stream_index = -1;
+	anim->decode_ahead = NULL;
+	anim->need_seek = false;
 
 	anim->pFrame = av_frame_alloc();
 	anim->pFrameComplete = false;
@@ -692,13 +714,12 @@ static int startffmpeg(struct anim *anim)
 /* postprocess the image in anim->pFrame and do color conversion
  * and deinterlacing stuff.
  *
- * Output is anim->last_frame
+ * Output is ibuf
  */
 
-static void ffmpeg_postprocess(struct anim *anim)
+static void ffmpeg_postprocess(struct anim *anim, ImBuf *ibuf)
 {
 	AVFrame *input = anim->pFrame;
-	ImBuf *ibuf = anim->last_frame;
 	int filter_y = 0;
 
 	if (!anim->pFrameComplete) {
@@ -1003,6 +1024,241 @@ static int ffmpeg_seek_by_byte(AVFormatContext *pFormatCtx)
 	return false;
 }
 
+/* Decode-ahead.
+ *
+ * Once frames are requested one after another (playback), a worker thread keeps
+ * decoding and converting the frames which follow the last requested one into
+ * a small ring buffer, so decoding of the next frame overlaps with whatever the
+ * caller does with the current one. Frames are handed out as-is (the caller gets
+ * a reference to the ImBuf), so putting them into movie cache doesn't copy pixels.
+ *
+ * While the worker is running it owns all the decoder state of the anim, any
+ * access which can't be served from the ring buffer stops the worker first.
+ *
+ * Frames in the ring buffer end up in the movie cache, so they are counted
+ * against the same limit: before decoding further ahead the worker frees the
+ * least important cached frames until the buffered frames fit in. It only
+ * waits when the cache can't make room (frames which are in use).
+ */
+
+/* Upper bound of the amount of frames in the ring buffer. */
+#define DECODE_AHEAD_MAX_FRAMES 8
+
+typedef struct AnimDecodedFrame {
+	ImBuf *ibuf;
+	/* Presentation time of the frame and of the frame following it. */
+	int64_t pts, next_pts;
+} AnimDecodedFrame;
+
+typedef struct AnimDecodeAhead {
+	ListBase threads;
+	ThreadMutex mutex;
+	ThreadCondition cond;
+
+	AnimDecodedFrame frames[DECODE_AHEAD_MAX_FRAMES];
+	int first_frame, num_frames, max_frames;
+
+	/* Presentation time of the frame following anim->last_frame. */
+	int64_t last_next_pts;
+
+	bool stop;
+	/* Worker reached the end of the stream. */
+	bool finished;
+} AnimDecodeAhead;
+
+static void *ffmpeg_decode_ahead_thread(void *anim_v)
+{
+	struct anim *anim = anim_v;
+	AnimDecodeAhead *ahead = anim->decode_ahead;
+
+	BLI_mutex_lock(&ahead->mutex);
+
+	while (!ahead->stop) {
+		AnimDecodedFrame frame;
+		bool decoded;
+
+		if (ahead->num_frames == ahead->max_frames) {
+			BLI_condition_wait(&ahead->cond, &ahead->mutex);
+			continue;
+		}
+
+		/* The frame which is requested next is always decoded, it would be
+		 * allocated without decode-ahead too. */
+		if (ahead->num_frames != 0) {
+			const size_t size = (size_t)(ahead->num_frames + 1) * (size_t)anim->framesize;
+			bool has_space;
+
+			BLI_mutex_unlock(&ahead->mutex);
+			has_space = IMB_moviecache_make_space(size);
+			BLI_mutex_lock(&ahead->mutex);
+
+			if (ahead->stop) {
+				break;
+			}
+			if (!has_space) {
+				BLI_condition_wait(&ahead->cond, &ahead->mutex);
+				continue;
+			}
+		}
+
+		BLI_mutex_unlock(&ahead->mutex);
+
+		/* Same as ffmpeg_fetchibuf() does for sequential access: convert the frame
+		 * which is already decoded and decode the one after it.
+		 */
+		frame.ibuf = IMB_allocImBuf(anim->x, anim->y, 32, IB_rect);
+		frame.ibuf->rect_colorspace = colormanage_colorspace_get_named(anim->colorspace);
+		ffmpeg_postprocess(anim, frame.ibuf);
+		frame.pts = anim->next_pts;
+
+		decoded = ffmpeg_decode_video_frame(anim) && anim->next_pts != frame.pts;
+		frame.next_pts = decoded ? anim->next_pts : frame.pts + 1;
+
+		BLI_mutex_lock(&ahead->mutex);
+
+		ahead->frames[(ahead->first_frame + ahead->num_frames) % ahead->max_frames] = frame;
+		ahead->num_frames++;
+
+		if (!decoded) {
+			ahead->finished = true;
+		}
+
+		BLI_condition_notify_all(&ahead->cond);
+
+		if (ahead->finished) {
+			break;
+		}
+	}
+
+	BLI_mutex_unlock(&ahead->mutex);
+
+	return NULL;
+}
+
+/* Should be called right after sequential access, when anim->pFrame contains the
+ * frame following anim->last_frame. */
+static void ffmpeg_decode_ahead_start(struct anim *anim)
+{
+	AnimDecodeAhead *ahead;
+
+	if (anim->framesize == 0) {
+		return;
+	}
+
+	ahead = MEM_callocN(sizeof(AnimDecodeAhead), "anim decode ahead");
+
+	BLI_mutex_init(&ahead->mutex);
+	BLI_condition_init(&ahead->cond);
+
+	ahead->max_frames = DECODE_AHEAD_MAX_FRAMES;
+	ahead->last_next_pts = anim->next_pts;
+
+	anim->decode_ahead = ahead;
+
+	BLI_threadpool_init(&ahead->threads, ffmpeg_decode_ahead_thread, 1);
+	BLI_threadpool_insert(&ahead->threads, anim);
+}
+
+static void ffmpeg_decode_ahead_stop(struct anim *anim)
+{
+	AnimDecodeAhead *ahead = anim->decode_ahead;
+
+	if (ahead == NULL) {
+		return;
+	}
+
+	BLI_mutex_lock(&ahead->mutex);
+	ahead->stop = true;
+	BLI_condition_notify_all(&ahead->cond);
+	BLI_mutex_unlock(&ahead->mutex);
+
+	BLI_threadpool_end(&ahead->threads);
+
+	while (ahead->num_frames) {
+		IMB_freeImBuf(ahead->frames[ahead->first_frame].ibuf);
+		ahead->first_frame = (ahead->first_frame + 1) % ahead->max_frames;
+		ahead->num_frames--;
+	}
+
+	BLI_condition_end(&ahead->cond);
+	BLI_mutex_end(&ahead->mutex);
+
+	MEM_freeN(ahead);
+	anim->decode_ahead = NULL;
+
+	/* Decoder went past frames which were never handed out, so its state
+	 * doesn't match the current position anymore. */
+	IMB_freeImBuf(anim->last_frame);
+	anim->last_frame = NULL;
+	anim->last_pts = -1;
+	anim->need_seek = true;
+}
+
+/* Get frame from the ring buffer, waiting for the worker if needed.
+ * Returns NULL if the frame is not going to be decoded there. */
+static ImBuf *ffmpeg_decode_ahead_fetch(struct anim *anim, int64_t pts_to_search)
+{
+	AnimDecodeAhead *ahead = anim->decode_ahead;
+	ImBuf *ibuf = NULL;
+	int skipped = 0;
+
+	if (anim->last_frame &&
+	    anim->last_pts <= pts_to_search && ahead->last_next_pts > pts_to_search)
+	{
+		IMB_refImBuf(anim->last_frame);
+		return anim->last_frame;
+	}
+
+	BLI_mutex_lock(&ahead->mutex);
+
+	while (true) {
+		AnimDecodedFrame *frame;
+
+		if (ahead->num_frames == 0) {
+			if (ahead->finished) {
+				break;
+			}
+
+			BLI_condition_wait(&ahead->cond, &ahead->mutex);
+			continue;
+		}
+
+		frame = &ahead->frames[ahead->first_frame];
+
+		if (pts_to_search < frame->pts) {
+			/* Seeking backwards. */
+			break;
+		}
+
+		ahead->first_frame = (ahead->first_frame + 1) % ahead->max_frames;
+		ahead->num_frames--;
+		BLI_condition_notify_all(&ahead->cond);
+
+		if (pts_to_search < frame->next_pts) {
+			IMB_freeImBuf(anim->last_frame);
+			anim->last_frame = frame->ibuf;
+			anim->last_pts = frame->pts;
+			ahead->last_next_pts = frame->next_pts;
+
+			IMB_refImBuf(anim->last_frame);
+			ibuf = anim->last_frame;
+			break;
+		}
+
+		/* Frame was skipped (playback dropping frames), seeking is cheaper
+		 * than decoding everything in between for bigger jumps. */
+		IMB_freeImBuf(frame->ibuf);
+
+		if (++skipped >= ahead->max_frames) {
+			break;
+		}
+	}
+
+	BLI_mutex_unlock(&ahead->mutex);
+
+	return ibuf;
+}
+
 static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
                                IMB_Timecode_Type tc)
 {
@@ -1014,6 +1270,7 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 	AVStream *v_st;
 	int new_frame_index = 0; /* To quiet gcc barking... */
 	int old_frame_index = 0; /* To quiet gcc barking... */
+	bool is_sequential;
 
 	if (anim == NULL) return (0);
 
@@ -1053,6 +1310,17 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 	       "(pts_timebase=%g, frame_rate=%g, st_time=%lld)\n",
 	       (long long int)pts_to_search, pts_time_base, frame_rate, st_time);
 
+	if (anim->decode_ahead) {
+		ImBuf *ibuf = ffmpeg_decode_ahead_fetch(anim, pts_to_search);
+
+		if (ibuf) {
+			anim->curposition = position;
+			return ibuf;
+		}
+
+		ffmpeg_decode_ahead_stop(anim);
+	}
+
 	if (anim->last_frame &&
 	    anim->last_pts <= pts_to_search && anim->next_pts > pts_to_search)
 	{
@@ -1065,9 +1333,13 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 		return anim->last_frame;
 	}
 
+	/* Start decoding ahead once playback is going on, not for the first frame. */
+	is_sequential = (position == anim->curposition + 1 && anim->curposition >= 0 && !anim->need_seek);
+
 	if (position > anim->curposition + 1 &&
 	    anim->preseek &&
 	    !tc_index &&
+	    !anim->need_seek &&
 	    position - (anim->curposition + 1) < anim->preseek)
 	{
 		av_log(anim->pFormatCtx, AV_LOG_DEBUG,
@@ -1076,6 +1348,7 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 		ffmpeg_decode_video_frame_scan(anim, pts_to_search);
 	}
 	else if (tc_index &&
+	         !anim->need_seek &&
 	         IMB_indexer_can_scan(tc_index, old_frame_index,
 	                              new_frame_index))
 	{
@@ -1085,10 +1358,12 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 
 		ffmpeg_decode_video_frame_scan(anim, pts_to_search);
 	}
-	else if (position != anim->curposition + 1) {
+	else if (position != anim->curposition + 1 || anim->need_seek) {
 		long long pos;
 		int ret;
 
+		anim->need_seek = false;
+
 		if (tc_index) {
 			unsigned long long dts;
 
@@ -1178,7 +1453,7 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 	anim->last_frame = IMB_allocImBuf(anim->x, anim->y, 32, IB_rect);
 	anim->last_frame->rect_colorspace = colormanage_colorspace_get_named(anim->colorspace);
 
-	ffmpeg_postprocess(anim);
+	ffmpeg_postprocess(anim, anim->last_frame);
 
 	anim->last_pts = anim->next_pts;
 
@@ -1188,6 +1463,10 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position,
 
 	IMB_refImBuf(anim->last_frame);
 
+	if (is_sequential) {
+		ffmpeg_decode_ahead_start(anim);
+	}
+
 	return anim->last_frame;
 }
 
@@ -1196,6 +1475,8 @@ static void free_anim_ffmpeg(struct anim *anim)
 	if (anim == NULL) return;
 
 	if (anim->pCodecCtx) {
+		ffmpeg_decode_ahead_stop(anim);
+
 		avcodec_close(anim->pCodecCtx);
 		avformat_close_input(&anim->pFormatCtx);
 
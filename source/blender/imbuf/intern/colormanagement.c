@@ -57,6 +57,7 @@
 #include "BLI_math.h"
 #include "BLI_math_color.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_rect.h"
 
@@ -108,9 +109,16 @@ static pthread_mutex_t processor_lock = BLI_MUTEX_INITIALIZER;
 typedef struct ColormanageProcessor {
 	OCIO_ConstProcessorRcPtr *processor;
 	CurveMapping *curve_mapping;
+	/* Baked display transform used instead of processor, see display_lut_apply(). */
+	struct ColormanageDisplayLUT *display_lut;
 	bool is_data_result;
 } ColormanageProcessor;
 
+static void display_lut_free_global(void);
+static void imb_partial_display_buffer_update_invalid(ImBuf *ibuf,
+                                                      const ColorManagedViewSettings *view_settings,
+                                                      const ColorManagedDisplaySettings *display_settings);
+
 static struct global_glsl_state {
 	/* Actual processor used for GLSL baked LUTs. */
 	OCIO_ConstProcessorRcPtr *processor;
@@ -699,6 +707,8 @@ void colormanagement_exit(void)
 	if (global_glsl_state.transform_ocio_glsl_state)
 		OCIO_freeOGLState(global_glsl_state.transform_ocio_glsl_state);
 
+	display_lut_free_global();
+
 	colormanage_free_config();
 }
 
@@ -712,6 +722,12 @@ void colormanage_cache_free(ImBuf *ibuf)
 		ibuf->display_buffer_flags = NULL;
 	}
 
+	if (ibuf->invalid_tiles) {
+		MEM_freeN(ibuf->invalid_tiles);
+
+		ibuf->invalid_tiles = NULL;
+	}
+
 	if (ibuf->colormanage_cache) {
 		ColormanageCacheData *cache_data = colormanage_cachedata_get(ibuf);
 		struct MovieCache *moviecache = colormanage_moviecache_get(ibuf);
@@ -831,6 +847,267 @@ static OCIO_ConstProcessorRcPtr *create_display_buffer_processor(const char *loo
 	return processor;
 }
 
+/*********************** Baked display transform *************************/
+
+/* Display buffers which are only used for drawing are computed through a 3D LUT
+ * baked from the display transform, the same way GLSL drawing does it. Applying
+ * OCIO processors per pixel is expensive for the complex view transforms, and
+ * display buffers are recalculated a lot (render progress, painting, changes of
+ * view settings), while a table lookup costs the same for any view transform.
+ *
+ * Table is indexed by a log2 shaper, so the range above 1.0 which view
+ * transforms like Filmic map into visible range keeps enough precision.
+ * Exact transform is still used for everything which leaves Blender,
+ * such as saving images.
+ */
+
+#define DISPLAY_LUT_SIZE       64
+#define DISPLAY_LUT_LOG2_MIN   -12.0f
+#define DISPLAY_LUT_LOG2_MAX   12.0f
+#define DISPLAY_LUT_SCALE      ((float)(DISPLAY_LUT_SIZE - 1) / (DISPLAY_LUT_LOG2_MAX - DISPLAY_LUT_LOG2_MIN))
+/* Offset applied before the logarithm, makes zero map to the first table entry. */
+#define DISPLAY_LUT_OFFSET     (1.0f / 4096.0f)
+
+/* Number of pixels processed at once by display_lut_apply(). */
+#define DISPLAY_LUT_BATCH      256
+
+typedef struct ColormanageDisplayLUT {
+	/* Settings the table was baked for. */
+	char look[MAX_COLORSPACE_NAME];
+	char view[MAX_COLORSPACE_NAME];
+	char display[MAX_COLORSPACE_NAME];
+	float exposure, gamma;
+
+	/* Global pointer holds one user, processors using the table hold the rest. */
+	int users;
+
+	/* DISPLAY_LUT_SIZE^3 RGB triplets, red changes fastest. */
+	float *table;
+} ColormanageDisplayLUT;
+
+static ColormanageDisplayLUT *global_display_lut = NULL;
+static ThreadMutex display_lut_lock = BLI_MUTEX_INITIALIZER;
+
+BLI_INLINE float display_lut_shaper(float value)
+{
+	/* Negative values and NaN are mapped to the first entry. */
+	if (!(value > 0.0f)) {
+		value = 0.0f;
+	}
+
+	return min_ff((log2f(value + DISPLAY_LUT_OFFSET) - DISPLAY_LUT_LOG2_MIN) * DISPLAY_LUT_SCALE,
+	              (float)(DISPLAY_LUT_SIZE - 1));
+}
+
+BLI_INLINE float display_lut_shaper_inverse(float coord)
+{
+	return exp2f(DISPLAY_LUT_LOG2_MIN + coord / DISPLAY_LUT_SCALE) - DISPLAY_LUT_OFFSET;
+}
+
+typedef struct DisplayLUTBakeData {
+	OCIO_ConstProcessorRcPtr *processor;
+	float *table;
+} DisplayLUTBakeData;
+
+static void display_lut_bake_slice(void *__restrict userdata,
+                                   const int b,
+                                   const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	DisplayLUTBakeData *data = userdata;
+	float *slice = data->table + (size_t)b * DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE * 3;
+	float *fp = slice;
+	OCIO_PackedImageDesc *img;
+	int r, g;
+
+	for (g = 0; g < DISPLAY_LUT_SIZE; g++) {
+		for (r = 0; r < DISPLAY_LUT_SIZE; r++, fp += 3) {
+			fp[0] = display_lut_shaper_inverse((float)r);
+			fp[1] = display_lut_shaper_inverse((float)g);
+			fp[2] = display_lut_shaper_inverse((float)b);
+		}
+	}
+
+	img = OCIO_createOCIO_PackedImageDesc(
+	        slice, DISPLAY_LUT_SIZE, DISPLAY_LUT_SIZE, 3, sizeof(float),
+	        3 * sizeof(float), 3 * sizeof(float) * DISPLAY_LUT_SIZE);
+
+	OCIO_processorApply(data->processor, img);
+
+	OCIO_PackedImageDescRelease(img);
+}
+
+static ColormanageDisplayLUT *display_lut_create(OCIO_ConstProcessorRcPtr *processor,
+                                                 const ColorManagedViewSettings *view_settings,
+                                                 const ColorManagedDisplaySettings *display_settings)
+{
+	ColormanageDisplayLUT *lut = MEM_callocN(sizeof(ColormanageDisplayLUT), "colormanage display lut");
+	DisplayLUTBakeData data;
+	ParallelRangeSettings settings;
+
+	BLI_strncpy(lut->look, view_settings->look, sizeof(lut->look));
+	BLI_strncpy(lut->view, view_settings->view_transform, sizeof(lut->view));
+	BLI_strncpy(lut->display, display_settings->display_device, sizeof(lut->display));
+	lut->exposure = view_settings->exposure;
+	lut->gamma = view_settings->gamma;
+
+	lut->table = MEM_mallocN(sizeof(float) * 3 * DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE,
+	                         "colormanage display lut table");
+
+	data.processor = processor;
+	data.table = lut->table;
+
+	BLI_parallel_range_settings_defaults(&settings);
+	BLI_task_parallel_range(0, DISPLAY_LUT_SIZE, &data, display_lut_bake_slice, &settings);
+
+	return lut;
+}
+
+static bool display_lut_matches(const ColormanageDisplayLUT *lut,
+                                const ColorManagedViewSettings *view_settings,
+                                const ColorManagedDisplaySettings *display_settings)
+{
+	return (lut->exposure == view_settings->exposure &&
+	        lut->gamma == view_settings->gamma &&
+	        STREQ(lut->look, view_settings->look) &&
+	        STREQ(lut->view, view_settings->view_transform) &&
+	        STREQ(lut->display, display_settings->display_device));
+}
+
+/* Should be called with display_lut_lock held. */
+static void display_lut_unref(ColormanageDisplayLUT *lut)
+{
+	BLI_assert(lut->users > 0);
+
+	if (--lut->users == 0) {
+		MEM_freeN(lut->table);
+		MEM_freeN(lut);
+	}
+}
+
+/* Get table for given settings. When there's no table baked for them yet,
+ * it's only created if asked to, since baking is only worth it for big
+ * enough buffers.
+ */
+static ColormanageDisplayLUT *display_lut_acquire(OCIO_ConstProcessorRcPtr *processor,
+                                                  const ColorManagedViewSettings *view_settings,
+                                                  const ColorManagedDisplaySettings *display_settings,
+                                                  bool create)
+{
+	ColormanageDisplayLUT *lut;
+
+	BLI_mutex_lock(&display_lut_lock);
+
+	lut = global_display_lut;
+
+	if (lut == NULL || !display_lut_matches(lut, view_settings, display_settings)) {
+		if (!create) {
+			BLI_mutex_unlock(&display_lut_lock);
+			return NULL;
+		}
+
+		if (global_display_lut) {
+			display_lut_unref(global_display_lut);
+		}
+
+		lut = global_display_lut = display_lut_create(processor, view_settings, display_settings);
+		lut->users = 1;
+	}
+
+	lut->users++;
+
+	BLI_mutex_unlock(&display_lut_lock);
+
+	return lut;
+}
+
+static void display_lut_release(ColormanageDisplayLUT *lut)
+{
+	BLI_mutex_lock(&display_lut_lock);
+	display_lut_unref(lut);
+	BLI_mutex_unlock(&display_lut_lock);
+}
+
+static void display_lut_free_global(void)
+{
+	BLI_mutex_lock(&display_lut_lock);
+
+	if (global_display_lut) {
+		display_lut_unref(global_display_lut);
+		global_display_lut = NULL;
+	}
+
+	BLI_mutex_unlock(&display_lut_lock);
+}
+
+/* Apply baked display transform to a buffer of num_pixels pixels.
+ *
+ * Pixels are processed in batches: first all the table coordinates are computed,
+ * then all the lookups are done, which keeps both loops free of branches and
+ * lets compiler vectorize them.
+ */
+static void display_lut_apply(const ColormanageDisplayLUT *lut, float *buffer, size_t num_pixels,
+                              int channels, bool predivide)
+{
+	const float *table = lut->table;
+	const size_t stride_g = DISPLAY_LUT_SIZE * 3;
+	const size_t stride_b = DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE * 3;
+	const bool use_alpha = predivide && channels == 4;
+	float coords[DISPLAY_LUT_BATCH * 3];
+	float alpha[DISPLAY_LUT_BATCH];
+	size_t batch_start;
+
+	BLI_assert(channels >= 3);
+
+	for (batch_start = 0; batch_start < num_pixels; batch_start += DISPLAY_LUT_BATCH) {
+		const int batch_size = (int)min_zz(num_pixels - batch_start, DISPLAY_LUT_BATCH);
+		float *batch_buffer = buffer + batch_start * channels;
+		float *fp;
+		int i;
+
+		for (i = 0, fp = batch_buffer; i < batch_size; i++, fp += channels) {
+			/* Same as OCIO predivide: fully transparent and opaque pixels are used as-is. */
+			float inv_alpha = 1.0f;
+
+			alpha[i] = 1.0f;
+
+			if (use_alpha && fp[3] != 1.0f && fp[3] != 0.0f) {
+				alpha[i] = fp[3];
+				inv_alpha = 1.0f / fp[3];
+			}
+
+			coords[i * 3 + 0] = display_lut_shaper(fp[0] * inv_alpha);
+			coords[i * 3 + 1] = display_lut_shaper(fp[1] * inv_alpha);
+			coords[i * 3 + 2] = display_lut_shaper(fp[2] * inv_alpha);
+		}
+
+		for (i = 0, fp = batch_buffer; i < batch_size; i++, fp += channels) {
+			const float *coord = coords + i * 3;
+			const int r = min_ii((int)coord[0], DISPLAY_LUT_SIZE - 2);
+			const int g = min_ii((int)coord[1], DISPLAY_LUT_SIZE - 2);
+			const int b = min_ii((int)coord[2], DISPLAY_LUT_SIZE - 2);
+			const float fr = coord[0] - (float)r;
+			const float fg = coord[1] - (float)g;
+			const float fb = coord[2] - (float)b;
+			const float *p000 = table + (size_t)b * stride_b + (size_t)g * stride_g + (size_t)r * 3;
+			const float *p010 = p000 + stride_g;
+			const float *p001 = p000 + stride_b;
+			const float *p011 = p001 + stride_g;
+			int c;
+
+			for (c = 0; c < 3; c++) {
+				const float c00 = p000[c] + (p000[c + 3] - p000[c]) * fr;
+				const float c10 = p010[c] + (p010[c + 3] - p010[c]) * fr;
+				const float c01 = p001[c] + (p001[c + 3] - p001[c]) * fr;
+				const float c11 = p011[c] + (p011[c + 3] - p011[c]) * fr;
+				const float c0 = c00 + (c10 - c00) * fg;
+				const float c1 = c01 + (c11 - c01) * fg;
+
+				fp[c] = (c0 + (c1 - c0) * fb) * alpha[i];
+			}
+		}
+	}
+}
+
 static OCIO_ConstProcessorRcPtr *create_colorspace_transform_processor(const char *from_colorspace,
                                                                        const char *to_colorspace)
 {
@@ -1248,6 +1525,39 @@ const char *IMB_colormanagement_get_rect_colorspace(ImBuf *ibuf)
 	}
 }
 
+/* Processor for display buffers which are used for drawing only, which could use
+ * baked display transform. num_pixels is the amount of pixels which are about to
+ * be processed, used to decide whether baking the table is worth it.
+ */
+static ColormanageProcessor *display_buffer_processor_new(const ColorManagedViewSettings *view_settings,
+                                                          const ColorManagedDisplaySettings *display_settings,
+                                                          size_t num_pixels)
+{
+	ColormanageProcessor *cm_processor;
+	ColorManagedViewSettings default_view_settings;
+	const ColorManagedViewSettings *applied_view_settings;
+
+	cm_processor = IMB_colormanagement_display_processor_new(view_settings, display_settings);
+
+	if (cm_processor->processor == NULL || cm_processor->is_data_result) {
+		return cm_processor;
+	}
+
+	if (view_settings) {
+		applied_view_settings = view_settings;
+	}
+	else {
+		init_default_view_settings(display_settings, &default_view_settings);
+		applied_view_settings = &default_view_settings;
+	}
+
+	cm_processor->display_lut = display_lut_acquire(
+	        cm_processor->processor, applied_view_settings, display_settings,
+	        num_pixels >= DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE);
+
+	return cm_processor;
+}
+
 /*********************** Threaded display buffer transform routines *************************/
 
 typedef struct DisplayBufferThread {
@@ -1535,9 +1845,11 @@ static bool is_ibuf_rect_in_display_space(ImBuf *ibuf, const ColorManagedViewSet
 	return false;
 }
 
+/* for_drawing allows to use baked display transform, result is not to be used anywhere other than for drawing. */
 static void colormanage_display_buffer_process_ex(ImBuf *ibuf, float *display_buffer, unsigned char *display_buffer_byte,
                                                   const ColorManagedViewSettings *view_settings,
-                                                  const ColorManagedDisplaySettings *display_settings)
+                                                  const ColorManagedDisplaySettings *display_settings,
+                                                  bool for_drawing)
 {
 	ColormanageProcessor *cm_processor = NULL;
 	bool skip_transform = false;
@@ -1551,8 +1863,15 @@ static void colormanage_display_buffer_process_ex(ImBuf *ibuf, float *display_bu
 		skip_transform = is_ibuf_rect_in_display_space(ibuf, view_settings, display_settings);
 	}
 
-	if (skip_transform == false)
-		cm_processor = IMB_colormanagement_display_processor_new(view_settings, display_settings);
+	if (skip_transform == false) {
+		if (for_drawing) {
+			cm_processor = display_buffer_processor_new(view_settings, display_settings,
+			                                            (size_t)ibuf->x * ibuf->y);
+		}
+		else {
+			cm_processor = IMB_colormanagement_display_processor_new(view_settings, display_settings);
+		}
+	}
 
 	display_buffer_apply_threaded(ibuf, ibuf->rect_float, (unsigned char *) ibuf->rect,
 	                              display_buffer, display_buffer_byte, cm_processor);
@@ -1565,7 +1884,7 @@ static void colormanage_display_buffer_process(ImBuf *ibuf, unsigned char *displ
                                                const ColorManagedViewSettings *view_settings,
                                                const ColorManagedDisplaySettings *display_settings)
 {
-	colormanage_display_buffer_process_ex(ibuf, NULL, display_buffer, view_settings, display_settings);
+	colormanage_display_buffer_process_ex(ibuf, NULL, display_buffer, view_settings, display_settings, true);
 }
 
 /*********************** Threaded processor transform routines *************************/
@@ -1960,7 +2279,7 @@ static void colormanagement_imbuf_make_display_space(ImBuf *ibuf, const ColorMan
 		imb_addrectImBuf(ibuf);
 
 	colormanage_display_buffer_process_ex(ibuf, ibuf->rect_float, (unsigned char *)ibuf->rect,
-	                                      view_settings, display_settings);
+	                                      view_settings, display_settings, false);
 }
 
 void IMB_colormanagement_imbuf_make_display_space(ImBuf *ibuf, const ColorManagedViewSettings *view_settings,
@@ -2160,21 +2479,14 @@ unsigned char *IMB_display_buffer_acquire(ImBuf *ibuf, const ColorManagedViewSet
 
 	if (ibuf->invalid_rect.xmin != ibuf->invalid_rect.xmax) {
 		if ((ibuf->userflags & IB_DISPLAY_BUFFER_INVALID) == 0) {
-			IMB_partial_display_buffer_update_threaded(ibuf,
-			                                           ibuf->rect_float,
-			                                           (unsigned char *) ibuf->rect,
-			                                           ibuf->x,
-			                                           0, 0,
-			                                           applied_view_settings,
-			                                           display_settings,
-			                                           ibuf->invalid_rect.xmin,
-			                                           ibuf->invalid_rect.ymin,
-			                                           ibuf->invalid_rect.xmax,
-			                                           ibuf->invalid_rect.ymax,
-			                                           false);
+			imb_partial_display_buffer_update_invalid(ibuf, applied_view_settings, display_settings);
 		}
 
 		BLI_rcti_init(&ibuf->invalid_rect, 0, 0, 0, 0);
+
+		if (ibuf->invalid_tiles) {
+			memset(ibuf->invalid_tiles, 0, (size_t)ibuf->invalid_tiles_x * ibuf->invalid_tiles_y);
+		}
 	}
 
 	BLI_thread_lock(LOCK_COLORMANAGE);
@@ -2777,6 +3089,11 @@ void IMB_colormanagement_colorspace_items_add(EnumPropertyItem **items, int *tot
  * the rest buffers would be marked as dirty
  */
 
+/* Delayed updates are tracked in tiles of this size. */
+#define PARTIAL_UPDATE_TILE_SIZE 64
+/* Amount of scanlines updated by a single task. */
+#define PARTIAL_UPDATE_CHUNK_LINES 16
+
 static void partial_buffer_update_rect(ImBuf *ibuf,
                                        unsigned char *display_buffer,
                                        const float *linear_buffer,
@@ -2812,69 +3129,76 @@ static void partial_buffer_update_rect(ImBuf *ibuf,
 	}
 
 	if (cm_processor) {
+		/* Transform whole scanlines at once rather than pixel by pixel,
+		 * so processor could handle batches of pixels.
+		 */
+		float *row_buffer = NULL;
+
+		if (display_buffer_float == NULL) {
+			row_buffer = MEM_mallocN((size_t)channels * width * sizeof(float), "partial update row buffer");
+		}
+
 		for (y = ymin; y < ymax; y++) {
-			for (x = xmin; x < xmax; x++) {
-				size_t display_index = ((size_t)y * display_stride + x) * 4;
-				size_t linear_index = ((size_t)(y - linear_offset_y) * linear_stride + (x - linear_offset_x)) * channels;
-				float pixel[4];
+			size_t linear_index = ((size_t)(y - linear_offset_y) * linear_stride + (xmin - linear_offset_x)) * channels;
+			float *row, *pixel;
 
-				if (linear_buffer) {
-					if (channels == 4) {
-						copy_v4_v4(pixel, (float *) linear_buffer + linear_index);
-					}
-					else if (channels == 3) {
-						copy_v3_v3(pixel, (float *) linear_buffer + linear_index);
-						pixel[3] = 1.0f;
-					}
-					else if (channels == 1) {
-						pixel[0] = linear_buffer[linear_index];
-					}
-					else {
-						BLI_assert(!"Unsupported number of channels in partial buffer update");
-					}
-				}
-				else if (byte_buffer) {
-					rgba_uchar_to_float(pixel, byte_buffer + linear_index);
-					IMB_colormanagement_colorspace_to_scene_linear_v3(pixel, rect_colorspace);
-					straight_to_premul_v4(pixel);
+			if (display_buffer_float) {
+				row = display_buffer_float + (size_t)(y - ymin) * width * channels;
+			}
+			else {
+				row = row_buffer;
+			}
+
+			if (linear_buffer) {
+				if (!ELEM(channels, 1, 3, 4)) {
+					BLI_assert(!"Unsupported number of channels in partial buffer update");
 				}
 
-				if (!is_data) {
-					IMB_colormanagement_processor_apply_pixel(cm_processor, pixel, channels);
+				memcpy(row, linear_buffer + linear_index, (size_t)channels * width * sizeof(float));
+			}
+			else if (byte_buffer) {
+				const unsigned char *cp = byte_buffer + linear_index;
+
+				BLI_assert(channels == 4);
+
+				for (x = 0, pixel = row; x < width; x++, pixel += channels, cp += channels) {
+					rgba_uchar_to_float(pixel, cp);
 				}
 
-				if (display_buffer_float) {
-					size_t index = ((size_t)(y - ymin) * width + (x - xmin)) * channels;
+				IMB_colormanagement_colorspace_to_scene_linear(row, width, 1, channels, rect_colorspace, false);
 
-					if (channels == 4) {
-						copy_v4_v4(display_buffer_float + index, pixel);
-					}
-					else if (channels == 3) {
-						copy_v3_v3(display_buffer_float + index, pixel);
-					}
-					else /* if (channels == 1) */ {
-						display_buffer_float[index] = pixel[0];
-					}
+				for (x = 0, pixel = row; x < width; x++, pixel += channels) {
+					straight_to_premul_v4(pixel);
 				}
-				else {
+			}
+
+			if (!is_data) {
+				IMB_colormanagement_processor_apply(cm_processor, row, width, 1, channels, channels == 4);
+			}
+
+			if (display_buffer_float == NULL) {
+				unsigned char *cp = display_buffer + ((size_t)y * display_stride + xmin) * 4;
+
+				for (x = 0, pixel = row; x < width; x++, pixel += channels, cp += 4) {
 					if (channels == 4) {
 						float pixel_straight[4];
 						premul_to_straight_v4_v4(pixel_straight, pixel);
-						rgba_float_to_uchar(display_buffer + display_index, pixel_straight);
+						rgba_float_to_uchar(cp, pixel_straight);
 					}
 					else if (channels == 3) {
-						rgb_float_to_uchar(display_buffer + display_index, pixel);
-						display_buffer[display_index + 3] = 255;
+						rgb_float_to_uchar(cp, pixel);
+						cp[3] = 255;
 					}
 					else /* if (channels == 1) */ {
-						display_buffer[display_index] =
-							display_buffer[display_index + 1] =
-							display_buffer[display_index + 2] =
-							display_buffer[display_index + 3] = unit_float_to_uchar_clamp(pixel[0]);
+						cp[0] = cp[1] = cp[2] = cp[3] = unit_float_to_uchar_clamp(pixel[0]);
 					}
 				}
 			}
 		}
+
+		if (row_buffer) {
+			MEM_freeN(row_buffer);
+		}
 	}
 	else {
 		if (display_buffer_float) {
@@ -2914,15 +3238,16 @@ typedef struct PartialThreadData {
 	int linear_stride;
 	int linear_offset_x, linear_offset_y;
 	ColormanageProcessor *cm_processor;
-	int xmin, ymin, xmax;
+	const rcti *chunks;
 } PartialThreadData;
 
-static void partial_buffer_update_rect_thread_do(void *data_v,
-                                                 int start_scanline,
-                                                 int num_scanlines)
+static void partial_buffer_update_rect_thread_do(void *__restrict data_v,
+                                                 const int iter,
+                                                 const ParallelRangeTLS *__restrict UNUSED(tls))
 {
 	PartialThreadData *data = (PartialThreadData *)data_v;
-	int ymin = data->ymin + start_scanline;
+	const rcti *chunk = &data->chunks[iter];
+
 	partial_buffer_update_rect(data->ibuf,
 	                           data->display_buffer,
 	                           data->linear_buffer,
@@ -2932,10 +3257,42 @@ static void partial_buffer_update_rect_thread_do(void *data_v,
 	                           data->linear_offset_x,
 	                           data->linear_offset_y,
 	                           data->cm_processor,
-	                           data->xmin,
-	                           ymin,
-	                           data->xmax,
-	                           ymin + num_scanlines);
+	                           chunk->xmin,
+	                           chunk->ymin,
+	                           chunk->xmax,
+	                           chunk->ymax);
+}
+
+/* Split regions into chunks of scanlines, which are the units of work for threads. */
+static rcti *partial_update_chunks_create(const rcti *rects, int totrect, int *r_totchunk, size_t *r_num_pixels)
+{
+	rcti *chunks;
+	int i, totchunk = 0;
+	size_t num_pixels = 0;
+
+	for (i = 0; i < totrect; i++) {
+		const int height = BLI_rcti_size_y(&rects[i]);
+		totchunk += (height + PARTIAL_UPDATE_CHUNK_LINES - 1) / PARTIAL_UPDATE_CHUNK_LINES;
+		num_pixels += (size_t)BLI_rcti_size_x(&rects[i]) * height;
+	}
+
+	chunks = MEM_mallocN(sizeof(rcti) * max_ii(totchunk, 1), "partial update chunks");
+	totchunk = 0;
+
+	for (i = 0; i < totrect; i++) {
+		int y;
+
+		for (y = rects[i].ymin; y < rects[i].ymax; y += PARTIAL_UPDATE_CHUNK_LINES) {
+			BLI_rcti_init(&chunks[totchunk++],
+			              rects[i].xmin, rects[i].xmax,
+			              y, min_ii(y + PARTIAL_UPDATE_CHUNK_LINES, rects[i].ymax));
+		}
+	}
+
+	*r_totchunk = totchunk;
+	*r_num_pixels = num_pixels;
+
+	return chunks;
 }
 
 static void imb_partial_display_buffer_update_ex(ImBuf *ibuf,
@@ -2945,8 +3302,7 @@ static void imb_partial_display_buffer_update_ex(ImBuf *ibuf,
                                                  int offset_x, int offset_y,
                                                  const ColorManagedViewSettings *view_settings,
                                                  const ColorManagedDisplaySettings *display_settings,
-                                                 int xmin, int ymin,
-                                                 int xmax, int ymax,
+                                                 const rcti *rects, int totrect,
                                                  bool copy_display_to_byte_buffer,
                                                  bool do_threads)
 {
@@ -2955,6 +3311,7 @@ static void imb_partial_display_buffer_update_ex(ImBuf *ibuf,
 	void *cache_handle = NULL;
 	unsigned char *display_buffer = NULL;
 	int buffer_width = ibuf->x;
+	int i;
 
 	if (ibuf->display_buffer_flags) {
 		int view_flag, display_index;
@@ -2996,6 +3353,11 @@ static void imb_partial_display_buffer_update_ex(ImBuf *ibuf,
 	if (display_buffer) {
 		ColormanageProcessor *cm_processor = NULL;
 		bool skip_transform = false;
+		PartialThreadData data;
+		ParallelRangeSettings settings;
+		rcti *chunks;
+		int totchunk;
+		size_t num_pixels;
 
 		/* Byte buffer is assumed to be in imbuf's rect space, so if byte buffer
 		 * is known we could skip display->linear->display conversion in case
@@ -3010,38 +3372,39 @@ static void imb_partial_display_buffer_update_ex(ImBuf *ibuf,
 			                                               display_settings);
 		}
 
+		chunks = partial_update_chunks_create(rects, totrect, &totchunk, &num_pixels);
+
 		if (!skip_transform) {
-			cm_processor = IMB_colormanagement_display_processor_new(
-			        view_settings, display_settings);
-		}
-
-		if (do_threads) {
-			PartialThreadData data;
-			data.ibuf = ibuf;
-			data.display_buffer = display_buffer;
-			data.linear_buffer = linear_buffer;
-			data.byte_buffer = byte_buffer;
-			data.display_stride = buffer_width;
-			data.linear_stride = stride;
-			data.linear_offset_x = offset_x;
-			data.linear_offset_y = offset_y;
-			data.cm_processor = cm_processor;
-			data.xmin = xmin;
-			data.ymin = ymin;
-			data.xmax = xmax;
-			IMB_processor_apply_threaded_scanlines(
-			    ymax - ymin, partial_buffer_update_rect_thread_do, &data);
-		}
-		else {
-			partial_buffer_update_rect(ibuf,
-			                           display_buffer, linear_buffer, byte_buffer,
-			                           buffer_width,
-			                           stride,
-			                           offset_x, offset_y,
-			                           cm_processor,
-			                           xmin, ymin, xmax, ymax);
+			/* Byte buffer of the image might be saved later on, only use
+			 * baked transform for buffers which are just drawn.
+			 */
+			if (copy_display_to_byte_buffer) {
+				cm_processor = IMB_colormanagement_display_processor_new(
+				        view_settings, display_settings);
+			}
+			else {
+				cm_processor = display_buffer_processor_new(
+				        view_settings, display_settings, num_pixels);
+			}
 		}
 
+		data.ibuf = ibuf;
+		data.display_buffer = display_buffer;
+		data.linear_buffer = linear_buffer;
+		data.byte_buffer = byte_buffer;
+		data.display_stride = buffer_width;
+		data.linear_stride = stride;
+		data.linear_offset_x = offset_x;
+		data.linear_offset_y = offset_y;
+		data.cm_processor = cm_processor;
+		data.chunks = chunks;
+
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.use_threading = do_threads;
+		BLI_task_parallel_range(0, totchunk, &data, partial_buffer_update_rect_thread_do, &settings);
+
+		MEM_freeN(chunks);
+
 		if (cm_processor) {
 			IMB_colormanagement_processor_free(cm_processor);
 		}
@@ -3050,12 +3413,14 @@ static void imb_partial_display_buffer_update_ex(ImBuf *ibuf,
 	}
 
 	if (copy_display_to_byte_buffer && (unsigned char *) ibuf->rect != display_buffer) {
-		int y;
-		for (y = ymin; y < ymax; y++) {
-			size_t index = (size_t)y * buffer_width * 4;
-			memcpy((unsigned char *)ibuf->rect + index,
-			       display_buffer + index,
-			       (size_t)(xmax - xmin) * 4);
+		for (i = 0; i < totrect; i++) {
+			int y;
+			for (y = rects[i].ymin; y < rects[i].ymax; y++) {
+				size_t index = ((size_t)y * buffer_width + rects[i].xmin) * 4;
+				memcpy((unsigned char *)ibuf->rect + index,
+				       display_buffer + index,
+				       (size_t)BLI_rcti_size_x(&rects[i]) * 4);
+			}
 		}
 	}
 }
@@ -3071,6 +3436,10 @@ void IMB_partial_display_buffer_update(ImBuf *ibuf,
                                        int xmax, int ymax,
                                        bool copy_display_to_byte_buffer)
 {
+	rcti rect;
+
+	BLI_rcti_init(&rect, xmin, xmax, ymin, ymax);
+
 	imb_partial_display_buffer_update_ex(ibuf,
 	                                     linear_buffer,
 	                                     byte_buffer,
@@ -3078,8 +3447,7 @@ void IMB_partial_display_buffer_update(ImBuf *ibuf,
 	                                     offset_x, offset_y,
 	                                     view_settings,
 	                                     display_settings,
-	                                     xmin, ymin,
-	                                     xmax, ymax,
+	                                     &rect, 1,
 	                                     copy_display_to_byte_buffer,
 	                                     false);
 
@@ -3098,6 +3466,10 @@ void IMB_partial_display_buffer_update_threaded(struct ImBuf *ibuf,
 	int width = xmax - xmin;
 	int height = ymax - ymin;
 	bool do_threads = (((size_t)width) * height >= 64 * 64);
+	rcti rect;
+
+	BLI_rcti_init(&rect, xmin, xmax, ymin, ymax);
+
 	imb_partial_display_buffer_update_ex(ibuf,
 	                                     linear_buffer,
 	                                     byte_buffer,
@@ -3105,14 +3477,110 @@ void IMB_partial_display_buffer_update_threaded(struct ImBuf *ibuf,
 	                                     offset_x, offset_y,
 	                                     view_settings,
 	                                     display_settings,
-	                                     xmin, ymin,
-	                                     xmax, ymax,
+	                                     &rect, 1,
 	                                     copy_display_to_byte_buffer,
 	                                     do_threads);
 }
 
+/* Update regions marked by IMB_partial_display_buffer_update_delayed().
+ * Only tiles which were actually touched are updated, not the whole
+ * bounds of them, so scattered updates (like paint strokes) stay cheap.
+ */
+static void imb_partial_display_buffer_update_invalid(ImBuf *ibuf,
+                                                      const ColorManagedViewSettings *view_settings,
+                                                      const ColorManagedDisplaySettings *display_settings)
+{
+	const int tiles_x = (ibuf->x + PARTIAL_UPDATE_TILE_SIZE - 1) / PARTIAL_UPDATE_TILE_SIZE;
+	const int tiles_y = (ibuf->y + PARTIAL_UPDATE_TILE_SIZE - 1) / PARTIAL_UPDATE_TILE_SIZE;
+	rcti bounds, *rects;
+	int totrect = 0;
+	size_t num_pixels = 0;
+
+	BLI_rcti_init(&bounds, 0, ibuf->x, 0, ibuf->y);
+	if (!BLI_rcti_isect(&ibuf->invalid_rect, &bounds, &bounds)) {
+		return;
+	}
+
+	if (ibuf->invalid_tiles && ibuf->invalid_tiles_x == tiles_x && ibuf->invalid_tiles_y == tiles_y) {
+		int tx, ty;
+
+		rects = MEM_mallocN(sizeof(rcti) * ((tiles_x + 1) / 2) * tiles_y, "partial update rects");
+
+		/* Merge runs of invalid tiles in every row of tiles into a single region. */
+		for (ty = 0; ty < tiles_y; ty++) {
+			const unsigned char *row = ibuf->invalid_tiles + (size_t)ty * tiles_x;
+
+			for (tx = 0; tx < tiles_x; tx++) {
+				rcti rect;
+				int tx_end;
+
+				if (row[tx] == 0) {
+					continue;
+				}
+
+				for (tx_end = tx + 1; tx_end < tiles_x && row[tx_end]; tx_end++) {
+					/* pass */
+				}
+
+				BLI_rcti_init(&rect,
+				              tx * PARTIAL_UPDATE_TILE_SIZE, tx_end * PARTIAL_UPDATE_TILE_SIZE,
+				              ty * PARTIAL_UPDATE_TILE_SIZE, (ty + 1) * PARTIAL_UPDATE_TILE_SIZE);
+
+				if (BLI_rcti_isect(&rect, &bounds, &rects[totrect])) {
+					num_pixels += (size_t)BLI_rcti_size_x(&rects[totrect]) * BLI_rcti_size_y(&rects[totrect]);
+					totrect++;
+				}
+
+				tx = tx_end;
+			}
+		}
+	}
+	else {
+		rects = MEM_mallocN(sizeof(rcti), "partial update rects");
+		rects[0] = bounds;
+		num_pixels = (size_t)BLI_rcti_size_x(&bounds) * BLI_rcti_size_y(&bounds);
+		totrect = 1;
+	}
+
+	if (totrect) {
+		imb_partial_display_buffer_update_ex(ibuf,
+		                                     ibuf->rect_float,
+		                                     (unsigned char *) ibuf->rect,
+		                                     ibuf->x,
+		                                     0, 0,
+		                                     view_settings,
+		                                     display_settings,
+		                                     rects, totrect,
+		                                     false,
+		                                     num_pixels >= 64 * 64);
+	}
+
+	MEM_freeN(rects);
+}
+
 void IMB_partial_display_buffer_update_delayed(ImBuf *ibuf, int xmin, int ymin, int xmax, int ymax)
 {
+	const int tiles_x = (ibuf->x + PARTIAL_UPDATE_TILE_SIZE - 1) / PARTIAL_UPDATE_TILE_SIZE;
+	const int tiles_y = (ibuf->y + PARTIAL_UPDATE_TILE_SIZE - 1) / PARTIAL_UPDATE_TILE_SIZE;
+	int tx, ty, tx_min, ty_min, tx_max, ty_max;
+
+	if (ibuf->invalid_tiles == NULL || ibuf->invalid_tiles_x != tiles_x || ibuf->invalid_tiles_y != tiles_y) {
+		if (ibuf->invalid_tiles) {
+			MEM_freeN(ibuf->invalid_tiles);
+		}
+
+		ibuf->invalid_tiles = MEM_callocN((size_t)tiles_x * tiles_y, "imbuf invalid tiles");
+		ibuf->invalid_tiles_x = tiles_x;
+		ibuf->invalid_tiles_y = tiles_y;
+
+		/* Regions which were marked before are not known per tile, update all of them. */
+		if (ibuf->invalid_rect.xmin != ibuf->invalid_rect.xmax) {
+			IMB_partial_display_buffer_update_delayed(ibuf,
+			                                          ibuf->invalid_rect.xmin, ibuf->invalid_rect.ymin,
+			                                          ibuf->invalid_rect.xmax, ibuf->invalid_rect.ymax);
+		}
+	}
+
 	if (ibuf->invalid_rect.xmin == ibuf->invalid_rect.xmax) {
 		BLI_rcti_init(&ibuf->invalid_rect, xmin, xmax, ymin, ymax);
 	}
@@ -3121,6 +3589,17 @@ void IMB_partial_display_buffer_update_delayed(ImBuf *ibuf, int xmin, int ymin,
 		BLI_rcti_init(&rect, xmin, xmax, ymin, ymax);
 		BLI_rcti_union(&ibuf->invalid_rect, &rect);
 	}
+
+	tx_min = max_ii(xmin, 0) / PARTIAL_UPDATE_TILE_SIZE;
+	ty_min = max_ii(ymin, 0) / PARTIAL_UPDATE_TILE_SIZE;
+	tx_max = min_ii((xmax + PARTIAL_UPDATE_TILE_SIZE - 1) / PARTIAL_UPDATE_TILE_SIZE, tiles_x);
+	ty_max = min_ii((ymax + PARTIAL_UPDATE_TILE_SIZE - 1) / PARTIAL_UPDATE_TILE_SIZE, tiles_y);
+
+	for (ty = ty_min; ty < ty_max; ty++) {
+		for (tx = tx_min; tx < tx_max; tx++) {
+			ibuf->invalid_tiles[(size_t)ty * tiles_x + tx] = 1;
+		}
+	}
 }
 
 /*********************** Pixel processor functions *************************/
@@ -3238,7 +3717,10 @@ void IMB_colormanagement_processor_apply(ColormanageProcessor *cm_processor, flo
 		}
 	}
 
-	if (cm_processor->processor && channels >= 3) {
+	if (cm_processor->display_lut && channels >= 3) {
+		display_lut_apply(cm_processor->display_lut, buffer, (size_t)width * height, channels, predivide);
+	}
+	else if (cm_processor->processor && channels >= 3) {
 		OCIO_PackedImageDesc *img;
 
 		/* apply OCIO processor */
@@ -3281,6 +3763,8 @@ void IMB_colormanagement_processor_free(ColormanageProcessor *cm_processor)
 		curvemapping_free(cm_processor->curve_mapping);
 	if (cm_processor->processor)
 		OCIO_processorRelease(cm_processor->processor);
+	if (cm_processor->display_lut)
+		display_lut_release(cm_processor->display_lut);
 
 	MEM_freeN(cm_processor);
 }
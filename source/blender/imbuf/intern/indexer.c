@@ -36,6 +36,7 @@
 #include "BLI_string.h"
 #include "BLI_fileops.h"
 #include "BLI_ghash.h"
+#include "BLI_threads.h"
 
 #include "IMB_indexer.h"
 #include "IMB_anim.h"
@@ -459,8 +460,22 @@ struct proxy_output_ctx {
 	int proxy_size;
 	int orig_height;
 	struct anim *anim;
+
+	/* Decoded frames waiting to be scaled and encoded by the thread of this proxy. */
+	ThreadQueue *frame_queue;
+	ListBase threads;
+
+	/* Frames pushed and not encoded yet, the decoder waits on the condition
+	 * while there are PROXY_QUEUE_MAX_FRAMES of them. */
+	int queue_len;
+	ThreadMutex queue_lock;
+	ThreadCondition queue_cond;
 };
 
+/* Amount of decoded frames which can be waiting for a proxy encoder,
+ * decoding is paused when the slowest encoder falls this much behind. */
+#define PROXY_QUEUE_MAX_FRAMES 8
+
 // work around stupid swscaler 16 bytes alignment bug...
 
 static int round_up(int x, int mod)
@@ -644,6 +659,79 @@ static int add_to_proxy_output_ffmpeg(
 	}
 }
 
+static void *proxy_output_thread(void *ctx_v)
+{
+	struct proxy_output_ctx *ctx = ctx_v;
+	AVFrame *frame;
+
+	while ((frame = BLI_thread_queue_pop(ctx->frame_queue))) {
+		add_to_proxy_output_ffmpeg(ctx, frame);
+		av_frame_free(&frame);
+
+		BLI_mutex_lock(&ctx->queue_lock);
+		ctx->queue_len--;
+		BLI_condition_notify_one(&ctx->queue_cond);
+		BLI_mutex_unlock(&ctx->queue_lock);
+	}
+
+	return NULL;
+}
+
+/* Every proxy size is scaled and encoded on its own thread, so the source
+ * is only decoded once no matter how many sizes are being built. */
+static void proxy_output_threads_start(struct proxy_output_ctx *ctx)
+{
+	if (!ctx) {
+		return;
+	}
+
+	ctx->frame_queue = BLI_thread_queue_init();
+	ctx->queue_len = 0;
+	BLI_mutex_init(&ctx->queue_lock);
+	BLI_condition_init(&ctx->queue_cond);
+	BLI_threadpool_init(&ctx->threads, proxy_output_thread, 1);
+	BLI_threadpool_insert(&ctx->threads, ctx);
+}
+
+/* Wait for all the queued frames to be encoded. */
+static void proxy_output_threads_end(struct proxy_output_ctx *ctx)
+{
+	if (!ctx || !ctx->frame_queue) {
+		return;
+	}
+
+	BLI_thread_queue_nowait(ctx->frame_queue);
+	BLI_threadpool_end(&ctx->threads);
+	BLI_thread_queue_free(ctx->frame_queue);
+	ctx->frame_queue = NULL;
+	BLI_condition_end(&ctx->queue_cond);
+	BLI_mutex_end(&ctx->queue_lock);
+}
+
+static void proxy_output_push_frame(struct proxy_output_ctx *ctx, AVFrame *frame)
+{
+	AVFrame *frame_copy;
+
+	if (!ctx) {
+		return;
+	}
+
+	/* Decoder reuses its frame, so hand out a reference of it. */
+	frame_copy = av_frame_clone(frame);
+	if (!frame_copy) {
+		return;
+	}
+
+	BLI_mutex_lock(&ctx->queue_lock);
+	while (ctx->queue_len >= PROXY_QUEUE_MAX_FRAMES) {
+		BLI_condition_wait(&ctx->queue_cond, &ctx->queue_lock);
+	}
+	ctx->queue_len++;
+	BLI_mutex_unlock(&ctx->queue_lock);
+
+	BLI_thread_queue_push(ctx->frame_queue, frame_copy);
+}
+
 static void free_proxy_output_ffmpeg(struct proxy_output_ctx *ctx,
                                      int rollback)
 {
@@ -784,6 +872,24 @@ static IndexBuildContext *index_ffmpeg_create_context(struct anim *anim, IMB_Tim
 
 	context->iCodecCtx->workaround_bugs = 1;
 
+	/* Decoding is the bottleneck when building proxies. Frame threading delays
+	 * decoded frames relative to the packets which were read, which would mess up
+	 * seek positions stored in timecode indices, so only use it for proxies.
+	 */
+	if (context->iCodec->capabilities & CODEC_CAP_AUTO_THREADS) {
+		context->iCodecCtx->thread_count = 0;
+	}
+	else {
+		context->iCodecCtx->thread_count = BLI_system_thread_count();
+	}
+
+	if ((context->iCodec->capabilities & CODEC_CAP_FRAME_THREADS) && tcs_in_use == IMB_TC_NONE) {
+		context->iCodecCtx->thread_type = FF_THREAD_FRAME;
+	}
+	else if (context->iCodec->capabilities & CODEC_CAP_SLICE_THREADS) {
+		context->iCodecCtx->thread_type = FF_THREAD_SLICE;
+	}
+
 	if (avcodec_open2(context->iCodecCtx, context->iCodec, NULL) < 0) {
 		avformat_close_input(&context->iFormatCtx);
 		MEM_freeN(context);
@@ -853,7 +959,7 @@ static void index_rebuild_ffmpeg_proc_decoded_frame(
 	unsigned long long pts = av_get_pts_from_frame(context->iFormatCtx, in_frame);
 
 	for (i = 0; i < context->num_proxy_sizes; i++) {
-		add_to_proxy_output_ffmpeg(context->proxy_ctx[i], in_frame);
+		proxy_output_push_frame(context->proxy_ctx[i], in_frame);
 	}
 
 	if (!context->start_pts_set) {
@@ -902,9 +1008,14 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
 	AVFrame *in_frame = 0;
 	AVPacket next_packet;
 	uint64_t stream_size;
+	int i;
 
 	memset(&next_packet, 0, sizeof(AVPacket));
 
+	for (i = 0; i < context->num_proxy_sizes; i++) {
+		proxy_output_threads_start(context->proxy_ctx[i]);
+	}
+
 	in_frame = av_frame_alloc();
 
 	stream_size = avio_size(context->iFormatCtx->pb);
@@ -973,6 +1084,10 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
 		} while (frame_finished);
 	}
 
+	for (i = 0; i < context->num_proxy_sizes; i++) {
+		proxy_output_threads_end(context->proxy_ctx[i]);
+	}
+
 	av_free(in_frame);
 
 	return 1;
@@ -415,6 +415,43 @@ bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibu
 	return result;
 }
 
+/* Check whether an item of given size fits into the cache without
+ * making the limiter free other items. */
+bool IMB_moviecache_has_space(size_t size)
+{
+	size_t mem_in_use, mem_limit;
+
+	if (!limitor)
+		IMB_moviecache_init();
+
+	mem_limit = MEM_CacheLimiter_get_maximum();
+
+	BLI_mutex_lock(&limitor_lock);
+	mem_in_use = MEM_CacheLimiter_get_memory_in_use(limitor);
+	BLI_mutex_unlock(&limitor_lock);
+
+	return mem_in_use + size <= mem_limit;
+}
+
+/* Free the least important items of all caches until an item of given size
+ * fits into the cache, returns false when not enough of them can be freed. */
+bool IMB_moviecache_make_space(size_t size)
+{
+	size_t mem_in_use, mem_limit;
+
+	if (!limitor)
+		IMB_moviecache_init();
+
+	mem_limit = MEM_CacheLimiter_get_maximum();
+
+	BLI_mutex_lock(&limitor_lock);
+	MEM_CacheLimiter_enforce_limits_reserve(limitor, size);
+	mem_in_use = MEM_CacheLimiter_get_memory_in_use(limitor);
+	BLI_mutex_unlock(&limitor_lock);
+
+	return mem_in_use + size <= mem_limit;
+}
+
 ImBuf *IMB_moviecache_get(MovieCache *cache, void *userkey)
 {
 	MovieCacheKey key;
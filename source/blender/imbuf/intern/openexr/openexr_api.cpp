@@ -1397,39 +1397,12 @@ static ExrPass *imb_exr_get_pass(ListBase *lb, char *passname)
 	return pass;
 }
 
-/* creates channels, makes a hierarchy and assigns memory to channels */
-static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream, MultiPartInputFile &file, int width, int height)
+/* makes the hierarchical layer list out of the flattened channels */
+static bool imb_exr_build_layers(ExrHandle *data)
 {
-	ExrLayer *lay;
-	ExrPass *pass;
 	ExrChannel *echan;
-	ExrHandle *data = (ExrHandle *)IMB_exr_get_handle();
-	int a;
 	char layname[EXR_TOT_MAXNAME], passname[EXR_TOT_MAXNAME];
 
-	data->ifile_stream = &file_stream;
-	data->ifile = &file;
-
-	data->width = width;
-	data->height = height;
-
-	std::vector<MultiViewChannelName> channels;
-	GetChannelsInMultiPartFile(*data->ifile, channels);
-
-	imb_exr_get_views(*data->ifile, *data->multiView);
-
-	for (size_t i = 0; i < channels.size(); i++) {
-		IMB_exr_add_channel(data, NULL, channels[i].name.c_str(), channels[i].view.c_str(), 0, 0, NULL, false);
-
-		echan = (ExrChannel *)data->channels.last;
-		echan->m->name = channels[i].name;
-		echan->m->view = channels[i].view;
-		echan->m->part_number = channels[i].part_number;
-		echan->m->internal_name = channels[i].internal_name;
-	}
-
-	/* now try to sort out how to assign memory to the channels */
-	/* first build hierarchical layer list */
 	for (echan = (ExrChannel *)data->channels.first; echan; echan = echan->next) {
 		if (imb_exr_split_channel_name(echan, layname, passname)) {
 
@@ -1459,6 +1432,82 @@ static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream, MultiPartInputFil
 	}
 	if (echan) {
 		printf("error, too many channels in one pass: %s\n", echan->m->name.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+/* position of every channel of the pass in its interleaved buffer,
+ * we can have RGB(A), XYZ(W), UVA, anything else is kept in file order */
+static void imb_exr_pass_channel_offsets(ExrPass *pass, int r_offset[EXR_PASS_MAXCHAN])
+{
+	int a;
+
+	if (pass->totchan == 3 || pass->totchan == 4) {
+		char lookup[256];
+
+		memset(lookup, 0, sizeof(lookup));
+
+		if (pass->chan[0]->chan_id == 'B' || pass->chan[1]->chan_id == 'B' ||  pass->chan[2]->chan_id == 'B') {
+			lookup[(unsigned int)'R'] = 0;
+			lookup[(unsigned int)'G'] = 1;
+			lookup[(unsigned int)'B'] = 2;
+			lookup[(unsigned int)'A'] = 3;
+		}
+		else if (pass->chan[0]->chan_id == 'Y' || pass->chan[1]->chan_id == 'Y' ||  pass->chan[2]->chan_id == 'Y') {
+			lookup[(unsigned int)'X'] = 0;
+			lookup[(unsigned int)'Y'] = 1;
+			lookup[(unsigned int)'Z'] = 2;
+			lookup[(unsigned int)'W'] = 3;
+		}
+		else {
+			lookup[(unsigned int)'U'] = 0;
+			lookup[(unsigned int)'V'] = 1;
+			lookup[(unsigned int)'A'] = 2;
+		}
+		for (a = 0; a < pass->totchan; a++) {
+			r_offset[a] = lookup[(unsigned int)pass->chan[a]->chan_id];
+		}
+	}
+	else {
+		for (a = 0; a < pass->totchan; a++) {
+			r_offset[a] = a;
+		}
+	}
+}
+
+/* creates channels, makes a hierarchy and assigns memory to channels */
+static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream, MultiPartInputFile &file, int width, int height)
+{
+	ExrLayer *lay;
+	ExrPass *pass;
+	ExrChannel *echan;
+	ExrHandle *data = (ExrHandle *)IMB_exr_get_handle();
+	int a;
+
+	data->ifile_stream = &file_stream;
+	data->ifile = &file;
+
+	data->width = width;
+	data->height = height;
+
+	std::vector<MultiViewChannelName> channels;
+	GetChannelsInMultiPartFile(*data->ifile, channels);
+
+	imb_exr_get_views(*data->ifile, *data->multiView);
+
+	for (size_t i = 0; i < channels.size(); i++) {
+		IMB_exr_add_channel(data, NULL, channels[i].name.c_str(), channels[i].view.c_str(), 0, 0, NULL, false);
+
+		echan = (ExrChannel *)data->channels.last;
+		echan->m->name = channels[i].name;
+		echan->m->view = channels[i].view;
+		echan->m->part_number = channels[i].part_number;
+		echan->m->internal_name = channels[i].internal_name;
+	}
+
+	if (!imb_exr_build_layers(data)) {
 		IMB_exr_close(data);
 		return NULL;
 	}
@@ -1467,63 +1516,222 @@ static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream, MultiPartInputFil
 	for (lay = (ExrLayer *)data->layers.first; lay; lay = lay->next) {
 		for (pass = (ExrPass *)lay->passes.first; pass; pass = pass->next) {
 			if (pass->totchan) {
+				int offset[EXR_PASS_MAXCHAN];
+
 				pass->rect = (float *)MEM_mapallocN(width * height * pass->totchan * sizeof(float), "pass rect");
-				if (pass->totchan == 1) {
-					echan = pass->chan[0];
-					echan->rect = pass->rect;
-					echan->xstride = 1;
-					echan->ystride = width;
-					pass->chan_id[0] = echan->chan_id;
+				imb_exr_pass_channel_offsets(pass, offset);
+
+				for (a = 0; a < pass->totchan; a++) {
+					echan = pass->chan[a];
+					echan->rect = pass->rect + offset[a];
+					echan->xstride = pass->totchan;
+					echan->ystride = width * pass->totchan;
+					pass->chan_id[offset[a]] = echan->chan_id;
 				}
-				else {
-					char lookup[256];
+			}
+		}
+	}
 
-					memset(lookup, 0, sizeof(lookup));
+	return data;
+}
 
-					/* we can have RGB(A), XYZ(W), UVA */
-					if (pass->totchan == 3 || pass->totchan == 4) {
-						if (pass->chan[0]->chan_id == 'B' || pass->chan[1]->chan_id == 'B' ||  pass->chan[2]->chan_id == 'B') {
-							lookup[(unsigned int)'R'] = 0;
-							lookup[(unsigned int)'G'] = 1;
-							lookup[(unsigned int)'B'] = 2;
-							lookup[(unsigned int)'A'] = 3;
-						}
-						else if (pass->chan[0]->chan_id == 'Y' || pass->chan[1]->chan_id == 'Y' ||  pass->chan[2]->chan_id == 'Y') {
-							lookup[(unsigned int)'X'] = 0;
-							lookup[(unsigned int)'Y'] = 1;
-							lookup[(unsigned int)'Z'] = 2;
-							lookup[(unsigned int)'W'] = 3;
-						}
-						else {
-							lookup[(unsigned int)'U'] = 0;
-							lookup[(unsigned int)'V'] = 1;
-							lookup[(unsigned int)'A'] = 2;
-						}
-						for (a = 0; a < pass->totchan; a++) {
-							echan = pass->chan[a];
-							echan->rect = pass->rect + lookup[(unsigned int)echan->chan_id];
-							echan->xstride = pass->totchan;
-							echan->ystride = width * pass->totchan;
-							pass->chan_id[(unsigned int)lookup[(unsigned int)echan->chan_id]] = echan->chan_id;
-						}
-					}
-					else { /* unknown */
-						for (a = 0; a < pass->totchan; a++) {
-							echan = pass->chan[a];
-							echan->rect = pass->rect + a;
-							echan->xstride = pass->totchan;
-							echan->ystride = width * pass->totchan;
-							pass->chan_id[a] = echan->chan_id;
-						}
-					}
-				}
+
+/* ********************** lazy reading ********************** */
+
+/* Opens the file like #IMB_exr_begin_read and builds the layer hierarchy,
+ * but doesn't allocate any pixels: passes are decoded on request with
+ * #IMB_exr_read_pass_rect, so callers only pay for what they use.
+ * #IMB_exr_multilayer_convert can be used on the handle, passes get a NULL rect. */
+int IMB_exr_begin_read_lazy(void *handle, const char *filename, int *width, int *height)
+{
+	ExrHandle *data = (ExrHandle *)handle;
+	ExrLayer *lay;
+	ExrPass *pass;
+
+	if (IMB_exr_begin_read(handle, filename, width, height) == 0) {
+		return 0;
+	}
+
+	if (!imb_exr_build_layers(data)) {
+		return 0;
+	}
+
+	for (lay = (ExrLayer *)data->layers.first; lay; lay = lay->next) {
+		for (pass = (ExrPass *)lay->passes.first; pass; pass = pass->next) {
+			int offset[EXR_PASS_MAXCHAN];
+
+			imb_exr_pass_channel_offsets(pass, offset);
+			for (int a = 0; a < pass->totchan; a++) {
+				pass->chan_id[offset[a]] = pass->chan[a]->chan_id;
 			}
 		}
 	}
 
-	return data;
+	return 1;
+}
+
+static ExrPass *imb_exr_find_pass(ExrHandle *data, const char *layname, const char *passname, const char *viewname)
+{
+	ExrLayer *lay = (ExrLayer *)BLI_findstring(&data->layers, layname ? layname : "", offsetof(ExrLayer, name));
+	char name[EXR_PASS_MAXNAME];
+
+	if (lay == NULL) {
+		return NULL;
+	}
+
+	if (viewname && viewname[0] != '\0') {
+		BLI_snprintf(name, sizeof(name), "%s.%s", passname, viewname);
+	}
+	else {
+		BLI_strncpy(name, passname, sizeof(name));
+	}
+
+	return (ExrPass *)BLI_findstring(&lay->passes, name, offsetof(ExrPass, name));
+}
+
+/* Scanlines decoded at once for crops narrower than the image. OpenEXR
+ * always writes full lines (or full tiles), these go through a temporary
+ * band buffer which still has enough lines to keep its decoding threads busy. */
+#define EXR_LAZY_BAND_LINES 64
+
+static void imb_exr_insert_pass_slices(
+        ExrPass *pass, FrameBuffer &frameBuffer, int part, float *first,
+        size_t xstride, ptrdiff_t ystride)
+{
+	int offset[EXR_PASS_MAXCHAN];
+
+	imb_exr_pass_channel_offsets(pass, offset);
+
+	for (int a = 0; a < pass->totchan; a++) {
+		ExrChannel *echan = pass->chan[a];
+		if (echan->m->part_number == part) {
+			frameBuffer.insert(echan->m->internal_name, Slice(Imf::FLOAT, (char *)(first + offset[a]), xstride, ystride));
+		}
+	}
 }
 
+/* Reads lines ymin..ymax (in Blender convention, bottom to top) of all image columns
+ * into buffer, which is interleaved with pass->totchan floats per pixel. */
+static bool imb_exr_read_pass_lines(ExrHandle *data, ExrPass *pass, bool flip, int ymin, int ymax, float *buffer)
+{
+	const int totchan = pass->totchan;
+	const size_t xstride = totchan * sizeof(float);
+	int numparts = data->ifile->parts();
+
+	for (int i = 0; i < numparts; i++) {
+		bool in_part = false;
+
+		for (int a = 0; a < totchan; a++) {
+			if (pass->chan[a]->m->part_number == i) {
+				in_part = true;
+				break;
+			}
+		}
+		if (!in_part) {
+			continue;
+		}
+
+		InputPart in(*data->ifile, i);
+		Box2i dw = in.header().dataWindow();
+		FrameBuffer frameBuffer;
+		float *first;
+		ptrdiff_t ystride;
+		int exr_ymin, exr_ymax;
+
+		if (!flip) {
+			/* first line of the buffer is the last file line which is read, same
+			 * pointer arithmetic as IMB_exr_read_channels, relative to the crop */
+			first = buffer - totchan * (dw.min.x - (ptrdiff_t)(dw.min.y + data->height - 1 - ymin) * data->width);
+			ystride = -(ptrdiff_t)xstride * data->width;
+			exr_ymin = dw.min.y + data->height - 1 - ymax;
+			exr_ymax = dw.min.y + data->height - 1 - ymin;
+		}
+		else {
+			first = buffer - totchan * (dw.min.x + (ptrdiff_t)(dw.min.y + ymin) * data->width);
+			ystride = (ptrdiff_t)xstride * data->width;
+			exr_ymin = dw.min.y + ymin;
+			exr_ymax = dw.min.y + ymax;
+		}
+
+		imb_exr_insert_pass_slices(pass, frameBuffer, i, first, xstride, ystride);
+
+		try {
+			in.setFrameBuffer(frameBuffer);
+			exr_printf("readPixels:lazy[%d]: min.y: %d, max.y: %d\n", i, exr_ymin, exr_ymax);
+			in.readPixels(exr_ymin, exr_ymax);
+		}
+		catch (const std::exception& exc) {
+			std::cerr << "OpenEXR-readPixels: ERROR: " << exc.what() << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Decodes the region xmin..xmax, ymin..ymax (inclusive, in Blender image space) of one pass
+ * into rect, which holds (xmax - xmin + 1) * (ymax - ymin + 1) pixels with
+ * one float per pass channel, laid out like RenderPass rects.
+ * Only the lines (or tiles) overlapping the region are decoded, using the
+ * OpenEXR thread pool. Reads on the same handle are not to be done in parallel. */
+bool IMB_exr_read_pass_rect(void *handle, const char *layname, const char *passname, const char *viewname,
+                            int xmin, int ymin, int xmax, int ymax, float *rect)
+{
+	ExrHandle *data = (ExrHandle *)handle;
+	ExrPass *pass;
+
+	if (data->ifile == NULL) {
+		return false;
+	}
+
+	pass = imb_exr_find_pass(data, layname, passname, viewname);
+	if (pass == NULL || pass->totchan == 0) {
+		return false;
+	}
+
+	CLAMP_MIN(xmin, 0);
+	CLAMP_MIN(ymin, 0);
+	CLAMP_MAX(xmax, data->width - 1);
+	CLAMP_MAX(ymax, data->height - 1);
+	if (xmin > xmax || ymin > ymax) {
+		return false;
+	}
+
+	/* check if exr was saved with previous versions of blender which flipped images */
+	const StringAttribute *ta = data->ifile->header(0).findTypedAttribute <StringAttribute> ("BlenderMultiChannel");
+	const bool flip = (ta && STREQLEN(ta->value().c_str(), "Blender V2.43", 13));
+	const int totchan = pass->totchan;
+	const int width = xmax - xmin + 1;
+
+	if (width == data->width) {
+		/* full lines, decode straight into the caller's buffer */
+		return imb_exr_read_pass_lines(data, pass, flip, ymin, ymax, rect);
+	}
+
+	const size_t line_size = (size_t)data->width * totchan;
+	const int band_lines = std::min(EXR_LAZY_BAND_LINES, ymax - ymin + 1);
+	float *band = (float *)MEM_mallocN(sizeof(float) * line_size * band_lines, "exr lazy band");
+	bool ok = true;
+
+	for (int y = ymin; y <= ymax && ok; y += band_lines) {
+		const int y_end = std::min(y + band_lines - 1, ymax);
+
+		ok = imb_exr_read_pass_lines(data, pass, flip, y, y_end, band);
+
+		for (int line = y; line <= y_end && ok; line++) {
+			memcpy(rect + (size_t)(line - ymin) * width * totchan,
+			       band + (size_t)(line - y) * line_size + (size_t)xmin * totchan,
+			       sizeof(float) * width * totchan);
+		}
+	}
+
+	MEM_freeN(band);
+
+	return ok;
+}
+
+#undef EXR_LAZY_BAND_LINES
+
 
 /* ********************************************************* */
 
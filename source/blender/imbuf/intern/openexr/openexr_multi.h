@@ -83,6 +83,11 @@ void    IMB_exr_add_view(void *handle, const char *name);
 
 bool IMB_exr_has_multilayer(void *handle);
 
+/* lazy reading, decodes single passes or crops on request */
+int     IMB_exr_begin_read_lazy(void *handle, const char *filename, int *width, int *height);
+bool    IMB_exr_read_pass_rect(void *handle, const char *layname, const char *passname, const char *viewname,
+                               int xmin, int ymin, int xmax, int ymax, float *rect);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -33,8 +33,10 @@
 
 
 #include "BLI_utildefines.h"
+#include "BLI_math_base.h"
 #include "BLI_math_color.h"
 #include "BLI_math_interp.h"
+#include "BLI_task.h"
 #include "MEM_guardedalloc.h"
 
 #include "imbuf.h"
@@ -881,673 +883,461 @@ static bool q_scale_linear_interpolation(
 	return true;
 }
 
-static ImBuf *scaledownx(struct ImBuf *ibuf, int newx)
+static void scalefast_Z_ImBuf(ImBuf *ibuf, int newx, int newy)
 {
-	const int do_rect = (ibuf->rect != NULL);
-	const int do_float = (ibuf->rect_float != NULL);
-	const size_t rect_size = ibuf->x * ibuf->y * 4;
-
-	uchar *rect, *_newrect, *newrect;
-	float *rectf, *_newrectf, *newrectf;
-	float sample, add, val[4], nval[4], valf[4], nvalf[4];
+	int *zbuf, *newzbuf, *_newzbuf = NULL;
+	float *zbuf_float, *newzbuf_float, *_newzbuf_float = NULL;
 	int x, y;
+	int ofsx, ofsy, stepx, stepy;
 
-	rectf = _newrectf = newrectf = NULL;
-	rect = _newrect = newrect = NULL;
-	nval[0] =  nval[1] = nval[2] = nval[3] = 0.0f;
-	nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
-
-	if (!do_rect && !do_float) return (ibuf);
-
-	if (do_rect) {
-		_newrect = MEM_mallocN(newx * ibuf->y * sizeof(uchar) * 4, "scaledownx");
-		if (_newrect == NULL) return(ibuf);
-	}
-	if (do_float) {
-		_newrectf = MEM_mallocN(newx * ibuf->y * sizeof(float) * 4, "scaledownxf");
-		if (_newrectf == NULL) {
-			if (_newrect) MEM_freeN(_newrect);
-			return(ibuf);
+	if (ibuf->zbuf) {
+		_newzbuf = MEM_mallocN(newx * newy * sizeof(int), __func__);
+		if (_newzbuf == NULL) {
+			IMB_freezbufImBuf(ibuf);
 		}
 	}
 
-	add = (ibuf->x - 0.01) / newx;
-
-	if (do_rect) {
-		rect = (uchar *) ibuf->rect;
-		newrect = _newrect;
-	}
-	if (do_float) {
-		rectf = ibuf->rect_float;
-		newrectf = _newrectf;
+	if (ibuf->zbuf_float) {
+		_newzbuf_float = MEM_mallocN((size_t)newx * newy * sizeof(float), __func__);
+		if (_newzbuf_float == NULL) {
+			IMB_freezbuffloatImBuf(ibuf);
+		}
 	}
 
-	for (y = ibuf->y; y > 0; y--) {
-		sample = 0.0f;
-		val[0] =  val[1] = val[2] = val[3] = 0.0f;
-		valf[0] = valf[1] = valf[2] = valf[3] = 0.0f;
+	if (!_newzbuf && !_newzbuf_float) {
+		return;
+	}
 
-		for (x = newx; x > 0; x--) {
-			if (do_rect) {
-				nval[0] = -val[0] * sample;
-				nval[1] = -val[1] * sample;
-				nval[2] = -val[2] * sample;
-				nval[3] = -val[3] * sample;
-			}
-			if (do_float) {
-				nvalf[0] = -valf[0] * sample;
-				nvalf[1] = -valf[1] * sample;
-				nvalf[2] = -valf[2] * sample;
-				nvalf[3] = -valf[3] * sample;
-			}
+	stepx = (65536.0 * (ibuf->x - 1.0) / (newx - 1.0)) + 0.5;
+	stepy = (65536.0 * (ibuf->y - 1.0) / (newy - 1.0)) + 0.5;
+	ofsy = 32768;
 
-			sample += add;
+	newzbuf = _newzbuf;
+	newzbuf_float = _newzbuf_float;
 
-			while (sample >= 1.0f) {
-				sample -= 1.0f;
+	for (y = newy; y > 0; y--, ofsy += stepy) {
+		if (newzbuf) {
+			zbuf = ibuf->zbuf;
+			zbuf += (ofsy >> 16) * ibuf->x;
+			ofsx = 32768;
+			for (x = newx; x > 0; x--, ofsx += stepx) {
+				*newzbuf++ = zbuf[ofsx >> 16];
+			}
+		}
 
-				if (do_rect) {
-					nval[0] += rect[0];
-					nval[1] += rect[1];
-					nval[2] += rect[2];
-					nval[3] += rect[3];
-					rect += 4;
-				}
-				if (do_float) {
-					nvalf[0] += rectf[0];
-					nvalf[1] += rectf[1];
-					nvalf[2] += rectf[2];
-					nvalf[3] += rectf[3];
-					rectf += 4;
-				}
+		if (newzbuf_float) {
+			zbuf_float = ibuf->zbuf_float;
+			zbuf_float += (ofsy >> 16) * ibuf->x;
+			ofsx = 32768;
+			for (x = newx; x > 0; x--, ofsx += stepx) {
+				*newzbuf_float++ = zbuf_float[ofsx >> 16];
 			}
+		}
+	}
 
-			if (do_rect) {
-				val[0] = rect[0]; val[1] = rect[1]; val[2] = rect[2]; val[3] = rect[3];
-				rect += 4;
+	if (_newzbuf) {
+		IMB_freezbufImBuf(ibuf);
+		ibuf->mall |= IB_zbuf;
+		ibuf->zbuf = _newzbuf;
+	}
 
-				newrect[0] = ((nval[0] + sample * val[0]) / add + 0.5f);
-				newrect[1] = ((nval[1] + sample * val[1]) / add + 0.5f);
-				newrect[2] = ((nval[2] + sample * val[2]) / add + 0.5f);
-				newrect[3] = ((nval[3] + sample * val[3]) / add + 0.5f);
+	if (_newzbuf_float) {
+		IMB_freezbuffloatImBuf(ibuf);
+		ibuf->mall |= IB_zbuffloat;
+		ibuf->zbuf_float = _newzbuf_float;
+	}
+}
 
-				newrect += 4;
-			}
-			if (do_float) {
+/* ******** separable filter scaling ******** */
 
-				valf[0] = rectf[0]; valf[1] = rectf[1]; valf[2] = rectf[2]; valf[3] = rectf[3];
-				rectf += 4;
+/* Source pixels contributing to every pixel along one axis of the scaled image. */
+typedef struct ScaleFilterAxis {
+	int *bounds;     /* first source pixel and number of taps, for every output pixel */
+	float *weights;  /* max_taps normalized weights for every output pixel */
+	int max_taps;
+} ScaleFilterAxis;
 
-				newrectf[0] = ((nvalf[0] + sample * valf[0]) / add);
-				newrectf[1] = ((nvalf[1] + sample * valf[1]) / add);
-				newrectf[2] = ((nvalf[2] + sample * valf[2]) / add);
-				newrectf[3] = ((nvalf[3] + sample * valf[3]) / add);
+static float scale_filter_box(float x)
+{
+	return (x > -0.5f && x <= 0.5f) ? 1.0f : 0.0f;
+}
 
-				newrectf += 4;
-			}
+static float scale_filter_triangle(float x)
+{
+	x = fabsf(x);
+	return (x < 1.0f) ? 1.0f - x : 0.0f;
+}
 
-			sample -= 1.0f;
-		}
-	}
+/* Catmull-Rom spline (a = -0.5) */
+static float scale_filter_bicubic(float x)
+{
+	const float a = -0.5f;
 
-	if (do_rect) {
-		// printf("%ld %ld\n", (uchar *)rect - ((uchar *)ibuf->rect), rect_size);
-		BLI_assert((uchar *)rect - ((uchar *)ibuf->rect) == rect_size); /* see bug [#26502] */
-		imb_freerectImBuf(ibuf);
-		ibuf->mall |= IB_rect;
-		ibuf->rect = (unsigned int *) _newrect;
+	x = fabsf(x);
+	if (x < 1.0f) {
+		return ((a + 2.0f) * x - (a + 3.0f)) * x * x + 1.0f;
 	}
-	if (do_float) {
-		// printf("%ld %ld\n", rectf - ibuf->rect_float, rect_size);
-		BLI_assert((rectf - ibuf->rect_float) == rect_size); /* see bug [#26502] */
-		imb_freerectfloatImBuf(ibuf);
-		ibuf->mall |= IB_rectfloat;
-		ibuf->rect_float = _newrectf;
+	else if (x < 2.0f) {
+		return (((x - 5.0f) * x + 8.0f) * x - 4.0f) * a;
 	}
-	(void)rect_size; /* UNUSED in release builds */
+	return 0.0f;
+}
 
-	ibuf->x = newx;
-	return(ibuf);
+static float scale_filter_sinc(float x)
+{
+	if (x == 0.0f) {
+		return 1.0f;
+	}
+	x *= (float)M_PI;
+	return sinf(x) / x;
 }
 
+/* three lobed */
+static float scale_filter_lanczos(float x)
+{
+	if (fabsf(x) >= 3.0f) {
+		return 0.0f;
+	}
+	return scale_filter_sinc(x) * scale_filter_sinc(x / 3.0f);
+}
 
-static ImBuf *scaledowny(struct ImBuf *ibuf, int newy)
+static float (*scale_filter_func(eIMBScaleFilter filter, float *r_support))(float x)
 {
-	const int do_rect = (ibuf->rect != NULL);
-	const int do_float = (ibuf->rect_float != NULL);
-	const size_t rect_size = ibuf->x * ibuf->y * 4;
+	switch (filter) {
+		case IMB_SCALE_FILTER_BOX:
+			*r_support = 0.5f;
+			return scale_filter_box;
+		case IMB_SCALE_FILTER_BICUBIC:
+			*r_support = 2.0f;
+			return scale_filter_bicubic;
+		case IMB_SCALE_FILTER_LANCZOS:
+			*r_support = 3.0f;
+			return scale_filter_lanczos;
+		case IMB_SCALE_FILTER_BILINEAR:
+		default:
+			*r_support = 1.0f;
+			return scale_filter_triangle;
+	}
+}
 
-	uchar *rect, *_newrect, *newrect;
-	float *rectf, *_newrectf, *newrectf;
-	float sample, add, val[4], nval[4], valf[4], nvalf[4];
-	int x, y, skipx;
+/* When shrinking, the filter is stretched over all source pixels covered by
+ * an output pixel, so downscaling averages instead of skipping pixels.
+ * The box filter weights source pixels by how much of them the output pixel
+ * covers, so non-integer ratios give an exact area average. */
+static void scale_filter_axis_init(ScaleFilterAxis *axis, int in_size, int out_size, eIMBScaleFilter filter)
+{
+	float support;
+	float (*func)(float x) = scale_filter_func(filter, &support);
+	const float scale = (float)in_size / (float)out_size;
+	const float filter_scale = max_ff(scale, 1.0f);
+	const float radius = support * filter_scale;
+	int i;
 
-	rectf = _newrectf = newrectf = NULL;
-	rect = _newrect = newrect = NULL;
-	nval[0] =  nval[1] = nval[2] = nval[3] = 0.0f;
-	nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
+	axis->max_taps = (in_size == out_size) ? 1 : (int)ceilf(radius) * 2 + 1;
+	axis->bounds = MEM_mallocN(sizeof(int) * 2 * out_size, "scale filter bounds");
+	axis->weights = MEM_callocN(sizeof(float) * axis->max_taps * out_size, "scale filter weights");
 
-	if (!do_rect && !do_float) return (ibuf);
+	for (i = 0; i < out_size; i++) {
+		float *weights = axis->weights + (size_t)i * axis->max_taps;
+		const float center = (i + 0.5f) * scale;
+		int start, taps, k;
+		float total = 0.0f;
 
-	if (do_rect) {
-		_newrect = MEM_mallocN(newy * ibuf->x * sizeof(uchar) * 4, "scaledowny");
-		if (_newrect == NULL) return(ibuf);
-	}
-	if (do_float) {
-		_newrectf = MEM_mallocN(newy * ibuf->x * sizeof(float) * 4, "scaledownyf");
-		if (_newrectf == NULL) {
-			if (_newrect) MEM_freeN(_newrect);
-			return(ibuf);
+		if (in_size == out_size) {
+			start = i;
+			taps = 1;
+			weights[0] = 1.0f;
 		}
-	}
+		else if (filter == IMB_SCALE_FILTER_BOX) {
+			const float lo = center - radius, hi = center + radius;
 
-	add = (ibuf->y - 0.01) / newy;
-	skipx = 4 * ibuf->x;
+			start = max_ii((int)floorf(lo), 0);
+			taps = min_ii(min_ii((int)ceilf(hi), in_size) - start, axis->max_taps);
 
-	for (x = skipx - 4; x >= 0; x -= 4) {
-		if (do_rect) {
-			rect = ((uchar *) ibuf->rect) + x;
-			newrect = _newrect + x;
-		}
-		if (do_float) {
-			rectf = ibuf->rect_float + x;
-			newrectf = _newrectf + x;
+			for (k = 0; k < taps; k++) {
+				weights[k] = max_ff(min_ff(hi, (float)(start + k + 1)) - max_ff(lo, (float)(start + k)), 0.0f);
+				total += weights[k];
+			}
 		}
+		else {
+			start = max_ii((int)(center - radius + 0.5f), 0);
+			taps = min_ii(min_ii((int)(center + radius + 0.5f), in_size) - start, axis->max_taps);
 
-		sample = 0.0f;
-		val[0] =  val[1] = val[2] = val[3] = 0.0f;
-		valf[0] = valf[1] = valf[2] = valf[3] = 0.0f;
-
-		for (y = newy; y > 0; y--) {
-			if (do_rect) {
-				nval[0] = -val[0] * sample;
-				nval[1] = -val[1] * sample;
-				nval[2] = -val[2] * sample;
-				nval[3] = -val[3] * sample;
-			}
-			if (do_float) {
-				nvalf[0] = -valf[0] * sample;
-				nvalf[1] = -valf[1] * sample;
-				nvalf[2] = -valf[2] * sample;
-				nvalf[3] = -valf[3] * sample;
+			for (k = 0; k < taps; k++) {
+				weights[k] = func((start + k - center + 0.5f) / filter_scale);
+				total += weights[k];
 			}
+		}
 
-			sample += add;
-
-			while (sample >= 1.0f) {
-				sample -= 1.0f;
-
-				if (do_rect) {
-					nval[0] += rect[0];
-					nval[1] += rect[1];
-					nval[2] += rect[2];
-					nval[3] += rect[3];
-					rect += skipx;
-				}
-				if (do_float) {
-					nvalf[0] += rectf[0];
-					nvalf[1] += rectf[1];
-					nvalf[2] += rectf[2];
-					nvalf[3] += rectf[3];
-					rectf += skipx;
+		if (in_size != out_size) {
+			if (total != 0.0f) {
+				for (k = 0; k < taps; k++) {
+					weights[k] /= total;
 				}
 			}
-
-			if (do_rect) {
-				val[0] = rect[0]; val[1] = rect[1]; val[2] = rect[2]; val[3] = rect[3];
-				rect += skipx;
-
-				newrect[0] = ((nval[0] + sample * val[0]) / add + 0.5f);
-				newrect[1] = ((nval[1] + sample * val[1]) / add + 0.5f);
-				newrect[2] = ((nval[2] + sample * val[2]) / add + 0.5f);
-				newrect[3] = ((nval[3] + sample * val[3]) / add + 0.5f);
-
-				newrect += skipx;
+			else {
+				/* filter fell between source pixels, use the nearest one */
+				start = min_ii((int)center, in_size - 1);
+				taps = 1;
+				weights[0] = 1.0f;
 			}
-			if (do_float) {
-
-				valf[0] = rectf[0]; valf[1] = rectf[1]; valf[2] = rectf[2]; valf[3] = rectf[3];
-				rectf += skipx;
-
-				newrectf[0] = ((nvalf[0] + sample * valf[0]) / add);
-				newrectf[1] = ((nvalf[1] + sample * valf[1]) / add);
-				newrectf[2] = ((nvalf[2] + sample * valf[2]) / add);
-				newrectf[3] = ((nvalf[3] + sample * valf[3]) / add);
-
-				newrectf += skipx;
-			}
-
-			sample -= 1.0f;
 		}
-	}
 
-	if (do_rect) {
-		// printf("%ld %ld\n", (uchar *)rect - ((uchar *)ibuf->rect), rect_size);
-		BLI_assert((uchar *)rect - ((uchar *)ibuf->rect) == rect_size); /* see bug [#26502] */
-		imb_freerectImBuf(ibuf);
-		ibuf->mall |= IB_rect;
-		ibuf->rect = (unsigned int *) _newrect;
+		axis->bounds[i * 2] = start;
+		axis->bounds[i * 2 + 1] = taps;
 	}
-	if (do_float) {
-		// printf("%ld %ld\n", rectf - ibuf->rect_float, rect_size);
-		BLI_assert((rectf - ibuf->rect_float) == rect_size); /* see bug [#26502] */
-		imb_freerectfloatImBuf(ibuf);
-		ibuf->mall |= IB_rectfloat;
-		ibuf->rect_float = (float *) _newrectf;
-	}
-	(void)rect_size; /* UNUSED in release builds */
-
-	ibuf->y = newy;
-	return(ibuf);
 }
 
-
-static ImBuf *scaleupx(struct ImBuf *ibuf, int newx)
+static void scale_filter_axis_free(ScaleFilterAxis *axis)
 {
-	uchar *rect, *_newrect = NULL, *newrect;
-	float *rectf, *_newrectf = NULL, *newrectf;
-	float sample, add;
-	float val_a, nval_a, diff_a;
-	float val_b, nval_b, diff_b;
-	float val_g, nval_g, diff_g;
-	float val_r, nval_r, diff_r;
-	float val_af, nval_af, diff_af;
-	float val_bf, nval_bf, diff_bf;
-	float val_gf, nval_gf, diff_gf;
-	float val_rf, nval_rf, diff_rf;
-	int x, y;
-	bool do_rect = false, do_float = false;
-
-	val_a = nval_a = diff_a = val_b = nval_b = diff_b = 0;
-	val_g = nval_g = diff_g = val_r = nval_r = diff_r = 0;
-	val_af = nval_af = diff_af = val_bf = nval_bf = diff_bf = 0;
-	val_gf = nval_gf = diff_gf = val_rf = nval_rf = diff_rf = 0;
-	if (ibuf == NULL) return(NULL);
-	if (ibuf->rect == NULL && ibuf->rect_float == NULL) return (ibuf);
+	MEM_freeN(axis->bounds);
+	MEM_freeN(axis->weights);
+}
 
-	if (ibuf->rect) {
-		do_rect = true;
-		_newrect = MEM_mallocN(newx * ibuf->y * sizeof(int), "scaleupx");
-		if (_newrect == NULL) return(ibuf);
-	}
-	if (ibuf->rect_float) {
-		do_float = true;
-		_newrectf = MEM_mallocN(newx * ibuf->y * sizeof(float) * 4, "scaleupxf");
-		if (_newrectf == NULL) {
-			if (_newrect) MEM_freeN(_newrect);
-			return(ibuf);
-		}
-	}
+BLI_INLINE unsigned char scale_filter_to_byte(float f)
+{
+	return (f <= 0.0f) ? 0 : ((f >= 254.5f) ? 255 : (unsigned char)(f + 0.5f));
+}
 
-	add = (ibuf->x - 1.001) / (newx - 1.0);
+typedef struct ScaleFilterData {
+	const ScaleFilterAxis *axis;
 
-	rect = (uchar *) ibuf->rect;
-	rectf = (float *) ibuf->rect_float;
-	newrect = _newrect;
-	newrectf = _newrectf;
+	/* source, only one of them is set */
+	const unsigned char *src_byte;
+	const float *src_float;
+	int src_width;
 
-	for (y = ibuf->y; y > 0; y--) {
+	/* destination, only one of them is set */
+	unsigned char *dst_byte;
+	float *dst_float;
+	int dst_width;
 
-		sample = 0;
+	int channels;
+} ScaleFilterData;
 
-		if (do_rect) {
-			val_a = rect[0];
-			nval_a = rect[4];
-			diff_a = nval_a - val_a;
-			val_a += 0.5f;
-
-			val_b = rect[1];
-			nval_b = rect[5];
-			diff_b = nval_b - val_b;
-			val_b += 0.5f;
-
-			val_g = rect[2];
-			nval_g = rect[6];
-			diff_g = nval_g - val_g;
-			val_g += 0.5f;
-
-			val_r = rect[3];
-			nval_r = rect[7];
-			diff_r = nval_r - val_r;
-			val_r += 0.5f;
-
-			rect += 8;
+/* Filters one row horizontally into a float row. Four channel pixels are
+ * accumulated as a whole, which compilers turn into vector operations. */
+static void scale_filter_horizontal_cb(void *__restrict userdata, const int y,
+                                       const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	const ScaleFilterData *data = userdata;
+	const ScaleFilterAxis *axis = data->axis;
+	const int channels = data->channels;
+	float *dst = data->dst_float + (size_t)y * data->dst_width * channels;
+	int x, k, c;
+
+	for (x = 0; x < data->dst_width; x++, dst += channels) {
+		const int start = axis->bounds[x * 2];
+		const int taps = axis->bounds[x * 2 + 1];
+		const float *weights = axis->weights + (size_t)x * axis->max_taps;
+		const size_t offset = ((size_t)y * data->src_width + start) * channels;
+		float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+		if (data->src_byte) {
+			const unsigned char *src = data->src_byte + offset;
+			for (k = 0; k < taps; k++, src += 4) {
+				const float w = weights[k];
+				acc[0] += src[0] * w;
+				acc[1] += src[1] * w;
+				acc[2] += src[2] * w;
+				acc[3] += src[3] * w;
+			}
 		}
-		if (do_float) {
-			val_af = rectf[0];
-			nval_af = rectf[4];
-			diff_af = nval_af - val_af;
-
-			val_bf = rectf[1];
-			nval_bf = rectf[5];
-			diff_bf = nval_bf - val_bf;
-
-			val_gf = rectf[2];
-			nval_gf = rectf[6];
-			diff_gf = nval_gf - val_gf;
-
-			val_rf = rectf[3];
-			nval_rf = rectf[7];
-			diff_rf = nval_rf - val_rf;
-
-			rectf += 8;
+		else if (channels == 4) {
+			const float *src = data->src_float + offset;
+			for (k = 0; k < taps; k++, src += 4) {
+				const float w = weights[k];
+				acc[0] += src[0] * w;
+				acc[1] += src[1] * w;
+				acc[2] += src[2] * w;
+				acc[3] += src[3] * w;
+			}
 		}
-		for (x = newx; x > 0; x--) {
-			if (sample >= 1.0f) {
-				sample -= 1.0f;
-
-				if (do_rect) {
-					val_a = nval_a;
-					nval_a = rect[0];
-					diff_a = nval_a - val_a;
-					val_a += 0.5f;
-
-					val_b = nval_b;
-					nval_b = rect[1];
-					diff_b = nval_b - val_b;
-					val_b += 0.5f;
-
-					val_g = nval_g;
-					nval_g = rect[2];
-					diff_g = nval_g - val_g;
-					val_g += 0.5f;
-
-					val_r = nval_r;
-					nval_r = rect[3];
-					diff_r = nval_r - val_r;
-					val_r += 0.5f;
-					rect += 4;
-				}
-				if (do_float) {
-					val_af = nval_af;
-					nval_af = rectf[0];
-					diff_af = nval_af - val_af;
-
-					val_bf = nval_bf;
-					nval_bf = rectf[1];
-					diff_bf = nval_bf - val_bf;
-
-					val_gf = nval_gf;
-					nval_gf = rectf[2];
-					diff_gf = nval_gf - val_gf;
-
-					val_rf = nval_rf;
-					nval_rf = rectf[3];
-					diff_rf = nval_rf - val_rf;
-					rectf += 4;
+		else {
+			const float *src = data->src_float + offset;
+			for (k = 0; k < taps; k++, src += channels) {
+				for (c = 0; c < channels; c++) {
+					acc[c] += src[c] * weights[k];
 				}
 			}
-			if (do_rect) {
-				newrect[0] = val_a + sample * diff_a;
-				newrect[1] = val_b + sample * diff_b;
-				newrect[2] = val_g + sample * diff_g;
-				newrect[3] = val_r + sample * diff_r;
-				newrect += 4;
-			}
-			if (do_float) {
-				newrectf[0] = val_af + sample * diff_af;
-				newrectf[1] = val_bf + sample * diff_bf;
-				newrectf[2] = val_gf + sample * diff_gf;
-				newrectf[3] = val_rf + sample * diff_rf;
-				newrectf += 4;
-			}
-			sample += add;
 		}
-	}
 
-	if (do_rect) {
-		imb_freerectImBuf(ibuf);
-		ibuf->mall |= IB_rect;
-		ibuf->rect = (unsigned int *) _newrect;
-	}
-	if (do_float) {
-		imb_freerectfloatImBuf(ibuf);
-		ibuf->mall |= IB_rectfloat;
-		ibuf->rect_float = (float *) _newrectf;
+		for (c = 0; c < channels; c++) {
+			dst[c] = acc[c];
+		}
 	}
-
-	ibuf->x = newx;
-	return(ibuf);
 }
 
-static ImBuf *scaleupy(struct ImBuf *ibuf, int newy)
+/* Filters one output row vertically out of the horizontally filtered rows,
+ * a whole row is accumulated per tap to walk memory linearly. */
+static void scale_filter_vertical_cb(void *__restrict userdata, const int y,
+                                     const ParallelRangeTLS *__restrict UNUSED(tls))
 {
-	uchar *rect, *_newrect = NULL, *newrect;
-	float *rectf, *_newrectf = NULL, *newrectf;
-	float sample, add;
-	float val_a, nval_a, diff_a;
-	float val_b, nval_b, diff_b;
-	float val_g, nval_g, diff_g;
-	float val_r, nval_r, diff_r;
-	float val_af, nval_af, diff_af;
-	float val_bf, nval_bf, diff_bf;
-	float val_gf, nval_gf, diff_gf;
-	float val_rf, nval_rf, diff_rf;
-	int x, y, skipx;
-	bool do_rect = false, do_float = false;
-
-	val_a = nval_a = diff_a = val_b = nval_b = diff_b = 0;
-	val_g = nval_g = diff_g = val_r = nval_r = diff_r = 0;
-	val_af = nval_af = diff_af = val_bf = nval_bf = diff_bf = 0;
-	val_gf = nval_gf = diff_gf = val_rf = nval_rf = diff_rf = 0;
-	if (ibuf == NULL) return(NULL);
-	if (ibuf->rect == NULL && ibuf->rect_float == NULL) return (ibuf);
-
-	if (ibuf->rect) {
-		do_rect = true;
-		_newrect = MEM_mallocN(ibuf->x * newy * sizeof(int), "scaleupy");
-		if (_newrect == NULL) return(ibuf);
-	}
-	if (ibuf->rect_float) {
-		do_float = true;
-		_newrectf = MEM_mallocN(ibuf->x * newy * sizeof(float) * 4, "scaleupyf");
-		if (_newrectf == NULL) {
-			if (_newrect) MEM_freeN(_newrect);
-			return(ibuf);
+	const ScaleFilterData *data = userdata;
+	const ScaleFilterAxis *axis = data->axis;
+	const size_t row_size = (size_t)data->dst_width * data->channels;
+	const int start = axis->bounds[y * 2];
+	const int taps = axis->bounds[y * 2 + 1];
+	const float *weights = axis->weights + (size_t)y * axis->max_taps;
+	size_t i;
+	int k;
+
+	if (data->dst_float) {
+		float *dst = data->dst_float + (size_t)y * row_size;
+
+		memset(dst, 0, sizeof(float) * row_size);
+		for (k = 0; k < taps; k++) {
+			const float *src = data->src_float + (size_t)(start + k) * row_size;
+			const float w = weights[k];
+			for (i = 0; i < row_size; i++) {
+				dst[i] += src[i] * w;
+			}
 		}
 	}
+	else {
+		unsigned char *dst = data->dst_byte + (size_t)y * row_size;
+
+		for (i = 0; i < row_size; i += 4) {
+			const float *src = data->src_float + (size_t)start * row_size + i;
+			float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+			for (k = 0; k < taps; k++, src += row_size) {
+				const float w = weights[k];
+				acc[0] += src[0] * w;
+				acc[1] += src[1] * w;
+				acc[2] += src[2] * w;
+				acc[3] += src[3] * w;
+			}
 
-	add = (ibuf->y - 1.001) / (newy - 1.0);
-	skipx = 4 * ibuf->x;
-
-	rect = (uchar *) ibuf->rect;
-	rectf = (float *) ibuf->rect_float;
-	newrect = _newrect;
-	newrectf = _newrectf;
-
-	for (x = ibuf->x; x > 0; x--) {
-
-		sample = 0;
-		if (do_rect) {
-			rect = ((uchar *)ibuf->rect) + 4 * (x - 1);
-			newrect = _newrect + 4 * (x - 1);
-
-			val_a = rect[0];
-			nval_a = rect[skipx];
-			diff_a = nval_a - val_a;
-			val_a += 0.5f;
-
-			val_b = rect[1];
-			nval_b = rect[skipx + 1];
-			diff_b = nval_b - val_b;
-			val_b += 0.5f;
-
-			val_g = rect[2];
-			nval_g = rect[skipx + 2];
-			diff_g = nval_g - val_g;
-			val_g += 0.5f;
-
-			val_r = rect[3];
-			nval_r = rect[skipx + 3];
-			diff_r = nval_r - val_r;
-			val_r += 0.5f;
-
-			rect += 2 * skipx;
+			dst[i + 0] = scale_filter_to_byte(acc[0]);
+			dst[i + 1] = scale_filter_to_byte(acc[1]);
+			dst[i + 2] = scale_filter_to_byte(acc[2]);
+			dst[i + 3] = scale_filter_to_byte(acc[3]);
 		}
-		if (do_float) {
-			rectf = ibuf->rect_float + 4 * (x - 1);
-			newrectf = _newrectf + 4 * (x - 1);
+	}
+}
 
-			val_af = rectf[0];
-			nval_af = rectf[skipx];
-			diff_af = nval_af - val_af;
+static void scale_filter_run(int tot, ScaleFilterData *data, TaskParallelRangeFunc func, size_t pixels)
+{
+	ParallelRangeSettings settings;
 
-			val_bf = rectf[1];
-			nval_bf = rectf[skipx + 1];
-			diff_bf = nval_bf - val_bf;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (pixels > 64 * 64);
+	BLI_task_parallel_range(0, tot, data, func, &settings);
+}
 
-			val_gf = rectf[2];
-			nval_gf = rectf[skipx + 2];
-			diff_gf = nval_gf - val_gf;
+/* Horizontal pass into a float buffer of newx * ibuf->y pixels, then a
+ * vertical pass into the final buffer. Float buffers skip passes along
+ * axes which don't change size. */
+static void *scale_filter_buffer(
+        const unsigned char *src_byte, const float *src_float, int channels,
+        int width, int height, int newx, int newy,
+        eIMBScaleFilter filter_x, eIMBScaleFilter filter_y)
+{
+	ScaleFilterAxis axis_x, axis_y;
+	ScaleFilterData data = {NULL};
+	const float *tmp;
+	float *tmp_alloc = NULL;
+	void *result;
 
-			val_rf = rectf[3];
-			nval_rf = rectf[skipx + 3];
-			diff_rf = nval_rf - val_rf;
+	data.channels = channels;
 
-			rectf += 2 * skipx;
-		}
+	if (src_float && newx == width) {
+		tmp = src_float;
+	}
+	else {
+		tmp_alloc = MEM_mapallocN(sizeof(float) * newx * height * channels, "scale filter temp");
+
+		scale_filter_axis_init(&axis_x, width, newx, filter_x);
+		data.axis = &axis_x;
+		data.src_byte = src_byte;
+		data.src_float = src_float;
+		data.src_width = width;
+		data.dst_float = tmp_alloc;
+		data.dst_width = newx;
+		scale_filter_run(height, &data, scale_filter_horizontal_cb, (size_t)newx * height);
+		scale_filter_axis_free(&axis_x);
+
+		tmp = tmp_alloc;
+	}
 
-		for (y = newy; y > 0; y--) {
-			if (sample >= 1.0f) {
-				sample -= 1.0f;
-
-				if (do_rect) {
-					val_a = nval_a;
-					nval_a = rect[0];
-					diff_a = nval_a - val_a;
-					val_a += 0.5f;
-
-					val_b = nval_b;
-					nval_b = rect[1];
-					diff_b = nval_b - val_b;
-					val_b += 0.5f;
-
-					val_g = nval_g;
-					nval_g = rect[2];
-					diff_g = nval_g - val_g;
-					val_g += 0.5f;
-
-					val_r = nval_r;
-					nval_r = rect[3];
-					diff_r = nval_r - val_r;
-					val_r += 0.5f;
-					rect += skipx;
-				}
-				if (do_float) {
-					val_af = nval_af;
-					nval_af = rectf[0];
-					diff_af = nval_af - val_af;
-
-					val_bf = nval_bf;
-					nval_bf = rectf[1];
-					diff_bf = nval_bf - val_bf;
-
-					val_gf = nval_gf;
-					nval_gf = rectf[2];
-					diff_gf = nval_gf - val_gf;
-
-					val_rf = nval_rf;
-					nval_rf = rectf[3];
-					diff_rf = nval_rf - val_rf;
-					rectf += skipx;
-				}
-			}
-			if (do_rect) {
-				newrect[0] = val_a + sample * diff_a;
-				newrect[1] = val_b + sample * diff_b;
-				newrect[2] = val_g + sample * diff_g;
-				newrect[3] = val_r + sample * diff_r;
-				newrect += skipx;
-			}
-			if (do_float) {
-				newrectf[0] = val_af + sample * diff_af;
-				newrectf[1] = val_bf + sample * diff_bf;
-				newrectf[2] = val_gf + sample * diff_gf;
-				newrectf[3] = val_rf + sample * diff_rf;
-				newrectf += skipx;
-			}
-			sample += add;
+	if (src_float && newy == height) {
+		if (tmp_alloc) {
+			return tmp_alloc;
 		}
+		return MEM_dupallocN(src_float);
 	}
 
-	if (do_rect) {
-		imb_freerectImBuf(ibuf);
-		ibuf->mall |= IB_rect;
-		ibuf->rect = (unsigned int *) _newrect;
+	if (src_float) {
+		result = MEM_mapallocN(sizeof(float) * newx * newy * channels, "scale filter float");
+		data.dst_byte = NULL;
+		data.dst_float = result;
 	}
-	if (do_float) {
-		imb_freerectfloatImBuf(ibuf);
-		ibuf->mall |= IB_rectfloat;
-		ibuf->rect_float = (float *) _newrectf;
+	else {
+		result = MEM_mapallocN(sizeof(unsigned char) * newx * newy * 4, "scale filter byte");
+		data.dst_byte = result;
+		data.dst_float = NULL;
 	}
 
-	ibuf->y = newy;
-	return(ibuf);
+	scale_filter_axis_init(&axis_y, height, newy, filter_y);
+	data.axis = &axis_y;
+	data.src_byte = NULL;
+	data.src_float = tmp;
+	data.src_width = newx;
+	data.dst_width = newx;
+	scale_filter_run(newy, &data, scale_filter_vertical_cb, (size_t)newx * newy);
+	scale_filter_axis_free(&axis_y);
+
+	if (tmp_alloc) {
+		MEM_freeN(tmp_alloc);
+	}
+
+	return result;
 }
 
-static void scalefast_Z_ImBuf(ImBuf *ibuf, int newx, int newy)
+static bool imb_scale_filter(ImBuf *ibuf, unsigned int newx, unsigned int newy,
+                             eIMBScaleFilter filter_x, eIMBScaleFilter filter_y)
 {
-	int *zbuf, *newzbuf, *_newzbuf = NULL;
-	float *zbuf_float, *newzbuf_float, *_newzbuf_float = NULL;
-	int x, y;
-	int ofsx, ofsy, stepx, stepy;
-
-	if (ibuf->zbuf) {
-		_newzbuf = MEM_mallocN(newx * newy * sizeof(int), __func__);
-		if (_newzbuf == NULL) {
-			IMB_freezbufImBuf(ibuf);
-		}
-	}
+	if (ibuf == NULL) return false;
+	if (ibuf->rect == NULL && ibuf->rect_float == NULL) return false;
 
-	if (ibuf->zbuf_float) {
-		_newzbuf_float = MEM_mallocN((size_t)newx * newy * sizeof(float), __func__);
-		if (_newzbuf_float == NULL) {
-			IMB_freezbuffloatImBuf(ibuf);
-		}
-	}
+	if (newx == 0) newx = ibuf->x;
+	if (newy == 0) newy = ibuf->y;
 
-	if (!_newzbuf && !_newzbuf_float) {
-		return;
+	if (newx == ibuf->x && newy == ibuf->y) {
+		return false;
 	}
 
-	stepx = (65536.0 * (ibuf->x - 1.0) / (newx - 1.0)) + 0.5;
-	stepy = (65536.0 * (ibuf->y - 1.0) / (newy - 1.0)) + 0.5;
-	ofsy = 32768;
-
-	newzbuf = _newzbuf;
-	newzbuf_float = _newzbuf_float;
-
-	for (y = newy; y > 0; y--, ofsy += stepy) {
-		if (newzbuf) {
-			zbuf = ibuf->zbuf;
-			zbuf += (ofsy >> 16) * ibuf->x;
-			ofsx = 32768;
-			for (x = newx; x > 0; x--, ofsx += stepx) {
-				*newzbuf++ = zbuf[ofsx >> 16];
-			}
-		}
+	scalefast_Z_ImBuf(ibuf, newx, newy);
 
-		if (newzbuf_float) {
-			zbuf_float = ibuf->zbuf_float;
-			zbuf_float += (ofsy >> 16) * ibuf->x;
-			ofsx = 32768;
-			for (x = newx; x > 0; x--, ofsx += stepx) {
-				*newzbuf_float++ = zbuf_float[ofsx >> 16];
-			}
-		}
+	if (ibuf->rect) {
+		unsigned int *rect = scale_filter_buffer(
+		        (unsigned char *)ibuf->rect, NULL, 4, ibuf->x, ibuf->y, newx, newy, filter_x, filter_y);
+		imb_freerectImBuf(ibuf);
+		ibuf->mall |= IB_rect;
+		ibuf->rect = rect;
 	}
 
-	if (_newzbuf) {
-		IMB_freezbufImBuf(ibuf);
-		ibuf->mall |= IB_zbuf;
-		ibuf->zbuf = _newzbuf;
+	if (ibuf->rect_float) {
+		float *rect_float = scale_filter_buffer(
+		        NULL, ibuf->rect_float, ibuf->channels, ibuf->x, ibuf->y, newx, newy, filter_x, filter_y);
+		imb_freerectfloatImBuf(ibuf);
+		ibuf->mall |= IB_rectfloat;
+		ibuf->rect_float = rect_float;
 	}
 
-	if (_newzbuf_float) {
-		IMB_freezbuffloatImBuf(ibuf);
-		ibuf->mall |= IB_zbuffloat;
-		ibuf->zbuf_float = _newzbuf_float;
-	}
+	ibuf->x = newx;
+	ibuf->y = newy;
+
+	return true;
+}
+
+/**
+ * Return true if \a ibuf is modified.
+ */
+bool IMB_scaleImBuf_filter(struct ImBuf *ibuf, unsigned int newx, unsigned int newy, eIMBScaleFilter filter)
+{
+	return imb_scale_filter(ibuf, newx, newy, filter, filter);
 }
 
 /**
@@ -1556,15 +1346,6 @@ static void scalefast_Z_ImBuf(ImBuf *ibuf, int newx, int newy)
 bool IMB_scaleImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy)
 {
 	if (ibuf == NULL) return false;
-	if (ibuf->rect == NULL && ibuf->rect_float == NULL) return false;
-
-	if (newx == ibuf->x && newy == ibuf->y) {
-		return false;
-	}
-
-	/* scaleup / scaledown functions below change ibuf->x and ibuf->y
-	 * so we first scale the Z-buffer (if any) */
-	scalefast_Z_ImBuf(ibuf, newx, newy);
 
 	/* try to scale common cases in a fast way */
 	/* disabled, quality loss is unacceptable, see report #18609  (ton) */
@@ -1572,12 +1353,10 @@ bool IMB_scaleImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy)
 		return true;
 	}
 
-	if (newx && (newx < ibuf->x)) scaledownx(ibuf, newx);
-	if (newy && (newy < ibuf->y)) scaledowny(ibuf, newy);
-	if (newx && (newx > ibuf->x)) scaleupx(ibuf, newx);
-	if (newy && (newy > ibuf->y)) scaleupy(ibuf, newy);
-
-	return true;
+	/* area average when shrinking, linear interpolation when enlarging */
+	return imb_scale_filter(ibuf, newx, newy,
+	                        (newx < ibuf->x) ? IMB_SCALE_FILTER_BOX : IMB_SCALE_FILTER_BILINEAR,
+	                        (newy < ibuf->y) ? IMB_SCALE_FILTER_BOX : IMB_SCALE_FILTER_BILINEAR);
 }
 
 struct imbufRGBA {
@@ -1665,113 +1444,8 @@ bool IMB_scalefastImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy
 	return true;
 }
 
-/* ******** threaded scaling ******** */
-
-typedef struct ScaleTreadInitData {
-	ImBuf *ibuf;
-
-	unsigned int newx;
-	unsigned int newy;
-
-	unsigned char *byte_buffer;
-	float *float_buffer;
-} ScaleTreadInitData;
-
-typedef struct ScaleThreadData {
-	ImBuf *ibuf;
-
-	unsigned int newx;
-	unsigned int newy;
-
-	int start_line;
-	int tot_line;
-
-	unsigned char *byte_buffer;
-	float *float_buffer;
-} ScaleThreadData;
-
-static void scale_thread_init(void *data_v, int start_line, int tot_line, void *init_data_v)
-{
-	ScaleThreadData *data = (ScaleThreadData *) data_v;
-	ScaleTreadInitData *init_data = (ScaleTreadInitData *) init_data_v;
-
-	data->ibuf = init_data->ibuf;
-
-	data->newx = init_data->newx;
-	data->newy = init_data->newy;
-
-	data->start_line = start_line;
-	data->tot_line = tot_line;
-
-	data->byte_buffer = init_data->byte_buffer;
-	data->float_buffer = init_data->float_buffer;
-}
-
-static void *do_scale_thread(void *data_v)
-{
-	ScaleThreadData *data = (ScaleThreadData *) data_v;
-	ImBuf *ibuf = data->ibuf;
-	int i;
-	float factor_x = (float) ibuf->x / data->newx;
-	float factor_y = (float) ibuf->y / data->newy;
-
-	for (i = 0; i < data->tot_line; i++) {
-		int y = data->start_line + i;
-		int x;
-
-		for (x = 0; x < data->newx; x++) {
-			float u = (float) x * factor_x;
-			float v = (float) y * factor_y;
-			int offset = y * data->newx + x;
-
-			if (data->byte_buffer) {
-				unsigned char *pixel = data->byte_buffer + 4 * offset;
-				BLI_bilinear_interpolation_char((unsigned char *) ibuf->rect, pixel, ibuf->x, ibuf->y, 4, u, v);
-			}
-
-			if (data->float_buffer) {
-				float *pixel = data->float_buffer + ibuf->channels * offset;
-				BLI_bilinear_interpolation_fl(ibuf->rect_float, pixel, ibuf->x, ibuf->y, ibuf->channels, u, v);
-			}
-		}
-	}
-
-	return NULL;
-}
-
+/* Interpolating scaling, both when shrinking and enlarging. */
 void IMB_scaleImBuf_threaded(ImBuf *ibuf, unsigned int newx, unsigned int newy)
 {
-	ScaleTreadInitData init_data = {NULL};
-
-	/* prepare initialization data */
-	init_data.ibuf = ibuf;
-
-	init_data.newx = newx;
-	init_data.newy = newy;
-
-	if (ibuf->rect)
-		init_data.byte_buffer = MEM_mallocN(4 * newx * newy * sizeof(char), "threaded scale byte buffer");
-
-	if (ibuf->rect_float)
-		init_data.float_buffer = MEM_mallocN(ibuf->channels * newx * newy * sizeof(float), "threaded scale float buffer");
-
-	/* actual scaling threads */
-	IMB_processor_apply_threaded(newy, sizeof(ScaleThreadData), &init_data,
-	                             scale_thread_init, do_scale_thread);
-
-	/* alter image buffer */
-	ibuf->x = newx;
-	ibuf->y = newy;
-
-	if (ibuf->rect) {
-		imb_freerectImBuf(ibuf);
-		ibuf->mall |= IB_rect;
-		ibuf->rect = (unsigned int *) init_data.byte_buffer;
-	}
-
-	if (ibuf->rect_float) {
-		imb_freerectfloatImBuf(ibuf);
-		ibuf->mall |= IB_rectfloat;
-		ibuf->rect_float = init_data.float_buffer;
-	}
+	imb_scale_filter(ibuf, newx, newy, IMB_SCALE_FILTER_BILINEAR, IMB_SCALE_FILTER_BILINEAR);
 }
@@ -131,7 +131,11 @@ typedef struct ID {
 	int us;
 	int icon_id;
 	int recalc;
-	int pad;
+	/**
+	 * Incremented whenever the data-block is tagged for a data update (runtime only),
+	 * caches of data derived from it compare it to notice changes.
+	 */
+	int recalc_generation;
 	IDProperty *properties;
 
 	void *py_instance;
@@ -119,6 +119,7 @@ typedef enum {
 	eSubsurfModifierFlag_DebugIncr    = (1 << 1),
 	eSubsurfModifierFlag_ControlEdges = (1 << 2),
 	eSubsurfModifierFlag_SubsurfUv    = (1 << 3),
+	eSubsurfModifierFlag_OpenSubdivCPU = (1 << 4),
 } SubsurfModifierFlag;
 
 /* not a real modifier */
@@ -139,6 +140,7 @@ typedef struct SubsurfModifierData {
 	short use_opensubdiv, pad[3];
 
 	void *emCache, *mCache;
+	void *renderCache;  /* CCGSubSurf kept between render frames, OpenSubdiv CPU evaluation only */
 } SubsurfModifierData;
 
 typedef struct LatticeModifierData {
@@ -457,6 +459,7 @@ enum {
 	MOD_DECIM_FLAG_TRIANGULATE         = (1 << 1),  /* for collapse only. dont convert tri pairs back to quads */
 	MOD_DECIM_FLAG_ALL_BOUNDARY_VERTS  = (1 << 2),  /* for dissolve only. collapse all verts between 2 faces */
 	MOD_DECIM_FLAG_SYMMETRY            = (1 << 3),
+	MOD_DECIM_FLAG_FAST                = (1 << 4),  /* for collapse only. threaded batch collapse */
 };
 
 enum {
@@ -550,6 +553,7 @@ typedef struct ArmatureModifierData {
 	int pad2;
 	struct Object *object;
 	float *prevCos;           /* stored input of previous modifier, for vertexgroup blending */
+	void *weights_cache;      /* runtime only, per-vertex bone weights kept between evaluations */
 	char defgrp_name[64];     /* MAX_VGROUP_NAME */
 } ArmatureModifierData;
 
@@ -655,7 +659,8 @@ typedef struct BooleanModifierData {
 
 	struct Object *object;
 	char operation;
-	char pad[2];
+	char solver;
+	char pad;
 	char bm_flag;
 	float double_threshold;
 } BooleanModifierData;
@@ -666,6 +671,12 @@ typedef enum {
 	eBooleanModifierOp_Difference = 2,
 } BooleanModifierOp;
 
+/* solver */
+typedef enum {
+	eBooleanModifierSolver_BMesh  = 0,
+	eBooleanModifierSolver_Exact  = 1,
+} BooleanModifierSolver;
+
 /* bm_flag (only used when G_DEBUG) */
 enum {
 	eBooleanModifierBMeshFlag_BMesh_Separate            = (1 << 0),
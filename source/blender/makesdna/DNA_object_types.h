@@ -296,7 +296,7 @@ typedef struct Object {
 
 	float ima_ofs[2];		/* offset for image empties */
 	ImageUser *iuser;		/* must be non-null when oject is an empty image */
-	void *pad3;
+	struct ModifierStackCache *modifier_cache;	/* runtime, results of the modifier stack */
 
 	ListBase lodlevels;		/* contains data for levels of detail */
 	LodLevel *currentlod;
@@ -299,7 +299,7 @@ typedef struct ParticleSystem {
 	char name[64];							/* particle system name, MAX_NAME */
 
 	float imat[4][4];	/* used for duplicators */
-	float cfra, tree_frame, bvhtree_frame;
+	float cfra, tree_frame, pad2;
 	int seed, child_seed;
 	int flag, totpart, totunexist, totchild, totcached, totchildcache;
 	short recalc, target_psys, totkeyed, bakespace;
@@ -323,7 +323,6 @@ typedef struct ParticleSystem {
 	int tot_fluidsprings, alloc_fluidsprings;
 
 	struct KDTree *tree;					/* used for interactions with self and other systems */
-	struct BVHTree *bvhtree;				/* used for interactions with self and other systems */
 
 	struct ParticleDrawData *pdd;
 
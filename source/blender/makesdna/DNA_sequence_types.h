@@ -201,6 +201,10 @@ typedef struct Sequence {
 
 	/* modifiers */
 	ListBase modifiers;
+
+	/* identifies files of the strip in the sequencer disk cache, kept on rename */
+	int cache_id;
+	int pad1;
 } Sequence;
 
 typedef struct MetaStack {
@@ -225,6 +229,8 @@ typedef struct Editing {
 	int over_ofs, over_cfra;
 	int over_flag, proxy_storage;
 	rctf over_border;
+
+	int cache_flag, pad;
 } Editing;
 
 /* ************* Effect Variable Structs ********* */
@@ -398,6 +404,10 @@ typedef struct SequencerScopes {
 /* store proxies in project directory */
 #define SEQ_EDIT_PROXY_DIR_STORAGE 1
 
+/* Editor->cache_flag */
+/* store rendered frames on disk, next to the memory cache */
+#define SEQ_CACHE_DISK_CACHE_ENABLE 1
+
 /* SpeedControlVars->flags */
 #define SEQ_SPEED_INTEGRATE      1
 /* #define SEQ_SPEED_BLEND          2 */ /* DEPRECATED */
@@ -494,9 +494,9 @@ typedef struct UserDef {
 	char keyconfigstr[64];
 
 	short undosteps;
-	short pad1;
+	short undo_flag;  /* eUserpref_Undo_Flag */
 	int undomemory;
-	int pad3;
+	int sculpt_undo_memory;  /* megabytes of packed sculpt undo kept in memory, 0 means unlimited */
 	short gp_manhattendist, gp_euclideandist, gp_eraser;
 	short gp_settings;  /* eGP_UserdefSettings */
 	short tb_leftmouse, tb_rightmouse;
@@ -582,7 +582,11 @@ typedef struct UserDef {
 	struct WalkNavigation walk_navigation;
 
 	short opensubdiv_compute_type;
-	char pad5[6];
+	short sequencer_disk_cache_compression; /* zlib compression level of the sequencer disk cache */
+	int sequencer_disk_cache_size_limit;    /* sequencer disk cache size limit, in gigabytes */
+	char sequencer_disk_cache_dir[1024];    /* 1024 = FILE_MAX */
+	int modifier_cache_limit;               /* modifier stack cache size limit, in megabytes */
+	int pad10;
 } UserDef;
 
 extern UserDef U; /* from blenkernel blender.c */
@@ -603,7 +607,7 @@ typedef enum eUserPref_Section {
 /* UserDef.flag */
 typedef enum eUserPref_Flag {
 	USER_AUTOSAVE			= (1 << 0),
-	USER_FLAG_DEPRECATED_1	= (1 << 1),  /* cleared */
+	USER_MODIFIER_CACHE_DISABLE	= (1 << 1),
 	USER_FLAG_DEPRECATED_2	= (1 << 2),  /* cleared */
 	USER_FLAG_DEPRECATED_3	= (1 << 3),  /* cleared */
 	USER_SCENEGLOBAL		= (1 << 4),
@@ -711,6 +715,11 @@ typedef enum eUserpref_APP_Flag {
 	USER_APP_VIEW3D_HIDE_CURSOR = (1 << 1),
 } eUserpref_APP_Flag;
 
+/* UserDef.undo_flag */
+typedef enum eUserpref_Undo_Flag {
+	USER_UNDO_SCULPT_PACK = (1 << 0),
+} eUserpref_Undo_Flag;
+
 /* Auto-Keying mode.
  * UserDef.autokey_mode */
 typedef enum eAutokey_Mode {
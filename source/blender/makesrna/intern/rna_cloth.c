@@ -600,6 +600,14 @@ static void rna_def_cloth_sim_settings(BlenderRNA *brna)
 	RNA_def_property_update(prop, 0, "rna_cloth_update");
 	RNA_def_property_clear_flag(prop, PROP_ANIMATABLE);
 
+	prop = RNA_def_property(srna, "use_parallel_solver", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "flags", CLOTH_SIMSETTINGS_FLAG_PARALLEL_SOLVER);
+	RNA_def_property_ui_text(prop, "Parallel Solver",
+	                         "Solve the implicit system with a multi-threaded block-sparse conjugate gradient "
+	                         "using a block-Jacobi preconditioner (results differ slightly from the default solver)");
+	RNA_def_property_update(prop, 0, "rna_cloth_update");
+	RNA_def_property_clear_flag(prop, PROP_ANIMATABLE);
+
 	/* unused */
 
 	/* unused still */
@@ -425,16 +425,24 @@ static int rna_RenderPass_rect_get_length(PointerRNA *ptr, int length[RNA_MAX_AR
 	return length[0] * length[1];
 }
 
+/* passes of lazily read multilayer files have no rect until an image of them is acquired */
 static void rna_RenderPass_rect_get(PointerRNA *ptr, float *values)
 {
 	RenderPass *rpass = (RenderPass *)ptr->data;
-	memcpy(values, rpass->rect, sizeof(float) * rpass->rectx * rpass->recty * rpass->channels);
+	const size_t size = sizeof(float) * rpass->rectx * rpass->recty * rpass->channels;
+
+	if (rpass->rect)
+		memcpy(values, rpass->rect, size);
+	else
+		memset(values, 0, size);
 }
 
 void rna_RenderPass_rect_set(PointerRNA *ptr, const float *values)
 {
 	RenderPass *rpass = (RenderPass *)ptr->data;
-	memcpy(rpass->rect, values, sizeof(float) * rpass->rectx * rpass->recty * rpass->channels);
+
+	if (rpass->rect)
+		memcpy(rpass->rect, values, sizeof(float) * rpass->rectx * rpass->recty * rpass->channels);
 }
 
 static PointerRNA rna_BakePixel_next_get(PointerRNA *ptr)
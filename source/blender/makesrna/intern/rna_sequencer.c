@@ -1712,6 +1712,12 @@ static void rna_def_editor(BlenderRNA *brna)
 	RNA_def_property_string_sdna(prop, NULL, "proxy_dir");
 	RNA_def_property_ui_text(prop, "Proxy Directory", "");
 	RNA_def_property_update(prop, NC_SPACE | ND_SPACE_SEQUENCER, "rna_SequenceEditor_update_cache");
+
+	prop = RNA_def_property(srna, "use_cache_disk", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "cache_flag", SEQ_CACHE_DISK_CACHE_ENABLE);
+	RNA_def_property_ui_text(prop, "Disk Cache",
+	                         "Store rendered frames on disk, so they are kept when the file is reopened");
+	RNA_def_property_update(prop, NC_SPACE | ND_SPACE_SEQUENCER, NULL);
 }
 
 static void rna_def_filter_video(StructRNA *srna)
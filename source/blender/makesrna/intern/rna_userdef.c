@@ -3692,6 +3692,19 @@ static void rna_def_userdef_edit(BlenderRNA *brna)
 	RNA_def_property_range(prop, 0, max_memory_in_megabytes_int());
 	RNA_def_property_ui_text(prop, "Undo Memory Size", "Maximum memory usage in megabytes (0 means unlimited)");
 
+	prop = RNA_def_property(srna, "use_sculpt_undo_pack", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "undo_flag", USER_UNDO_SCULPT_PACK);
+	RNA_def_property_ui_text(prop, "Pack Sculpt Undo",
+	                         "Store sculpt undo steps as compressed differences, "
+	                         "uses less memory at the cost of some processing when undoing");
+
+	prop = RNA_def_property(srna, "sculpt_undo_memory_limit", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "sculpt_undo_memory");
+	RNA_def_property_range(prop, 0, max_memory_in_megabytes_int());
+	RNA_def_property_ui_text(prop, "Sculpt Undo Memory Size",
+	                         "Maximum memory used by packed sculpt undo steps in megabytes, "
+	                         "older steps are moved to a temporary file (0 means unlimited)");
+
 	prop = RNA_def_property(srna, "use_global_undo", PROP_BOOLEAN, PROP_NONE);
 	RNA_def_property_boolean_sdna(prop, NULL, "uiflag", USER_GLOBALUNDO);
 	RNA_def_property_ui_text(prop, "Global Undo",
@@ -4105,12 +4118,36 @@ static void rna_def_userdef_system(BlenderRNA *brna)
 	RNA_def_property_ui_range(prop, 0, 500, 1, -1);
 	RNA_def_property_ui_text(prop, "Prefetch Frames", "Number of frames to render ahead during playback (sequencer only)");
 
+	prop = RNA_def_property(srna, "sequencer_disk_cache_size_limit", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "sequencer_disk_cache_size_limit");
+	RNA_def_property_range(prop, 1, INT_MAX);
+	RNA_def_property_ui_range(prop, 1, 1000, 1, -1);
+	RNA_def_property_ui_text(prop, "Disk Cache Limit", "Sequencer disk cache size limit (in gigabytes)");
+
+	prop = RNA_def_property(srna, "sequencer_disk_cache_compression", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "sequencer_disk_cache_compression");
+	RNA_def_property_range(prop, 0, 9);
+	RNA_def_property_ui_text(prop, "Disk Cache Compression",
+	                         "Compression level of frames stored in the sequencer disk cache, "
+	                         "higher levels use less space but are slower to write");
+
 	prop = RNA_def_property(srna, "memory_cache_limit", PROP_INT, PROP_NONE);
 	RNA_def_property_int_sdna(prop, NULL, "memcachelimit");
 	RNA_def_property_range(prop, 0, max_memory_in_megabytes_int());
 	RNA_def_property_ui_text(prop, "Memory Cache Limit", "Memory cache limit (in megabytes)");
 	RNA_def_property_update(prop, 0, "rna_Userdef_memcache_update");
 
+	prop = RNA_def_property(srna, "use_modifier_cache", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_negative_sdna(prop, NULL, "flag", USER_MODIFIER_CACHE_DISABLE);
+	RNA_def_property_ui_text(prop, "Modifier Cache",
+	                         "Keep intermediate results of modifier stacks, so only modifiers "
+	                         "after the first changed one are evaluated again");
+
+	prop = RNA_def_property(srna, "modifier_cache_limit", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "modifier_cache_limit");
+	RNA_def_property_range(prop, 1, max_memory_in_megabytes_int());
+	RNA_def_property_ui_text(prop, "Modifier Cache Limit", "Modifier cache memory limit (in megabytes)");
+
 	prop = RNA_def_property(srna, "frame_server_port", PROP_INT, PROP_NONE);
 	RNA_def_property_int_sdna(prop, NULL, "frameserverport");
 	RNA_def_property_range(prop, 0, 32727);
@@ -4592,6 +4629,12 @@ static void rna_def_userdef_filepaths(BlenderRNA *brna)
 	RNA_def_property_string_sdna(prop, NULL, "render_cachedir");
 	RNA_def_property_ui_text(prop, "Render Cache Path", "Where to cache raw render results");
 
+	prop = RNA_def_property(srna, "sequencer_disk_cache_directory", PROP_STRING, PROP_DIRPATH);
+	RNA_def_property_string_sdna(prop, NULL, "sequencer_disk_cache_dir");
+	RNA_def_property_ui_text(prop, "Sequencer Disk Cache Path",
+	                         "Where to store rendered sequencer frames, "
+	                         "when empty they are stored next to the blend file");
+
 	prop = RNA_def_property(srna, "image_editor", PROP_STRING, PROP_FILEPATH);
 	RNA_def_property_string_sdna(prop, NULL, "image_editor");
 	RNA_def_property_ui_text(prop, "Image Editor", "Path to an image editor");
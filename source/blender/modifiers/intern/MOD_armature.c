@@ -71,6 +71,17 @@ static void copyData(const ModifierData *md, ModifierData *target)
 
 	modifier_copyData_generic(md, target);
 	tamd->prevCos = NULL;
+	tamd->weights_cache = NULL;
+}
+
+static void freeData(ModifierData *md)
+{
+	ArmatureModifierData *amd = (ArmatureModifierData *) md;
+
+	if (amd->weights_cache) {
+		armature_deform_weights_free(amd->weights_cache);
+		amd->weights_cache = NULL;
+	}
 }
 
 static CustomDataMask requiredDataMask(Object *UNUSED(ob), ModifierData *UNUSED(md))
@@ -133,7 +144,8 @@ static void deformVerts(
 	modifier_vgroup_cache(md, vertexCos); /* if next modifier needs original vertices */
 
 	armature_deform_verts(amd->object, ob, derivedData, vertexCos, NULL,
-	                      numVerts, amd->deformflag, (float(*)[3])amd->prevCos, amd->defgrp_name);
+	                      numVerts, amd->deformflag, (float(*)[3])amd->prevCos, amd->defgrp_name,
+	                      (struct ArmatureDeformWeights **)&amd->weights_cache);
 
 	/* free cache */
 	if (amd->prevCos) {
@@ -154,7 +166,8 @@ static void deformVertsEM(
 	modifier_vgroup_cache(md, vertexCos); /* if next modifier needs original vertices */
 
 	armature_deform_verts(amd->object, ob, dm, vertexCos, NULL,
-	                      numVerts, amd->deformflag, (float(*)[3])amd->prevCos, amd->defgrp_name);
+	                      numVerts, amd->deformflag, (float(*)[3])amd->prevCos, amd->defgrp_name,
+	                      (struct ArmatureDeformWeights **)&amd->weights_cache);
 
 	/* free cache */
 	if (amd->prevCos) {
@@ -176,7 +189,8 @@ static void deformMatricesEM(
 	if (!derivedData) dm = CDDM_from_editbmesh(em, false, false);
 
 	armature_deform_verts(amd->object, ob, dm, vertexCos, defMats, numVerts,
-	                      amd->deformflag, NULL, amd->defgrp_name);
+	                      amd->deformflag, NULL, amd->defgrp_name,
+	                      (struct ArmatureDeformWeights **)&amd->weights_cache);
 
 	if (!derivedData) dm->release(dm);
 }
@@ -191,7 +205,8 @@ static void deformMatrices(
 	if (!derivedData) dm = CDDM_from_mesh((Mesh *)ob->data);
 
 	armature_deform_verts(amd->object, ob, dm, vertexCos, defMats, numVerts,
-	                      amd->deformflag, NULL, amd->defgrp_name);
+	                      amd->deformflag, NULL, amd->defgrp_name,
+	                      (struct ArmatureDeformWeights **)&amd->weights_cache);
 
 	if (!derivedData) dm->release(dm);
 }
@@ -214,7 +229,7 @@ ModifierTypeInfo modifierType_Armature = {
 	/* applyModifierEM */   NULL,
 	/* initData */          initData,
 	/* requiredDataMask */  requiredDataMask,
-	/* freeData */          NULL,
+	/* freeData */          freeData,
 	/* isDisabled */        isDisabled,
 	/* updateDepgraph */    updateDepgraph,
 	/* updateDepsgraph */   updateDepsgraph,
@@ -312,7 +312,8 @@ static DerivedMesh *applyModifier(
 				        false,
 				        false,
 				        bmd->operation,
-				        bmd->double_threshold);
+				        bmd->double_threshold,
+				        bmd->solver == eBooleanModifierSolver_Exact);
 
 				MEM_freeN(looptris);
 			}
@@ -158,9 +158,10 @@ static DerivedMesh *applyModifier(
 			const bool do_triangulate = (dmd->flag & MOD_DECIM_FLAG_TRIANGULATE) != 0;
 			const int symmetry_axis = (dmd->flag & MOD_DECIM_FLAG_SYMMETRY) ? dmd->symmetry_axis : -1;
 			const float symmetry_eps = 0.00002f;
+			const bool use_fast = (dmd->flag & MOD_DECIM_FLAG_FAST) != 0;
 			BM_mesh_decimate_collapse(
 			        bm, dmd->percent, vweights, dmd->defgrp_factor, do_triangulate,
-			        symmetry_axis, symmetry_eps);
+			        symmetry_axis, symmetry_eps, use_fast);
 			break;
 		}
 		case MOD_DECIM_MODE_UNSUBDIV:
@@ -187,6 +187,7 @@ typedef struct DisplaceUserdata {
 	float (*vertexCos)[3];
 	float local_mat[4][4];
 	MVert *mvert;
+	const float (*vert_nors)[3];
 	float (*vert_clnors)[3];
 } DisplaceUserdata;
 
@@ -279,9 +280,14 @@ static void displaceModifier_do_task(
 			add_v3_v3(vertexCos[iter], local_vec);
 			break;
 		case MOD_DISP_DIR_NOR:
-			vertexCos[iter][0] += delta * (mvert[iter].no[0] / 32767.0f);
-			vertexCos[iter][1] += delta * (mvert[iter].no[1] / 32767.0f);
-			vertexCos[iter][2] += delta * (mvert[iter].no[2] / 32767.0f);
+			if (data->vert_nors) {
+				madd_v3_v3fl(vertexCos[iter], data->vert_nors[iter], delta);
+			}
+			else {
+				vertexCos[iter][0] += delta * (mvert[iter].no[0] / 32767.0f);
+				vertexCos[iter][1] += delta * (mvert[iter].no[1] / 32767.0f);
+				vertexCos[iter][2] += delta * (mvert[iter].no[2] / 32767.0f);
+			}
 			break;
 		case MOD_DISP_DIR_CLNOR:
 			madd_v3_v3fl(vertexCos[iter], vert_clnors[iter], delta);
@@ -289,10 +295,11 @@ static void displaceModifier_do_task(
 	}
 }
 
-/* dm must be a CDDerivedMesh */
+/* dm must be a CDDerivedMesh with normals of vertexCos, unless vert_nors are given
+ * (or the direction doesn't use normals) */
 static void displaceModifier_do(
         DisplaceModifierData *dmd, Object *ob,
-        DerivedMesh *dm, float (*vertexCos)[3], int numVerts)
+        DerivedMesh *dm, float (*vertexCos)[3], const float (*vert_nors)[3], int numVerts)
 {
 	MVert *mvert;
 	MDeformVert *dvert;
@@ -307,7 +314,7 @@ static void displaceModifier_do(
 	if (!dmd->texture && dmd->direction == MOD_DISP_DIR_RGB_XYZ) return;
 	if (dmd->strength == 0.0f) return;
 
-	mvert = CDDM_get_verts(dm);
+	mvert = (vert_nors == NULL && ELEM(direction, MOD_DISP_DIR_NOR, MOD_DISP_DIR_CLNOR)) ? CDDM_get_verts(dm) : NULL;
 	modifier_get_vgroup(ob, dm, dmd->defgrp_name, &dvert, &defgrp_index);
 
 	if (dmd->texture) {
@@ -357,6 +364,7 @@ static void displaceModifier_do(
 	data.vertexCos = vertexCos;
 	copy_m4_m4(data.local_mat, local_mat);
 	data.mvert = mvert;
+	data.vert_nors = vert_nors;
 	data.vert_clnors = vert_clnors;
 	if (dmd->texture != NULL) {
 		data.pool = BKE_image_pool_new();
@@ -390,10 +398,29 @@ static void deformVerts(
         int numVerts,
         ModifierApplyFlag UNUSED(flag))
 {
-	DerivedMesh *dm = get_cddm(ob, NULL, derivedData, vertexCos, dependsOnNormals(md));
+	DisplaceModifierData *dmd = (DisplaceModifierData *)md;
+	DerivedMesh *dm;
+	float (*vert_nors)[3] = NULL;
 
-	displaceModifier_do((DisplaceModifierData *)md, ob, dm,
-	                    vertexCos, numVerts);
+	if (dmd->direction == MOD_DISP_DIR_NOR) {
+		vert_nors = modifier_vert_normals_from_cos(ob, derivedData, (const float (*)[3])vertexCos, numVerts);
+	}
+
+	if (vert_nors || !dependsOnNormals(md)) {
+		/* only needed for vertex groups and texture coordinates,
+		 * no need to write the positions into it */
+		dm = get_dm(ob, NULL, derivedData, NULL, false, false);
+	}
+	else {
+		/* custom normals are calculated from the derived mesh */
+		dm = get_cddm(ob, NULL, derivedData, vertexCos, true);
+	}
+
+	displaceModifier_do(dmd, ob, dm,
+	                    vertexCos, (const float (*)[3])vert_nors, numVerts);
+
+	if (vert_nors)
+		MEM_freeN(vert_nors);
 
 	if (dm != derivedData)
 		dm->release(dm);
@@ -406,7 +433,7 @@ static void deformVertsEM(
 	DerivedMesh *dm = get_cddm(ob, editData, derivedData, vertexCos, dependsOnNormals(md));
 
 	displaceModifier_do((DisplaceModifierData *)md, ob, dm,
-	                    vertexCos, numVerts);
+	                    vertexCos, NULL, numVerts);
 
 	if (dm != derivedData)
 		dm->release(dm);
@@ -72,7 +72,7 @@ static void copyData(const ModifierData *md, ModifierData *target)
 
 	modifier_copyData_generic(md, target);
 
-	tsmd->emCache = tsmd->mCache = NULL;
+	tsmd->emCache = tsmd->mCache = tsmd->renderCache = NULL;
 }
 
 static void freeData(ModifierData *md)
@@ -87,6 +87,7 @@ static void freeData(ModifierData *md)
 		ccgSubSurf_free(smd->emCache);
 		smd->emCache = NULL;
 	}
+	subsurf_free_render_cache(smd);
 }
 
 static bool isDisabled(ModifierData *md, int useRenderParams)
@@ -33,6 +33,7 @@
 #include <string.h>
 
 #include "DNA_image_types.h"
+#include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
 #include "DNA_modifier_types.h"
 #include "DNA_object_types.h"
@@ -218,6 +219,58 @@ DerivedMesh *get_dm_for_modifier(Object *ob, ModifierApplyFlag flag)
 	}
 }
 
+/* Vertex normals of the deformed positions, calculated without building (or writing into)
+ * a derived mesh. Topology comes from dm, or the object mesh when there is none.
+ * Returns NULL when there is no topology matching the positions. */
+float (*modifier_vert_normals_from_cos(
+        Object *ob, DerivedMesh *dm,
+        const float (*vertexCos)[3], int numVerts))[3]
+{
+	float (*vert_nors)[3];
+
+	if (dm) {
+		bool poly_allocated, loop_allocated;
+		MPoly *mpoly;
+		MLoop *mloop;
+
+		if (dm->getNumVerts(dm) != numVerts) {
+			return NULL;
+		}
+
+		mpoly = DM_get_poly_array(dm, &poly_allocated);
+		mloop = DM_get_loop_array(dm, &loop_allocated);
+
+		vert_nors = MEM_malloc_arrayN((size_t)numVerts, sizeof(*vert_nors), __func__);
+		BKE_mesh_calc_normals_poly_cos(
+		        vertexCos, vert_nors, numVerts,
+		        mloop, mpoly, dm->getNumLoops(dm), dm->getNumPolys(dm));
+
+		if (poly_allocated) {
+			MEM_freeN(mpoly);
+		}
+		if (loop_allocated) {
+			MEM_freeN(mloop);
+		}
+	}
+	else if (ob->type == OB_MESH) {
+		Mesh *me = ob->data;
+
+		if (me->totvert != numVerts) {
+			return NULL;
+		}
+
+		vert_nors = MEM_malloc_arrayN((size_t)numVerts, sizeof(*vert_nors), __func__);
+		BKE_mesh_calc_normals_poly_cos(
+		        vertexCos, vert_nors, numVerts,
+		        me->mloop, me->mpoly, me->totloop, me->totpoly);
+	}
+	else {
+		return NULL;
+	}
+
+	return vert_nors;
+}
+
 void modifier_get_vgroup(Object *ob, DerivedMesh *dm, const char *name, MDeformVert **dvert, int *defgrp_index)
 {
 	*defgrp_index = defgroup_name_index(ob, name);
@@ -52,6 +52,9 @@ struct DerivedMesh *get_dm(
         struct Object *ob, struct BMEditMesh *em, struct DerivedMesh *dm,
         float (*vertexCos)[3], bool use_normals, bool use_orco);
 struct DerivedMesh *get_dm_for_modifier(struct Object *ob, ModifierApplyFlag flag);
+float (*modifier_vert_normals_from_cos(
+        struct Object *ob, struct DerivedMesh *dm,
+        const float (*vertexCos)[3], int numVerts))[3];
 void modifier_get_vgroup(
         struct Object *ob, struct DerivedMesh *dm,
         const char *name, struct MDeformVert **dvert, int *defgrp_index);
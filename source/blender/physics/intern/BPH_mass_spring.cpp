@@ -991,6 +991,8 @@ int BPH_cloth_solve(Object *ob, float frame, ClothModifierData *clmd, ListBase *
 		clmd->solver_result = (ClothSolverResult *)MEM_callocN(sizeof(ClothSolverResult), "cloth solver result");
 	cloth_clear_result(clmd);
 
+	BPH_mass_spring_solver_set_parallel(id, (clmd->sim_parms->flags & CLOTH_SIMSETTINGS_FLAG_PARALLEL_SOLVER) != 0);
+
 	if (clmd->sim_parms->flags & CLOTH_SIMSETTINGS_FLAG_GOAL) { /* do goal stuff */
 		for (i = 0; i < mvert_num; i++) {
 			// update velocities with constrained velocities from pinned verts
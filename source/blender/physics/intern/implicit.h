@@ -92,6 +92,8 @@ void BPH_mass_spring_add_constraint_ndof0(struct Implicit_Data *data, int index,
 void BPH_mass_spring_add_constraint_ndof1(struct Implicit_Data *data, int index, const float c1[3], const float c2[3], const float dV[3]);
 void BPH_mass_spring_add_constraint_ndof2(struct Implicit_Data *data, int index, const float c1[3], const float dV[3]);
 
+/* Use the multi-threaded block-CSR solver instead of the default one */
+void BPH_mass_spring_solver_set_parallel(struct Implicit_Data *data, bool use_parallel);
 bool BPH_mass_spring_solve_velocities(struct Implicit_Data *data, float dt, struct ImplicitSolverResult *result);
 bool BPH_mass_spring_solve_positions(struct Implicit_Data *data, float dt);
 void BPH_mass_spring_apply_result(struct Implicit_Data *data);
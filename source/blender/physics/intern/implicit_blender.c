@@ -43,6 +43,7 @@
 
 #include "BLI_math.h"
 #include "BLI_linklist.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_cloth.h"
@@ -660,8 +661,13 @@ typedef struct Implicit_Data  {
 	lfVector *z;				/* target velocity in constrained directions */
 	fmatrix3x3 *S;				/* filtering matrix for constraints */
 	fmatrix3x3 *P, *Pinv;		/* pre-conditioning matrix */
+
+	bool use_parallel_solver;	/* solve with the block-CSR solver below */
+	struct BlockCSRMatrix *bsr;	/* row-gathered copy of A, created on first use */
 } Implicit_Data;
 
+static void bsr_free(struct BlockCSRMatrix *bsr);
+
 Implicit_Data *BPH_mass_spring_solver_create(int numverts, int numsprings)
 {
 	Implicit_Data *id = (Implicit_Data *)MEM_callocN(sizeof(Implicit_Data), "implicit vecmat");
@@ -711,6 +717,10 @@ void BPH_mass_spring_solver_free(Implicit_Data *id)
 	del_lfvector(id->dV);
 	del_lfvector(id->z);
 
+	if (id->bsr) {
+		bsr_free(id->bsr);
+	}
+
 	MEM_freeN(id);
 }
 
@@ -906,6 +916,310 @@ static int cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z,
 	return conjgrad_loopcount < conjgrad_looplimit;  // true means we reached desired accuracy in given time - ie stable
 }
 
+/* ==== Parallel block-CSR solver ==== */
+
+/* The spring blocks of the system matrix are stored once per spring in the bfmatrix arrays,
+ * which makes the matrix-vector product scatter into two rows at a time and prevents
+ * splitting it over threads. This alternative solver gathers the blocks into rows
+ * (block compressed sparse rows), so every row of a product can be computed independently,
+ * and uses the inverse diagonal blocks of A as preconditioner (block-Jacobi).
+ *
+ * The sparsity pattern only depends on the springs, the block values are refreshed
+ * every solve. All vector operations of one CG iteration are fused into three passes
+ * over the rows, dot products are reduced in double precision per thread chunk. */
+
+#define CLOTH_BSR_THREADED_LIMIT 256
+
+typedef struct BlockCSRMatrix {
+	int num_rows;
+	int num_entries, num_entries_alloc;
+	int *row_offset;			/* first entry of each row, num_rows + 1 items */
+	int *col;					/* column of each entry */
+	int *block;					/* source block in the bfmatrix arrays */
+	float (*A)[3][3];			/* A = M - dt * dFdV - dt^2 * dFdX */
+	float (*Pinv)[3][3];		/* inverse of the diagonal blocks of A, per row */
+
+	/* solver vectors */
+	lfVector *fB, *r, *c, *q, *s;
+} BlockCSRMatrix;
+
+static BlockCSRMatrix *bsr_create(int numverts)
+{
+	BlockCSRMatrix *bsr = MEM_callocN(sizeof(BlockCSRMatrix), "cloth BlockCSRMatrix");
+
+	bsr->num_rows = numverts;
+	bsr->row_offset = MEM_mallocN(sizeof(int) * (numverts + 1), "cloth BlockCSRMatrix rows");
+	bsr->Pinv = MEM_mallocN(sizeof(float[3][3]) * numverts, "cloth BlockCSRMatrix Pinv");
+	bsr->fB = create_lfvector(numverts);
+	bsr->r = create_lfvector(numverts);
+	bsr->c = create_lfvector(numverts);
+	bsr->q = create_lfvector(numverts);
+	bsr->s = create_lfvector(numverts);
+
+	return bsr;
+}
+
+static void bsr_free(BlockCSRMatrix *bsr)
+{
+	MEM_freeN(bsr->row_offset);
+	MEM_SAFE_FREE(bsr->col);
+	MEM_SAFE_FREE(bsr->block);
+	MEM_SAFE_FREE(bsr->A);
+	MEM_freeN(bsr->Pinv);
+
+	del_lfvector(bsr->fB);
+	del_lfvector(bsr->r);
+	del_lfvector(bsr->c);
+	del_lfvector(bsr->q);
+	del_lfvector(bsr->s);
+
+	MEM_freeN(bsr);
+}
+
+/* Gather the used blocks of the bfmatrix arrays into rows.
+ * Diagonal blocks come first in each row, followed by spring blocks in spring order,
+ * so the summation order is the same for every solve. */
+static void bsr_build_structure(BlockCSRMatrix *bsr, const fmatrix3x3 *M, int num_blocks)
+{
+	const int numverts = bsr->num_rows;
+	const int totblock = numverts + num_blocks;
+	int *row_offset = bsr->row_offset;
+	int *row_fill;
+	int i, num_entries;
+
+	memset(row_offset, 0, sizeof(int) * (numverts + 1));
+	for (i = 0; i < totblock; i++) {
+		row_offset[M[i].r + 1]++;
+		if (i >= numverts) {
+			row_offset[M[i].c + 1]++;
+		}
+	}
+	for (i = 0; i < numverts; i++) {
+		row_offset[i + 1] += row_offset[i];
+	}
+	num_entries = row_offset[numverts];
+
+	if (num_entries > bsr->num_entries_alloc) {
+		MEM_SAFE_FREE(bsr->col);
+		MEM_SAFE_FREE(bsr->block);
+		MEM_SAFE_FREE(bsr->A);
+		bsr->col = MEM_mallocN(sizeof(int) * num_entries, "cloth BlockCSRMatrix col");
+		bsr->block = MEM_mallocN(sizeof(int) * num_entries, "cloth BlockCSRMatrix block");
+		bsr->A = MEM_mallocN(sizeof(float[3][3]) * num_entries, "cloth BlockCSRMatrix A");
+		bsr->num_entries_alloc = num_entries;
+	}
+	bsr->num_entries = num_entries;
+
+	row_fill = MEM_mallocN(sizeof(int) * numverts, __func__);
+	memcpy(row_fill, row_offset, sizeof(int) * numverts);
+
+	for (i = 0; i < totblock; i++) {
+		/* block m at (r, c) contributes m * x[c] to row r, and for springs m * x[r] to row c */
+		int e = row_fill[M[i].r]++;
+		bsr->col[e] = M[i].c;
+		bsr->block[e] = i;
+
+		if (i >= numverts) {
+			e = row_fill[M[i].c]++;
+			bsr->col[e] = M[i].r;
+			bsr->block[e] = i;
+		}
+	}
+
+	MEM_freeN(row_fill);
+}
+
+typedef struct BSRSolverData {
+	Implicit_Data *data;
+	BlockCSRMatrix *bsr;
+	float dt;
+
+	float alpha, beta;
+
+	/* reduction results */
+	double dot[2];
+} BSRSolverData;
+
+BLI_INLINE void bsr_mul_row(const BlockCSRMatrix *bsr, int row, const lfVector *x, float r[3])
+{
+	int e;
+
+	zero_v3(r);
+	for (e = bsr->row_offset[row]; e < bsr->row_offset[row + 1]; e++) {
+		muladd_fmatrix_fvector(r, bsr->A[e], (float *)x[bsr->col[e]]);
+	}
+}
+
+static void bsr_reduce_finalize(void *__restrict userdata, void *__restrict userdata_chunk)
+{
+	BSRSolverData *sd = userdata;
+	const double *dot = userdata_chunk;
+
+	sd->dot[0] += dot[0];
+	sd->dot[1] += dot[1];
+}
+
+/* A and Pinv values, B = dt * F + dt^2 * dFdX * V */
+static void bsr_assemble_cb(void *__restrict userdata, const int row, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BSRSolverData *sd = userdata;
+	Implicit_Data *data = sd->data;
+	BlockCSRMatrix *bsr = sd->bsr;
+	const float dt = sd->dt;
+	float P[3][3], dFdXmV[3];
+	int e;
+
+	zero_m3(P);
+	zero_v3(dFdXmV);
+
+	for (e = bsr->row_offset[row]; e < bsr->row_offset[row + 1]; e++) {
+		const int b = bsr->block[e];
+		const int col = bsr->col[e];
+
+		copy_m3_m3(bsr->A[e], data->M[b].m);
+		subadd_fmatrixS_fmatrixS(bsr->A[e], data->dFdV[b].m, dt, data->dFdX[b].m, dt * dt);
+		muladd_fmatrix_fvector(dFdXmV, data->dFdX[b].m, data->V[col]);
+
+		if (col == row) {
+			add_m3_m3m3(P, P, bsr->A[e]);
+		}
+	}
+
+	if (!invert_m3_m3(bsr->Pinv[row], P)) {
+		unit_m3(bsr->Pinv[row]);
+	}
+
+	VECADDSS(data->B[row], data->F[row], dt, dFdXmV, dt * dt);
+}
+
+/* fB = S(B), r = S(B - A * dV), c = S(Pinv * r) */
+static void bsr_init_cb(void *__restrict userdata, const int row, const ParallelRangeTLS *__restrict tls)
+{
+	BSRSolverData *sd = userdata;
+	Implicit_Data *data = sd->data;
+	BlockCSRMatrix *bsr = sd->bsr;
+	double *dot = tls->userdata_chunk;
+	float (*S)[3] = data->S[row].m;
+	float AdV[3], tmp[3];
+
+	copy_v3_v3(bsr->fB[row], data->B[row]);
+	mul_m3_v3(S, bsr->fB[row]);
+
+	bsr_mul_row(bsr, row, data->dV, AdV);
+	sub_v3_v3v3(bsr->r[row], data->B[row], AdV);
+	mul_m3_v3(S, bsr->r[row]);
+
+	mul_v3_m3v3(bsr->c[row], bsr->Pinv[row], bsr->r[row]);
+	mul_m3_v3(S, bsr->c[row]);
+
+	mul_v3_m3v3(tmp, bsr->Pinv[row], bsr->fB[row]);
+	dot[0] += dot_v3v3(bsr->fB[row], tmp);
+	dot[1] += dot_v3v3(bsr->r[row], bsr->c[row]);
+}
+
+/* q = S(A * c), dot(c, q) */
+static void bsr_mul_filter_cb(void *__restrict userdata, const int row, const ParallelRangeTLS *__restrict tls)
+{
+	BSRSolverData *sd = userdata;
+	BlockCSRMatrix *bsr = sd->bsr;
+	double *dot = tls->userdata_chunk;
+
+	bsr_mul_row(bsr, row, bsr->c, bsr->q[row]);
+	mul_m3_v3(sd->data->S[row].m, bsr->q[row]);
+
+	dot[0] += dot_v3v3(bsr->c[row], bsr->q[row]);
+}
+
+/* dV += alpha * c, r -= alpha * q, s = Pinv * r, dot(r, s) */
+static void bsr_update_cb(void *__restrict userdata, const int row, const ParallelRangeTLS *__restrict tls)
+{
+	BSRSolverData *sd = userdata;
+	BlockCSRMatrix *bsr = sd->bsr;
+	double *dot = tls->userdata_chunk;
+	const float alpha = sd->alpha;
+
+	madd_v3_v3fl(sd->data->dV[row], bsr->c[row], alpha);
+	madd_v3_v3fl(bsr->r[row], bsr->q[row], -alpha);
+	mul_v3_m3v3(bsr->s[row], bsr->Pinv[row], bsr->r[row]);
+
+	dot[0] += dot_v3v3(bsr->r[row], bsr->s[row]);
+}
+
+/* c = S(s + beta * c) */
+static void bsr_direction_cb(void *__restrict userdata, const int row, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BSRSolverData *sd = userdata;
+	BlockCSRMatrix *bsr = sd->bsr;
+
+	VECADDS(bsr->c[row], bsr->s[row], bsr->c[row], sd->beta);
+	mul_m3_v3(sd->data->S[row].m, bsr->c[row]);
+}
+
+static void bsr_parallel_range(BSRSolverData *sd, TaskParallelRangeFunc func, bool reduce)
+{
+	ParallelRangeSettings settings;
+	double dot_chunk[2] = {0.0, 0.0};
+
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (sd->bsr->num_rows > CLOTH_BSR_THREADED_LIMIT);
+	if (reduce) {
+		sd->dot[0] = sd->dot[1] = 0.0;
+		settings.userdata_chunk = dot_chunk;
+		settings.userdata_chunk_size = sizeof(dot_chunk);
+		settings.func_finalize = bsr_reduce_finalize;
+	}
+
+	BLI_task_parallel_range(0, sd->bsr->num_rows, sd, func, &settings);
+}
+
+/* Same as cg_filtered, with the modified preconditioned CG of [Baraff and Witkin 98]. */
+static int cg_filtered_bsr(Implicit_Data *data, float dt, ImplicitSolverResult *result)
+{
+	unsigned int conjgrad_loopcount = 0, conjgrad_looplimit = 100;
+	float conjgrad_epsilon = 0.01f;
+	BlockCSRMatrix *bsr = data->bsr;
+	BSRSolverData sd = {NULL};
+	double bnorm2, delta_new, delta_old, delta_target;
+
+	bsr_build_structure(bsr, data->M, data->num_blocks);
+
+	sd.data = data;
+	sd.bsr = bsr;
+	sd.dt = dt;
+
+	bsr_parallel_range(&sd, bsr_assemble_cb, false);
+
+	cp_lfvector(data->dV, data->z, bsr->num_rows);
+
+	bsr_parallel_range(&sd, bsr_init_cb, true);
+	bnorm2 = sd.dot[0];
+	delta_new = sd.dot[1];
+	delta_target = conjgrad_epsilon * conjgrad_epsilon * bnorm2;
+
+	while (delta_new > delta_target && conjgrad_loopcount < conjgrad_looplimit) {
+		bsr_parallel_range(&sd, bsr_mul_filter_cb, true);
+		if (sd.dot[0] == 0.0) {
+			break;
+		}
+		sd.alpha = (float)(delta_new / sd.dot[0]);
+
+		bsr_parallel_range(&sd, bsr_update_cb, true);
+		delta_old = delta_new;
+		delta_new = sd.dot[0];
+
+		sd.beta = (float)(delta_new / delta_old);
+		bsr_parallel_range(&sd, bsr_direction_cb, false);
+
+		conjgrad_loopcount++;
+	}
+
+	result->status = conjgrad_loopcount < conjgrad_looplimit ? BPH_SOLVER_SUCCESS : BPH_SOLVER_NO_CONVERGENCE;
+	result->iterations = conjgrad_loopcount;
+	result->error = bnorm2 > 0.0 ? (float)sqrt(delta_new / bnorm2) : 0.0f;
+
+	return conjgrad_loopcount < conjgrad_looplimit;
+}
+
 #if 0
 // block diagonalizer
 DO_INLINE void BuildPPinv(fmatrix3x3 *lA, fmatrix3x3 *P, fmatrix3x3 *Pinv)
@@ -1104,11 +1418,30 @@ static int cg_filtered_pre(lfVector *dv, fmatrix3x3 *lA, lfVector *lB, lfVector
 }
 #endif
 
+void BPH_mass_spring_solver_set_parallel(Implicit_Data *data, bool use_parallel)
+{
+	data->use_parallel_solver = use_parallel;
+}
+
 bool BPH_mass_spring_solve_velocities(Implicit_Data *data, float dt, ImplicitSolverResult *result)
 {
 	unsigned int numverts = data->dFdV[0].vcount;
+	lfVector *dFdXmV;
+
+	if (data->use_parallel_solver) {
+		if (data->bsr == NULL) {
+			data->bsr = bsr_create(numverts);
+		}
+
+		cg_filtered_bsr(data, dt, result);
+
+		// advance velocities
+		add_lfvector_lfvector(data->Vnew, data->V, data->dV, numverts);
+
+		return result->status == BPH_SOLVER_SUCCESS;
+	}
 
-	lfVector *dFdXmV = create_lfvector(numverts);
+	dFdXmV = create_lfvector(numverts);
 	zero_lfvector(data->dV, numverts);
 
 	cp_bfmatrix(data->A, data->M);
@@ -494,6 +494,11 @@ BLI_INLINE void root_to_world_m3(Implicit_Data *data, int index, float r[3][3],
 
 /* ================================ */
 
+void BPH_mass_spring_solver_set_parallel(Implicit_Data *UNUSED(data), bool UNUSED(use_parallel))
+{
+	/* Eigen solves the system on its own, there is no alternative solver here */
+}
+
 bool BPH_mass_spring_solve_velocities(Implicit_Data *data, float dt, ImplicitSolverResult *result)
 {
 #ifdef USE_EIGEN_CORE
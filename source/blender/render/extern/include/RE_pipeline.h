@@ -173,6 +173,13 @@ typedef struct RenderResult {
 	char *error;
 
 	struct StampData *stamp_data;
+
+	/* multilayer file loaded with RE_MultilayerRead, passes without rect are decoded
+	 * from it on first use by RE_MultilayerPassEnsure, it is closed once all are */
+	void *exrhandle;
+	int exr_lazy_passes;
+	char exr_colorspace[64];  /* MAX_COLORSPACE_NAME */
+	bool exr_predivide;
 } RenderResult;
 
 
@@ -315,6 +322,8 @@ bool RE_WriteRenderResult(
         struct ImageFormatData *imf, const char *view, int layer);
 struct RenderResult *RE_MultilayerConvert(
         void *exrhandle, const char *colorspace, bool predivide, int rectx, int recty);
+struct RenderResult *RE_MultilayerRead(const char *filepath, const char *colorspace, bool predivide);
+bool RE_MultilayerPassEnsure(struct RenderResult *rr, struct RenderPass *rpass);
 
 extern const float default_envmap_layout[];
 bool RE_WriteEnvmapResult(
@@ -2806,7 +2806,11 @@ static void do_render_seq(Render *re)
 
 	for (view_id = 0; view_id < tot_views; view_id++) {
 		context.view_id = view_id;
+
+		/* the sequencer might be rendering ahead in the background */
+		BKE_sequencer_prefetch_lock();
 		out = BKE_sequencer_give_ibuf(&context, cfra, 0);
+		BKE_sequencer_prefetch_unlock();
 
 		if (out) {
 			ibuf_arr[view_id] = IMB_dupImBuf(out);
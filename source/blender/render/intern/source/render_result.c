@@ -121,6 +121,9 @@ void render_result_free(RenderResult *res)
 
 	BKE_stamp_data_free(res->stamp_data);
 
+	if (res->exrhandle)
+		IMB_exr_close(res->exrhandle);
+
 	MEM_freeN(res);
 }
 
@@ -719,7 +722,7 @@ RenderResult *render_result_new_from_exr(void *exrhandle, const char *colorspace
 			rpass->rectx = rectx;
 			rpass->recty = recty;
 
-			if (rpass->channels >= 3) {
+			if (rpass->rect && rpass->channels >= 3) {
 				IMB_colormanagement_transform(rpass->rect, rpass->rectx, rpass->recty, rpass->channels,
 				                              colorspace, to_colorspace, predivide);
 			}
@@ -729,6 +732,91 @@ RenderResult *render_result_new_from_exr(void *exrhandle, const char *colorspace
 	return rr;
 }
 
+/* Opens a multilayer file without decoding any pixels, the passes have no rect
+ * until RE_MultilayerPassEnsure reads them. Returns NULL for other files. */
+RenderResult *RE_MultilayerRead(const char *filepath, const char *colorspace, bool predivide)
+{
+	void *exrhandle = IMB_exr_get_handle();
+	RenderResult *rr;
+	int width, height;
+
+	if (!IMB_exr_begin_read_lazy(exrhandle, filepath, &width, &height) || !IMB_exr_has_multilayer(exrhandle)) {
+		IMB_exr_close(exrhandle);
+		return NULL;
+	}
+
+	rr = render_result_new_from_exr(exrhandle, colorspace, predivide, width, height);
+	rr->exrhandle = exrhandle;
+	for (RenderLayer *rl = rr->layers.first; rl; rl = rl->next) {
+		rr->exr_lazy_passes += BLI_listbase_count(&rl->passes);
+	}
+	BLI_strncpy(rr->exr_colorspace, colorspace, sizeof(rr->exr_colorspace));
+	rr->exr_predivide = predivide;
+
+	return rr;
+}
+
+/* all lazily read files share one lock, a handle can't decode in parallel */
+static ThreadMutex exr_pass_read_lock = BLI_MUTEX_INITIALIZER;
+
+static bool render_result_pass_read(RenderResult *rr, RenderLayer *rl, RenderPass *rpass)
+{
+	if (rpass->rect) {
+		return true;
+	}
+
+	BLI_mutex_lock(&exr_pass_read_lock);
+
+	/* can have been read by another thread while waiting */
+	if (rpass->rect == NULL && rr->exrhandle) {
+		float *rect = MEM_mapallocN(sizeof(float) * rpass->rectx * rpass->recty * rpass->channels, "loaded pass");
+
+		if (IMB_exr_read_pass_rect(rr->exrhandle, rl->name, rpass->name, rpass->view,
+		                           0, 0, rpass->rectx - 1, rpass->recty - 1, rect))
+		{
+			if (rpass->channels >= 3) {
+				const char *to_colorspace = IMB_colormanagement_role_colorspace_name_get(COLOR_ROLE_SCENE_LINEAR);
+
+				IMB_colormanagement_transform(rect, rpass->rectx, rpass->recty, rpass->channels,
+				                              rr->exr_colorspace, to_colorspace, rr->exr_predivide);
+			}
+			rpass->rect = rect;
+
+			/* everything is in memory now, don't keep the file open */
+			if (--rr->exr_lazy_passes == 0) {
+				IMB_exr_close(rr->exrhandle);
+				rr->exrhandle = NULL;
+			}
+		}
+		else {
+			MEM_freeN(rect);
+		}
+	}
+
+	BLI_mutex_unlock(&exr_pass_read_lock);
+
+	return (rpass->rect != NULL);
+}
+
+/* Makes sure rpass->rect is there, decoding the pass from the file of
+ * a render result from RE_MultilayerRead when it wasn't used yet. */
+bool RE_MultilayerPassEnsure(RenderResult *rr, RenderPass *rpass)
+{
+	RenderLayer *rl;
+
+	if (rpass->rect) {
+		return true;
+	}
+
+	for (rl = rr->layers.first; rl; rl = rl->next) {
+		if (BLI_findindex(&rl->passes, rpass) != -1) {
+			return render_result_pass_read(rr, rl, rpass);
+		}
+	}
+
+	return false;
+}
+
 void render_result_view_new(RenderResult *rr, const char *viewname)
 {
 	RenderView *rv = MEM_callocN(sizeof(RenderView), "new render view");
@@ -928,6 +1016,11 @@ bool RE_WriteRenderResult(ReportList *reports, RenderResult *rr, const char *fil
 				}
 			}
 
+			/* Passes of a lazily read multilayer file are decoded first. */
+			if (!render_result_pass_read(rr, rl, rp)) {
+				continue;
+			}
+
 			/* We only store RGBA passes as half float, for
 			 * others precision loss can be problematic. */
 			bool pass_half_float = half_float &&
@@ -1520,8 +1613,19 @@ static RenderView *duplicate_render_view(RenderView *rview)
 RenderResult *RE_DuplicateRenderResult(RenderResult *rr)
 {
 	RenderResult *new_rr = MEM_mallocN(sizeof(RenderResult), "new duplicated render result");
+
+	/* the file handle isn't shared, read what is still lazy in the original */
+	if (rr->exrhandle) {
+		for (RenderLayer *rl = rr->layers.first; rl != NULL; rl = rl->next) {
+			for (RenderPass *rpass = rl->passes.first; rpass != NULL; rpass = rpass->next) {
+				render_result_pass_read(rr, rl, rpass);
+			}
+		}
+	}
+
 	*new_rr = *rr;
 	new_rr->next = new_rr->prev = NULL;
+	new_rr->exrhandle = NULL;
 	new_rr->layers.first = new_rr->layers.last = NULL;
 	new_rr->views.first = new_rr->views.last = NULL;
 	for (RenderLayer *rl = rr->layers.first; rl != NULL; rl = rl->next) {
@@ -0,0 +1,142 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <vector>
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+
+#include "BLI_rand.h"
+#include "BLI_math_vector.h"
+
+#include "DNA_particle_types.h"
+
+#include "BKE_particle.h"
+}
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+typedef struct GridQueryData {
+	std::vector<int> hits;
+	float dist_sq_error;
+	const ParticleSystem *psys;
+} GridQueryData;
+
+static void grid_query_cb(void *userdata, int index, const float co[3], float dist_sq)
+{
+	GridQueryData *data = (GridQueryData *)userdata;
+	const float expect = len_squared_v3v3(co, data->psys->particles[index].state.co);
+
+	data->hits[index]++;
+	data->dist_sq_error = max_ff(data->dist_sq_error, fabsf(dist_sq - expect));
+}
+
+static void particles_init(ParticleSystem *psys, int totpart, float scale, int random_seed)
+{
+	struct RNG *rng = BLI_rng_new(random_seed);
+
+	memset(psys, 0, sizeof(*psys));
+	psys->totpart = totpart;
+	psys->particles = (ParticleData *)MEM_callocN(sizeof(ParticleData) * max_ii(totpart, 1), __func__);
+
+	for (int p = 0; p < totpart; p++) {
+		ParticleData *pa = &psys->particles[p];
+		const float r = BLI_rng_get_float(rng);
+
+		for (int i = 0; i < 3; i++) {
+			pa->state.co[i] = (BLI_rng_get_float(rng) * 2.0f - 1.0f) * scale;
+		}
+		pa->alive = PARS_ALIVE;
+
+		/* a mix of particles which must not be found */
+		if (r < 0.05f) {
+			pa->alive = PARS_DEAD;
+		}
+		else if (r < 0.10f) {
+			pa->alive = PARS_UNBORN;
+		}
+		else if (r < 0.15f) {
+			pa->flag |= PARS_UNEXIST;
+		}
+		else if (r < 0.20f) {
+			pa->flag |= PARS_NO_DISP;
+		}
+		else if (r < 0.21f) {
+			/* far away, to hit the clamping of cell coordinates */
+			mul_v3_fl(pa->state.co, 1.0e10f);
+		}
+	}
+
+	BLI_rng_free(rng);
+}
+
+static void sph_grid_brute_force_test(int totpart, float scale, float cell_size, float radius, int random_seed)
+{
+	ParticleSystem psys;
+	particles_init(&psys, totpart, scale, random_seed);
+
+	/* state.time differs from cfra, so the grid uses state.co */
+	struct SPHGrid *grid = psys_sph_grid_build(&psys, cell_size, 1.0f);
+	struct RNG *rng = BLI_rng_new(random_seed + 1);
+
+	GridQueryData data;
+	data.psys = &psys;
+
+	for (int q = 0; q < 100; q++) {
+		float co[3];
+
+		if (q % 2) {
+			copy_v3_v3(co, psys.particles[BLI_rng_get_int(rng) % totpart].state.co);
+		}
+		else {
+			for (int i = 0; i < 3; i++) {
+				co[i] = (BLI_rng_get_float(rng) * 2.0f - 1.0f) * scale;
+			}
+		}
+
+		data.hits.assign(totpart, 0);
+		data.dist_sq_error = 0.0f;
+		psys_sph_grid_range_query(grid, co, radius, grid_query_cb, &data);
+
+		for (int p = 0; p < totpart; p++) {
+			const ParticleData *pa = &psys.particles[p];
+			const bool use = (pa->alive == PARS_ALIVE) && !(pa->flag & (PARS_UNEXIST | PARS_NO_DISP));
+			const int expect = (use && len_squared_v3v3(co, pa->state.co) <= radius * radius) ? 1 : 0;
+
+			EXPECT_EQ(expect, data.hits[p]);
+		}
+		EXPECT_LE(data.dist_sq_error, 1e-6f);
+	}
+
+	BLI_rng_free(rng);
+	psys_sph_grid_free(grid);
+	MEM_freeN(psys.particles);
+}
+
+/* -------------------------------------------------------------------- */
+/* Tests */
+
+TEST(sph_grid, Empty)
+{
+	ParticleSystem psys;
+	particles_init(&psys, 0, 1.0f, 0);
+
+	struct SPHGrid *grid = psys_sph_grid_build(&psys, 0.1f, 1.0f);
+	float co[3] = {0.0f, 0.0f, 0.0f};
+	GridQueryData data;
+	data.psys = &psys;
+	data.dist_sq_error = 0.0f;
+	psys_sph_grid_range_query(grid, co, 1.0f, grid_query_cb, &data);
+	EXPECT_TRUE(data.hits.empty());
+
+	psys_sph_grid_free(grid);
+	MEM_SAFE_FREE(psys.particles);
+}
+
+TEST(sph_grid, RadiusSmall)        { sph_grid_brute_force_test(20000, 1.0f, 0.05f, 0.05f, 1234); }
+TEST(sph_grid, RadiusSmallerCells) { sph_grid_brute_force_test(20000, 1.0f, 0.05f, 0.2f, 1234); }
+TEST(sph_grid, RadiusLargerCells)  { sph_grid_brute_force_test(20000, 1.0f, 0.5f, 0.05f, 1234); }
+TEST(sph_grid, RadiusHuge)         { sph_grid_brute_force_test(20000, 1.0f, 0.05f, 100.0f, 1234); }
+TEST(sph_grid, ScaleLarge)         { sph_grid_brute_force_test(20000, 1000.0f, 10.0f, 25.0f, 1234); }
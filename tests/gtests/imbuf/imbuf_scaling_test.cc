@@ -0,0 +1,90 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+
+extern "C" {
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+}
+
+/* Average of the source area covered by every output pixel, computed directly. */
+static void area_average_reference(const float *src, int w, int h, float *dst, int newx, int newy)
+{
+	const float sx = (float)w / newx, sy = (float)h / newy;
+
+	for (int y = 0; y < newy; y++) {
+		for (int x = 0; x < newx; x++) {
+			float sum = 0.0f, area = 0.0f;
+
+			for (int j = 0; j < h; j++) {
+				const float cy = std::min(sy * (y + 1), (float)(j + 1)) - std::max(sy * y, (float)j);
+				if (cy <= 0.0f) {
+					continue;
+				}
+				for (int i = 0; i < w; i++) {
+					const float cx = std::min(sx * (x + 1), (float)(i + 1)) - std::max(sx * x, (float)i);
+					if (cx <= 0.0f) {
+						continue;
+					}
+					sum += src[j * w + i] * cx * cy;
+					area += cx * cy;
+				}
+			}
+
+			dst[y * newx + x] = sum / area;
+		}
+	}
+}
+
+static ImBuf *create_float_ibuf(const float *values, int w, int h)
+{
+	ImBuf *ibuf = IMB_allocImBuf(w, h, 32, IB_rectfloat);
+
+	for (int i = 0; i < w * h; i++) {
+		for (int c = 0; c < 4; c++) {
+			ibuf->rect_float[i * 4 + c] = values[i];
+		}
+	}
+
+	return ibuf;
+}
+
+TEST(imbuf_scaling, BoxShrinkNonInteger)
+{
+	/* 1.5x shrink: the middle pixel is shared half by each output pixel */
+	const float src[3] = {0.0f, 3.0f, 6.0f};
+	ImBuf *ibuf = create_float_ibuf(src, 3, 1);
+
+	EXPECT_TRUE(IMB_scaleImBuf_filter(ibuf, 2, 1, IMB_SCALE_FILTER_BOX));
+	ASSERT_EQ(ibuf->x, 2);
+	EXPECT_NEAR(ibuf->rect_float[0], 1.0f, 1e-5f);
+	EXPECT_NEAR(ibuf->rect_float[4], 5.0f, 1e-5f);
+
+	IMB_freeImBuf(ibuf);
+}
+
+TEST(imbuf_scaling, BoxShrinkAreaAverage)
+{
+	const int w = 17, h = 11, newx = 7, newy = 4;
+	float src[w * h], ref[newx * newy];
+
+	for (int i = 0; i < w * h; i++) {
+		src[i] = (float)((i * 7919) % 97) / 97.0f;
+	}
+	area_average_reference(src, w, h, ref, newx, newy);
+
+	ImBuf *ibuf = create_float_ibuf(src, w, h);
+	EXPECT_TRUE(IMB_scaleImBuf(ibuf, newx, newy));
+	ASSERT_EQ(ibuf->x, newx);
+	ASSERT_EQ(ibuf->y, newy);
+
+	for (int i = 0; i < newx * newy; i++) {
+		for (int c = 0; c < 4; c++) {
+			EXPECT_NEAR(ibuf->rect_float[i * 4 + c], ref[i], 1e-5f);
+		}
+	}
+
+	IMB_freeImBuf(ibuf);
+}